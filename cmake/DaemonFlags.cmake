@@ -260,7 +260,7 @@ if (USE_FLOAT_EXCEPTIONS)
     add_definitions(-DDAEMON_USE_FLOAT_EXCEPTIONS)
 endif()
 
-if (NOT NACL AND BUILD_CLIENT)
+if (NOT NACL AND (BUILD_CLIENT OR BUILD_SERVER OR BUILD_TTY_CLIENT))
 	option(USE_OPENMP "Use OpenMP to parallelize some tasks" OFF)
 endif()
 
@@ -275,7 +275,7 @@ if (YOKAI_CXX_COMPILER_MSVC_COMPATIBILITY)
         set_cxx_flag("/std:c++23preview")
     endif()
 
-	if (NOT NACL AND BUILD_CLIENT AND USE_OPENMP)
+	if (NOT NACL AND (BUILD_CLIENT OR BUILD_SERVER OR BUILD_TTY_CLIENT) AND USE_OPENMP)
 		# Flag checks doen't work with MSVC so we assume it's there.
 		set(OPENMP_COMPILE_FLAG "/openmp")
 	endif()
@@ -375,7 +375,7 @@ else()
 		endif()
 	endif()
 
-	if (NOT NACL AND BUILD_CLIENT AND USE_OPENMP)
+	if (NOT NACL AND (BUILD_CLIENT OR BUILD_SERVER OR BUILD_TTY_CLIENT) AND USE_OPENMP)
 		check_CXX_compiler_flag("-fopenmp" FLAG_FOPENMP)
 
 		if (FLAG_FOPENMP)
@@ -0,0 +1,23 @@
+// Shaders for the shader index tests
+test/shaderindex/plain
+{
+	{
+		map textures\imagedecode\checker
+		blendFunc blend
+	}
+}
+
+/* a comment
+   spanning lines */
+test/shaderindex/comments // trailing
+{
+	cull none // trailing
+	{
+		map textures/imagedecode/opaque
+	}
+}
+
+test/shaderindex/implicit
+{
+	implicitMap textures/imagedecode/gradient
+}
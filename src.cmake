@@ -35,6 +35,9 @@ set(COMMONLIST
     ${COMMON_DIR}/Math.h
     ${COMMON_DIR}/Optional.h
     ${COMMON_DIR}/Platform.h
+    ${COMMON_DIR}/Profiler.cpp
+    ${COMMON_DIR}/Profiler.h
+    ${COMMON_DIR}/Serialize.cpp
     ${COMMON_DIR}/Serialize.h
     ${COMMON_DIR}/StackTrace.h
     ${COMMON_DIR}/String.cpp
@@ -73,6 +76,8 @@ set(COMMONTESTLIST
     ${COMMON_DIR}/ColorTest.cpp
     ${COMMON_DIR}/CvarTest.cpp
     ${COMMON_DIR}/FileSystemTest.cpp
+    ${COMMON_DIR}/IPC/ChannelTest.cpp
+    ${COMMON_DIR}/IPC/CommandBufferTest.cpp
     ${COMMON_DIR}/StringTest.cpp
     ${COMMON_DIR}/cm/unittest.cpp
     ${COMMON_DIR}/MathTest.cpp
@@ -187,6 +192,8 @@ set(ENGINELIST
     ${ENGINE_DIR}/framework/LogSystem.h
     ${ENGINE_DIR}/framework/OmpSystem.cpp
     ${ENGINE_DIR}/framework/OmpSystem.h
+    ${ENGINE_DIR}/framework/ProfilerSystem.cpp
+    ${ENGINE_DIR}/framework/ProfilerSystem.h
     ${ENGINE_DIR}/framework/Resource.cpp
     ${ENGINE_DIR}/framework/Resource.h
     ${ENGINE_DIR}/framework/System.cpp
@@ -223,7 +230,10 @@ endif()
 
 # Tests runnable for any engine variant
 set(ENGINETESTLIST ${COMMONTESTLIST}
+    ${ENGINE_DIR}/framework/CommandBufferHostTest.cpp
     ${ENGINE_DIR}/framework/CommandSystemTest.cpp
+    ${ENGINE_DIR}/framework/LogSystemTest.cpp
+    ${ENGINE_DIR}/framework/ProfilerSystemTest.cpp
 )
 
 set(QCOMMONLIST
@@ -247,6 +257,17 @@ set(QCOMMONLIST
     ${ENGINE_DIR}/qcommon/translation.cpp
 )
 
+# Tests for engine variants built with QCOMMONLIST
+set(QCOMMONTESTLIST
+    ${ENGINE_DIR}/qcommon/huffman_test.cpp
+    ${ENGINE_DIR}/qcommon/net_ip_test.cpp
+)
+
+# Tests for engine variants built with SERVERLIST
+set(SERVERTESTLIST
+    ${ENGINE_DIR}/server/sv_snapshot_test.cpp
+)
+
 if (USE_CURSES)
     set(ENGINELIST ${ENGINELIST}
         ${ENGINE_DIR}/sys/con_curses.cpp
@@ -256,6 +277,7 @@ endif()
 set(CLIENTBASELIST
     ${ENGINE_DIR}/client/cg_api.h
     ${ENGINE_DIR}/client/cg_msgdef.h
+    ${ENGINE_DIR}/client/cg_snapshot_ring.h
     ${ENGINE_DIR}/client/client.h
     ${ENGINE_DIR}/client/cl_avi.cpp
     ${ENGINE_DIR}/client/cl_cgame.cpp
@@ -306,6 +328,9 @@ if (YOKAI_TARGET_SYSTEM_MACOS)
 endif()
 
 set(CLIENTTESTLIST ${ENGINETESTLIST}
+    ${ENGINE_DIR}/audio/SoundCodecTest.cpp
+    ${ENGINE_DIR}/client/cg_skeleton_batch_test.cpp
+    ${ENGINE_DIR}/client/cg_snapshot_ring_test.cpp
 )
 
 set(TTYCLIENTLIST
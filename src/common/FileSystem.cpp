@@ -29,6 +29,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #if defined(BUILD_ENGINE)
+#include <atomic>
+#include <thread>
 #include "minizip/unzip.h"
 #endif
 
@@ -134,6 +136,7 @@ namespace FS {
 static Cvar::Cvar<bool> fs_legacypaks("fs_legacypaks", "also load pk3s, ignoring version", Cvar::NONE, false);
 static Cvar::Cvar<int> fs_maxSymlinkDepth("fs_maxSymlinkDepth", "max depth of symlinks in zip paks (0 means disabled)", Cvar::NONE, 1);
 static Cvar::Cvar<std::string> fs_pakprefixes("fs_pakprefixes", "prefixes to look for paks to load", 0, "");
+static Cvar::Cvar<bool> fs_pakIndexCache("fs_pakIndexCache", "cache the file lists of dpks in the homepath", Cvar::NONE, true);
 
 bool UseLegacyPaks()
 {
@@ -274,6 +277,26 @@ inline int my_stat(Str::StringRef path, my_stat_t* st)
 	return stat(path.c_str(), st);
 #endif
 }
+// Latest of the modification and status change times, with the sub-second
+// part where the platform has it
+inline std::chrono::system_clock::time_point my_timestamp(const my_stat_t& st)
+{
+#if defined(__APPLE__) || defined(__linux__) || defined(__FreeBSD__)
+#ifdef __APPLE__
+	const struct timespec& mtime = st.st_mtimespec;
+	const struct timespec& ctime = st.st_ctimespec;
+#else
+	const struct timespec& mtime = st.st_mtim;
+	const struct timespec& ctime = st.st_ctim;
+#endif
+	bool useMtime = mtime.tv_sec > ctime.tv_sec || (mtime.tv_sec == ctime.tv_sec && mtime.tv_nsec > ctime.tv_nsec);
+	const struct timespec& time = useMtime ? mtime : ctime;
+	return std::chrono::system_clock::from_time_t(time.tv_sec)
+		+ std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time.tv_nsec));
+#else
+	return std::chrono::system_clock::from_time_t(std::max(st.st_ctime, st.st_mtime));
+#endif
+}
 inline intptr_t my_pread(int fd, void* buf, size_t count, offset_t offset)
 {
 #ifdef _WIN32
@@ -605,7 +628,7 @@ std::chrono::system_clock::time_point File::Timestamp(std::error_code& err) cons
 		return {};
 	} else {
 		ClearErrorCode(err);
-		return std::chrono::system_clock::from_time_t(std::max(st.st_ctime, st.st_mtime));
+		return my_timestamp(st);
 	}
 }
 void File::SeekCur(offset_t off, std::error_code& err) const
@@ -981,6 +1004,18 @@ public:
 		return fileInfo.uncompressed_size;
 	}
 
+	// Get the position in the archive of the data of the currently open file,
+	// if it is stored without compression or encryption and can therefore be
+	// read directly from the archive.
+	Util::optional<offset_t> StoredFileOffset() const
+	{
+		unz_file_info64 fileInfo;
+		int result = unzGetCurrentFileInfo64(zipFile, &fileInfo, nullptr, 0, nullptr, 0, nullptr, 0);
+		if (result != UNZ_OK || fileInfo.compression_method != 0 || (fileInfo.flag & 1))
+			return {};
+		return offset_t(unzGetCurrentFileZStreamPos64(zipFile));
+	}
+
 	// Read from the currently open file
 	size_t ReadFile(void* buffer, size_t length, std::error_code& err) const
 	{
@@ -1165,7 +1200,9 @@ static void InternalLoadPak(
 
 // Parse the dependencies file of a package
 // Each line of the dependencies file is a name followed by an optional version
-static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::StringRef prefix, std::error_code& err)
+// Callback signature: bool(const std::string& name, const std::string& version)
+// where the version is empty if not specified, returning false to stop parsing
+template<typename Func> static void ForEachDep(const PakInfo& parent, Str::StringRef depsData, bool warn, Func&& func)
 {
 	auto lineStart = depsData.begin();
 	int line = 0;
@@ -1191,22 +1228,7 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 		while (lineStart != lineEnd && Str::cisspace(*lineStart))
 			lineStart++;
 
-		// If this is the end of the line, load a package by name
-		if (lineStart == lineEnd) {
-			const PakInfo* pak = FindPak(name);
-			if (!pak) {
-				fsLogs.Warn("Could not find pak '%s' required by '%s'", name, parent.path);
-				SetErrorCodeFilesystem(err, filesystem_error::missing_dependency);
-				return;
-			}
-			InternalLoadPak(*pak, Util::nullopt, prefix, true, err);
-			if (err)
-				return;
-			lineStart = lineEnd == depsData.end() ? lineEnd : lineEnd + 1;
-			continue;
-		}
-
-		// Read the package version
+		// Read the package version, if any
 		std::string version;
 		while (lineStart != lineEnd && !Str::cisspace(*lineStart))
 			version.push_back(*lineStart++);
@@ -1215,27 +1237,39 @@ static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::Strin
 		while (lineStart != lineEnd && Str::cisspace(*lineStart))
 			lineStart++;
 
-		// If this is the end of the line, load a package with an explicit version
+		// If this is the end of the line, load the package
 		if (lineStart == lineEnd) {
-			const PakInfo* pak = FindPak(name, version);
-			if (!pak) {
-				fsLogs.Warn("Could not find pak '%s' with version '%s' required by '%s'", name, version, parent.path);
-				SetErrorCodeFilesystem(err, filesystem_error::missing_dependency);
-				return;
-			}
-			InternalLoadPak(*pak, Util::nullopt, prefix, true, err);
-			if (err)
+			if (!func(name, version))
 				return;
 			lineStart = lineEnd == depsData.end() ? lineEnd : lineEnd + 1;
 			continue;
 		}
 
 		// If there is still stuff at the end of the line, print a warning and ignore it
-		fsLogs.Warn("Invalid dependency specification on line %d in %s", line, Path::Build(parent.path, PAK_DEPS_FILE));
+		if (warn)
+			fsLogs.Warn("Invalid dependency specification on line %d in %s", line, Path::Build(parent.path, PAK_DEPS_FILE));
 		lineStart = lineEnd == depsData.end() ? lineEnd : lineEnd + 1;
 	}
 }
 
+// Load the dependencies of a package
+static void ParseDeps(const PakInfo& parent, Str::StringRef depsData, Str::StringRef prefix, std::error_code& err)
+{
+	ForEachDep(parent, depsData, true, [&](const std::string& name, const std::string& version) {
+		const PakInfo* pak = version.empty() ? FindPak(name) : FindPak(name, version);
+		if (!pak) {
+			if (version.empty())
+				fsLogs.Warn("Could not find pak '%s' required by '%s'", name, parent.path);
+			else
+				fsLogs.Warn("Could not find pak '%s' with version '%s' required by '%s'", name, version, parent.path);
+			SetErrorCodeFilesystem(err, filesystem_error::missing_dependency);
+			return false;
+		}
+		InternalLoadPak(*pak, Util::nullopt, prefix, true, err);
+		return !err;
+	});
+}
+
 /* The code is expected to be only reliable for ignoring deleted files
 in dependencies. For example if the unvanquished_0.52.2.dpk pak lists the
 scripts/colors.shader file in the DELETED file and has unvanquished_0.52.1.dpk
@@ -1259,25 +1293,399 @@ static bool FileIsDeleted(const PakInfo& pak, Str::StringRef filename)
 	return deletedFileSet.find(std::pair<std::string, std::string>(pak.name, filename)) != deletedFileSet.end();
 }
 
-static void InternalLoadPak(
-	const PakInfo& pak, Util::optional<uint32_t> expectedChecksum, Str::StringRef pathPrefix,
-	bool loadDeps, std::error_code& err)
-{
-	Util::optional<uint32_t> realChecksum;
+// File list of a pak, read before loading it. Reading it doesn't touch the
+// state of the filesystem, so a pak and its dependencies can be indexed on
+// several threads before being loaded one after the other in order.
+struct PakIndex {
+	struct Entry {
+		std::string filename;
+		offset_t offset; // Position within the zip archive (unused for PAK_DIR)
+		uint32_t crc;
+		bool valid;
+	};
+	std::vector<Entry> files;
+	uint32_t checksum = 0; // Checksum of all file checksums, for an empty path prefix
 	bool hasDeleted = false;
-	offset_t deletedOffset = 0;
+	std::string deletedData;
 	bool hasDeps = false;
+	std::string depsData;
+	std::error_code err;
+};
+
+// Indexes of the paks being loaded by the outermost InternalLoadPak call
+static std::unordered_map<std::string, PakIndex> pakIndexes;
+
+static const char PAK_INDEX_CACHE_MAGIC[] = "DAEMON_PAK_INDEX_2";
+
+static std::string PakIndexCachePath(const PakInfo& pak)
+{
+	uint32_t hash = crc32(0, reinterpret_cast<const Bytef*>(pak.path.data()), pak.path.size());
+	return Str::Format("cache/paks/%s-%08x.index", Path::BaseNameStripExtension(pak.path), hash);
+}
+
+// Modification time of a pak at the finest resolution the platform has, so
+// that a pak rewritten within the same second isn't taken for the cached one
+static uint64_t PakModificationTime(const PakInfo& pak, const my_stat_t& st)
+{
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetFileAttributesExW(Str::UTF8To16(pak.path).c_str(), GetFileExInfoStandard, &attributes))
+		return uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+	return st.st_mtime;
+#elif defined(__APPLE__)
+	Q_UNUSED(pak);
+	return uint64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	Q_UNUSED(pak);
+	return uint64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+// Read the index of a zip pak from the cache in the homepath, if it was
+// written for the same path, modification time and size
+static bool ReadPakIndexCache(const PakInfo& pak, const my_stat_t& st, PakIndex& index)
+{
+	std::error_code err;
+	File file = HomePath::OpenRead(PakIndexCachePath(pak), err);
+	if (err)
+		return false;
+	std::string data = file.ReadAll(err);
+	if (err)
+		return false;
+
+	size_t pos = 0;
+	bool ok = true;
+	auto getInt = [&](size_t bytes) -> uint64_t {
+		if (!ok || data.size() - pos < bytes) {
+			ok = false;
+			return 0;
+		}
+		uint64_t value = 0;
+		for (size_t i = 0; i < bytes; i++)
+			value |= uint64_t(static_cast<unsigned char>(data[pos++])) << (8 * i);
+		return value;
+	};
+	auto getString = [&]() -> std::string {
+		size_t length = getInt(4);
+		if (!ok || data.size() - pos < length) {
+			ok = false;
+			return "";
+		}
+		pos += length;
+		return data.substr(pos - length, length);
+	};
+
+	if (getString() != PAK_INDEX_CACHE_MAGIC || getString() != pak.path
+	    || getInt(8) != PakModificationTime(pak, st) || getInt(8) != uint64_t(st.st_size))
+		return false;
+	index.checksum = getInt(4);
+	index.hasDeleted = getInt(1);
+	index.deletedData = getString();
+	index.hasDeps = getInt(1);
+	index.depsData = getString();
+	size_t numFiles = getInt(4);
+	// Each entry takes at least 17 bytes, don't trust the count any further
+	if (!ok || numFiles > (data.size() - pos) / 17)
+		return false;
+	index.files.resize(numFiles);
+	for (PakIndex::Entry& entry: index.files) {
+		entry.filename = getString();
+		entry.offset = getInt(8);
+		entry.crc = getInt(4);
+		entry.valid = getInt(1);
+	}
+	return ok && pos == data.size();
+}
+
+// Indexes kept for the paks that aren't available anymore, such as the older
+// versions of an updated pak or the paks of another pak path
+static const size_t MAX_STALE_PAK_INDEXES = 8;
+
+// Delete the indexes of the paks that went away, except for the newest ones
+static void PrunePakIndexCache()
+{
+	std::unordered_set<std::string> available;
+	for (const PakInfo& pak: availablePaks)
+		available.insert(Path::Build("cache/paks", Path::BaseName(PakIndexCachePath(pak))));
+
+	std::vector<std::pair<std::chrono::system_clock::time_point, std::string>> stale;
+	std::error_code err;
+	for (const std::string& filename: HomePath::ListFiles("cache/paks", err)) {
+		std::string path = Path::Build("cache/paks", filename);
+		if (!Str::IsSuffix(".index", filename) || available.count(path))
+			continue;
+		auto timestamp = HomePath::FileTimestamp(path, err);
+		if (!err)
+			stale.emplace_back(timestamp, std::move(path));
+	}
+	if (stale.size() <= MAX_STALE_PAK_INDEXES)
+		return;
+
+	// The oldest first
+	std::sort(stale.begin(), stale.end());
+	for (size_t i = 0; i < stale.size() - MAX_STALE_PAK_INDEXES; i++) {
+		fsLogs.Debug("Deleting the old pak index %s", stale[i].second);
+		HomePath::DeleteFile(stale[i].second, err);
+	}
+}
+
+static void WritePakIndexCache(const PakInfo& pak, const my_stat_t& st, const PakIndex& index)
+{
+	std::string data;
+	auto putInt = [&data](uint64_t value, size_t bytes) {
+		for (size_t i = 0; i < bytes; i++)
+			data.push_back(static_cast<char>(value >> (8 * i)));
+	};
+	auto putString = [&](Str::StringRef str) {
+		putInt(str.size(), 4);
+		data.append(str.data(), str.size());
+	};
+
+	putString(PAK_INDEX_CACHE_MAGIC);
+	putString(pak.path);
+	putInt(PakModificationTime(pak, st), 8);
+	putInt(st.st_size, 8);
+	putInt(index.checksum, 4);
+	putInt(index.hasDeleted, 1);
+	putString(index.deletedData);
+	putInt(index.hasDeps, 1);
+	putString(index.depsData);
+	putInt(index.files.size(), 4);
+	for (const PakIndex::Entry& entry: index.files) {
+		putString(entry.filename);
+		putInt(entry.offset, 8);
+		putInt(entry.crc, 4);
+		putInt(entry.valid, 1);
+	}
+
+	// Written to a temporary file first so that a reader never sees a partial
+	// index. It would be rejected anyway, so errors can be ignored.
+	std::string cachePath = PakIndexCachePath(pak);
+	std::string tempPath = cachePath + ".tmp";
+	std::error_code err;
+	{
+		File file = HomePath::OpenWrite(tempPath, err);
+		if (!err)
+			file.Write(data.data(), data.size(), err);
+		if (!err)
+			file.Close(err);
+	}
+	if (!err)
+		HomePath::MoveFile(cachePath, tempPath, err);
+}
+
+static std::string ReadZipEntry(ZipArchive& zipFile, offset_t offset, std::error_code& err)
+{
+	zipFile.OpenFile(offset, err);
+	if (err)
+		return "";
+	offset_t length = zipFile.FileLength(err);
+	if (err)
+		return "";
+	std::string data;
+	data.resize(length);
+	auto read = zipFile.ReadFile(&data[0], length, err);
+	data.resize(read);
+	return data;
+}
+
+static void IndexZipArchive(const PakInfo& pak, ZipArchive& zipFile, PakIndex& index)
+{
+	std::error_code& err = index.err;
+	bool isLegacy = pak.version.empty();
+	offset_t deletedOffset = 0;
 	offset_t depsOffset = 0;
-	ZipArchive zipFile;
+
+	// Get the file list and calculate the checksum of the package (checksum of all file checksums)
+	index.checksum = crc32(0, Z_NULL, 0);
+	zipFile.ForEachFile([&](Str::StringRef filename, offset_t offset, uint32_t crc) {
+		// Note that 'return' is effectively 'continue' since we are in a lambda
+		if (Str::IsSuffix("/", filename))
+			return;
+		bool valid = Path::IsValid(filename, false);
+		index.files.push_back({filename, offset, crc, valid});
+		if (!valid)
+			return;
+
+		// Legacy paks don't have version neither checksum
+		if (!isLegacy) {
+			index.checksum = crc32(index.checksum, reinterpret_cast<const Bytef*>(&crc), sizeof(crc));
+		}
+
+		if (!isLegacy && filename == PAK_DELETED_FILE) {
+			index.hasDeleted = true;
+			deletedOffset = offset;
+		} else if (!isLegacy && filename == PAK_DEPS_FILE) {
+			index.hasDeps = true;
+			depsOffset = offset;
+		}
+	}, err);
+	if (err)
+		return;
+
+	if (index.hasDeleted) {
+		index.deletedData = ReadZipEntry(zipFile, deletedOffset, err);
+		if (err)
+			return;
+	}
+	if (index.hasDeps)
+		index.depsData = ReadZipEntry(zipFile, depsOffset, err);
+}
+
+static void IndexPakDir(const PakInfo& pak, PakIndex& index)
+{
+	std::error_code& err = index.err;
 	bool isLegacy = pak.version.empty();
 
-	// Check if this pak has already been loaded to avoid recursive dependencies
+	auto dirRange = RawPath::ListFilesRecursive(pak.path, err);
+	if (err)
+		return;
+	for (auto it = dirRange.begin(); it != dirRange.end();) {
+		if (!isLegacy && *it == PAK_DELETED_FILE) {
+			index.hasDeleted = true;
+		}
+		else if (!isLegacy && *it == PAK_DEPS_FILE) {
+			index.hasDeps = true;
+		}
+		else if (!Str::IsSuffix("/", *it)) {
+			index.files.push_back({*it, 0, 0, true});
+		}
+		it.increment(err);
+		if (err)
+			return;
+	}
+
+	if (index.hasDeleted) {
+		File deletedFile = RawPath::OpenRead(Path::Build(pak.path, PAK_DELETED_FILE), err);
+		if (err)
+			return;
+		index.deletedData = deletedFile.ReadAll(err);
+		if (err)
+			return;
+	}
+	if (index.hasDeps) {
+		File depsFile = RawPath::OpenRead(Path::Build(pak.path, PAK_DEPS_FILE), err);
+		if (err)
+			return;
+		index.depsData = depsFile.ReadAll(err);
+	}
+}
+
+// Read the file list of a pak. This may run on any thread. Returns whether
+// a new index was written to the cache.
+static bool IndexPak(const PakInfo& pak, bool useCache, PakIndex& index)
+{
+	if (pak.type == pakType_t::PAK_DIR) {
+		IndexPakDir(pak, index);
+		return false;
+	}
+
+	my_stat_t st;
+	bool cacheable = useCache && my_stat(pak.path, &st) == 0;
+	if (cacheable && ReadPakIndexCache(pak, st, index))
+		return false;
+	index = PakIndex();
+
+	int fd = my_open(pak.path, openMode_t::MODE_READ);
+	if (fd == -1) {
+		SetErrorCodeSystem(index.err);
+		return false;
+	}
+	{
+		ZipArchive zipFile = ZipArchive::Open(fd, index.err);
+		if (!index.err)
+			IndexZipArchive(pak, zipFile, index);
+	}
+	close(fd);
+
+	if (!cacheable || index.err)
+		return false;
+	WritePakIndexCache(pak, st, index);
+	return true;
+}
+
+static bool PakIsLoaded(const PakInfo& pak, Str::StringRef pathPrefix)
+{
 	for (auto& x: loadedPaks) {
 		// If the prefix is a superset of our current prefix, then it already
 		// includes all the files we care about.
 		if (x.path == pak.path && Str::IsPrefix(x.pathPrefix, pathPrefix))
-			return;
+			return true;
 	}
+	return false;
+}
+
+// Index a pak and all its dependencies into pakIndexes. The dependency tree
+// is walked a level at a time, with the paks of a level indexed in parallel.
+static void IndexPakWithDeps(const PakInfo& root, Str::StringRef pathPrefix, bool loadDeps)
+{
+	bool useCache = fs_pakIndexCache.Get();
+	std::vector<const PakInfo*> level = {&root};
+	while (!level.empty()) {
+		std::vector<const PakInfo*> paks;
+		std::vector<PakIndex*> indexes;
+		for (const PakInfo* pak: level) {
+			if (pakIndexes.count(pak->path) || (pak != &root && PakIsLoaded(*pak, pathPrefix)))
+				continue;
+			paks.push_back(pak);
+			indexes.push_back(&pakIndexes[pak->path]);
+		}
+
+		std::atomic<size_t> next(0);
+		std::atomic<bool> written(false);
+		auto worker = [&] {
+			for (size_t i; (i = next++) < paks.size();) {
+				if (IndexPak(*paks[i], useCache, *indexes[i]))
+					written = true;
+			}
+		};
+		size_t numThreads = std::min<size_t>(paks.size(), std::max(1u, std::thread::hardware_concurrency()));
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < numThreads; i++)
+			threads.emplace_back(worker);
+		worker();
+		for (std::thread& thread: threads)
+			thread.join();
+		if (written)
+			PrunePakIndexCache();
+
+		// Find the paks of the next level, missing ones are reported when loading
+		level.clear();
+		if (!loadDeps)
+			break;
+		for (size_t i = 0; i < paks.size(); i++) {
+			if (indexes[i]->err || !indexes[i]->hasDeps)
+				continue;
+			ForEachDep(*paks[i], indexes[i]->depsData, false, [&level](const std::string& name, const std::string& version) {
+				const PakInfo* pak = version.empty() ? FindPak(name) : FindPak(name, version);
+				if (pak)
+					level.push_back(pak);
+				return true;
+			});
+		}
+	}
+}
+
+static void LoadIndexedPak(
+	const PakInfo& pak, Util::optional<uint32_t> expectedChecksum, Str::StringRef pathPrefix,
+	bool loadDeps, std::error_code& err)
+{
+	Util::optional<uint32_t> realChecksum;
+	bool isLegacy = pak.version.empty();
+
+	// Check if this pak has already been loaded to avoid recursive dependencies
+	if (PakIsLoaded(pak, pathPrefix))
+		return;
+
+	// Dependencies are usually indexed ahead, but not if they were skipped
+	// because they were already loaded with a different prefix
+	auto it = pakIndexes.find(pak.path);
+	if (it == pakIndexes.end()) {
+		it = pakIndexes.emplace(pak.path, PakIndex()).first;
+		if (IndexPak(pak, fs_pakIndexCache.Get(), it->second))
+			PrunePakIndexCache();
+	}
+	const PakIndex& index = it->second;
 
 	if (pak.type == pakType_t::PAK_ZIP) {
 		if (!isLegacy) {
@@ -1302,31 +1710,24 @@ static void InternalLoadPak(
 	loadedPak.checksum = pak.checksum;
 	loadedPak.type = pak.type;
 	loadedPak.path = pak.path;
+	loadedPak.fd = -1;
+
+	if (index.err) {
+		SetErrorCode(err, index.err.value(), index.err.category());
+		return;
+	}
 
 	// Update the list of files, but don't overwrite existing files, so the sort order is preserved
 	if (pak.type == pakType_t::PAK_DIR) {
-		loadedPak.fd = -1;
-		auto dirRange = RawPath::ListFilesRecursive(pak.path, err);
-		if (err)
-			return;
-		for (auto it = dirRange.begin(); it != dirRange.end();) {
-			if (!isLegacy && *it == PAK_DELETED_FILE) {
-				hasDeleted = true;
-			}
-			else if (!isLegacy && *it == PAK_DEPS_FILE) {
-				hasDeps = true;
+		for (const PakIndex::Entry& entry: index.files) {
+			if (!Str::IsPrefix(pathPrefix, entry.filename))
+				continue;
+			if (FileIsDeleted(pak, entry.filename)) {
+				Log::Debug("Ignoring deleted file %s from %s", entry.filename, pak.path);
 			}
-			else if (!Str::IsSuffix("/", *it) && Str::IsPrefix(pathPrefix, *it)) {
-				if (FileIsDeleted(pak, *it)) {
-					Log::Debug("Ignoring deleted file %s from %s", *it, pak.path);
-				}
-				else {
-					fileMap.emplace(*it, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, 0));
-				}
+			else {
+				fileMap.emplace(entry.filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, 0));
 			}
-			it.increment(err);
-			if (err)
-				return;
 		}
 	} else if (pak.type == pakType_t::PAK_ZIP) {
 		// Open file
@@ -1336,51 +1737,35 @@ static void InternalLoadPak(
 			return;
 		}
 
-		// Open zip
-		zipFile = ZipArchive::Open(loadedPak.fd, err);
-		if (err)
-			return;
-
-		// Get the file list and calculate the checksum of the package (checksum of all file checksums)
-		realChecksum = crc32(0, Z_NULL, 0);
-		zipFile.ForEachFile([&pak, &realChecksum, &pathPrefix, &hasDeps, &hasDeleted, &depsOffset, &deletedOffset, &isLegacy](Str::StringRef filename, offset_t offset, uint32_t crc) {
-			// Note that 'return' is effectively 'continue' since we are in a lambda
-			if (!Str::IsPrefix(pathPrefix, filename)
-				&& filename != PAK_DELETED_FILE
-				&& filename != PAK_DEPS_FILE)
-				return;
-			if (Str::IsSuffix("/", filename))
-				return;
-			if (!Path::IsValid(filename, false)) {
-				fsLogs.Warn("Invalid filename '%s' in pak '%s'", filename, pak.path);
-				return;
+		// The checksum only covers the files in the prefix, it's only computed ahead for the whole pak
+		realChecksum = index.checksum;
+		if (!pathPrefix.empty())
+			realChecksum = crc32(0, Z_NULL, 0);
+		for (const PakIndex::Entry& entry: index.files) {
+			if (!Str::IsPrefix(pathPrefix, entry.filename)
+				&& entry.filename != PAK_DELETED_FILE
+				&& entry.filename != PAK_DEPS_FILE)
+				continue;
+			if (!entry.valid) {
+				fsLogs.Warn("Invalid filename '%s' in pak '%s'", entry.filename, pak.path);
+				continue;
 			}
 
 			// Legacy paks don't have version neither checksum
-			if (!isLegacy) {
-				realChecksum = crc32(*realChecksum, reinterpret_cast<const Bytef*>(&crc), sizeof(crc));
+			if (!isLegacy && !pathPrefix.empty()) {
+				realChecksum = crc32(*realChecksum, reinterpret_cast<const Bytef*>(&entry.crc), sizeof(entry.crc));
 			}
 
-			if (!isLegacy && filename == PAK_DELETED_FILE) {
-				hasDeleted = true;
-				deletedOffset = offset;
-				return;
-			}
-			else if (!isLegacy && filename == PAK_DEPS_FILE) {
-				hasDeps = true;
-				depsOffset = offset;
-				return;
-			}
+			if (!isLegacy && (entry.filename == PAK_DELETED_FILE || entry.filename == PAK_DEPS_FILE))
+				continue;
 
-			if (FileIsDeleted(pak, filename)) {
-				Log::Debug("Ignoring deleted file %s from %s", filename, pak.path);
+			if (FileIsDeleted(pak, entry.filename)) {
+				Log::Debug("Ignoring deleted file %s from %s", entry.filename, pak.path);
 			}
 			else {
-				fileMap.emplace(filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, offset));
+				fileMap.emplace(entry.filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, entry.offset));
 			}
-		}, err);
-		if (err)
-			return;
+		}
 	} else {
 		ASSERT_UNREACHABLE();
 	}
@@ -1388,7 +1773,7 @@ static void InternalLoadPak(
 	// Save the real checksum in the list of loaded paks (empty for directories, not used for legacy paks)
 	loadedPak.realChecksum = realChecksum;
 
-	// Get the timestamp of the pak, but only for dpk files. 
+	// Get the timestamp of the pak, but only for dpk files.
 	// Directories (aka a dpkdir) don't need timestamp.
 	// Fixes Windows bug where calling _wstat64i with trailing slash causes "file not found" error.
 	// For future stat calls on directories, trim the trailing slash (if exists)
@@ -1416,61 +1801,36 @@ static void InternalLoadPak(
 	// Load deleted file list
 	// Do not look for deleted file list if it's a legacy pak (pk3)
 	if (!isLegacy) {
-		if (hasDeleted) {
-			std::string deletedData;
-			if (pak.type == pakType_t::PAK_DIR) {
-				File depsFile = RawPath::OpenRead(Path::Build(pak.path, PAK_DELETED_FILE), err);
-				if (err)
-					return;
-				deletedData = depsFile.ReadAll(err);
-				if (err)
-					return;
-			} else if (pak.type == pakType_t::PAK_ZIP) {
-				zipFile.OpenFile(deletedOffset, err);
-				if (err)
-					return;
-				offset_t length = zipFile.FileLength(err);
-				if (err)
-					return;
-				deletedData.resize(length);
-				auto read = zipFile.ReadFile(&deletedData[0], length, err);
-				deletedData.resize(read);
-				if (err)
-					return;
-			} else {
-				ASSERT_UNREACHABLE();
-			}
-			ParseDeleted(pak, deletedData);
-		}
+		if (index.hasDeleted)
+			ParseDeleted(pak, index.deletedData);
 
 		// Load dependencies (non-legacy paks (pk3) only)
-		if (loadDeps && hasDeps) {
-			std::string depsData;
-			if (pak.type == pakType_t::PAK_DIR) {
-				File depsFile = RawPath::OpenRead(Path::Build(pak.path, PAK_DEPS_FILE), err);
-				if (err)
-					return;
-				depsData = depsFile.ReadAll(err);
-				if (err)
-					return;
-			} else if (pak.type == pakType_t::PAK_ZIP) {
-				zipFile.OpenFile(depsOffset, err);
-				if (err)
-					return;
-				offset_t length = zipFile.FileLength(err);
-				if (err)
-					return;
-				depsData.resize(length);
-				auto read = zipFile.ReadFile(&depsData[0], length, err);
-				depsData.resize(read);
-				if (err)
-					return;
-			} else {
-				ASSERT_UNREACHABLE();
-			}
-			ParseDeps(pak, depsData, pathPrefix, err);
-		}
+		if (loadDeps && index.hasDeps)
+			ParseDeps(pak, index.depsData, pathPrefix, err);
+	}
+}
+
+static void InternalLoadPak(
+	const PakInfo& pak, Util::optional<uint32_t> expectedChecksum, Str::StringRef pathPrefix,
+	bool loadDeps, std::error_code& err)
+{
+	// Dependencies are loaded by recursive calls, with the indexes read ahead
+	if (!pakIndexes.empty()) {
+		LoadIndexedPak(pak, expectedChecksum, pathPrefix, loadDeps, err);
+		return;
+	}
+
+	// The outermost call indexes the pak and its dependencies in parallel first
+	if (PakIsLoaded(pak, pathPrefix))
+		return;
+	IndexPakWithDeps(pak, pathPrefix, loadDeps);
+	try {
+		LoadIndexedPak(pak, expectedChecksum, pathPrefix, loadDeps, err);
+	} catch (...) {
+		pakIndexes.clear();
+		throw;
 	}
+	pakIndexes.clear();
 }
 
 void LoadPak(const PakInfo& pak, std::error_code& err)
@@ -1528,23 +1888,68 @@ const std::vector<LoadedPakInfo>& GetLoadedPaks()
 }
 
 #ifdef BUILD_VM
+// Read a range of a file received from the engine and close it
+static bool ReadFileRange(const IPC::FileHandle& handle, offset_t offset, void* buffer, size_t length)
+{
+	int fd = handle.GetHandle();
+	char* out = static_cast<char*>(buffer);
+#ifdef __native_client__
+	// NaCl has no pread and the descriptor is only used by this thread
+	bool ok = lseek(fd, offset, SEEK_SET) != -1;
+#else
+	bool ok = true;
+#endif
+	while (ok && length != 0) {
+#ifdef __native_client__
+		intptr_t result = read(fd, out, length);
+#else
+		intptr_t result = my_pread(fd, out, length, offset);
+#endif
+		if (result <= 0) {
+			ok = false;
+			break;
+		}
+		out += result;
+		offset += result;
+		length -= result;
+	}
+#ifdef _WIN32
+	_close(fd);
+#else
+	close(fd);
+#endif
+	return ok;
+}
+
 std::string ReadFile(Str::StringRef path, std::error_code& err) {
-	// The VM has a list of all the pak files, so this may save a round trip
-	// if the file doesn't exist, as well as allowing a more specific error.
-	// It may be wrong if more paks are loaded after initialization though?
-	int length, h;
-	VM::SendMsg<VM::FSOpenPakFileReadMsg>(path, length, h);
-	if (!h) {
-		SetErrorCodeFilesystem(err, filesystem_error::no_such_file, path);
+	PROFILE_ZONE("FS::PakPath::ReadFile");
+
+	// The engine tells us where the content is instead of sending it through
+	// the socket: a range of a pakdir file or of a dpk for stored entries, or
+	// a shared memory region holding the inflated content of the others.
+	int error;
+	Util::optional<IPC::FileHandle> handle;
+	uint64_t offset, length;
+	Util::optional<IPC::SharedMemory> shm;
+	VM::SendMsg<VM::FSPakPathOpenFileMsg>(path, error, handle, offset, shm, length);
+	if (error != Util::ordinal(filesystem_error::no_filesystem_error)) {
+		SetErrorCodeFilesystem(err, static_cast<filesystem_error>(error), path);
 		return "";
 	}
+
 	std::string content;
-	int lengthRead;
-	VM::SendMsg<VM::FSReadMsg>(h, length, content, lengthRead);
-	VM::SendMsg<VM::FSFCloseFileMsg>(h);
-	if (lengthRead != length) {
-		SetErrorCodeFilesystem(err, filesystem_error::io_error, path);
-		return "";
+	content.resize(length);
+	if (handle) {
+		if (!ReadFileRange(*handle, offset, &content[0], length)) {
+			SetErrorCodeFilesystem(err, filesystem_error::io_error, path);
+			return "";
+		}
+	} else if (length != 0) {
+		if (!shm || shm->GetSize() < length) {
+			SetErrorCodeFilesystem(err, filesystem_error::io_error, path);
+			return "";
+		}
+		memcpy(&content[0], shm->GetBase(), length);
 	}
 	ClearErrorCode(err);
 	return content;
@@ -1554,6 +1959,8 @@ std::string ReadFile(Str::StringRef path, std::error_code& err) {
 #ifdef BUILD_ENGINE
 std::string ReadFile(Str::StringRef path, std::error_code& err)
 {
+	PROFILE_ZONE("FS::PakPath::ReadFile");
+
 	auto it = fileMap.find(path);
 	if (it == fileMap.end()) {
 		SetErrorCodeFilesystem(err, filesystem_error::no_such_file, path);
@@ -1659,6 +2066,66 @@ void CopyFile(Str::StringRef path, const File& dest, std::error_code& err)
 		ASSERT_UNREACHABLE();
 	}
 }
+
+VMFileContent OpenFileForVM(Str::StringRef path, std::error_code& err)
+{
+	VMFileContent out;
+	auto it = fileMap.find(path);
+	if (it == fileMap.end()) {
+		SetErrorCodeFilesystem(err, filesystem_error::no_such_file, path);
+		return out;
+	}
+
+	const LoadedPakInfo& pak = loadedPaks[it->second.first];
+	if (pak.type == pakType_t::PAK_DIR) {
+		out.file = RawPath::OpenRead(Path::Build(pak.path, it->first), err);
+		if (err)
+			return out;
+		out.length = out.file.Length(err);
+		if (err)
+			return out;
+		out.handle = IPC::FileHandle(fileno(out.file.GetHandle()), IPC::FileOpenMode::MODE_READ);
+		return out;
+	} else if (pak.type == pakType_t::PAK_ZIP) {
+		// Open zip
+		ZipArchive zipFile = ZipArchive::Open(pak.fd, err);
+		if (err)
+			return out;
+
+		// Open file in zip
+		out.length = zipFile.OpenFileWithSymlinkResolution(it->first, it->second.second, err);
+		if (err)
+			return out;
+
+		// Stored files are read by the VM straight from the archive. Their CRC
+		// is not checked since that would require reading them here as well.
+		Util::optional<offset_t> offset = zipFile.StoredFileOffset();
+		if (offset) {
+			std::error_code ignored;
+			zipFile.CloseFile(ignored);
+			out.handle = IPC::FileHandle(pak.fd, IPC::FileOpenMode::MODE_READ);
+			out.offset = *offset;
+			return out;
+		}
+
+		// Inflate compressed files into shared memory
+		if (out.length != 0) {
+			out.shm = IPC::SharedMemory::Create(out.length);
+			zipFile.ReadFile(out.shm.GetBase(), out.length, err);
+			if (err) {
+				std::error_code ignored;
+				zipFile.CloseFile(ignored);
+				return out;
+			}
+		}
+
+		// Close file and check for CRC errors
+		zipFile.CloseFile(err);
+		return out;
+	}
+
+	ASSERT_UNREACHABLE();
+}
 #endif //BUILD_ENGINE
 
 bool FileExists(Str::StringRef path)
@@ -1919,7 +2386,7 @@ std::chrono::system_clock::time_point FileTimestamp(Str::StringRef path, std::er
 		return {};
 	} else {
 		ClearErrorCode(err);
-		return std::chrono::system_clock::from_time_t(std::max(st.st_ctime, st.st_mtime));
+		return my_timestamp(st);
 	}
 }
 
@@ -2982,6 +3449,31 @@ void HandleFileSystemSyscall(int minor, Util::Reader& reader, IPC::Channel& chan
 		});
 		break;
 
+	case VM::FS_PAKPATH_OPENFILE:
+	{
+		// Declared here so that a pakdir file stays open until the reply is sent
+		PakPath::VMFileContent content;
+		IPC::HandleMsg<VM::FSPakPathOpenFileMsg>(channel, std::move(reader), [&content](std::string path, int& error,
+		                                                                                Util::optional<IPC::FileHandle>& handle, uint64_t& offset,
+		                                                                                Util::optional<IPC::SharedMemory>& shm, uint64_t& length) {
+			std::error_code err;
+			content = PakPath::OpenFileForVM(path, err);
+			offset = content.offset;
+			length = content.length;
+			if (err) {
+				filesystem_error ec = err.category() == filesystem_category() ? static_cast<filesystem_error>(err.value()) : filesystem_error::io_error;
+				error = Util::ordinal(ec);
+				return;
+			}
+			error = Util::ordinal(filesystem_error::no_filesystem_error);
+			if (content.handle)
+				handle = content.handle;
+			if (content.shm)
+				shm = std::move(content.shm);
+		});
+		break;
+	}
+
 	default:
 		Sys::Drop("Bad filesystem syscall number '%d' for VM '%s'", minor, vmName);
 	}
@@ -343,6 +343,21 @@ namespace PakPath {
 	// Copy an entire file to another file
 	void CopyFile(Str::StringRef path, const File& dest, std::error_code& err = throws());
 
+#ifdef BUILD_ENGINE
+	// Where a VM reads the content of a file from, so that it isn't copied
+	// through the IPC socket: a range of an open file for pakdirs and for zip
+	// entries stored without compression, or a shared memory region holding
+	// the inflated content of the other zip entries.
+	struct VMFileContent {
+		File file; // the pakdir file, to be kept open until the handle is sent
+		IPC::FileHandle handle;
+		offset_t offset = 0;
+		IPC::SharedMemory shm;
+		offset_t length = 0;
+	};
+	VMFileContent OpenFileForVM(Str::StringRef path, std::error_code& err = throws());
+#endif
+
 	// Check if a file exists
 	// BEWARE: this doesn't work inside a VM if a pak was loaded after the VM starts!
 	bool FileExists(Str::StringRef path);
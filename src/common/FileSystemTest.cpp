@@ -33,6 +33,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "common/FileSystem.h"
 
+#ifdef BUILD_ENGINE
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <zlib.h>
+#endif
+
 namespace FS {
 namespace {
     class FileSystemTest : public ::testing::Test
@@ -62,5 +69,268 @@ namespace {
         ASSERT_EQ(contents, "test2");
     }
 
+#ifdef BUILD_ENGINE
+    std::string ReadVMFileContent(PakPath::VMFileContent& content)
+    {
+        std::string out(content.length, '\0');
+        if (content.handle) {
+            EXPECT_EQ(pread(content.handle.GetHandle(), &out[0], out.size(), content.offset), ssize_t(out.size()));
+        } else if (content.length != 0) {
+            EXPECT_GE(content.shm.GetSize(), content.length);
+            memcpy(&out[0], content.shm.GetBase(), out.size());
+        }
+        return out;
+    }
+
+    TEST_F(FileSystemTest, OpenFileForVMZipStored)
+    {
+        PakPath::VMFileContent content = PakPath::OpenFileForVM("test2.txt");
+        ASSERT_TRUE(content.handle);
+        ASSERT_FALSE(content.shm);
+        ASSERT_EQ(ReadVMFileContent(content), "test2");
+    }
+
+    TEST_F(FileSystemTest, OpenFileForVMDir)
+    {
+        PakPath::VMFileContent content = PakPath::OpenFileForVM("test1.txt");
+        ASSERT_TRUE(content.file);
+        ASSERT_TRUE(content.handle);
+        ASSERT_EQ(content.offset, 0u);
+        ASSERT_EQ(ReadVMFileContent(content), "test1");
+    }
+
+    TEST_F(FileSystemTest, OpenFileForVMMissing)
+    {
+        std::error_code err;
+        PakPath::OpenFileForVM("nonexistent.txt", err);
+        ASSERT_EQ(err, std::error_code(Util::ordinal(filesystem_error::no_such_file), filesystem_category()));
+    }
+
+    // Writes a dpk with the given files, each either stored or deflated
+    void WriteTestDpk(const File& out, const std::vector<std::pair<std::string, std::string>>& files, bool compress)
+    {
+        std::string data, centralDir;
+        auto put = [](std::string& s, uint32_t value, int bytes) {
+            for (int i = 0; i < bytes; i++)
+                s.push_back(char(value >> (8 * i)));
+        };
+        for (auto& file : files) {
+            std::string compressed = file.second;
+            if (compress) {
+                z_stream stream{};
+                deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                compressed.resize(deflateBound(&stream, file.second.size()));
+                stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(file.second.data()));
+                stream.avail_in = file.second.size();
+                stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+                stream.avail_out = compressed.size();
+                ::deflate(&stream, Z_FINISH);
+                compressed.resize(stream.total_out);
+                deflateEnd(&stream);
+            }
+            uint32_t crc = crc32(0, reinterpret_cast<const Bytef*>(file.second.data()), file.second.size());
+            uint32_t localOffset = data.size();
+
+            std::string common;
+            put(common, 20, 2); // version needed
+            put(common, 0, 2); // flags
+            put(common, compress ? Z_DEFLATED : 0, 2); // method
+            put(common, 0, 4); // time and date
+            put(common, crc, 4);
+            put(common, compressed.size(), 4);
+            put(common, file.second.size(), 4);
+            put(common, file.first.size(), 2);
+            put(common, 0, 2); // extra length
+
+            put(data, 0x04034b50, 4);
+            data += common + file.first + compressed;
+
+            put(centralDir, 0x02014b50, 4);
+            put(centralDir, 20, 2); // version made by
+            centralDir += common;
+            put(centralDir, 0, 2); // comment length
+            put(centralDir, 0, 2); // disk number
+            put(centralDir, 0, 2); // internal attributes
+            put(centralDir, 0, 4); // external attributes
+            put(centralDir, localOffset, 4);
+            centralDir += file.first;
+        }
+        uint32_t centralDirOffset = data.size();
+        data += centralDir;
+        put(data, 0x06054b50, 4);
+        put(data, 0, 4); // disk numbers
+        put(data, files.size(), 2);
+        put(data, files.size(), 2);
+        put(data, centralDir.size(), 4);
+        put(data, centralDirOffset, 4);
+        put(data, 0, 2); // comment length
+        out.Write(data.data(), data.size());
+    }
+
+    TEST_F(FileSystemTest, PakIndexCache)
+    {
+        WriteTestDpk(HomePath::OpenWrite("pkg/indexcache_0.dpk"), {{"a/1.txt", "1"}, {"b/2.txt", "2"}}, true);
+        RefreshPaks();
+        const PakInfo* pak = FindPak("indexcache", "0");
+        ASSERT_NE(pak, nullptr);
+
+        // Indexed from the archive
+        PakPath::LoadPakPrefix(*pak, "a/");
+        ASSERT_EQ(PakPath::ReadFile("a/1.txt"), "1");
+        ASSERT_FALSE(PakPath::FileExists("b/2.txt"));
+        ASSERT_TRUE(HomePath::ListFiles("cache/paks").begin() != HomePath::ListFiles("cache/paks").end());
+
+        // Indexed from the cache
+        PakPath::LoadPak(*pak);
+        ASSERT_EQ(PakPath::ReadFile("b/2.txt"), "2");
+    }
+
+    TEST_F(FileSystemTest, PakIndexCacheRewrittenPak)
+    {
+        WriteTestDpk(HomePath::OpenWrite("pkg/indexcache2_0.dpk"), {{"c/3.txt", "3"}}, false);
+        RefreshPaks();
+        const PakInfo* pak = FindPak("indexcache2", "0");
+        ASSERT_NE(pak, nullptr);
+        PakPath::LoadPak(*pak);
+        uint32_t checksum = *PakPath::LocateFile("c/3.txt")->realChecksum;
+
+        // Same size and within the same second, only longer than the
+        // granularity of the filesystem timestamps
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        WriteTestDpk(HomePath::OpenWrite("pkg/indexcache2_0.dpk"), {{"c/3.txt", "4"}}, false);
+        PakPath::ClearPaks();
+        pak = FindPak("indexcache2", "0");
+        ASSERT_NE(pak, nullptr);
+        PakPath::LoadPak(*pak);
+        EXPECT_NE(*PakPath::LocateFile("c/3.txt")->realChecksum, checksum);
+        EXPECT_EQ(PakPath::ReadFile("c/3.txt"), "4");
+
+        PakPath::ClearPaks();
+        SetUpTestSuite();
+    }
+
+    TEST_F(FileSystemTest, PakIndexCachePruned)
+    {
+        // Indexes of paks that went away, from the oldest to the newest
+        std::vector<std::string> stale;
+        for (int i = 0; i < 12; i++) {
+            stale.push_back(Str::Format("cache/paks/gone%d-00000000.index", i));
+            HomePath::OpenWrite(stale.back()).Write("x", 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        WriteTestDpk(HomePath::OpenWrite("pkg/indexcache3_0.dpk"), {{"d/4.txt", "4"}}, false);
+        RefreshPaks();
+        const PakInfo* pak = FindPak("indexcache3", "0");
+        ASSERT_NE(pak, nullptr);
+        PakPath::LoadPak(*pak);
+
+        // Only the newest stale indexes are kept, along with the new one
+        for (size_t i = 0; i < stale.size(); i++) {
+            EXPECT_EQ(i >= stale.size() - 8, HomePath::FileExists(stale[i])) << stale[i];
+        }
+        bool indexed = false;
+        for (const std::string& filename : HomePath::ListFiles("cache/paks")) {
+            if (Str::IsPrefix("indexcache3_0-", filename) && Str::IsSuffix(".index", filename))
+                indexed = true;
+        }
+        EXPECT_TRUE(indexed);
+
+        PakPath::ClearPaks();
+        SetUpTestSuite();
+    }
+
+#if defined(__APPLE__) || defined(__linux__) || defined(__FreeBSD__)
+    // The caches of data derived from pakdir files are keyed on the timestamps
+    TEST_F(FileSystemTest, SubSecondTimestamp)
+    {
+        HomePath::OpenWrite("timestamp.txt").Write("1", 1);
+        auto before = HomePath::FileTimestamp("timestamp.txt");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        HomePath::OpenWrite("timestamp.txt").Write("2", 1);
+        EXPECT_LT(before, HomePath::FileTimestamp("timestamp.txt"));
+        HomePath::DeleteFile("timestamp.txt");
+    }
+#endif
+
+    // Compares sending the content of the files of a large dpk through the IPC
+    // socket as the VMs used to with sending a handle or shared memory region.
+    TEST_F(FileSystemTest, DISABLED_VMReadBenchmark)
+    {
+        using Clock = std::chrono::steady_clock;
+        constexpr int numFiles = 32;
+        constexpr size_t fileSize = 4 << 20;
+
+        std::mt19937 rng(42);
+        std::vector<std::pair<std::string, std::string>> files;
+        for (int i = 0; i < numFiles; i++) {
+            std::string content(fileSize, '\0');
+            // Half random like already compressed images and sounds, half compressible
+            for (char& c : content)
+                c = i % 2 ? char(rng()) : char('a' + rng() % 4);
+            files.emplace_back(Str::Format("bench/%d.bin", i), std::move(content));
+        }
+
+        for (bool compress : {false, true}) {
+            std::string name = compress ? "vmbenchdeflated" : "vmbenchstored";
+            WriteTestDpk(HomePath::OpenWrite(Path::Build("pkg", name + "_0.dpk")), files, compress);
+            RefreshPaks();
+            const PakInfo* pak = FindPak(name, "0");
+            ASSERT_NE(pak, nullptr);
+            PakPath::LoadPak(*pak);
+
+            auto sockets = IPC::Socket::CreatePair();
+            auto time = [&](const char* method, auto&& send, auto&& recv) {
+                auto start = Clock::now();
+                std::thread receiver([&] {
+                    for (int i = 0; i < numFiles; i++) {
+                        Util::Reader reader = sockets.second.RecvMsg();
+                        EXPECT_EQ(recv(reader), files[i].second);
+                    }
+                });
+                for (int i = 0; i < numFiles; i++)
+                    send(files[i].first);
+                receiver.join();
+                std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+                Log::Notice("%s %s: %.2f ms", compress ? "deflated" : "stored", method, elapsed.count());
+            };
+
+            time("socket", [&](const std::string& path) {
+                Util::Writer writer;
+                writer.Write<std::string>(PakPath::ReadFile(path));
+                sockets.first.SendMsg(writer);
+            }, [](Util::Reader& reader) {
+                return reader.Read<std::string>();
+            });
+
+            time("handle", [&](const std::string& path) {
+                PakPath::VMFileContent content = PakPath::OpenFileForVM(path);
+                Util::Writer writer;
+                writer.Write<Util::optional<IPC::FileHandle>>(content.handle ? Util::optional<IPC::FileHandle>(content.handle) : Util::nullopt);
+                writer.Write<uint64_t>(content.offset);
+                writer.Write<Util::optional<IPC::SharedMemory>>(content.shm ? Util::optional<IPC::SharedMemory>(std::move(content.shm)) : Util::nullopt);
+                writer.Write<uint64_t>(content.length);
+                sockets.first.SendMsg(writer);
+            }, [](Util::Reader& reader) {
+                PakPath::VMFileContent content;
+                auto handle = reader.Read<Util::optional<IPC::FileHandle>>();
+                content.offset = reader.Read<uint64_t>();
+                auto shm = reader.Read<Util::optional<IPC::SharedMemory>>();
+                content.length = reader.Read<uint64_t>();
+                if (handle)
+                    content.handle = *handle;
+                if (shm)
+                    content.shm = std::move(*shm);
+                std::string out = ReadVMFileContent(content);
+                if (handle)
+                    close(handle->GetHandle());
+                return out;
+            });
+
+            HomePath::DeleteFile(Path::Build("pkg", name + "_0.dpk"));
+        }
+    }
+#endif
+
 } // namespace
 } // namespace FS
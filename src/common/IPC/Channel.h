@@ -145,6 +145,8 @@ namespace IPC {
                 Sys::Drop("Attempting to send a Message in VM toplevel with id: 0x%x", Message::id);
 
             Util::Writer writer;
+            writer.Reserve(sizeof(uint32_t) + Util::SerializedSizeHint(Util::TypeListFromTuple<typename Message::Inputs>()));
+            writer.BeginGather();
             writer.Write<uint32_t>(Message::id);
             writer.WriteArgs(Util::TypeListFromTuple<typename Message::Inputs>(), std::forward<Args>(args)...);
             channel.SendMsg(writer);
@@ -158,6 +160,8 @@ namespace IPC {
                 Sys::Drop("Attempting to send a SyncMessage while handling a Message or in VM toplevel with id: 0x%x", Message::id);
 
             Util::Writer writer;
+            writer.Reserve(sizeof(uint32_t) + Util::SerializedSizeHint(Util::TypeListFromTuple<typename Message::Inputs>()));
+            writer.BeginGather();
             writer.Write<uint32_t>(Message::id);
             writer.WriteArgs(Util::TypeListFromTuple<typename Message::Inputs>(), std::forward<Args>(args)...);
             channel.SendMsg(writer);
@@ -219,6 +223,8 @@ namespace IPC {
             channel.canSendAsyncMsg = oldAsync;
 
             Util::Writer writer;
+            writer.Reserve(sizeof(uint32_t) + Util::SerializedSizeHint(Util::TypeListFromTuple<typename Message::Outputs>()));
+            writer.BeginGather();
             writer.Write<uint32_t>(ID_RETURN);
             writer.WriteTuple(Util::TypeListFromTuple<typename Message::Outputs>(), std::move(outputs));
             channel.SendMsg(writer);
@@ -0,0 +1,147 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <thread>
+#include <gtest/gtest.h>
+#include "common/Common.h"
+#include "Channel.h"
+#include "CommonSyscalls.h"
+
+namespace IPC {
+namespace {
+
+using EchoMsg = SyncMessage<Message<Id<VM::QVM, 1>, std::string>, Reply<std::string>>;
+using EchoMapMsg = SyncMessage<Message<Id<VM::QVM, 2>, std::map<std::string, std::string>>, Reply<std::map<std::string, std::string>>>;
+using QuitMsg = Message<Id<VM::QVM, 3>>;
+
+// Answers the messages sent to the other end of a socket pair on a thread,
+// like a VM would.
+class ChannelTest : public testing::Test {
+protected:
+    ChannelTest() {
+        auto sockets = Socket::CreatePair();
+        channel = Channel(std::move(sockets.first));
+        echo = std::thread([this](Channel remote) {
+            while (true) {
+                Util::Reader reader = remote.RecvMsg();
+                uint32_t id = reader.Read<uint32_t>();
+                if (id == EchoMsg::id) {
+                    HandleMsg<EchoMsg>(remote, std::move(reader), [](std::string in, std::string& out) {
+                        out = std::move(in);
+                    });
+                } else if (id == EchoMapMsg::id) {
+                    HandleMsg<EchoMapMsg>(remote, std::move(reader), [](std::map<std::string, std::string> in, std::map<std::string, std::string>& out) {
+                        out = std::move(in);
+                    });
+                } else {
+                    break;
+                }
+            }
+        }, Channel(std::move(sockets.second)));
+    }
+
+    ~ChannelTest() {
+        Send<QuitMsg>();
+        echo.join();
+    }
+
+    template<typename Msg, typename... Args> void Send(Args&&... args) {
+        SendMsg<Msg>(channel, [](uint32_t, Util::Reader) {
+            FAIL() << "Unexpected message";
+        }, std::forward<Args>(args)...);
+    }
+
+    std::string Echo(const std::string& in) {
+        std::string out;
+        Send<EchoMsg>(in, out);
+        return out;
+    }
+
+    Channel channel;
+    std::thread echo;
+};
+
+std::string MakeString(size_t size) {
+    std::string out(size, '\0');
+    for (size_t i = 0; i < size; i++)
+        out[i] = 'a' + i % 26;
+    return out;
+}
+
+TEST_F(ChannelTest, Gather)
+{
+    // Sizes around the gathering threshold and the 4K datagram size
+    for (size_t size : {0, 10, 1023, 1024, 4092, 4096, 5000, 300000}) {
+        std::string in = MakeString(size);
+        EXPECT_EQ(Echo(in), in);
+    }
+}
+
+TEST_F(ChannelTest, GatherConvertedArgument)
+{
+    // The const char* and the const keys of the map entries are converted to
+    // temporaries that must be copied, not referenced.
+    std::string big = MakeString(3000);
+    std::string out;
+    Send<EchoMsg>(big.c_str(), out);
+    EXPECT_EQ(out, big);
+
+    std::map<std::string, std::string> in = {{big, "x"}, {"y", big}}, mapOut;
+    Send<EchoMapMsg>(in, mapOut);
+    EXPECT_EQ(mapOut, in);
+}
+
+TEST_F(ChannelTest, PooledBuffers)
+{
+    std::string in = MakeString(100);
+    Echo(in);
+    size_t misses = Util::BufferPoolMisses();
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(Echo(in), in);
+    EXPECT_EQ(Util::BufferPoolMisses(), misses);
+}
+
+TEST_F(ChannelTest, DISABLED_Benchmark)
+{
+    constexpr int ROUNDS = 20000;
+    for (size_t size : {16, 1000, 65536}) {
+        std::string in = MakeString(size);
+        size_t misses = Util::BufferPoolMisses();
+        auto start = Sys::SteadyClock::now();
+        for (int i = 0; i < ROUNDS; i++)
+            Echo(in);
+        std::chrono::duration<double, std::micro> elapsed = Sys::SteadyClock::now() - start;
+        Log::Notice("%d bytes: %.2f us per round trip, %.3f buffers allocated per message",
+            size, elapsed.count() / ROUNDS, double(Util::BufferPoolMisses() - misses) / ROUNDS);
+    }
+}
+
+} // namespace
+} // namespace IPC
@@ -88,6 +88,24 @@ namespace IPC {
         InternalWrite(writerOffset_ + offset, in, len);
     }
 
+    void CommandBuffer::BeginWrite(Util::Writer& writer, size_t offset) {
+        size_t maxLength = GetMaxWriteLength();
+        if (offset < maxLength) {
+            writer.BeginRing(base_ + DATA_OFFSET, size_, Normalize(writerOffset_ + offset), maxLength - offset);
+        }
+    }
+
+    void CommandBuffer::ReadInPlace(Util::Reader& reader, size_t len, size_t offset) {
+        size_t start = Normalize(readerOffset_ + offset + SAFETY_OFFSET);
+        if (start + len <= size_) {
+            reader.SetInPlaceData(base_ + DATA_OFFSET + start, len);
+        } else {
+            std::vector<char>& readerData = reader.GetData();
+            readerData.resize(len);
+            InternalRead(start, readerData.data(), len);
+        }
+    }
+
     void CommandBuffer::AdvanceReadPointer(size_t offset) {
         // TODO assert that offset is < size
         // Realign the offset to be a multiple of 4
@@ -76,6 +76,15 @@ namespace IPC {
         void Read(char* out, size_t len, size_t offset = 0);
         void Write(const char* in, size_t len, size_t offset = 0);
 
+        // Zero-copy variants of the above: the writer serializes directly in the
+        // free space starting at offset from the write pointer, and the reader
+        // deserializes len bytes starting at offset from the read pointer in
+        // place (they are only copied if they wrap around the end of the
+        // buffer). The read pointer must not be advanced past the data before
+        // the reader is done with it.
+        void BeginWrite(Util::Writer& writer, size_t offset = 0);
+        void ReadInPlace(Util::Reader& reader, size_t len, size_t offset = 0);
+
         // Advances the pointers and makes the update visible to the other end.
         // Make sure read advances correspond to write advances as the pointers
         // are re-aligned on advance.
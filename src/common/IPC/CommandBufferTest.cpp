@@ -0,0 +1,272 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+#include "common/Common.h"
+#include "CommandBuffer.h"
+
+namespace IPC {
+namespace {
+
+// Typical renderer commands sent by the cgame
+struct PolyVert {
+    float xyz[3];
+    float st[2];
+    uint8_t modulate[4];
+};
+using DrawStretchPicMsg = Message<Id<VM::QVM, 1>, float, float, float, float, float, float, float, float, int>;
+using AddLightToSceneMsg = Message<Id<VM::QVM, 2>, std::array<float, 3>, float, float, float, float, int>;
+using AddPolyToSceneMsg = Message<Id<VM::QVM, 3>, int, std::vector<PolyVert>>;
+
+class CommandBufferTest : public testing::Test {
+protected:
+    void Init(size_t dataSize) {
+        memory.assign((CommandBuffer::DATA_OFFSET + dataSize) / sizeof(uint64_t), 0);
+        client.Init(memory.data(), memory.size() * sizeof(uint64_t));
+        client.Reset();
+        host.Init(memory.data(), memory.size() * sizeof(uint64_t));
+    }
+
+    // Same as CommandBufferClient::SendMsg, returns false if the message was
+    // too big and had to be moved out of the buffer.
+    template<typename Msg, typename... Args> bool Send(Util::Writer& writer, Args&&... args) {
+        client.LoadReaderData();
+        client.BeginWrite(writer, sizeof(uint32_t));
+        writer.Write<uint32_t>(Msg::id);
+        writer.WriteArgs(Util::TypeListFromTuple<typename Msg::Inputs>(), std::forward<Args>(args)...);
+        if (!writer.InRing()) {
+            return false;
+        }
+
+        uint32_t size = writer.GetRingLength();
+        client.Write((char*)&size, sizeof(uint32_t));
+        client.AdvanceWritePointer(size + sizeof(uint32_t));
+        return true;
+    }
+
+    // Same as CommandBufferHost::ConsumeOne
+    bool Receive(Util::Reader& reader, size_t& length) {
+        host.LoadWriterData();
+        if (!host.CanRead(sizeof(uint32_t))) {
+            return false;
+        }
+        uint32_t size;
+        host.Read((char*)&size, sizeof(uint32_t));
+        EXPECT_TRUE(host.CanRead(size + sizeof(uint32_t)));
+        host.ReadInPlace(reader, size, sizeof(uint32_t));
+        length = size + sizeof(uint32_t);
+        return true;
+    }
+
+    static std::vector<PolyVert> MakePoly(int numVerts) {
+        std::vector<PolyVert> verts(numVerts);
+        for (int i = 0; i < numVerts; i++) {
+            verts[i] = {{1.0f * i, 2.0f * i, 3.0f * i}, {0.5f, 0.25f}, {1, 2, 3, uint8_t(i)}};
+        }
+        return verts;
+    }
+
+    std::vector<uint64_t> memory;
+    CommandBuffer client;
+    CommandBuffer host;
+};
+
+TEST_F(CommandBufferTest, InPlaceRoundTrip)
+{
+    Init(4096);
+    int inPlaceReads = 0, copiedReads = 0;
+
+    // Go around the ring many times with messages of various sizes so that
+    // they get split at the end of the buffer in every possible way.
+    for (int round = 0; round < 200; round++) {
+        Util::Writer pic, light, poly;
+        ASSERT_TRUE(Send<DrawStretchPicMsg>(pic, 1.0f, 2.0f, 3.0f, 4.0f, 0.0f, 0.0f, 1.0f, 1.0f, round));
+        ASSERT_TRUE(Send<AddLightToSceneMsg>(light, std::array<float, 3>{{1.0f, 2.0f, 3.0f}}, 300.0f, 1.0f, 0.5f, 0.25f, round));
+        ASSERT_TRUE(Send<AddPolyToSceneMsg>(poly, round, MakePoly(round % 7)));
+
+        for (int i = 0; i < 3; i++) {
+            Util::Reader reader;
+            size_t length;
+            ASSERT_TRUE(Receive(reader, length));
+            if (reader.GetData().empty()) {
+                inPlaceReads++;
+            } else {
+                copiedReads++;
+            }
+
+            uint32_t id = reader.Read<uint32_t>();
+            if (i == 0) {
+                EXPECT_EQ(DrawStretchPicMsg::id, id);
+                for (float expected : {1.0f, 2.0f, 3.0f, 4.0f, 0.0f, 0.0f, 1.0f, 1.0f}) {
+                    EXPECT_EQ(expected, reader.Read<float>());
+                }
+                EXPECT_EQ(round, reader.Read<int>());
+            } else if (i == 1) {
+                EXPECT_EQ(AddLightToSceneMsg::id, id);
+                auto origin = reader.Read<std::array<float, 3>>();
+                EXPECT_EQ(3.0f, origin[2]);
+                EXPECT_EQ(300.0f, reader.Read<float>());
+                EXPECT_EQ(1.0f, reader.Read<float>());
+                EXPECT_EQ(0.5f, reader.Read<float>());
+                EXPECT_EQ(0.25f, reader.Read<float>());
+                EXPECT_EQ(round, reader.Read<int>());
+            } else {
+                EXPECT_EQ(AddPolyToSceneMsg::id, id);
+                EXPECT_EQ(round, reader.Read<int>());
+                auto verts = reader.Read<std::vector<PolyVert>>();
+                ASSERT_EQ(static_cast<size_t>(round % 7), verts.size());
+                for (size_t v = 0; v < verts.size(); v++) {
+                    EXPECT_EQ(2.0f * v, verts[v].xyz[1]);
+                    EXPECT_EQ(v, verts[v].modulate[3]);
+                }
+            }
+            reader.CheckEndRead();
+            host.AdvanceReadPointer(length);
+        }
+
+        Util::Reader reader;
+        size_t length;
+        EXPECT_FALSE(Receive(reader, length));
+    }
+
+    EXPECT_GT(inPlaceReads, 0);
+    EXPECT_GT(copiedReads, 0);
+}
+
+TEST_F(CommandBufferTest, MessageTooBig)
+{
+    Init(1024);
+
+    // Fill the buffer until a message doesn't fit
+    int sent = 0;
+    Util::Writer writer;
+    while (Send<AddPolyToSceneMsg>(writer, sent, MakePoly(5))) {
+        writer = Util::Writer();
+        sent++;
+    }
+    EXPECT_GT(sent, 0);
+
+    // The message that didn't fit is complete in the writer
+    Util::Reader tooBig;
+    tooBig.GetData() = writer.GetData();
+    EXPECT_EQ(AddPolyToSceneMsg::id, tooBig.Read<uint32_t>());
+    EXPECT_EQ(sent, tooBig.Read<int>());
+    EXPECT_EQ(5U, tooBig.Read<std::vector<PolyVert>>().size());
+    tooBig.CheckEndRead();
+
+    // The messages that fit can still be read
+    for (int i = 0; i < sent; i++) {
+        Util::Reader reader;
+        size_t length;
+        ASSERT_TRUE(Receive(reader, length));
+        reader.Read<uint32_t>();
+        EXPECT_EQ(i, reader.Read<int>());
+        reader.Read<std::vector<PolyVert>>();
+        host.AdvanceReadPointer(length);
+    }
+}
+
+TEST_F(CommandBufferTest, DISABLED_Benchmark)
+{
+    constexpr int ROUNDS = 2000;
+    constexpr int COMMANDS_PER_ROUND = 999;
+    Init(2 * 1024 * 1024);
+    std::vector<PolyVert> poly = MakePoly(4);
+
+    for (bool inPlace : {false, true}) {
+        auto start = Sys::SteadyClock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            for (int i = 0; i < COMMANDS_PER_ROUND; i += 3) {
+                if (inPlace) {
+                    Util::Writer pic, light, polys;
+                    Send<DrawStretchPicMsg>(pic, 1.0f, 2.0f, 3.0f, 4.0f, 0.0f, 0.0f, 1.0f, 1.0f, i);
+                    Send<AddLightToSceneMsg>(light, std::array<float, 3>{{1.0f, 2.0f, 3.0f}}, 300.0f, 1.0f, 0.5f, 0.25f, i);
+                    Send<AddPolyToSceneMsg>(polys, i, poly);
+                } else {
+                    // What the command buffer used to do: serialize in a
+                    // vector then copy it in the buffer.
+                    Util::Writer writers[3];
+                    writers[0].Write<uint32_t>(DrawStretchPicMsg::id);
+                    writers[0].WriteArgs(Util::TypeListFromTuple<DrawStretchPicMsg::Inputs>(), 1.0f, 2.0f, 3.0f, 4.0f, 0.0f, 0.0f, 1.0f, 1.0f, i);
+                    writers[1].Write<uint32_t>(AddLightToSceneMsg::id);
+                    writers[1].WriteArgs(Util::TypeListFromTuple<AddLightToSceneMsg::Inputs>(), std::array<float, 3>{{1.0f, 2.0f, 3.0f}}, 300.0f, 1.0f, 0.5f, 0.25f, i);
+                    writers[2].Write<uint32_t>(AddPolyToSceneMsg::id);
+                    writers[2].WriteArgs(Util::TypeListFromTuple<AddPolyToSceneMsg::Inputs>(), i, poly);
+                    for (auto& writer : writers) {
+                        uint32_t size = writer.GetData().size();
+                        client.LoadReaderData();
+                        client.Write((char*)&size, sizeof(uint32_t));
+                        client.Write(writer.GetData().data(), size, sizeof(uint32_t));
+                        client.AdvanceWritePointer(size + sizeof(uint32_t));
+                    }
+                }
+            }
+
+            while (true) {
+                Util::Reader reader;
+                size_t length;
+                if (inPlace) {
+                    if (!Receive(reader, length)) {
+                        break;
+                    }
+                } else {
+                    host.LoadWriterData();
+                    if (!host.CanRead(sizeof(uint32_t))) {
+                        break;
+                    }
+                    uint32_t size;
+                    host.Read((char*)&size, sizeof(uint32_t));
+                    reader.GetData().resize(size);
+                    host.Read(reader.GetData().data(), size, sizeof(uint32_t));
+                    length = size + sizeof(uint32_t);
+                }
+
+                uint32_t id = reader.Read<uint32_t>();
+                if (id == DrawStretchPicMsg::id) {
+                    std::tuple<float, float, float, float, float, float, float, float, int> args;
+                    reader.FillTuple<0>(Util::TypeListFromTuple<DrawStretchPicMsg::Inputs>(), args);
+                } else if (id == AddLightToSceneMsg::id) {
+                    std::tuple<std::array<float, 3>, float, float, float, float, int> args;
+                    reader.FillTuple<0>(Util::TypeListFromTuple<AddLightToSceneMsg::Inputs>(), args);
+                } else {
+                    std::tuple<int, std::vector<PolyVert>> args;
+                    reader.FillTuple<0>(Util::TypeListFromTuple<AddPolyToSceneMsg::Inputs>(), args);
+                }
+                host.AdvanceReadPointer(length);
+            }
+        }
+        double time = std::chrono::duration<double>(Sys::SteadyClock::now() - start).count();
+
+        Log::Notice("%s: %.0f commands/s", inPlace ? "in place" : "copied", ROUNDS * COMMANDS_PER_ROUND / time);
+    }
+}
+
+} // namespace
+} // namespace IPC
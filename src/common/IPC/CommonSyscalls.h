@@ -155,6 +155,7 @@ namespace VM {
         CREATE_SHARED_MEMORY,
         CRASH_DUMP,
         GET_LOCAL_TIME_OFFSET,
+        PROFILER_LOCATE,
     };
 
     // CreateSharedMemoryMsg
@@ -171,6 +172,10 @@ namespace VM {
         IPC::Message<IPC::Id<MISC, EngineMiscMessages::GET_LOCAL_TIME_OFFSET>>,
         IPC::Reply<int>
     >;
+    // ProfilerLocateMsg
+    using ProfilerLocateMsg = IPC::SyncMessage<
+        IPC::Message<IPC::Id<MISC, EngineMiscMessages::PROFILER_LOCATE>, IPC::SharedMemory>
+    >;
 
     enum VMMiscMessages {
         GET_NETCODE_TABLES,
@@ -261,7 +266,8 @@ namespace VM {
         FS_HOMEPATH_LISTFILES,
         FS_HOMEPATH_LISTFILESRECURSIVE,
         FS_PAKPATH_TIMESTAMP,
-        FS_PAKPATH_LOADPAK
+        FS_PAKPATH_LOADPAK,
+        FS_PAKPATH_OPENFILE
     };
 
     using FSInitializeMsg = IPC::SyncMessage<
@@ -299,6 +305,12 @@ namespace VM {
     using FSPakPathLoadPakMsg = IPC::SyncMessage<
         IPC::Message<IPC::Id<FILESYSTEM, FS_PAKPATH_LOADPAK>, uint32_t, Util::optional<uint32_t>, std::string, bool>
     >;
+    // Where the VM reads a pak file from: filesystem_error, the file holding the content
+    // and its offset in it, or a shared memory region holding the content, and the length
+    using FSPakPathOpenFileMsg = IPC::SyncMessage<
+        IPC::Message<IPC::Id<FILESYSTEM, FS_PAKPATH_OPENFILE>, std::string>,
+        IPC::Reply<int, Util::optional<IPC::FileHandle>, uint64_t, Util::optional<IPC::SharedMemory>, uint64_t>
+    >;
 
 }
 
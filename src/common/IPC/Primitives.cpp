@@ -205,10 +205,13 @@ Socket Socket::FromHandle(Sys::OSHandle handle)
 	return out;
 }
 
-static void InternalSendMsg(Sys::OSHandle handle, bool more, const FileDesc* handles, size_t numHandles, const void* data, size_t len)
+// Maximum number of separate pieces of data in a single datagram
+static const size_t MAX_DATA_IOV = 16;
+
+static void InternalSendMsg(Sys::OSHandle handle, bool more, const FileDesc* handles, size_t numHandles, const NaClIOVec* data, size_t numData)
 {
 	NaClMessageHeader hdr;
-	NaClIOVec iov[4];
+	NaClIOVec iov[3 + MAX_DATA_IOV];
 
 	NaClHandle h[NACL_ABI_IMC_DESC_MAX];
 	for (size_t i = 0; i < numHandles; i++) {
@@ -219,14 +222,13 @@ static void InternalSendMsg(Sys::OSHandle handle, bool more, const FileDesc* han
 
 #ifdef __native_client__
 	hdr.iov = iov;
-	hdr.iov_length = 2;
+	hdr.iov_length = 1 + numData;
 	hdr.handles = h;
 	hdr.handle_count = numHandles;
 	hdr.flags = 0;
 	iov[0].base = &more;
 	iov[0].length = 1;
-	iov[1].base = const_cast<void*>(data);
-	iov[1].length = len;
+	std::copy(data, data + numData, &iov[1]);
 	if (NaClSendDatagram(handle, &hdr, 0) == -1) {
 		char error[256];
 		NaClGetLastErrorString(error, sizeof(error));
@@ -272,7 +274,7 @@ static void InternalSendMsg(Sys::OSHandle handle, bool more, const FileDesc* han
 
 	NaClInternalHeader internalHdr = {{NACL_HANDLE_TRANSFER_PROTOCOL, static_cast<uint32_t>(descBytes)}, {}};
 	hdr.iov = iov;
-	hdr.iov_length = 4;
+	hdr.iov_length = 3 + numData;
 	hdr.handles = h;
 	hdr.handle_count = numHandles;
 	hdr.flags = 0;
@@ -282,8 +284,7 @@ static void InternalSendMsg(Sys::OSHandle handle, bool more, const FileDesc* han
 	iov[1].length = descBytes;
 	iov[2].base = &more;
 	iov[2].length = 1;
-	iov[3].base = const_cast<void*>(data);
-	iov[3].length = len;
+	std::copy(data, data + numData, &iov[3]);
 
 	if (NaClSendDatagram(handle, &hdr, 0) == -1) {
 		char error[256];
@@ -297,20 +298,57 @@ void Socket::SendMsg(const Util::Writer& writer) const
 {
 	const FileDesc* handles = writer.GetHandles().data();
 	size_t numHandles = writer.GetHandles().size();
-	const void* data = writer.GetData().data();
-	size_t len = writer.GetData().size();
+
+	// Split the message into the bytes of the writer and the large blobs it
+	// only references, which are then sent without being copied.
+	const char* data = writer.GetData().data();
+	const std::vector<Util::Writer::GatherRef>& refs = writer.GetGatherRefs();
+	NaClIOVec inlineSegment;
+	std::vector<NaClIOVec> gatherSegments;
+	const NaClIOVec* segments = &inlineSegment;
+	inlineSegment.base = const_cast<char*>(data);
+	inlineSegment.length = writer.GetData().size();
+	if (!refs.empty()) {
+		size_t offset = 0;
+		for (const Util::Writer::GatherRef& ref : refs) {
+			if (ref.offset != offset)
+				gatherSegments.push_back({const_cast<char*>(data + offset), ref.offset - offset});
+			gatherSegments.push_back({const_cast<char*>(ref.data), ref.len});
+			offset = ref.offset;
+		}
+		if (offset != writer.GetData().size())
+			gatherSegments.push_back({const_cast<char*>(data + offset), writer.GetData().size() - offset});
+		segments = gatherSegments.data();
+	}
+	size_t len = writer.GetSize();
 
 	// Use a smaller buffer size to avoid ENOBUFS errors from the kernel
 	// NaCl defines NACL_ABI_IMC_USER_BYTES_MAX as 128K, use 4K instead
 	const size_t MAX_IPC_BYTES = 4 << 10;
 
+	size_t segmentPos = 0;
 	while (numHandles || len) {
-		bool more = numHandles > NACL_ABI_IMC_DESC_MAX || len > MAX_IPC_BYTES;
-		InternalSendMsg(handle, more, handles, std::min<size_t>(numHandles, NACL_ABI_IMC_DESC_MAX), data, std::min<size_t>(len, MAX_IPC_BYTES));
+		NaClIOVec iov[MAX_DATA_IOV];
+		size_t numIov = 0;
+		size_t datagramBytes = 0;
+		while (numIov < MAX_DATA_IOV && datagramBytes < MAX_IPC_BYTES && datagramBytes < len) {
+			size_t bytes = std::min(segments->length - segmentPos, MAX_IPC_BYTES - datagramBytes);
+			iov[numIov].base = static_cast<char*>(segments->base) + segmentPos;
+			iov[numIov].length = bytes;
+			numIov++;
+			datagramBytes += bytes;
+			segmentPos += bytes;
+			if (segmentPos == segments->length) {
+				segments++;
+				segmentPos = 0;
+			}
+		}
+
+		bool more = numHandles > NACL_ABI_IMC_DESC_MAX || len > datagramBytes;
+		InternalSendMsg(handle, more, handles, std::min<size_t>(numHandles, NACL_ABI_IMC_DESC_MAX), iov, numIov);
 		handles += std::min<size_t>(numHandles, NACL_ABI_IMC_DESC_MAX);
 		numHandles -= std::min<size_t>(numHandles, NACL_ABI_IMC_DESC_MAX);
-		data = static_cast<const char*>(data) + std::min<size_t>(len, MAX_IPC_BYTES);
-		len -= std::min<size_t>(len, MAX_IPC_BYTES);
+		len -= datagramBytes;
 	}
 }
 
@@ -470,7 +508,8 @@ bool InternalRecvMsg(Sys::OSHandle handle, Util::Reader& reader)
 
 Util::Reader Socket::RecvMsg() const
 {
-    Util::Reader out;
+	Util::Reader out;
+	out.GetData() = Util::AcquireBuffer();
 	while (InternalRecvMsg(handle, out)) {}
 	return out;
 }
@@ -0,0 +1,211 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "Common.h"
+
+namespace Profiler {
+
+    static const size_t THREAD_BUFFER_SIZE = 65536;
+
+    namespace {
+        struct Record {
+            const char* name;
+            int64_t start;
+            int64_t end;
+        };
+
+        // Ring buffer of the zones of a single thread. The lock is only
+        // contended while the engine collects the zones.
+        struct ThreadBuffer {
+            std::mutex mutex;
+            int thread;
+            size_t count = 0;
+            // Set when the thread exits, the buffer is recycled once collected
+            bool exited = false;
+            std::unique_ptr<Record[]> records{new Record[THREAD_BUFFER_SIZE]};
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            // Thread buffers outlive their thread so zones recorded just
+            // before a thread exits can still be collected.
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            // Buffers of the exited threads, given to the next new threads
+            std::vector<std::unique_ptr<ThreadBuffer>> freeBuffers;
+        };
+
+        // Owns the buffer of the thread until the thread exits
+        struct ThreadBufferRef {
+            ThreadBuffer* buffer = nullptr;
+
+            ~ThreadBufferRef() {
+                if (buffer) {
+                    std::lock_guard<std::mutex> lock(buffer->mutex);
+                    buffer->exited = true;
+                    buffer = nullptr;
+                }
+            }
+        };
+
+        // Never destroyed as threads may exit after the static destructors ran
+        Registry& GetRegistry() {
+            static Registry* registry = new Registry;
+            return *registry;
+        }
+    }
+
+    static std::atomic<uint32_t> localEnabled{0};
+    std::atomic<uint32_t>* enabledFlag = &localEnabled;
+
+    static SharedBuffer* sharedBuffer = nullptr;
+    static std::atomic<int> nextThreadIndex{0};
+    // VMs are single-threaded and thread_local may not be available to them
+#ifdef BUILD_ENGINE
+    thread_local
+#endif
+    static int threadIndex = -1;
+#ifdef BUILD_ENGINE
+    thread_local
+#endif
+    static ThreadBufferRef threadBuffer;
+
+    static int ThreadIndex() {
+        if (threadIndex < 0) {
+            threadIndex = nextThreadIndex++;
+        }
+        return threadIndex;
+    }
+
+    void SetEnabled(bool enable) {
+        enabledFlag->store(enable, std::memory_order_relaxed);
+    }
+
+    int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Sys::SteadyClock::now().time_since_epoch()).count();
+    }
+
+    void RecordZone(const char* name, int64_t start, int64_t end) {
+        if (sharedBuffer) {
+            uint32_t index = sharedBuffer->count.fetch_add(1, std::memory_order_relaxed);
+            if (index >= SharedBuffer::NUM_ENTRIES) {
+                return;
+            }
+            SharedBuffer::Entry& entry = sharedBuffer->entries[index];
+            Q_strncpyz(entry.name, name, sizeof(entry.name));
+            entry.start = start;
+            entry.end = end;
+            entry.thread = ThreadIndex();
+            return;
+        }
+
+        if (!threadBuffer.buffer) {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            std::unique_ptr<ThreadBuffer> buffer;
+            if (registry.freeBuffers.empty()) {
+                buffer = Util::make_unique<ThreadBuffer>();
+            } else {
+                buffer = std::move(registry.freeBuffers.back());
+                registry.freeBuffers.pop_back();
+                buffer->count = 0;
+                buffer->exited = false;
+            }
+            buffer->thread = ThreadIndex();
+            threadBuffer.buffer = buffer.get();
+            registry.buffers.push_back(std::move(buffer));
+        }
+
+        ThreadBuffer& buffer = *threadBuffer.buffer;
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.records[buffer.count % THREAD_BUFFER_SIZE] = {name, start, end};
+        buffer.count++;
+    }
+
+    std::vector<Zone> CollectZones() {
+        std::vector<Zone> zones;
+
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> registryLock(registry.mutex);
+        for (auto it = registry.buffers.begin(); it != registry.buffers.end();) {
+            ThreadBuffer& buffer = **it;
+            bool exited;
+            {
+                std::lock_guard<std::mutex> lock(buffer.mutex);
+
+                // Once the ring has wrapped around the oldest zones were overwritten
+                size_t first = buffer.count > THREAD_BUFFER_SIZE ? buffer.count - THREAD_BUFFER_SIZE : 0;
+                for (size_t i = first; i < buffer.count; i++) {
+                    const Record& record = buffer.records[i % THREAD_BUFFER_SIZE];
+                    zones.push_back({record.name, record.start, record.end, buffer.thread});
+                }
+                buffer.count = 0;
+                exited = buffer.exited;
+            }
+
+            // Nothing will be recorded in the buffer of an exited thread anymore
+            if (exited) {
+                registry.freeBuffers.push_back(std::move(*it));
+                it = registry.buffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        return zones;
+    }
+
+    size_t NumThreadBuffers() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        return registry.buffers.size() + registry.freeBuffers.size();
+    }
+
+    std::vector<Zone> CollectZones(SharedBuffer& buffer) {
+        std::vector<Zone> zones;
+
+        uint32_t count = std::min<uint32_t>(buffer.count.load(std::memory_order_acquire), SharedBuffer::NUM_ENTRIES);
+        for (uint32_t i = 0; i < count; i++) {
+            const SharedBuffer::Entry& entry = buffer.entries[i];
+            // The buffer is written by another process, don't trust it
+            size_t length = strnlen(entry.name, sizeof(entry.name));
+            zones.push_back({std::string(entry.name, length), entry.start, entry.end, entry.thread});
+        }
+        buffer.count.store(0, std::memory_order_release);
+
+        return zones;
+    }
+
+    void UseSharedBuffer(SharedBuffer* buffer) {
+        sharedBuffer = buffer;
+        enabledFlag = buffer ? &buffer->enabled : &localEnabled;
+    }
+
+} // namespace Profiler
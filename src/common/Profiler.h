@@ -0,0 +1,135 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef COMMON_PROFILER_H_
+#define COMMON_PROFILER_H_
+
+#include <atomic>
+
+/*
+ * Scoped-zone profiler
+ *
+ * A zone is a named interval of time on a thread, recorded by putting a
+ * PROFILE_ZONE("name") at the top of a scope. The zone names must be string
+ * literals as only the pointer is stored.
+ *
+ * When profiling is disabled a zone costs a single relaxed atomic load. When
+ * it is enabled each thread appends its zones to its own ring buffer which
+ * the engine collects at the end of a capture (see the "profile" command).
+ *
+ * VMs running in another process can't have their buffers collected directly
+ * so they record their zones in a SharedBuffer given to the engine instead,
+ * which also carries the enabled flag decided by the engine.
+ */
+
+namespace Profiler {
+
+    // Memory layout of the shared memory used to forward the zones of a VM.
+    struct SharedBuffer {
+        static const int NUM_ENTRIES = 16384;
+        static const int NAME_LENGTH = 48;
+
+        struct Entry {
+            char name[NAME_LENGTH];
+            int64_t start;
+            int64_t end;
+            int32_t thread;
+        };
+
+        std::atomic<uint32_t> enabled;
+        // Number of entries reserved so far, may go past NUM_ENTRIES in which
+        // case the zones that didn't fit are dropped.
+        std::atomic<uint32_t> count;
+        Entry entries[NUM_ENTRIES];
+    };
+
+    struct Zone {
+        std::string name;
+        int64_t start;
+        int64_t end;
+        int thread;
+    };
+
+    // Points to the flag deciding if zones are recorded, either a local one or
+    // the one in the shared buffer for VMs.
+    extern std::atomic<uint32_t>* enabledFlag;
+
+    inline bool Enabled() {
+        return enabledFlag->load(std::memory_order_relaxed) != 0;
+    }
+
+    void SetEnabled(bool enable);
+
+    // Time in nanoseconds since an unspecified epoch, the same for all
+    // processes on the machine.
+    int64_t Now();
+
+    void RecordZone(const char* name, int64_t start, int64_t end);
+
+    // Returns the zones recorded by all the threads of this process since
+    // the last call, then clears the thread buffers.
+    std::vector<Zone> CollectZones();
+
+    // Number of thread buffers allocated, the buffers of the exited threads
+    // are reused by the new threads once their zones were collected.
+    size_t NumThreadBuffers();
+
+    // Returns the zones recorded in a buffer shared by a VM then clears it.
+    std::vector<Zone> CollectZones(SharedBuffer& buffer);
+
+    // VM side: record the zones in this buffer and use its enabled flag.
+    void UseSharedBuffer(SharedBuffer* buffer);
+
+    class ScopedZone {
+    public:
+        explicit ScopedZone(const char* name)
+            : name(Enabled() ? name : nullptr), start(this->name ? Now() : 0) {}
+
+        ~ScopedZone() {
+            if (name) {
+                RecordZone(name, start, Now());
+            }
+        }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        const char* name;
+        int64_t start;
+    };
+
+} // namespace Profiler
+
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) Profiler::ScopedZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+
+#endif // COMMON_PROFILER_H_
@@ -0,0 +1,109 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "Common.h"
+
+namespace Util {
+
+    // Keep only a few buffers of reasonable size, big one-off messages like
+    // a file read through FSReadMsg would otherwise stay allocated forever.
+    static const size_t MAX_POOLED_BUFFERS = 8;
+    static const size_t MAX_POOLED_BUFFER_SIZE = 1 << 20;
+
+    namespace {
+        struct BufferPool {
+            std::vector<std::vector<char>> buffers;
+            size_t misses = 0;
+
+            BufferPool()
+            {
+                buffers.reserve(MAX_POOLED_BUFFERS);
+            }
+            ~BufferPool();
+        };
+    }
+
+    // Writers and Readers can be destroyed after the pool of their thread,
+    // for example if they are static, in which case they just free their
+    // memory. VMs are single threaded so they have a single pool.
+#ifdef BUILD_ENGINE
+    thread_local
+#endif
+    static bool poolDestroyed = false;
+
+    BufferPool::~BufferPool()
+    {
+        poolDestroyed = true;
+    }
+
+    static BufferPool& GetBufferPool()
+    {
+#ifdef BUILD_ENGINE
+        thread_local
+#endif
+        static BufferPool pool;
+        return pool;
+    }
+
+    std::vector<char> AcquireBuffer()
+    {
+        if (poolDestroyed)
+            return {};
+
+        BufferPool& pool = GetBufferPool();
+        if (pool.buffers.empty()) {
+            pool.misses++;
+            return {};
+        }
+
+        std::vector<char> buffer = std::move(pool.buffers.back());
+        pool.buffers.pop_back();
+        return buffer;
+    }
+
+    void ReleaseBuffer(std::vector<char>&& buffer)
+    {
+        if (buffer.capacity() == 0 || buffer.capacity() > MAX_POOLED_BUFFER_SIZE || poolDestroyed)
+            return;
+
+        BufferPool& pool = GetBufferPool();
+        if (pool.buffers.size() == MAX_POOLED_BUFFERS)
+            return;
+
+        buffer.clear();
+        pool.buffers.push_back(std::move(buffer));
+    }
+
+    size_t BufferPoolMisses()
+    {
+        return poolDestroyed ? 0 : GetBufferPool().misses;
+    }
+
+} // namespace Util
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef COMMON_SERIALIZATION_H_
 #define COMMON_SERIALIZATION_H_
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <set>
@@ -71,11 +72,68 @@ namespace Util {
 	// Trait declaration for the serialization trait.
 	template<typename T, typename = void> struct SerializeTraits {};
 
+	// Estimate of the serialized size of a list of types: exact for POD types
+	// and only the size prefix for containers. Used to reserve the memory of
+	// a message at once instead of growing it for every argument.
+	template<typename T> constexpr size_t SerializedSizeHint()
+	{
+		return IsPod<T> ? sizeof(T) : sizeof(uint32_t);
+	}
+	constexpr size_t SerializedSizeHint(Util::TypeList<>)
+	{
+		return 0;
+	}
+	template<typename Type0, typename... Types> constexpr size_t SerializedSizeHint(Util::TypeList<Type0, Types...>)
+	{
+		return SerializedSizeHint<Type0>() + SerializedSizeHint(Util::TypeList<Types...>());
+	}
+
+	// Writers and Readers take their buffer from a small per-thread pool and
+	// give it back when destroyed, so that sending and receiving a message
+	// usually doesn't allocate. BufferPoolMisses counts the buffers that had
+	// to start empty because the pool of the thread was.
+	std::vector<char> AcquireBuffer();
+	void ReleaseBuffer(std::vector<char>&& buffer);
+	size_t BufferPoolMisses();
+
 	// Class to generate messages
 	class Writer {
 	public:
+		// Writes of at least this size are only referenced while gathering
+		static const size_t GATHER_THRESHOLD = 1024;
+
+		struct GatherRef {
+			size_t offset;
+			const char* data;
+			size_t len;
+		};
+
+		Writer()
+			: data(AcquireBuffer()), gather(false), gatherSize(0),
+			  ring(nullptr), ringSize(0), ringOffset(0), ringLength(0), ringCapacity(0) {}
+		Writer(const Writer&) = default;
+		Writer(Writer&&) = default;
+		Writer& operator=(const Writer&) = default;
+		Writer& operator=(Writer&&) = default;
+		~Writer()
+		{
+			ReleaseBuffer(std::move(data));
+		}
+
 		void WriteData(const void* p, size_t len)
 		{
+			if (gather && len >= GATHER_THRESHOLD) {
+				gatherRefs.push_back({data.size(), static_cast<const char*>(p), len});
+				gatherSize += len;
+				return;
+			}
+			if (ring) {
+				if (ringLength + len <= ringCapacity) {
+					WriteRing(p, len);
+					return;
+				}
+				LeaveRing();
+			}
 			data.insert(data.end(), static_cast<const char*>(p), static_cast<const char*>(p) + len);
 		}
 		void WriteSize(size_t size)
@@ -86,6 +144,14 @@ namespace Util {
 		}
 		template<typename T, typename Arg> void Write(Arg&& value)
 		{
+			if (gather && !std::is_same<typename std::decay<Arg>::type, T>::value) {
+				// The value is converted to a temporary which will be gone
+				// by the time the message is sent, copy it instead.
+				gather = false;
+				SerializeTraits<T>::Write(*this, std::forward<Arg>(value));
+				gather = true;
+				return;
+			}
 			SerializeTraits<T>::Write(*this, std::forward<Arg>(value));
 		}
 		void WriteHandle(const IPC::FileDesc& h)
@@ -101,6 +167,51 @@ namespace Util {
 		{
 			return handles;
 		}
+		void Reserve(size_t size)
+		{
+			data.reserve(size);
+		}
+
+		// Large blobs written after this are referenced instead of copied,
+		// IPC::Socket::SendMsg then sends them straight from their memory with
+		// scatter-gather I/O. They must stay alive and untouched until the
+		// message is sent, which is the case for the arguments of IPC::SendMsg
+		// and the outputs of IPC::HandleMsg. GetData() only contains the bytes
+		// around them, GetGatherRefs() tells where each blob goes in between.
+		void BeginGather()
+		{
+			gather = true;
+		}
+		const std::vector<GatherRef>& GetGatherRefs() const
+		{
+			return gatherRefs;
+		}
+		size_t GetSize() const
+		{
+			return data.size() + gatherSize;
+		}
+
+		// Serializes in place in the capacity bytes starting at offset in a
+		// circular buffer, like the free space of an IPC::CommandBuffer,
+		// instead of the vector. If the message grows past the capacity what
+		// was written so far is moved to the vector and writing continues
+		// there, so check InRing() once done to know where the data is.
+		void BeginRing(char* base, size_t size, size_t offset, size_t capacity)
+		{
+			ring = base;
+			ringSize = size;
+			ringOffset = offset;
+			ringLength = 0;
+			ringCapacity = capacity;
+		}
+		bool InRing() const
+		{
+			return ring != nullptr;
+		}
+		size_t GetRingLength() const
+		{
+			return ringLength;
+		}
 
 		// Serialize a list of types into a Writer (ignores extra trailing arguments)
 		template<typename... Args>
@@ -123,23 +234,60 @@ namespace Util {
 			WriteTuple(Types(), std::forward<Tuple>(tuple), Util::gen_seq<std::tuple_size<typename std::decay<Tuple>::type>::value>());
 		}
 	private:
+		void WriteRing(const void* p, size_t len)
+		{
+			if (!len)
+				return; // ensure null is never passed to memcpy
+
+			size_t offset = ringOffset + ringLength;
+			if (offset >= ringSize)
+				offset -= ringSize;
+			size_t first = std::min(len, ringSize - offset);
+			memcpy(ring + offset, p, first);
+			memcpy(ring, static_cast<const char*>(p) + first, len - first);
+			ringLength += len;
+		}
+		void LeaveRing()
+		{
+			if (ringLength) {
+				data.resize(ringLength);
+				size_t first = std::min(ringLength, ringSize - ringOffset);
+				memcpy(data.data(), ring + ringOffset, first);
+				memcpy(data.data() + first, ring, ringLength - first);
+			}
+			ring = nullptr;
+		}
+
 		std::vector<char> data;
 		std::vector<IPC::FileDesc> handles;
+
+		bool gather;
+		std::vector<GatherRef> gatherRefs;
+		size_t gatherSize;
+
+		char* ring;
+		size_t ringSize;
+		size_t ringOffset;
+		size_t ringLength;
+		size_t ringCapacity;
 	};
 
 	// Class to read messages
 	class Reader {
 	public:
 		Reader()
-			: pos(0), handles_pos(0) {}
+			: pos(0), handles_pos(0), inPlace(nullptr), inPlaceSize(0) {}
 		Reader(Reader&& other) NOEXCEPT
-			: data(std::move(other.data)), handles(std::move(other.handles)), pos(other.pos), handles_pos(other.handles_pos) {}
+			: data(std::move(other.data)), handles(std::move(other.handles)), pos(other.pos), handles_pos(other.handles_pos),
+			  inPlace(other.inPlace), inPlaceSize(other.inPlaceSize) {}
 		Reader& operator=(Reader&& other) NOEXCEPT
 		{
 			std::swap(data, other.data);
 			std::swap(handles, other.handles);
 			std::swap(pos, other.pos);
 			std::swap(handles_pos, other.handles_pos);
+			std::swap(inPlace, other.inPlace);
+			std::swap(inPlaceSize, other.inPlaceSize);
 			return *this;
 		}
 		~Reader()
@@ -147,6 +295,7 @@ namespace Util {
 			// Close any handles that weren't read
 			for (size_t i = handles_pos; i < handles.size(); i++)
 				handles[i].Close();
+			ReleaseBuffer(std::move(data));
 		}
 
 		void ReadData(void* p, size_t len)
@@ -154,8 +303,8 @@ namespace Util {
 			if (!len)
 				return; // ensure null is never passed to memcpy
 
-			if (pos + len <= data.size()) {
-				memcpy(p, data.data() + pos, len);
+			if (pos + len <= Size()) {
+				memcpy(p, Begin() + pos, len);
 				pos += len;
 			} else
 				Sys::Drop("IPC: Unexpected end of message");
@@ -171,8 +320,8 @@ namespace Util {
 		}
 		const void* ReadInline(size_t len)
 		{
-			if (pos + len <= data.size()) {
-				const void* out = data.data() + pos;
+			if (pos + len <= Size()) {
+				const void* out = Begin() + pos;
 				pos += len;
 				return out;
 			} else
@@ -203,7 +352,7 @@ namespace Util {
 
 		void CheckEndRead()
 		{
-			if (pos != data.size())
+			if (pos != Size())
 				Sys::Drop("Reader: Unread bytes at end of message");
 			if (handles_pos != handles.size())
 				Sys::Drop("Reader: Unread handles at end of message");
@@ -218,11 +367,34 @@ namespace Util {
 			return handles;
 		}
 
+		// Deserializes from memory owned by someone else instead of the
+		// vector, for example a message in an IPC::CommandBuffer. The memory
+		// must stay untouched until the reader is done with it. If it is
+		// shared with another process it can still change under us so every
+		// byte is only read once and bounds are checked against len.
+		void SetInPlaceData(const void* p, size_t len)
+		{
+			inPlace = static_cast<const char*>(p);
+			inPlaceSize = len;
+			pos = 0;
+		}
+
 	private:
+		const char* Begin() const
+		{
+			return inPlace ? inPlace : data.data();
+		}
+		size_t Size() const
+		{
+			return inPlace ? inPlaceSize : data.size();
+		}
+
 		std::vector<char> data;
 		std::vector<IPC::FileDesc> handles;
 		size_t pos;
 		size_t handles_pos;
+		const char* inPlace;
+		size_t inPlaceSize;
 	};
 
 	// Implementation of the serialization traits for common types and std containers
@@ -226,10 +226,23 @@ bool OnMainThread()
 	return std::this_thread::get_id() == mainThread;
 }
 
+#ifdef BUILD_ENGINE
+thread_local
+#endif
+static bool catchesDrops = false;
+
+void CatchDropsOnThisThread()
+{
+	catchesDrops = true;
+}
+
 void Drop(Str::StringRef message)
 {
 	if (!OnMainThread()) {
-		Sys::Error(message);
+		if (!catchesDrops) {
+			Sys::Error(message);
+		}
+		throw DropErr(true, message);
 	}
 
 	// Transform into a fatal error if too many errors are generated in quick
@@ -436,7 +449,7 @@ intptr_t DynamicLib::InternalLoadSym(Str::StringRef sym, std::string& errorStrin
 #endif // __native_client__
 
 #ifdef BUILD_ENGINE
-static bool processTerminating = false;
+static std::atomic<bool> processTerminating(false);
 
 void OSExit(int exitCode) {
 	processTerminating = true;
@@ -101,6 +101,10 @@ private:
 };
 NORETURN void Drop(Str::StringRef errorMessage);
 
+// Drop is a fatal error outside of the main thread unless the thread said it
+// catches DropErr itself, to hand it over to the main thread.
+void CatchDropsOnThisThread();
+
 // Variadic wrappers for Error and Drop
 template<typename ... Args> NORETURN void Error(Str::StringRef format, Args&& ... args)
 {
@@ -47,8 +47,8 @@ static const int BOX_PLANES       = 12;
 #define LL( x ) x = LittleLong( x )
 
 clipMap_t cm;
-int       c_pointcontents;
-int       c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
+std::atomic<int> c_pointcontents;
+std::atomic<int> c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
 
 static cmodel_t  box_model;
 static cplane_t  *box_planes;
@@ -302,6 +302,51 @@ static void CMod_LoadBrushes(const byte *const cmod_base, const lump_t *l)
 	}
 }
 
+/*
+=================
+CMod_LoadBrushPlanes
+
+Copy the planes of the brush sides to a structure-of-arrays layout, so that
+CM_TraceThroughBrush can test four sides at a time
+=================
+*/
+static void CMod_LoadBrushPlanes()
+{
+	int numGroups = 0;
+
+	for ( int i = 0; i < cm.numBrushes; i++ )
+	{
+		numGroups += ( cm.brushes[ i ].numsides + 3 ) / 4;
+	}
+
+	float *groups = ( float * ) CM_Alloc( numGroups * BRUSH_SIDE_GROUP_FLOATS * sizeof( float ) );
+
+	for ( int i = 0; i < cm.numBrushes; i++ )
+	{
+		cbrush_t *b = &cm.brushes[ i ];
+		b->sidePlanes = groups;
+
+		for ( int j = 0; j < b->numsides; j++ )
+		{
+			const cplane_t *plane = b->sides[ j ].plane;
+			float *group = groups + ( j / 4 ) * BRUSH_SIDE_GROUP_FLOATS + ( j % 4 );
+
+			group[ 0 ] = plane->normal[ 0 ];
+			group[ 4 ] = plane->normal[ 1 ];
+			group[ 8 ] = plane->normal[ 2 ];
+			group[ 12 ] = plane->dist;
+
+			for ( int k = 0; k < 3; k++ )
+			{
+				uint32_t mask = ( plane->signbits >> k ) & 1 ? ~0u : 0u;
+				memcpy( &group[ 16 + 4 * k ], &mask, sizeof( mask ) );
+			}
+		}
+
+		groups += ( ( b->numsides + 3 ) / 4 ) * BRUSH_SIDE_GROUP_FLOATS;
+	}
+}
+
 /*
 =================
 CMod_LoadLeafs
@@ -820,6 +865,7 @@ void CM_LoadMap(Str::StringRef name)
 	CMod_LoadPlanes(cmod_base, &header.lumps[LUMP_PLANES]);
 	CMod_LoadBrushSides(cmod_base, &header.lumps[LUMP_BRUSHSIDES]);
 	CMod_LoadBrushes(cmod_base, &header.lumps[LUMP_BRUSHES]);
+	CMod_LoadBrushPlanes();
 	CMod_LoadSubmodels(cmod_base, &header.lumps[LUMP_MODELS]);
 	CMod_LoadNodes(cmod_base, &header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString(cmod_base, &header.lumps[LUMP_ENTITIES], externalEntities);
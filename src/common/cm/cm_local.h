@@ -35,6 +35,9 @@ Maryland 20850 USA.
 #ifndef COMMON_CM_CM_LOCAL_H_
 #define COMMON_CM_CM_LOCAL_H_
 
+#include <atomic>
+#include <vector>
+
 #include "cm_public.h"
 #include "cm_polylib.h"
 
@@ -83,9 +86,14 @@ struct cbrush_t
 	vec3_t       bounds[ 2 ];
 	int          numsides;
 	cbrushside_t *sides;
-	int          checkcount; // to avoid repeated testings
+	const float  *sidePlanes; // see CMod_LoadBrushPlanes, nullptr for the box brush
 };
 
+// The planes of the sides of a brush are stored in groups of 4 sides, each
+// group being the normal x, y and z, the dist and the x, y and z sign masks
+// (all bits set if the signbit is set) of the 4 sides.
+static const int BRUSH_SIDE_GROUP_FLOATS = 7 * 4;
+
 struct cPlane_t
 {
 	plane_t plane;
@@ -142,7 +150,6 @@ struct cSurfaceCollide_t
 
 struct cSurface_t
 {
-	int               checkcount; // to avoid repeated testings
 	int               surfaceFlags;
 	int               contents;
 	cSurfaceCollide_t *sc;
@@ -200,7 +207,6 @@ struct clipMap_t
 	cSurface_t   **surfaces; // non-patches will be nullptr
 
 	int          floodvalid;
-	int          checkcount; // incremented on each trace
 	bool     perPolyCollision;
 };
 
@@ -217,8 +223,8 @@ struct clipMap_t
 #define SURFACE_CLIP_EPSILON ( 0.125f )
 
 extern clipMap_t cm;
-extern int       c_pointcontents;
-extern int       c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
+extern std::atomic<int> c_pointcontents;
+extern std::atomic<int> c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
 extern Cvar::Cvar<bool> cm_forceTriangles;
 extern Log::Logger cmLog;
 
@@ -232,8 +238,30 @@ struct sphere_t
 	vec3_t offset;
 };
 
+// Per-thread state of the traces, so that traces against the map and its
+// inline models can run on several threads at the same time. Traces against
+// CM_TempBoxModel models are not thread-safe since the box model is global.
+struct traceContext_t
+{
+	// Brushes and surfaces already tested by the current trace are marked with its checkcount
+	int                checkcount;
+	std::vector<int>   brushCheckcounts;
+	std::vector<int>   surfaceCheckcounts;
+
+	// Scratch space of CM_TracePointThroughSurfaceCollide
+	std::vector<char>  frontFacing;
+	std::vector<float> intersection;
+
+	// Scratch space of CM_TraceThroughBrush
+	std::vector<float> sideDistances;
+};
+
+// Get the trace context of the current thread, ready for a new trace
+traceContext_t *CM_BeginTraceContext();
+
 struct traceWork_t
 {
+	traceContext_t *context;
 	traceType_t type;
 	vec3_t      start;
 	vec3_t      end;
@@ -304,6 +332,9 @@ bool CM_GenerateFacetFor3Points( cFacet_t *facet, const vec3_t p1, const vec3_t
 bool CM_GenerateFacetFor4Points( cFacet_t *facet, const vec3_t p1, const vec3_t p2, const vec3_t p3, const vec3_t p4 );
 
 
+// cm_trace.c
+void                           CM_BrushSideDistances( const traceWork_t *tw, const cbrush_t *brush, float *d1s, float *d2s );
+
 // cm_test.c
 void                           CM_StoreLeafs( leafList_t *ll, int nodenum );
 
@@ -64,6 +64,7 @@ std::string CM_CheckTraceConsistency( const vec3_t start, const vec3_t end, int
 float CM_DistanceToModel( const vec3_t loc, clipHandle_t model );
 
 byte *CM_ClusterPVS( int cluster );
+int   CM_NumClusters();
 
 int  CM_PointLeafnum( const vec3_t p );
 
@@ -168,8 +168,6 @@ int CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsiz
 {
 	leafList_t ll;
 
-	cm.checkcount++;
-
 	VectorCopy( mins, ll.bounds[ 0 ] );
 	VectorCopy( maxs, ll.bounds[ 1 ] );
 	ll.count = 0;
@@ -317,6 +315,11 @@ byte           *CM_ClusterPVS( int cluster )
 	return cm.visibility + cluster * cm.clusterBytes;
 }
 
+int CM_NumClusters()
+{
+	return cm.numClusters;
+}
+
 /*
 ===============================================================================
 
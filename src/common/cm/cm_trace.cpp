@@ -374,12 +374,14 @@ void CM_TestInLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 	{
 		cbrush_t *b = &cm.brushes[ *brushNum ];
 
-		if ( b->checkcount == cm.checkcount )
+		int &brushCheckcount = tw->context->brushCheckcounts[ *brushNum ];
+
+		if ( brushCheckcount == tw->context->checkcount )
 		{
 			continue; // already checked this brush in another leaf
 		}
 
-		b->checkcount = cm.checkcount;
+		brushCheckcount = tw->context->checkcount;
 
 		if ( !( b->contents & tw->contents ) )
 		{
@@ -411,12 +413,14 @@ void CM_TestInLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 			continue;
 		}
 
-		if ( surface->checkcount == cm.checkcount )
+		int &surfaceCheckcount = tw->context->surfaceCheckcounts[ *surfaceNum ];
+
+		if ( surfaceCheckcount == tw->context->checkcount )
 		{
 			continue; // already checked this surface in another leaf
 		}
 
-		surface->checkcount = cm.checkcount;
+		surfaceCheckcount = tw->context->checkcount;
 
 		if ( !( surface->contents & tw->contents ) )
 		{
@@ -633,12 +637,8 @@ void CM_PositionTest( traceWork_t *tw )
 	ll.lastLeaf = 0;
 	ll.overflowed = false;
 
-	cm.checkcount++;
-
 	CM_BoxLeafnums_r( &ll, 0 );
 
-	cm.checkcount++;
-
 	// test the contents of the leafs
 	for ( i = 0; i < ll.count; i++ )
 	{
@@ -668,8 +668,6 @@ CM_TracePointThroughSurfaceCollide
 */
 void CM_TracePointThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_t *sc )
 {
-	static bool frontFacing[ SHADER_MAX_TRIANGLES ];
-	static float    intersection[ SHADER_MAX_TRIANGLES ];
 	float           intersect;
 	const cPlane_t  *planes;
 	const cFacet_t  *facet;
@@ -683,6 +681,15 @@ void CM_TracePointThroughSurfaceCollide( traceWork_t *tw, const cSurfaceCollide_
 	// determine the trace's relationship to all planes
 	planes = sc->planes;
 
+	std::vector<char> &frontFacing = tw->context->frontFacing;
+	std::vector<float> &intersection = tw->context->intersection;
+
+	if ( frontFacing.size() < size_t( sc->numPlanes ) )
+	{
+		frontFacing.resize( sc->numPlanes );
+		intersection.resize( sc->numPlanes );
+	}
+
 	for ( i = 0; i < sc->numPlanes; i++, planes++ )
 	{
 		vec_t offset = DotProduct( tw->offsets[ planes->signbits ], planes->plane.normal );
@@ -1024,6 +1031,72 @@ void CM_TraceThroughSurface( traceWork_t *tw, const cSurface_t *surface )
 	}
 }
 
+/*
+================
+CM_BrushSideDistances
+
+Compute the distances of the start and end points of a box trace to the
+planes of all sides of a brush, adjusted for mins/maxs. d1s and d2s are
+padded to a multiple of 4 sides.
+================
+*/
+void CM_BrushSideDistances( const traceWork_t *tw, const cbrush_t *brush, float *d1s, float *d2s )
+{
+#if defined( DAEMON_USE_ARCH_INTRINSICS_I686_SSE )
+	if ( brush->sidePlanes )
+	{
+		__m128 start[ 3 ], end[ 3 ], size[ 2 ][ 3 ];
+
+		for ( int k = 0; k < 3; k++ )
+		{
+			start[ k ] = _mm_set1_ps( tw->start[ k ] );
+			end[ k ] = _mm_set1_ps( tw->end[ k ] );
+			size[ 0 ][ k ] = _mm_set1_ps( tw->size[ 0 ][ k ] );
+			size[ 1 ][ k ] = _mm_set1_ps( tw->size[ 1 ][ k ] );
+		}
+
+		// same operations in the same order as the scalar code, so the results are identical
+		const float *group = brush->sidePlanes;
+
+		for ( int i = 0; i < brush->numsides; i += 4, group += BRUSH_SIDE_GROUP_FLOATS )
+		{
+			__m128 normal[ 3 ], offset[ 3 ];
+
+			for ( int k = 0; k < 3; k++ )
+			{
+				normal[ k ] = _mm_loadu_ps( group + 4 * k );
+				__m128 mask = _mm_loadu_ps( group + 16 + 4 * k );
+				offset[ k ] = _mm_or_ps( _mm_and_ps( mask, size[ 1 ][ k ] ), _mm_andnot_ps( mask, size[ 0 ][ k ] ) );
+			}
+
+			__m128 offsetDot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( offset[ 0 ], normal[ 0 ] ), _mm_mul_ps( offset[ 1 ], normal[ 1 ] ) ),
+			                               _mm_mul_ps( offset[ 2 ], normal[ 2 ] ) );
+			__m128 dist = _mm_sub_ps( _mm_loadu_ps( group + 12 ), offsetDot );
+			__m128 startDot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( start[ 0 ], normal[ 0 ] ), _mm_mul_ps( start[ 1 ], normal[ 1 ] ) ),
+			                              _mm_mul_ps( start[ 2 ], normal[ 2 ] ) );
+			__m128 endDot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( end[ 0 ], normal[ 0 ] ), _mm_mul_ps( end[ 1 ], normal[ 1 ] ) ),
+			                            _mm_mul_ps( end[ 2 ], normal[ 2 ] ) );
+
+			_mm_storeu_ps( d1s + i, _mm_sub_ps( startDot, dist ) );
+			_mm_storeu_ps( d2s + i, _mm_sub_ps( endDot, dist ) );
+		}
+
+		return;
+	}
+#endif
+
+	for ( int i = 0; i < brush->numsides; i++ )
+	{
+		const cplane_t *plane = brush->sides[ i ].plane;
+
+		// adjust the plane distance appropriately for mins/maxs
+		float dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
+
+		d1s[ i ] = DotProduct( tw->start, plane->normal ) - dist;
+		d2s[ i ] = DotProduct( tw->end, plane->normal ) - dist;
+	}
+}
+
 /*
 ================
 CM_TraceThroughBrush
@@ -1149,6 +1222,19 @@ void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush )
 	}
 	else
 	{
+		// the side distances are computed for groups of 4 sides
+		size_t paddedSides = ( brush->numsides + 3 ) & ~3;
+		std::vector<float> &sideDistances = tw->context->sideDistances;
+
+		if ( sideDistances.size() < 2 * paddedSides )
+		{
+			sideDistances.resize( 2 * paddedSides );
+		}
+
+		float *d1s = sideDistances.data();
+		float *d2s = d1s + paddedSides;
+		CM_BrushSideDistances( tw, brush, d1s, d2s );
+
 		//
 		// compare the trace against all planes of the brush
 		// find the latest time the trace crosses a plane towards the interior
@@ -1158,11 +1244,8 @@ void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush )
 		{
 			const cplane_t *plane = side->plane;
 
-			// adjust the plane distance appropriately for mins/maxs
-			dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
-
-			d1 = DotProduct( tw->start, plane->normal ) - dist;
-			d2 = DotProduct( tw->end, plane->normal ) - dist;
+			d1 = d1s[ side - firstSide ];
+			d2 = d2s[ side - firstSide ];
 
 			if ( d2 > 0 )
 			{
@@ -1273,12 +1356,14 @@ void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 	{
 		cbrush_t *b = &cm.brushes[ *brushNum ];
 
-		if ( b->checkcount == cm.checkcount )
+		int &brushCheckcount = tw->context->brushCheckcounts[ *brushNum ];
+
+		if ( brushCheckcount == tw->context->checkcount )
 		{
 			continue; // already checked this brush in another leaf
 		}
 
-		b->checkcount = cm.checkcount;
+		brushCheckcount = tw->context->checkcount;
 
 		if ( !( b->contents & tw->contents ) )
 		{
@@ -1321,12 +1406,14 @@ void CM_TraceThroughLeaf( traceWork_t *tw, const cLeaf_t *leaf )
 			continue;
 		}
 
-		if ( surface->checkcount == cm.checkcount )
+		int &surfaceCheckcount = tw->context->surfaceCheckcounts[ *surfaceNum ];
+
+		if ( surfaceCheckcount == tw->context->checkcount )
 		{
 			continue; // already checked this surface in another leaf
 		}
 
-		surface->checkcount = cm.checkcount;
+		surfaceCheckcount = tw->context->checkcount;
 
 		if ( !( surface->contents & tw->contents ) )
 		{
@@ -1836,6 +1923,35 @@ static void CM_TraceThroughTree( traceWork_t *tw, int num, float p1f, float p2f,
 
 //======================================================================
 
+/*
+==================
+CM_BeginTraceContext
+==================
+*/
+// VMs are single-threaded and thread_local may not be available to them
+#ifdef BUILD_ENGINE
+thread_local
+#endif
+static traceContext_t traceContext;
+
+traceContext_t *CM_BeginTraceContext()
+{
+	traceContext_t *context = &traceContext;
+
+	// The box model brush follows the map brushes
+	size_t numBrushes = cm.numBrushes + 1;
+
+	if ( context->brushCheckcounts.size() != numBrushes || context->surfaceCheckcounts.size() != size_t( cm.numSurfaces ) )
+	{
+		context->checkcount = 0;
+		context->brushCheckcounts.assign( numBrushes, 0 );
+		context->surfaceCheckcounts.assign( cm.numSurfaces, 0 );
+	}
+
+	context->checkcount++;
+	return context;
+}
+
 /*
 ==================
 CM_Trace
@@ -1845,18 +1961,19 @@ static void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, co
                       const vec3_t maxs, clipHandle_t model, const vec3_t origin, int brushmask,
                       int skipmask, traceType_t type, const sphere_t *sphere )
 {
+	PROFILE_ZONE("CM_Trace");
+
 	int         i;
 	vec3_t      offset;
 	cmodel_t    *cmod;
 
 	cmod = CM_ClipHandleToModel( model );
 
-	cm.checkcount++; // for multi-check avoidance
-
 	c_traces++; // for statistics, may be zeroed
 
 	// fill in a default trace
 	traceWork_t tw{};
+	tw.context = CM_BeginTraceContext(); // for multi-check avoidance
 	tw.trace.fraction = 1; // assume it goes the entire distance until shown otherwise
 	VectorCopy( origin, tw.modelOrigin );
 	tw.type = type;
@@ -28,10 +28,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ===========================================================================
 */
 
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
-#include "cm_public.h"
+#include "cm_local.h"
 #include "common/FileSystem.h"
 
 namespace {
@@ -184,4 +189,191 @@ TEST_F(TraceTest, BoxHitPatch)
     EXPECT_NEAR(tr.plane.dist, 362.105, PATCH_PLANE_DIST_ATOL);
 }
 
+struct RandomTraces {
+    std::unique_ptr<vec3_t[]> starts, ends, mins, maxs;
+    std::vector<traceType_t> types;
+};
+
+// Random traces in the map: points, boxes, capsules and position tests
+RandomTraces MakeRandomTraces(int count, unsigned seed)
+{
+    vec3_t mapMins, mapMaxs;
+    CM_ModelBounds(CM_InlineModel(0), mapMins, mapMaxs);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    RandomTraces traces;
+    traces.starts.reset(new vec3_t[count]);
+    traces.ends.reset(new vec3_t[count]);
+    traces.mins.reset(new vec3_t[count]);
+    traces.maxs.reset(new vec3_t[count]);
+    traces.types.resize(count);
+    for (int n = 0; n < count; n++) {
+        for (int i = 0; i < 3; i++) {
+            traces.starts[n][i] = mapMins[i] + unit(rng) * (mapMaxs[i] - mapMins[i]);
+            // Mix long traces crossing many leafs with short movement-like ones
+            float length = rng() % 2 ? 2000.0f : 50.0f;
+            traces.ends[n][i] = traces.starts[n][i] + (unit(rng) - 0.5f) * length;
+        }
+        float size = rng() % 3 ? 4.0f + unit(rng) * 40.0f : 0.0f;
+        VectorSet(traces.mins[n], -size, -size, -size);
+        VectorSet(traces.maxs[n], size, size, size);
+        traces.types[n] = rng() % 2 ? traceType_t::TT_AABB : traceType_t::TT_CAPSULE;
+        if (rng() % 10 == 0) {
+            VectorCopy(traces.starts[n], traces.ends[n]);
+        }
+    }
+    return traces;
+}
+
+bool SameTrace(const trace_t& a, const trace_t& b)
+{
+    return a.allsolid == b.allsolid && a.startsolid == b.startsolid && a.fraction == b.fraction
+        && VectorCompare(a.endpos, b.endpos) && VectorCompare(a.plane.normal, b.plane.normal)
+        && a.plane.dist == b.plane.dist && a.surfaceFlags == b.surfaceFlags && a.contents == b.contents;
+}
+
+// A trace of random start, end and box size, with its offsets set up as in CM_Trace
+traceWork_t RandomTraceWork(std::mt19937& rng, const vec3_t mapMins, const vec3_t mapMaxs)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    traceWork_t tw{};
+    for (int i = 0; i < 3; i++) {
+        tw.start[i] = mapMins[i] + unit(rng) * (mapMaxs[i] - mapMins[i]);
+        tw.end[i] = tw.start[i] + (unit(rng) - 0.5f) * 500.0f;
+        tw.size[0][i] = -unit(rng) * 40.0f;
+        tw.size[1][i] = unit(rng) * 40.0f;
+    }
+    for (int signbits = 0; signbits < 8; signbits++) {
+        for (int i = 0; i < 3; i++) {
+            tw.offsets[signbits][i] = tw.size[(signbits >> i) & 1][i];
+        }
+    }
+    return tw;
+}
+
+// The plain computation from the planes of the sides, as in CM_TraceThroughBrush before the side groups
+void ReferenceSideDistances(const traceWork_t& tw, const cbrush_t& brush, float* d1s, float* d2s)
+{
+    for (int i = 0; i < brush.numsides; i++) {
+        const cplane_t* plane = brush.sides[i].plane;
+        float dist = plane->dist - DotProduct(tw.offsets[plane->signbits], plane->normal);
+        d1s[i] = DotProduct(tw.start, plane->normal) - dist;
+        d2s[i] = DotProduct(tw.end, plane->normal) - dist;
+    }
+}
+
+TEST_F(TraceTest, BrushSideDistancesSameAsScalar)
+{
+    vec3_t mapMins, mapMaxs;
+    CM_ModelBounds(CM_InlineModel(0), mapMins, mapMaxs);
+    std::mt19937 rng(42);
+
+    int numGrouped = 0;
+    for (int b = 0; b < cm.numBrushes; b++) {
+        const cbrush_t& brush = cm.brushes[b];
+        if (brush.sidePlanes) {
+            numGrouped++;
+        }
+
+        size_t paddedSides = (brush.numsides + 3) & ~3;
+        std::vector<float> d1s(paddedSides), d2s(paddedSides), expected1(brush.numsides), expected2(brush.numsides);
+        for (int n = 0; n < 20; n++) {
+            traceWork_t tw = RandomTraceWork(rng, mapMins, mapMaxs);
+            CM_BrushSideDistances(&tw, &brush, d1s.data(), d2s.data());
+            ReferenceSideDistances(tw, brush, expected1.data(), expected2.data());
+
+            for (int i = 0; i < brush.numsides; i++) {
+                ASSERT_EQ(d1s[i], expected1[i]) << "brush " << b << " side " << i;
+                ASSERT_EQ(d2s[i], expected2[i]) << "brush " << b << " side " << i;
+            }
+        }
+    }
+
+#if defined(DAEMON_USE_ARCH_INTRINSICS_I686_SSE)
+    EXPECT_GT(numGrouped, 0);
+#endif
+}
+
+TEST_F(TraceTest, DISABLED_Benchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int numPasses = 2000;
+    vec3_t mapMins, mapMaxs;
+    CM_ModelBounds(CM_InlineModel(0), mapMins, mapMaxs);
+    std::mt19937 rng(7);
+    traceWork_t tw = RandomTraceWork(rng, mapMins, mapMaxs);
+
+    int maxSides = 0;
+    for (int b = 0; b < cm.numBrushes; b++) {
+        maxSides = std::max(maxSides, cm.brushes[b].numsides);
+    }
+    std::vector<float> d1s((maxSides + 3) & ~3), d2s((maxSides + 3) & ~3);
+
+    auto time = [&](const char* name, auto&& fn) {
+        float sum = 0.0f;
+        auto start = Clock::now();
+        for (int n = 0; n < numPasses; n++) {
+            for (int b = 0; b < cm.numBrushes; b++) {
+                fn(cm.brushes[b]);
+                sum += d1s[0];
+            }
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        Log::Notice("%s: %.0f brushes/s (%g)", name, numPasses * cm.numBrushes / elapsed.count(), sum);
+    };
+
+    time("scalar side distances", [&](const cbrush_t& brush) {
+        ReferenceSideDistances(tw, brush, d1s.data(), d2s.data());
+    });
+    time("CM_BrushSideDistances", [&](const cbrush_t& brush) {
+        CM_BrushSideDistances(&tw, &brush, d1s.data(), d2s.data());
+    });
+}
+
+#ifdef BUILD_ENGINE
+// Traces against the map from several threads at once give the same results as
+// the same traces run one after the other
+TEST_F(TraceTest, ConcurrentTraces)
+{
+    constexpr int numTraces = 4000;
+    constexpr int numThreads = 4;
+    constexpr int numPasses = 10;
+
+    RandomTraces traces = MakeRandomTraces(numTraces, 23);
+    auto trace = [&traces](int i, trace_t& tr) {
+        CM_BoxTrace(&tr, traces.starts[i], traces.ends[i], traces.mins[i], traces.maxs[i], CM_InlineModel(0),
+                    contentmask, skipmask, traces.types[i]);
+    };
+
+    std::vector<trace_t> expected(numTraces);
+    for (int i = 0; i < numTraces; i++) {
+        trace(i, expected[i]);
+    }
+
+    // Each thread goes through all the traces a few times, starting at a different place
+    std::vector<int> mismatches(numThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (int n = 0; n < numPasses * numTraces; n++) {
+                int i = (n + t * numTraces / numThreads) % numTraces;
+                trace_t tr;
+                trace(i, tr);
+                if (!SameTrace(tr, expected[i])) {
+                    mismatches[t]++;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < numThreads; t++) {
+        EXPECT_EQ(mismatches[t], 0) << "in thread " << t;
+    }
+}
+#endif
+
 } // namespace
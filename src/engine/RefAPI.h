@@ -99,6 +99,16 @@ struct refexport_t {
 	void   ( *UnregisterFont )( fontInfo_t* font );
 	void   ( *GlyphChar )( fontInfo_t* font, int ch, glyphInfo_t* glyph );
 
+	// Read the files of a model, or of a skin or animation, ahead of their
+	// registration. Can be called from worker threads while the main thread
+	// doesn't touch the filesystem. The files not used by the registrations
+	// are dropped by ClearPrefetchedFiles.
+	void ( *PrefetchModel )( const char* name );
+	void ( *PrefetchFile )( const char* name );
+	void ( *ClearPrefetchedFiles )( );
+	// Main thread only, queues the decoding of the images of a shader
+	void ( *PrefetchShader )( const char* name );
+
 	void ( *LoadWorld )( const char* name );
 
 	// the vis data is a large enough block of data that we go to the trouble
@@ -150,6 +160,8 @@ struct refexport_t {
 
 	// XreaL BEGIN
 	void ( *TakeVideoFrame )( int h, int w, byte* captureBuffer, byte* encodeBuffer, bool motionJpeg );
+	// writes the video frames which are still being encoded
+	void ( *FinishVideoFrames )();
 
 	// RB: alternative skeletal animation system
 	qhandle_t( *RegisterAnimation )( const char* name );
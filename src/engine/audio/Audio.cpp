@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "framework/CvarSystem.h"
 #include "AudioPrivate.h"
 #include "AudioData.h"
+#include "SoundCodec.h"
 
 namespace Audio {
     /* When adding an entry point to the audio subsystem,
@@ -44,6 +45,7 @@ namespace Audio {
     static Cvar::Range<Cvar::Cvar<float>> masterVolume("audio.volume.master", "the global audio volume", Cvar::ARCHIVE, 0.8f, 0.0f, 1.0f);
 
     static Cvar::Range<Cvar::Cvar<float>> musicVolume("audio.volume.music", "the volume of the music", Cvar::NONE, 0.8f, 0.0f, 1.0f);
+    static Cvar::Cvar<bool> streamMusic("audio.streamMusic", "decode the music while it is played instead of loading it entirely", Cvar::NONE, true);
 
     static Cvar::Cvar<bool> muteWhenMinimized("audio.muteWhenMinimized", "should the game be muted when minimized", Cvar::NONE, false);
     static Cvar::Cvar<bool> muteWhenUnfocused("audio.muteWhenUnfocused", "should the game be muted when not focused", Cvar::NONE, false);
@@ -129,7 +131,7 @@ namespace Audio {
     void CaptureTestUpdate();
 
     // Like in the previous sound system, we only have a single music
-    std::shared_ptr<LoopingSound> music;
+    std::shared_ptr<Sound> music;
 
     bool IsValidEntity(int entityNum) {
         return entityNum >= 0 and entityNum < MAX_GENTITIES;
@@ -313,6 +315,14 @@ namespace Audio {
         return RegisterSample(filename)->GetHandle();
     }
 
+    void PrefetchSFX(Str::StringRef filename) {
+        if (not initialized) {
+            return;
+        }
+
+        PrefetchSample(filename);
+    }
+
     void EndRegistration() {
         if (not initialized) {
             return;
@@ -393,11 +403,51 @@ namespace Audio {
         entityLoops[entityNum].ClearLoopingSounds();
     }
 
+    // Returns nullptr if the music can't be streamed, e.g. if it is a .wav
+    static std::shared_ptr<Sound> NewStreamedMusic(Str::StringRef leadingSound, Str::StringRef loopSound) {
+        std::unique_ptr<SoundStream> leadingStream;
+        std::unique_ptr<SoundStream> loopingStream;
+
+        if (not leadingSound.empty()) {
+            leadingStream = OpenSoundStream(leadingSound);
+
+            if (not leadingStream) {
+                return nullptr;
+            }
+        }
+
+        if (not loopSound.empty()) {
+            loopingStream = OpenSoundStream(loopSound);
+
+            if (not loopingStream) {
+                return nullptr;
+            }
+        }
+
+        if (not leadingStream and not loopingStream) {
+            return nullptr;
+        }
+
+        return std::make_shared<StreamedSound>(std::move(leadingStream), std::move(loopingStream));
+    }
+
     void StartMusic(Str::StringRef leadingSound, Str::StringRef loopSound) {
         if (not initialized) {
             return;
         }
 
+        if (streamMusic.Get()) {
+            std::shared_ptr<Sound> streamedMusic = NewStreamedMusic(leadingSound, loopSound);
+
+            if (streamedMusic) {
+                StopMusic();
+                music = streamedMusic;
+                music->volumeModifier = &musicVolume;
+                AddSound( GetLocalEmitter(), music, ANY );
+                return;
+            }
+        }
+
         std::shared_ptr<Sample> leadingSample = nullptr;
         std::shared_ptr<Sample> loopingSample = nullptr;
         if (not leadingSound.empty()) {
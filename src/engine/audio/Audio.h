@@ -45,6 +45,9 @@ namespace Audio {
 
     void BeginRegistration( const int playerNum );
     sfxHandle_t RegisterSFX(Str::StringRef filename);
+    // Can be called from worker threads before RegisterSFX to decode the
+    // sound ahead, while the main thread doesn't touch the filesystem
+    void PrefetchSFX(Str::StringRef filename);
     void EndRegistration();
 
     void StartSound(int entityNum, Vec3 origin, sfxHandle_t sfx);
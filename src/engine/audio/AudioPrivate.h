@@ -38,7 +38,8 @@ namespace Audio {
 
     /**
      * The audio system is split in several parts:
-     * - Audio codecs, one for each supported format that allow to load an entire file.
+     * - Audio codecs, one for each supported format that allow to load an entire file, some of them
+     *   can also decode a file progressively while it is played.
      * - ALObjects that provide OO wrappers around OpenAL (OpenAL headers are only included in ALObjects.cpp)
      * - Audio the external interface, mostly using Sound and Emitter to create new sounds.
      * - Emitters that control the positional effects for the sound sources
@@ -109,84 +109,165 @@ size_t OggCallbackRead(void* ptr, size_t size, size_t count, void* datasource)
 }
 
 
-const ov_callbacks Ogg_Callbacks = {&OggCallbackRead, nullptr, nullptr, nullptr};
+/*
+ *Replacement for the seek_func of ov_callbacks, the file is in memory so
+ *seeking lets vorbisfile find the length of the sound.
+ *Returns 0 on success and -1 if the position is out of the file.
+ */
+int OggCallbackSeek(void* datasource, ogg_int64_t offset, int whence)
+{
+	OggDataSource* data = static_cast<OggDataSource*>(datasource);
+	ogg_int64_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		base = data->position;
+		break;
+	case SEEK_END:
+		base = data->audioFile->size();
+		break;
+	default:
+		return -1;
+	}
 
-AudioData LoadOggCodec(std::string filename)
+	if (offset < -base || base + offset > ogg_int64_t(data->audioFile->size())) {
+		return -1;
+	}
+
+	data->position = base + offset;
+	return 0;
+}
+
+// Replacement for the tell_func of ov_callbacks
+long OggCallbackTell(void* datasource)
 {
-	std::string audioFile;
-	try
+	return static_cast<OggDataSource*>(datasource)->position;
+}
+
+const ov_callbacks Ogg_Callbacks = {&OggCallbackRead, &OggCallbackSeek, nullptr, &OggCallbackTell};
+
+class OggStream : public SoundStream {
+public:
+	OggStream(std::string filename, std::string audioFile)
+		: filename(std::move(filename)), audioFile(std::move(audioFile)), dataSource{&this->audioFile, 0}
 	{
-		audioFile = FS::PakPath::ReadFile(filename);
 	}
-	catch (std::system_error& err)
+
+	~OggStream() override
 	{
-		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
-		return AudioData();
+		Close();
 	}
-	OggDataSource dataSource = {&audioFile, 0};
-	std::unique_ptr<OggVorbis_File> vorbisFile(new OggVorbis_File);
 
-	if (ov_open_callbacks(&dataSource, vorbisFile.get(), nullptr, 0, Ogg_Callbacks) != 0) {
-        audioLogs.Warn("Error while reading %s", filename);
-		ov_clear(vorbisFile.get());
-		return AudioData();
-	}
+	bool Open()
+	{
+		if (ov_open_callbacks(&dataSource, &vorbisFile, nullptr, 0, Ogg_Callbacks) != 0) {
+			audioLogs.Warn("Error while reading %s", filename);
+			ov_clear(&vorbisFile);
+			return false;
+		}
 
-	if (ov_streams(vorbisFile.get()) != 1) {
-		audioLogs.Warn("Unsupported number of streams in %s.", filename);
-		ov_clear(vorbisFile.get());
-		return AudioData();
-	}
+		opened = true;
 
-	vorbis_info* oggInfo = ov_info(vorbisFile.get(), 0);
+		if (ov_streams(&vorbisFile) != 1) {
+			audioLogs.Warn("Unsupported number of streams in %s.", filename);
+			return false;
+		}
 
-	if (!oggInfo) {
-        audioLogs.Warn("Could not read vorbis_info in %s.", filename);
-		ov_clear(vorbisFile.get());
-		return AudioData();
-	}
+		vorbis_info* oggInfo = ov_info(&vorbisFile, 0);
+
+		if (!oggInfo) {
+			audioLogs.Warn("Could not read vorbis_info in %s.", filename);
+			return false;
+		}
 
-	const int sampleWidth = 2;
+		sampleRate = oggInfo->rate;
+		byteDepth = 2;
+		numberOfChannels = oggInfo->channels;
 
-	int sampleRate = oggInfo->rate;
-	int numberOfChannels = oggInfo->channels;
+		return true;
+	}
+
+	size_t Read(char* out, size_t size) override
+	{
+		size_t bytesRead = 0;
+		int bitStream = 0;
 
-	/* The largest ogg file we have so far is res-soundtrack/sound/ui/heartbeat.ogg
-	It uncompress to ~47mb. Use 64mb here just in case */
-	static constexpr uint32_t MAX_USED_FILE_SIZE = 64 * 1024 * 1024;
-	static constexpr uint32_t MAX_READ_SIZE      =  1 * 1024 * 1024;
+		// ov_read decodes at most a packet at a time
+		while (bytesRead < size) {
+			int toRead = std::min<size_t>(size - bytesRead, INT_MAX);
+			long result = ov_read(&vorbisFile, out + bytesRead, toRead, 0, byteDepth, 1, &bitStream);
 
-	char* buffer = ( char* ) Hunk_AllocateTempMemory( MAX_USED_FILE_SIZE );
-	uint32_t bufferPointer = 0;
-	uint32_t rawSamplesPointer = 0;
+			if (result <= 0) {
+				break;
+			}
 
-	int bytesRead = 0;
-	int bitStream = 0;
+			bytesRead += result;
+		}
 
-	AudioData out { sampleRate, sampleWidth, numberOfChannels };
+		return bytesRead;
+	}
 
-	while ((bytesRead = ov_read(vorbisFile.get(), buffer + bufferPointer, MAX_READ_SIZE, 0, sampleWidth, 1, &bitStream)) > 0) {
-		bufferPointer += bytesRead;
+	size_t DecodedSize() override
+	{
+		ogg_int64_t samplesPerChannel = ov_pcm_total(&vorbisFile, -1);
+		return samplesPerChannel > 0 ? samplesPerChannel * byteDepth * numberOfChannels : 0;
+	}
 
-		if ( MAX_USED_FILE_SIZE - bufferPointer < MAX_READ_SIZE ) {
-			out.rawSamples.resize( out.rawSamples.size() + bufferPointer );
-			std::copy_n( buffer, bufferPointer, out.rawSamples.data() + rawSamplesPointer );
+	bool Rewind() override
+	{
+		return ov_raw_seek(&vorbisFile, 0) == 0;
+	}
 
-			rawSamplesPointer += bufferPointer;
-			bufferPointer = 0;
+private:
+	void Close()
+	{
+		if (opened) {
+			ov_clear(&vorbisFile);
+			opened = false;
 		}
 	}
 
-	if ( bufferPointer ) {
-		out.rawSamples.resize( out.rawSamples.size() + bufferPointer );
-		std::copy_n( buffer, bufferPointer, out.rawSamples.data() + rawSamplesPointer );
+	std::string filename;
+	std::string audioFile;
+	OggDataSource dataSource;
+	OggVorbis_File vorbisFile;
+	bool opened = false;
+};
+
+std::unique_ptr<SoundStream> OpenOggStream(std::string filename)
+{
+	std::string audioFile;
+	try
+	{
+		audioFile = FS::PakPath::ReadFile(filename);
+	}
+	catch (std::system_error& err)
+	{
+		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
+		return nullptr;
 	}
 
-	Hunk_FreeTempMemory( buffer );
+	std::unique_ptr<OggStream> stream(new OggStream(filename, std::move(audioFile)));
+
+	if (!stream->Open()) {
+		return nullptr;
+	}
 
-	ov_clear(vorbisFile.get());
+	return stream;
+}
+
+AudioData LoadOggCodec(std::string filename)
+{
+	std::unique_ptr<SoundStream> stream = OpenOggStream(filename);
+
+	if (!stream) {
+		return AudioData();
+	}
 
-	return out;
+	return ReadSoundStream(*stream);
 }
 
 } //namespace Audio
@@ -97,91 +97,167 @@ int OpusCallbackRead(void* dataSource, unsigned char* ptr, int nBytes)
     return bytesToRead;
 }
 
-const OpusFileCallbacks Opus_Callbacks = {&OpusCallbackRead, nullptr, nullptr, nullptr};
+/*
+ *Replacement for the op_seek_func, the file is in memory so seeking lets
+ *opusfile find the length of the sound.
+ *Returns 0 on success and -1 if the position is out of the file.
+ */
+int OpusCallbackSeek(void* dataSource, opus_int64 offset, int whence)
+{
+	OpusDataSource* data = static_cast<OpusDataSource*>(dataSource);
+	opus_int64 base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		base = data->position;
+		break;
+	case SEEK_END:
+		base = data->audioFile->size();
+		break;
+	default:
+		return -1;
+	}
 
-AudioData LoadOpusCodec(std::string filename)
+	if (offset < -base || base + offset > opus_int64(data->audioFile->size())) {
+		return -1;
+	}
+
+	data->position = base + offset;
+	return 0;
+}
+
+// Replacement for the op_tell_func
+opus_int64 OpusCallbackTell(void* dataSource)
 {
-	std::string audioFile;
-	try
+	return static_cast<OpusDataSource*>(dataSource)->position;
+}
+
+const OpusFileCallbacks Opus_Callbacks = {&OpusCallbackRead, &OpusCallbackSeek, &OpusCallbackTell, nullptr};
+
+class OpusStream : public SoundStream {
+public:
+	OpusStream(std::string filename, std::string audioFile)
+		: filename(std::move(filename)), audioFile(std::move(audioFile)), dataSource{&this->audioFile, 0}
 	{
-		audioFile = FS::PakPath::ReadFile(filename);
 	}
-	catch (std::system_error& err)
+
+	~OpusStream() override
 	{
-		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
-		return AudioData();
+		Close();
 	}
 
-	OpusDataSource dataSource = {&audioFile, 0};
-	OggOpusFile* opusFile = op_open_callbacks(&dataSource, &Opus_Callbacks, nullptr, 0, nullptr);
+	bool Open()
+	{
+		opusFile = op_open_callbacks(&dataSource, &Opus_Callbacks, nullptr, 0, nullptr);
 
-	if (!opusFile) {
-		audioLogs.Warn("Error while reading %s", filename);
-		return AudioData();
-	}
+		if (!opusFile) {
+			audioLogs.Warn("Error while reading %s", filename);
+			return false;
+		}
 
-	const OpusHead* opusInfo = op_head(opusFile, -1);
+		const OpusHead* opusInfo = op_head(opusFile, -1);
 
-	if (!opusInfo) {
-		op_free(opusFile);
-		audioLogs.Warn("Could not read OpusHead in %s", filename);
-		return AudioData();
-	}
+		if (!opusInfo) {
+			audioLogs.Warn("Could not read OpusHead in %s", filename);
+			return false;
+		}
 
-	if (opusInfo->stream_count != 1) {
-		op_free(opusFile);
-		audioLogs.Warn("Only one stream is supported in Opus files: %s", filename);
-		return AudioData();
-	}
+		if (opusInfo->stream_count != 1) {
+			audioLogs.Warn("Only one stream is supported in Opus files: %s", filename);
+			return false;
+		}
 
-	if (opusInfo->channel_count != 1 && opusInfo->channel_count != 2) {
-		op_free(opusFile);
-		audioLogs.Warn("Only mono and stereo Opus files are supported: %s", filename);
-		return AudioData();
-	}
+		if (opusInfo->channel_count != 1 && opusInfo->channel_count != 2) {
+			audioLogs.Warn("Only mono and stereo Opus files are supported: %s", filename);
+			return false;
+		}
+
+		sampleRate = 48000;
+		byteDepth = sizeof(opus_int16);
+		numberOfChannels = opusInfo->channel_count;
 
-	const int sampleWidth = 2;
+		return true;
+	}
 
-	int sampleRate = 48000;
-	int numberOfChannels = opusInfo->channel_count;
+	size_t Read(char* out, size_t size) override
+	{
+		size_t bytesRead = 0;
 
-	/* The largest opus file we have so far is sound/thunder/weather.opus
-	It uncompress to ~13mb. Use 64mb here just in case */
-	static constexpr uint32_t MAX_USED_FILE_SIZE = 64 * 1024 * 1024;
-	static constexpr uint32_t MAX_READ_SIZE      =  1 * 1024 * 1024;
+		// op_read decodes at most a packet at a time
+		while (bytesRead < size) {
+			int toRead = std::min<size_t>((size - bytesRead) / sizeof(opus_int16), INT_MAX);
+			int samplesPerChannelRead = op_read(opusFile, reinterpret_cast<opus_int16*>(out + bytesRead), toRead, nullptr);
 
-	char* buffer = ( char* ) Hunk_AllocateTempMemory( MAX_USED_FILE_SIZE );
-	uint32_t bufferPointer = 0;
-	uint32_t rawSamplesPointer = 0;
+			if (samplesPerChannelRead <= 0) {
+				break;
+			}
 
-	int samplesPerChannelRead = 0;
+			bytesRead += samplesPerChannelRead * numberOfChannels * sizeof(opus_int16);
+		}
 
-	AudioData out { sampleRate, sampleWidth, numberOfChannels };
+		return bytesRead;
+	}
 
-	while ( ( samplesPerChannelRead =
-				op_read( opusFile, ( opus_int16* ) ( buffer + bufferPointer ), MAX_READ_SIZE, nullptr )
-			) > 0 ) {
-		bufferPointer += samplesPerChannelRead * numberOfChannels * sizeof( opus_int16 );
+	size_t DecodedSize() override
+	{
+		ogg_int64_t samplesPerChannel = op_pcm_total(opusFile, -1);
+		return samplesPerChannel > 0 ? samplesPerChannel * byteDepth * numberOfChannels : 0;
+	}
 
-		if ( MAX_USED_FILE_SIZE - bufferPointer < MAX_READ_SIZE ) {
-			out.rawSamples.resize( out.rawSamples.size() + bufferPointer );
-			std::copy_n( buffer, bufferPointer, out.rawSamples.data() + rawSamplesPointer );
+	bool Rewind() override
+	{
+		return op_raw_seek(opusFile, 0) == 0;
+	}
 
-			rawSamplesPointer += bufferPointer;
-			bufferPointer = 0;
+private:
+	void Close()
+	{
+		if (opusFile) {
+			op_free(opusFile);
+			opusFile = nullptr;
 		}
 	}
 
-	if ( bufferPointer ) {
-		out.rawSamples.resize( out.rawSamples.size() + bufferPointer );
-		std::copy_n( buffer, bufferPointer, out.rawSamples.data() + rawSamplesPointer );
+	std::string filename;
+	std::string audioFile;
+	OpusDataSource dataSource;
+	OggOpusFile* opusFile = nullptr;
+};
+
+std::unique_ptr<SoundStream> OpenOpusStream(std::string filename)
+{
+	std::string audioFile;
+	try
+	{
+		audioFile = FS::PakPath::ReadFile(filename);
+	}
+	catch (std::system_error& err)
+	{
+		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
+		return nullptr;
+	}
+
+	std::unique_ptr<OpusStream> stream(new OpusStream(filename, std::move(audioFile)));
+
+	if (!stream->Open()) {
+		return nullptr;
 	}
 
-	Hunk_FreeTempMemory( buffer );
+	return stream;
+}
+
+AudioData LoadOpusCodec(std::string filename)
+{
+	std::unique_ptr<SoundStream> stream = OpenOpusStream(filename);
 
-	op_free(opusFile);
+	if (!stream) {
+		return AudioData();
+	}
 
-	return out;
+	return ReadSoundStream(*stream);
 }
 
 } //namespace Audio
@@ -35,6 +35,26 @@ namespace Audio {
 
     Resource::Manager<Sample>* sampleManager;
 
+    // Samples decoded by PrefetchSample, until they are loaded or the
+    // registration ends
+    static std::mutex prefetchMutex;
+    static std::unordered_map<std::string, AudioData> prefetchedSamples;
+
+    static AudioData LoadSample(const std::string& filename) {
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            auto it = prefetchedSamples.find(filename);
+
+            if (it != prefetchedSamples.end()) {
+                AudioData audioData = std::move(it->second);
+                prefetchedSamples.erase(it);
+                return audioData;
+            }
+        }
+
+        return LoadSoundCodec(filename);
+    }
+
     // Implementation of Sample
 
     Sample::Sample(std::string filename): Resource(filename) {
@@ -60,7 +80,7 @@ namespace Audio {
 			return true;
 		}
 
-	    AudioData audioData = LoadSoundCodec(GetName());
+	    AudioData audioData = LoadSample(GetName());
 
 	    if ( !audioData.rawSamples.size() ) {
 		    audioLogs.Debug("Couldn't load sound %s, it's empty!", GetName());
@@ -140,7 +160,34 @@ namespace Audio {
         return sample.Get();
     }
 
+    void PrefetchSample(Str::StringRef filename) {
+        // The sample manager is not modified while the samples are prefetched
+        if (sampleManager->IsLoaded(filename)) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            if (prefetchedSamples.count(filename)) {
+                return;
+            }
+        }
+
+        AudioData audioData = LoadSoundCodec(filename);
+
+        // Failures are reported again when loading
+        if (audioData.rawSamples.empty()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+        prefetchedSamples.emplace(filename, std::move(audioData));
+    }
+
     void EndSampleRegistration() {
         sampleManager->EndRegistration();
+
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+        prefetchedSamples.clear();
     }
 }
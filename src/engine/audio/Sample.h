@@ -117,6 +117,8 @@ namespace Audio {
 
     void BeginSampleRegistration();
     std::shared_ptr<Sample> RegisterSample(Str::StringRef filename);
+    // Decodes a sample ahead of its loading, can be called from worker threads
+    void PrefetchSample(Str::StringRef filename);
     void EndSampleRegistration();
 }
 
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "AudioPrivate.h"
+#include "SoundCodec.h"
 
 namespace Audio {
     /* When adding an entry point to the audio subsystem,
@@ -351,4 +352,146 @@ namespace Audio {
             source->Play();
         }
     }
+
+    // Implementation of StreamedSound
+
+    // Each chunk is about a quarter of a second of sound
+    static CONSTEXPR int CHUNKS_PER_SECOND = 4;
+    // Chunks decoded ahead by the thread and chunks queued in the source
+    static CONSTEXPR size_t MAX_DECODED_CHUNKS = 4;
+    static CONSTEXPR int MAX_QUEUED_CHUNKS = 4;
+
+    StreamedSound::StreamedSound(std::unique_ptr<SoundStream> leadingStream, std::unique_ptr<SoundStream> loopingStream)
+        : leadingStream(std::move(leadingStream)),
+          loopingStream(std::move(loopingStream)),
+          finished(false),
+          quit(false) {
+        thread = std::thread(&StreamedSound::DecodeThread, this);
+    }
+
+    StreamedSound::~StreamedSound() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+
+        chunkConsumed.notify_all();
+        thread.join();
+    }
+
+    void StreamedSound::DecodeThread() {
+        bool looped = false;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunkConsumed.wait(lock, [&] { return quit or decodedChunks.size() < MAX_DECODED_CHUNKS; });
+
+                if (quit) {
+                    return;
+                }
+            }
+
+            SoundStream* stream = leadingStream ? leadingStream.get() : loopingStream.get();
+
+            if (not stream) {
+                break;
+            }
+
+            size_t frameSize = stream->byteDepth * stream->numberOfChannels;
+            size_t chunkSize = stream->sampleRate / CHUNKS_PER_SECOND * frameSize;
+
+            AudioData chunk { stream->sampleRate, stream->byteDepth, stream->numberOfChannels };
+            chunk.rawSamples.resize(chunkSize);
+            chunk.rawSamples.resize(stream->Read(chunk.rawSamples.data(), chunkSize));
+
+            if (chunk.rawSamples.empty()) {
+                if (stream == leadingStream.get()) {
+                    leadingStream = nullptr;
+                    continue;
+                }
+
+                // Stop if the looping stream is empty or can't be decoded again
+                if (looped or not stream->Rewind()) {
+                    break;
+                }
+
+                looped = true;
+                continue;
+            }
+
+            looped = false;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            decodedChunks.push_back(std::move(chunk));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+
+    Util::optional<AudioData> StreamedSound::PopDecodedChunk() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (decodedChunks.empty()) {
+            return Util::nullopt;
+        }
+
+        Util::optional<AudioData> chunk(std::move(decodedChunks.front()));
+        decodedChunks.pop_front();
+        lock.unlock();
+
+        chunkConsumed.notify_one();
+        return chunk;
+    }
+
+    bool StreamedSound::IsFinished() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return finished and decodedChunks.empty();
+    }
+
+    // Called on the main thread only as it uses OpenAL
+    void StreamedSound::QueueDecodedChunks() {
+        while (source->GetNumQueuedBuffers() < MAX_QUEUED_CHUNKS) {
+            Util::optional<AudioData> chunk = PopDecodedChunk();
+
+            if (not chunk) {
+                return;
+            }
+
+            AL::Buffer buffer;
+
+            if (not buffer.Feed(*chunk)) {
+                source->QueueBuffer(std::move(buffer));
+            }
+        }
+    }
+
+    void StreamedSound::SetupSource(AL::Source&) {
+        soundGain = volumeModifier->Get();
+    }
+
+    void StreamedSound::InternalUpdate() {
+        while (source->GetNumProcessedBuffers() > 0) {
+            source->PopBuffer();
+        }
+
+        QueueDecodedChunks();
+
+        if (source->GetNumQueuedBuffers() == 0) {
+            // Otherwise the decoding thread is late, wait for it
+            if (IsFinished()) {
+                Stop();
+            }
+
+            return;
+        }
+
+        // Restart the source if it ran out of buffers
+        if (source->IsStopped()) {
+            source->Play();
+        }
+
+        soundGain = volumeModifier->Get();
+    }
 }
@@ -126,6 +126,38 @@ namespace Audio {
             void AppendBuffer(AL::Buffer buffer);
     };
 
+    class SoundStream;
+
+    // A sound decoded while it is played, such as the music. The leading stream is played
+    // once then the looping stream forever. A thread decodes a few chunks ahead.
+    class StreamedSound : public Sound {
+        public:
+            StreamedSound(std::unique_ptr<SoundStream> leadingStream, std::unique_ptr<SoundStream> loopingStream);
+            virtual ~StreamedSound() override;
+
+            virtual void SetupSource(AL::Source& source) override;
+            virtual void InternalUpdate() override;
+
+            // Takes the oldest decoded chunk, if the thread decoded one already
+            Util::optional<AudioData> PopDecodedChunk();
+            // True once the thread decoded everything and all the chunks were taken
+            bool IsFinished();
+
+        private:
+            void DecodeThread();
+            void QueueDecodedChunks();
+
+            std::unique_ptr<SoundStream> leadingStream;
+            std::unique_ptr<SoundStream> loopingStream;
+
+            std::mutex mutex;
+            std::condition_variable chunkConsumed;
+            std::deque<AudioData> decodedChunks;
+            bool finished;
+            bool quit;
+            std::thread thread;
+    };
+
 }
 
 #endif //AUDIO_SOUND_H_
@@ -37,15 +37,17 @@ struct soundExtToLoaderMap_t
 {
 	const char *ext;
 	AudioData (*SoundLoader) (std::string);
+	// nullptr if the format can't be streamed
+	std::unique_ptr<SoundStream> (*StreamOpener) (std::string);
 };
 
 // Note that the ordering indicates the order of preference used
 // when there are multiple sound files of different formats available
 static const soundExtToLoaderMap_t soundLoaders[] =
 {
-	{ ".wav",	LoadWavCodec },
-	{ ".opus",	LoadOpusCodec  },
-	{ ".ogg",	LoadOggCodec  },
+	{ ".wav",	LoadWavCodec, nullptr },
+	{ ".opus",	LoadOpusCodec, OpenOpusStream },
+	{ ".ogg",	LoadOggCodec, OpenOggStream },
 };
 
 static int numSoundLoaders = ARRAY_LEN(soundLoaders);
@@ -75,9 +77,9 @@ static int FindSoundLoader(std::string filename)
 	return bestLoader;
 }
 
-AudioData LoadSoundCodec(std::string filename)
+// Returns the loader to use and changes filename to the file to load, -1 if there is none
+static int ResolveSoundLoader(std::string& filename)
 {
-
 	std::string ext = FS::Path::Extension(filename);
 
 	// if filename has extension, try to load it
@@ -87,7 +89,7 @@ AudioData LoadSoundCodec(std::string filename)
 			if (ext == soundLoaders[i].ext) {
 				// if file exists, load it
 				if (FS::PakPath::FileExists(filename)) {
-					return soundLoaders[i].SoundLoader(filename);
+					return i;
 				}
 			}
 		}
@@ -109,8 +111,19 @@ AudioData LoadSoundCodec(std::string filename)
 
 	if (bestLoader >= 0)
 	{
-		std::string altName = Str::Format("%s%s", filename, soundLoaders[bestLoader].ext );
-		return soundLoaders[bestLoader].SoundLoader(altName);
+		filename = Str::Format("%s%s", filename, soundLoaders[bestLoader].ext );
+	}
+
+	return bestLoader;
+}
+
+AudioData LoadSoundCodec(std::string filename)
+{
+	int loader = ResolveSoundLoader(filename);
+
+	if (loader >= 0)
+	{
+		return soundLoaders[loader].SoundLoader(filename);
 	}
 
 	if (FS::PakPath::FileExists(filename)) {
@@ -122,4 +135,53 @@ AudioData LoadSoundCodec(std::string filename)
 	return AudioData();
 
 }
+
+std::unique_ptr<SoundStream> OpenSoundStream(std::string filename)
+{
+	int loader = ResolveSoundLoader(filename);
+
+	// Missing files are reported when falling back to LoadSoundCodec
+	if (loader < 0 || !soundLoaders[loader].StreamOpener)
+	{
+		return nullptr;
+	}
+
+	return soundLoaders[loader].StreamOpener(filename);
+}
+
+AudioData ReadSoundStream(SoundStream& stream)
+{
+	// Decode straight into the samples, sized from the stream when it knows
+	// its length (with a frame more to see the end), in large chunks otherwise
+	static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+
+	AudioData out { stream.sampleRate, stream.byteDepth, stream.numberOfChannels };
+	size_t frameSize = stream.byteDepth * stream.numberOfChannels;
+	size_t chunkSize = CHUNK_SIZE - CHUNK_SIZE % frameSize;
+	size_t decodedSize = stream.DecodedSize();
+	size_t size = 0;
+
+	out.rawSamples.resize(decodedSize ? decodedSize + frameSize : chunkSize);
+
+	while (true) {
+		if (size == out.rawSamples.size()) {
+			out.rawSamples.resize(size + chunkSize);
+		}
+
+		size_t bytesRead = stream.Read(out.rawSamples.data() + size, out.rawSamples.size() - size);
+
+		if (bytesRead == 0) {
+			break;
+		}
+
+		size += bytesRead;
+	}
+
+	out.rawSamples.resize(size);
+	if (out.rawSamples.capacity() - size >= chunkSize) {
+		out.rawSamples.shrink_to_fit();
+	}
+
+	return out;
+}
 } // namespace Audio
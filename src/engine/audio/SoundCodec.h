@@ -32,12 +32,48 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SOUND_CODEC_H
 
 #include "AudioData.h"
+#include <memory>
 #include <string>
 
 namespace Audio {
 
+    // Decodes a sound progressively, for the music and other long sounds that
+    // would take a lot of memory once entirely decoded.
+    class SoundStream {
+        public:
+            SoundStream() = default;
+            virtual ~SoundStream() = default;
+
+            SoundStream(const SoundStream& other) = delete;
+            SoundStream& operator=(const SoundStream& other) = delete;
+
+            // Decodes up to size bytes of samples, size must be a multiple of the frame size.
+            // Returns the number of bytes decoded, 0 at the end of the sound or on errors.
+            virtual size_t Read(char* out, size_t size) = 0;
+            // Starts decoding from the beginning of the sound again.
+            virtual bool Rewind() = 0;
+            // Size in bytes of the whole decoded sound, 0 if it isn't known.
+            virtual size_t DecodedSize() {
+                return 0;
+            }
+
+            int sampleRate = 0;
+            int byteDepth = 0;
+            int numberOfChannels = 0;
+    };
+
+    // Decodes what is left of a stream
+    AudioData ReadSoundStream(SoundStream& stream);
+
     AudioData LoadSoundCodec(std::string filename);
 
+    // Returns nullptr if the sound doesn't exist or its format can't be streamed
+    std::unique_ptr<SoundStream> OpenSoundStream(std::string filename);
+
+    std::unique_ptr<SoundStream> OpenOggStream(std::string filename);
+
+    std::unique_ptr<SoundStream> OpenOpusStream(std::string filename);
+
     AudioData LoadWavCodec(std::string filename);
 
     AudioData LoadOggCodec(std::string filename);
@@ -0,0 +1,240 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/FileSystem.h"
+
+#include "engine/audio/AudioPrivate.h"
+#include "engine/audio/SoundCodec.h"
+
+#define OV_EXCLUDE_STATIC_CALLBACKS
+#include <vorbis/vorbisfile.h>
+#include <opusfile.h>
+
+namespace Audio {
+namespace {
+
+const char* const SOUND_NAMES[] = {
+    "sound/streamtest/stereo.ogg",
+    "sound/streamtest/mono.opus",
+};
+
+class SoundStreamTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        const FS::PakInfo* pak = FS::FindPak("testdata", "src");
+        if (!pak) {
+            FAIL() << "Test data not available - some tests will be skipped. Please add daemon/pkg/ to the pak path";
+        }
+        FS::PakPath::LoadPak(*pak);
+    }
+
+    // Decodes the whole sound with a plain ov_read / op_read loop, independently of the codecs
+    static std::vector<char> ReferenceDecode(Str::StringRef name)
+    {
+        std::string data = FS::PakPath::ReadFile(name);
+        std::vector<char> samples;
+        char buffer[4096];
+
+        if (Str::IsSuffix(".ogg", name)) {
+            struct Source {
+                const std::string* data;
+                size_t position;
+            } source{&data, 0};
+            ov_callbacks callbacks = {[](void* out, size_t size, size_t count, void* datasource) -> size_t {
+                Source* source = static_cast<Source*>(datasource);
+                size_t bytes = std::min(size * count, source->data->size() - source->position);
+                memcpy(out, source->data->data() + source->position, bytes);
+                source->position += bytes;
+                return bytes / size;
+            }, nullptr, nullptr, nullptr};
+
+            OggVorbis_File vorbisFile;
+            EXPECT_EQ(0, ov_open_callbacks(&source, &vorbisFile, nullptr, 0, callbacks)) << name;
+            int bitStream = 0;
+            long bytesRead;
+            while ((bytesRead = ov_read(&vorbisFile, buffer, sizeof(buffer), 0, 2, 1, &bitStream)) > 0) {
+                samples.insert(samples.end(), buffer, buffer + bytesRead);
+            }
+            ov_clear(&vorbisFile);
+        } else {
+            int error = 0;
+            OggOpusFile* opusFile = op_open_memory(reinterpret_cast<const unsigned char*>(data.data()), data.size(), &error);
+            EXPECT_TRUE(opusFile) << name << " " << error;
+            if (!opusFile) {
+                return samples;
+            }
+            int channels = op_channel_count(opusFile, -1);
+            int samplesRead;
+            opus_int16* pcm = reinterpret_cast<opus_int16*>(buffer);
+            while ((samplesRead = op_read(opusFile, pcm, sizeof(buffer) / sizeof(opus_int16), nullptr)) > 0) {
+                samples.insert(samples.end(), buffer, buffer + samplesRead * channels * sizeof(opus_int16));
+            }
+            op_free(opusFile);
+        }
+
+        return samples;
+    }
+
+    // Reads the stream in small chunks that don't match the codec's packets
+    static std::vector<char> ReadInChunks(SoundStream& stream)
+    {
+        size_t chunkSize = 997 * stream.byteDepth * stream.numberOfChannels;
+        std::vector<char> samples;
+        while (true) {
+            size_t size = samples.size();
+            samples.resize(size + chunkSize);
+            size_t bytesRead = stream.Read(samples.data() + size, chunkSize);
+            samples.resize(size + bytesRead);
+            if (bytesRead == 0) {
+                return samples;
+            }
+            EXPECT_EQ(0u, bytesRead % (stream.byteDepth * stream.numberOfChannels));
+        }
+    }
+};
+
+TEST_F(SoundStreamTest, SameAsFullDecode)
+{
+    for (const char* name : SOUND_NAMES) {
+        std::vector<char> reference = ReferenceDecode(name);
+        ASSERT_FALSE(reference.empty()) << name;
+
+        AudioData full = LoadSoundCodec(name);
+        EXPECT_EQ(reference, full.rawSamples) << name;
+
+        std::unique_ptr<SoundStream> stream = OpenSoundStream(name);
+        ASSERT_TRUE(stream) << name;
+        EXPECT_EQ(full.sampleRate, stream->sampleRate);
+        EXPECT_EQ(full.byteDepth, stream->byteDepth);
+        EXPECT_EQ(full.numberOfChannels, stream->numberOfChannels);
+
+        std::vector<char> streamed = ReadInChunks(*stream);
+        EXPECT_EQ(reference, streamed) << name;
+        EXPECT_EQ(0u, stream->Read(streamed.data(), 2 * stream->numberOfChannels));
+
+        // The music loops by rewinding the stream
+        ASSERT_TRUE(stream->Rewind()) << name;
+        EXPECT_EQ(reference, ReadInChunks(*stream)) << name;
+    }
+}
+
+TEST_F(SoundStreamTest, WithoutExtension)
+{
+    for (const char* name : SOUND_NAMES) {
+        std::unique_ptr<SoundStream> stream = OpenSoundStream(FS::Path::StripExtension(name));
+        ASSERT_TRUE(stream) << name;
+        std::vector<char> samples(1024);
+        EXPECT_NE(0u, stream->Read(samples.data(), samples.size()));
+    }
+}
+
+// Takes the chunks of the decode thread until the given number of bytes
+// is reached or the sound is finished
+static std::vector<AudioData> TakeChunks(StreamedSound& sound, size_t maxBytes)
+{
+    std::vector<AudioData> chunks;
+    size_t bytes = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+    while (bytes < maxBytes && std::chrono::steady_clock::now() < deadline) {
+        Util::optional<AudioData> chunk = sound.PopDecodedChunk();
+        if (chunk) {
+            EXPECT_FALSE(chunk->rawSamples.empty());
+            bytes += chunk->rawSamples.size();
+            chunks.push_back(std::move(*chunk));
+        } else if (sound.IsFinished()) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    return chunks;
+}
+
+// Concatenates the samples of the chunks of the given number of channels, starting at the given chunk
+static std::vector<char> ConcatChunks(const std::vector<AudioData>& chunks, size_t& index, int numberOfChannels, size_t maxBytes)
+{
+    std::vector<char> samples;
+    for (; index < chunks.size() && chunks[index].numberOfChannels == numberOfChannels && samples.size() < maxBytes; index++) {
+        samples.insert(samples.end(), chunks[index].rawSamples.begin(), chunks[index].rawSamples.end());
+    }
+    return samples;
+}
+
+TEST_F(SoundStreamTest, StreamedSoundLeadingOnly)
+{
+    std::vector<char> reference = ReferenceDecode(SOUND_NAMES[0]);
+
+    StreamedSound sound(OpenSoundStream(SOUND_NAMES[0]), nullptr);
+    std::vector<AudioData> chunks = TakeChunks(sound, SIZE_MAX);
+    ASSERT_TRUE(sound.IsFinished());
+
+    size_t index = 0;
+    EXPECT_EQ(reference, ConcatChunks(chunks, index, 2, SIZE_MAX));
+    EXPECT_EQ(chunks.size(), index);
+    EXPECT_FALSE(sound.PopDecodedChunk());
+}
+
+TEST_F(SoundStreamTest, StreamedSoundLoops)
+{
+    // The leading sound is mono and the looping one stereo so the chunks can be told apart
+    std::vector<char> leading = ReferenceDecode(SOUND_NAMES[1]);
+    std::vector<char> looping = ReferenceDecode(SOUND_NAMES[0]);
+
+    std::vector<AudioData> chunks;
+    {
+        StreamedSound sound(OpenSoundStream(SOUND_NAMES[1]), OpenSoundStream(SOUND_NAMES[0]));
+        chunks = TakeChunks(sound, leading.size() + 3 * looping.size());
+        EXPECT_FALSE(sound.IsFinished());
+        // The destructor stops the thread while it waits for the chunks to be consumed
+    }
+
+    size_t index = 0;
+    EXPECT_EQ(leading, ConcatChunks(chunks, index, 1, SIZE_MAX));
+
+    // Chunks don't span a rewind so each loop starts on a new chunk
+    for (int loop = 0; loop < 2; loop++) {
+        EXPECT_EQ(looping, ConcatChunks(chunks, index, 2, looping.size())) << loop;
+    }
+}
+
+TEST_F(SoundStreamTest, NotFound)
+{
+    EXPECT_FALSE(OpenSoundStream("sound/streamtest/missing.ogg"));
+}
+
+} // namespace
+} // namespace Audio
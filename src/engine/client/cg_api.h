@@ -98,6 +98,24 @@ struct trustedServerInfo_t
 	char featuredLabel[ MAX_FEATLABEL_CHARS ];
 };
 
+enum class assetType_t : uint8_t
+{
+	MODEL,
+	SKIN,
+	SHADER,
+	SOUND,
+	ANIMATION,
+};
+
+// An asset registered by CG_REGISTERASSETS, flags are the RSF_* flags of
+// shaders
+struct assetRegistration_t
+{
+	assetType_t type;
+	int         flags;
+	std::string name;
+};
+
 using markMsgInput_t = std::pair<
 	std::vector<std::array<float, 3>>, // points
 	std::array<float, 3> // projection
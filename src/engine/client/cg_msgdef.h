@@ -55,6 +55,24 @@ namespace Util {
 		}
 	};
 
+	template<> struct SerializeTraits<assetRegistration_t> {
+		static void Write(Writer& stream, const assetRegistration_t& asset)
+		{
+			stream.Write<assetType_t>(asset.type);
+			stream.Write<int>(asset.flags);
+			stream.Write<std::string>(asset.name);
+		}
+
+		static assetRegistration_t Read(Reader& stream)
+		{
+			assetRegistration_t asset;
+			asset.type = stream.Read<assetType_t>();
+			asset.flags = stream.Read<int>();
+			asset.name = stream.Read<std::string>();
+			return asset;
+		}
+	};
+
 	// For skeletons, only send the bones which are used
 	template<> struct SerializeTraits<refSkeleton_t> {
 		static void Write(Writer& stream, const refSkeleton_t& skel)
@@ -283,6 +301,10 @@ enum cgameImport_t
   CG_LAN_RESETPINGS,
   CG_LAN_SERVERSTATUS,
   CG_LAN_RESETSERVERSTATUS,
+
+  CG_SNAPSHOTRING_LOCATE,
+  CG_R_BUILDSKELETONS,
+  CG_REGISTERASSETS,
 };
 
 // All Miscs
@@ -314,6 +336,8 @@ using GetSnapshotMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, CG_GETSNAPSHOT>, int>,
 	IPC::Reply<bool, ipcSnapshot_t>
 >;
+// shared memory and number of entities per slot, see cg_snapshot_ring.h
+using SnapshotRingLocateMsg = IPC::Message<IPC::Id<VM::QVM, CG_SNAPSHOTRING_LOCATE>, IPC::SharedMemory, int>;
 using GetCurrentCmdNumberMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, CG_GETCURRENTCMDNUMBER>>,
 	IPC::Reply<int>
@@ -324,6 +348,12 @@ using GetUserCmdMsg = IPC::SyncMessage<
 >;
 using SetUserCmdValueMsg = IPC::Message<IPC::Id<VM::QVM, CG_SETUSERCMDVALUE>, int, int, float>;
 using RegisterButtonCommandsMsg = IPC::Message<IPC::Id<VM::QVM, CG_REGISTER_BUTTON_COMMANDS>, std::string>;
+// Registers models, skins, shaders, sounds and animations in one go, their
+// files are read and decoded in parallel
+using RegisterAssetsMsg = IPC::SyncMessage<
+	IPC::Message<IPC::Id<VM::QVM, CG_REGISTERASSETS>, std::vector<assetRegistration_t>>,
+	IPC::Reply<std::vector<int>>
+>;
 using NotifyTeamChangeMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, CG_NOTIFY_TEAMCHANGE>, int>
 >;
@@ -403,6 +433,62 @@ namespace Render {
 		IPC::Message<IPC::Id<VM::QVM, CG_R_BUILDSKELETON>, int, int, int, float, bool>,
 		IPC::Reply<refSkeleton_t, int>
 	>;
+	using BuildSkeletonsMsg = IPC::SyncMessage<
+		IPC::Message<IPC::Id<VM::QVM, CG_R_BUILDSKELETONS>, std::vector<SkeletonBuild>>,
+		IPC::Reply<std::vector<SkeletonBuildResult>, std::vector<SkeletonBone>>
+	>;
+
+	// Packing of the CG_R_BUILDSKELETONS replies
+	inline void AppendSkeleton( const refSkeleton_t& skel, int result, bool returnBones,
+		std::vector<SkeletonBuildResult>& results, std::vector<SkeletonBone>& bones )
+	{
+		SkeletonBuildResult out;
+		out.result = result;
+		out.type = skel.type;
+		out.numBones = returnBones ? skel.numBones : 0;
+		VectorCopy( skel.bounds[ 0 ], out.bounds[ 0 ] );
+		VectorCopy( skel.bounds[ 1 ], out.bounds[ 1 ] );
+		results.push_back( out );
+
+		for ( int i = 0; i < out.numBones; i++ )
+		{
+			const refBone_t& bone = skel.bones[ i ];
+			SkeletonBone packed;
+			packed.parentIndex = bone.parentIndex;
+			QuatCopy( bone.t.rot, packed.rot );
+			VectorCopy( bone.t.trans, packed.trans );
+			packed.scale = bone.t.scale;
+			bones.push_back( packed );
+		}
+	}
+
+	// Returns the index of the bones of the next result
+	inline size_t ExtractSkeleton( const SkeletonBuildResult& result, const std::vector<SkeletonBone>& bones,
+		size_t firstBone, refSkeleton_t& skel )
+	{
+		if ( result.numBones < 0 || result.numBones > MAX_BONES || bones.size() - firstBone < size_t( result.numBones ) )
+		{
+			Sys::Drop( "IPC: Invalid skeleton in CG_R_BUILDSKELETONS reply" );
+		}
+
+		skel.type = result.type;
+		skel.numBones = result.numBones;
+		VectorCopy( result.bounds[ 0 ], skel.bounds[ 0 ] );
+		VectorCopy( result.bounds[ 1 ], skel.bounds[ 1 ] );
+
+		for ( int i = 0; i < result.numBones; i++ )
+		{
+			const SkeletonBone& packed = bones[ firstBone + i ];
+			refBone_t& bone = skel.bones[ i ];
+			bone.parentIndex = packed.parentIndex;
+			QuatCopy( packed.rot, bone.t.rot );
+			VectorCopy( packed.trans, bone.t.trans );
+			bone.t.scale = packed.scale;
+		}
+
+		return firstBone + result.numBones;
+	}
+
 	using BoneIndexMsg = IPC::SyncMessage<
 		IPC::Message<IPC::Id<VM::QVM, CG_R_BONEINDEX>, int, std::string>,
 		IPC::Reply<int>
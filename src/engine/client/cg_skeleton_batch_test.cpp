@@ -0,0 +1,334 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/FileSystem.h"
+#include "engine/renderer/tr_local.h"
+#include "client.h"
+#include "cg_msgdef.h"
+
+namespace {
+
+// Synthetic skeleton standing for what RE_BuildSkeleton gives for a frame
+void FakeBuildSkeleton(refSkeleton_t& skel, const SkeletonBuild& build, int numBones)
+{
+    skel.type = refSkeletonType_t::SK_RELATIVE;
+    skel.numBones = numBones;
+    VectorSet(skel.bounds[0], -build.anim, -16, -24);
+    VectorSet(skel.bounds[1], build.anim, 16, 32);
+    for (int i = 0; i < numBones; i++) {
+        refBone_t& bone = skel.bones[i];
+        bone.parentIndex = i - 1;
+        VectorSet(bone.t.trans, i, build.startFrame, build.lerp);
+        Vector4Set(bone.t.rot, 0, 0, build.lerp, 1);
+        bone.t.scale = 1;
+    }
+}
+
+TEST(SkeletonBatchTest, PackUnpack)
+{
+    std::vector<SkeletonBuild> builds(3);
+    for (size_t i = 0; i < builds.size(); i++) {
+        builds[i] = {};
+        builds[i].anim = i + 1;
+        builds[i].startFrame = 10 * i;
+        builds[i].lerp = 0.25f * i;
+        builds[i].returnBones = i != 1;
+    }
+
+    std::vector<SkeletonBuildResult> results;
+    std::vector<SkeletonBone> bones;
+    for (const SkeletonBuild& build : builds) {
+        refSkeleton_t skel;
+        FakeBuildSkeleton(skel, build, 20 + build.anim);
+        Render::AppendSkeleton(skel, true, build.returnBones, results, bones);
+    }
+
+    // The bones of the second skeleton were not requested
+    ASSERT_EQ(3U, results.size());
+    EXPECT_EQ(0, results[1].numBones);
+    EXPECT_EQ(21U + 23U, bones.size());
+
+    size_t firstBone = 0;
+    for (const SkeletonBuild& build : builds) {
+        const SkeletonBuildResult& result = results[&build - builds.data()];
+        EXPECT_TRUE(result.result);
+        if (!build.returnBones) {
+            continue;
+        }
+
+        refSkeleton_t expected, skel;
+        FakeBuildSkeleton(expected, build, 20 + build.anim);
+        firstBone = Render::ExtractSkeleton(result, bones, firstBone, skel);
+
+        ASSERT_EQ(expected.numBones, skel.numBones);
+        EXPECT_EQ(expected.type, skel.type);
+        EXPECT_TRUE(VectorCompare(expected.bounds[0], skel.bounds[0]));
+        EXPECT_TRUE(VectorCompare(expected.bounds[1], skel.bounds[1]));
+        for (int i = 0; i < skel.numBones; i++) {
+            EXPECT_EQ(expected.bones[i].parentIndex, skel.bones[i].parentIndex);
+            EXPECT_TRUE(VectorCompare(expected.bones[i].t.trans, skel.bones[i].t.trans));
+            EXPECT_EQ(expected.bones[i].t.rot[2], skel.bones[i].t.rot[2]);
+        }
+    }
+    EXPECT_EQ(bones.size(), firstBone);
+}
+
+const char* const ANIMATION_NAME = "models/animcache/test.md5anim";
+
+// Only used when the renderer was not started
+void* TestHunkAlloc(int size, ha_pref)
+{
+    static std::vector<std::unique_ptr<byte[]>> blocks;
+    blocks.emplace_back(new byte[size]());
+    return blocks.back().get();
+}
+
+// Registers the test animation to build real skeletons with the renderer
+class SkeletonBuildTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        const FS::PakInfo* pak = FS::FindPak("testdata", "src");
+        if (!pak) {
+            FAIL() << "Test data not available - some tests will be skipped. Please add daemon/pkg/ to the pak path";
+        }
+        FS::PakPath::LoadPak(*pak);
+
+        if (!ri.Hunk_Alloc) {
+            ri.Hunk_Alloc = TestHunkAlloc;
+        }
+        if (!re.BuildSkeleton) {
+            re.BuildSkeleton = RE_BuildSkeleton;
+            re.BlendSkeleton = RE_BlendSkeleton;
+        }
+        if (tr.numAnimations == 0) {
+            R_InitAnimations();
+        }
+
+        numAnimations = tr.numAnimations;
+        frameCount = tr.frameCount;
+        anim = RE_RegisterAnimation(ANIMATION_NAME);
+        ASSERT_NE(anim, 0);
+        numFrames = RE_AnimNumFrames(anim);
+        R_ClearSkeletonCache();
+    }
+
+    void TearDown() override
+    {
+        tr.numAnimations = numAnimations;
+        tr.frameCount = frameCount;
+        R_ClearSkeletonCache();
+        Cvar::SetValue("r_skeletonCache", "1");
+    }
+
+    // The skeletons of animated players: legs, torso and a blended attack
+    std::vector<SkeletonBuild> PlayerBuilds(int numEntities)
+    {
+        std::vector<SkeletonBuild> builds(numEntities * 3);
+        for (size_t i = 0; i < builds.size(); i++) {
+            SkeletonBuild& build = builds[i];
+            build = {};
+            build.anim = anim;
+            build.startFrame = (i / 3) % numFrames;
+            build.endFrame = (build.startFrame + 1) % numFrames;
+            build.lerp = 0.25f * (i % 3);
+            if (i % 3 == 2) {
+                build.blendAnim = anim;
+                build.blendStartFrame = (build.startFrame + 2) % numFrames;
+                build.blendEndFrame = build.startFrame;
+                build.blendLerp = 0.5f;
+                build.blendFrac = 0.3f;
+            }
+            build.returnBones = true;
+        }
+        return builds;
+    }
+
+    qhandle_t anim;
+    int numFrames;
+    int numAnimations;
+    int frameCount;
+};
+
+// CG_R_BUILDSKELETONS gives the same skeletons as building them one by one,
+// also when the renderer cache already has them
+TEST_F(SkeletonBuildTest, SameAsSingleBuilds)
+{
+    std::vector<SkeletonBuild> builds = PlayerBuilds(8);
+
+    Cvar::SetValue("r_skeletonCache", "0");
+    std::vector<refSkeleton_t> expected(builds.size());
+    for (size_t i = 0; i < builds.size(); i++) {
+        const SkeletonBuild& build = builds[i];
+        ASSERT_TRUE(RE_BuildSkeleton(&expected[i], build.anim, build.startFrame, build.endFrame, build.lerp, false));
+        if (build.blendAnim) {
+            refSkeleton_t blend;
+            ASSERT_TRUE(RE_BuildSkeleton(&blend, build.blendAnim, build.blendStartFrame, build.blendEndFrame, build.blendLerp, false));
+            ASSERT_TRUE(RE_BlendSkeleton(&expected[i], &blend, build.blendFrac));
+        }
+    }
+
+    Cvar::SetValue("r_skeletonCache", "1");
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<SkeletonBuildResult> results;
+        std::vector<SkeletonBone> bones;
+        CL_BuildSkeletons(builds, results, bones);
+        ASSERT_EQ(builds.size(), results.size());
+
+        size_t firstBone = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            refSkeleton_t skel;
+            EXPECT_TRUE(results[i].result);
+            firstBone = Render::ExtractSkeleton(results[i], bones, firstBone, skel);
+
+            ASSERT_EQ(expected[i].numBones, skel.numBones);
+            for (int j = 0; j < skel.numBones; j++) {
+                EXPECT_EQ(expected[i].bones[j].parentIndex, skel.bones[j].parentIndex);
+                EXPECT_TRUE(VectorCompare(expected[i].bones[j].t.trans, skel.bones[j].t.trans));
+                EXPECT_EQ(0, memcmp(expected[i].bones[j].t.rot, skel.bones[j].t.rot, sizeof(quat_t)));
+            }
+        }
+    }
+}
+
+// Compares building the skeletons of animated players with one
+// CG_R_BUILDSKELETON round trip each and with a single CG_R_BUILDSKELETONS,
+// through a socket to a thread running the engine handlers. The renderer
+// then builds the skeletons again for the entities, as it does in a frame.
+TEST_F(SkeletonBuildTest, DISABLED_BuildSkeletonsBenchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int numEntities = 40;
+    constexpr int numTimedFrames = 200;
+
+    std::vector<SkeletonBuild> builds = PlayerBuilds(numEntities);
+
+    auto sockets = IPC::Socket::CreatePair();
+    std::thread engine([&] {
+        while (true) {
+            Util::Reader request = sockets.second.RecvMsg();
+            Util::Writer reply;
+            switch (request.Read<int>()) {
+            case CG_R_BUILDSKELETON: {
+                SkeletonBuild build = request.Read<SkeletonBuild>();
+                refSkeleton_t skel;
+                int res = re.BuildSkeleton(&skel, build.anim, build.startFrame, build.endFrame, build.lerp, build.clearOrigin);
+                reply.Write<refSkeleton_t>(skel);
+                reply.Write<int>(res);
+                break;
+            }
+            case CG_R_BUILDSKELETONS: {
+                std::vector<SkeletonBuildResult> results;
+                std::vector<SkeletonBone> bones;
+                CL_BuildSkeletons(request.Read<std::vector<SkeletonBuild>>(), results, bones);
+                reply.Write<std::vector<SkeletonBuildResult>>(results);
+                reply.Write<std::vector<SkeletonBone>>(bones);
+                break;
+            }
+            default:
+                return;
+            }
+            sockets.second.SendMsg(reply);
+        }
+    });
+
+    static refSkeleton_t skeletons[numEntities * 3];
+
+    // What the renderer does for each entity after the cgame built its skeletons
+    auto renderEntities = [&] {
+        refSkeleton_t skel;
+        for (const SkeletonBuild& build : builds) {
+            RE_BuildSkeleton(&skel, build.anim, build.startFrame, build.endFrame, build.lerp, build.clearOrigin);
+        }
+        tr.frameCount++;
+    };
+
+    auto timeSingle = [&] {
+        auto start = Clock::now();
+        for (int frame = 0; frame < numTimedFrames; frame++) {
+            for (size_t i = 0; i < builds.size(); i++) {
+                Util::Writer request;
+                request.Write<int>(CG_R_BUILDSKELETON);
+                request.Write<SkeletonBuild>(builds[i]);
+                sockets.first.SendMsg(request);
+                Util::Reader reply = sockets.first.RecvMsg();
+                skeletons[i] = reply.Read<refSkeleton_t>();
+                reply.Read<int>();
+            }
+            renderEntities();
+        }
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / numTimedFrames;
+    };
+
+    auto timeBatch = [&] {
+        auto start = Clock::now();
+        for (int frame = 0; frame < numTimedFrames; frame++) {
+            Util::Writer request;
+            request.Write<int>(CG_R_BUILDSKELETONS);
+            request.Write<std::vector<SkeletonBuild>>(builds);
+            sockets.first.SendMsg(request);
+            Util::Reader reply = sockets.first.RecvMsg();
+            auto results = reply.Read<std::vector<SkeletonBuildResult>>();
+            auto bones = reply.Read<std::vector<SkeletonBone>>();
+            size_t firstBone = 0;
+            for (size_t i = 0; i < results.size(); i++) {
+                firstBone = Render::ExtractSkeleton(results[i], bones, firstBone, skeletons[i]);
+            }
+            renderEntities();
+        }
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / numTimedFrames;
+    };
+
+    Cvar::SetValue("r_skeletonCache", "0");
+    double singleTime = timeSingle();
+    double batchTime = timeBatch();
+    Cvar::SetValue("r_skeletonCache", "1");
+    double singleCachedTime = timeSingle();
+    double batchCachedTime = timeBatch();
+
+    Util::Writer stop;
+    stop.Write<int>(-1);
+    sockets.first.SendMsg(stop);
+    engine.join();
+
+    Log::Notice("%d skeletons per frame: %.1f us with CG_R_BUILDSKELETON, %.1f us with CG_R_BUILDSKELETONS",
+        int(builds.size()), singleTime, batchTime);
+    Log::Notice("with r_skeletonCache: %.1f us with CG_R_BUILDSKELETON, %.1f us with CG_R_BUILDSKELETONS",
+        singleCachedTime, batchCachedTime);
+}
+
+} // namespace
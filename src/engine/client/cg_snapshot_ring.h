@@ -0,0 +1,186 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+// Shared memory ring through which the engine publishes the snapshots it
+// received so that the cgame can read them without a CG_GETSNAPSHOT round
+// trip serializing the whole entity list.
+//
+// Slot i holds the last snapshot whose number is i modulo SNAPSHOT_RING_SLOTS,
+// mirroring the engine's backup of snapshots, with room for a fixed number of
+// entities. The header is only filled while the engine runs the cgame frame,
+// as the client state can change between frames without the ring noticing.
+// Whenever the ring can't give the same answer as CG_GETSNAPSHOT (server
+// commands to execute, too many entities, ...) the cgame falls back to it.
+
+#ifndef CG_SNAPSHOT_RING_H
+#define CG_SNAPSHOT_RING_H
+
+#include "cg_api.h"
+
+static const int SNAPSHOT_RING_SLOTS = 32;
+
+struct snapshotRingHeader_t
+{
+	int32_t active; // the rest of the header is only valid when this is set
+	int32_t latestMessageNum;
+	int32_t lastExecutedServerCommand;
+	int32_t oldestServerCommand; // commands before this one were cycled out
+};
+
+struct snapshotRingSlot_t
+{
+	int32_t messageNum;
+	int32_t valid;
+	int32_t numEntities; // -1 if the entities did not fit in the slot
+	int32_t serverCommandNum;
+	int32_t snapFlags;
+	int32_t ping;
+	int32_t serverTime;
+	byte areamask[ MAX_MAP_AREA_BYTES ];
+	OpaquePlayerState ps;
+};
+
+namespace SnapshotRing {
+
+inline size_t AlignUp( size_t size )
+{
+	return ( size + 63 ) & ~size_t( 63 );
+}
+
+inline size_t SlotSize( int slotEntities )
+{
+	return AlignUp( sizeof( snapshotRingSlot_t ) + slotEntities * sizeof( entityState_t ) );
+}
+
+inline size_t Size( int slotEntities )
+{
+	return AlignUp( sizeof( snapshotRingHeader_t ) ) + SNAPSHOT_RING_SLOTS * SlotSize( slotEntities );
+}
+
+inline snapshotRingHeader_t* Header( void* base )
+{
+	return static_cast<snapshotRingHeader_t*>( base );
+}
+
+inline snapshotRingSlot_t* Slot( void* base, int slotEntities, int index )
+{
+	char* slots = static_cast<char*>( base ) + AlignUp( sizeof( snapshotRingHeader_t ) );
+	return reinterpret_cast<snapshotRingSlot_t*>( slots + index * SlotSize( slotEntities ) );
+}
+
+// The entities are stored right after the slot description
+inline entityState_t* Entities( snapshotRingSlot_t* slot )
+{
+	static_assert( sizeof( snapshotRingSlot_t ) % alignof( entityState_t ) == 0, "misaligned entities" );
+	return reinterpret_cast<entityState_t*>( slot + 1 );
+}
+
+// Copies the snapshot in the slot, desc.numEntities is ignored
+inline void Write( void* base, int slotEntities, int index, const snapshotRingSlot_t& desc, const std::vector<entityState_t>& entities )
+{
+	snapshotRingSlot_t* slot = Slot( base, slotEntities, index );
+	*slot = desc;
+
+	if ( entities.size() > static_cast<size_t>( slotEntities ) )
+	{
+		slot->numEntities = -1;
+		return;
+	}
+
+	slot->numEntities = entities.size();
+	std::copy( entities.begin(), entities.end(), Entities( slot ) );
+}
+
+// Gives the same result as CG_GETSNAPSHOT in res and snapshot, or returns
+// false if the snapshot must be requested from the engine.
+inline bool Read( void* base, size_t size, int slotEntities, int snapshotNumber, bool& res, ipcSnapshot_t& snapshot )
+{
+	if ( Size( slotEntities ) > size )
+	{
+		return false;
+	}
+
+	const snapshotRingHeader_t& header = *Header( base );
+
+	// The engine drops on snapshots from the future
+	if ( !header.active || snapshotNumber > header.latestMessageNum )
+	{
+		return false;
+	}
+
+	// The frame has fallen out of the circular buffer
+	if ( header.latestMessageNum - snapshotNumber >= SNAPSHOT_RING_SLOTS )
+	{
+		res = false;
+		return true;
+	}
+
+	snapshotRingSlot_t* slot = Slot( base, slotEntities, snapshotNumber & ( SNAPSHOT_RING_SLOTS - 1 ) );
+
+	// The slot holds another snapshot, the one requested was dropped
+	if ( slot->messageNum != snapshotNumber )
+	{
+		return false;
+	}
+
+	if ( !slot->valid )
+	{
+		res = false;
+		return true;
+	}
+
+	// Getting the snapshot executes the server commands up to its own
+	if ( slot->serverCommandNum != header.lastExecutedServerCommand
+	     || header.lastExecutedServerCommand + 1 < header.oldestServerCommand )
+	{
+		return false;
+	}
+
+	if ( slot->numEntities < 0 || slot->numEntities > slotEntities )
+	{
+		return false;
+	}
+
+	snapshot.b.snapFlags = slot->snapFlags;
+	snapshot.b.ping = slot->ping;
+	snapshot.b.serverTime = slot->serverTime;
+	memcpy( snapshot.b.areamask, slot->areamask, sizeof( snapshot.b.areamask ) );
+	snapshot.ps = slot->ps;
+	const entityState_t* entities = Entities( slot );
+	snapshot.b.entities.assign( entities, entities + slot->numEntities );
+	snapshot.b.serverCommands.clear();
+
+	res = true;
+	return true;
+}
+
+} // namespace SnapshotRing
+
+#endif // CG_SNAPSHOT_RING_H
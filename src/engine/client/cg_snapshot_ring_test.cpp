@@ -0,0 +1,219 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "cg_msgdef.h"
+#include "cg_snapshot_ring.h"
+
+namespace {
+
+constexpr int slotEntities = 64;
+
+class SnapshotRingTest : public ::testing::Test
+{
+protected:
+    SnapshotRingTest()
+        : ring(IPC::SharedMemory::Create(SnapshotRing::Size(slotEntities)))
+    {
+    }
+
+    void* Base()
+    {
+        return ring.GetBase();
+    }
+
+    // Publishes snapshot number n with the given number of entities, with no
+    // server commands to execute
+    void Publish(int n, int numEntities)
+    {
+        snapshotRingSlot_t desc{};
+        desc.messageNum = n;
+        desc.valid = true;
+        desc.serverCommandNum = 10;
+        desc.serverTime = n * 50;
+        desc.ping = 42;
+        desc.areamask[3] = 7;
+        std::vector<entityState_t> entities(numEntities);
+        for (int i = 0; i < numEntities; i++) {
+            entities[i].number = i;
+            entities[i].origin[0] = n;
+        }
+        SnapshotRing::Write(Base(), slotEntities, n % SNAPSHOT_RING_SLOTS, desc, entities);
+
+        snapshotRingHeader_t* header = SnapshotRing::Header(Base());
+        header->active = true;
+        header->latestMessageNum = n;
+        header->lastExecutedServerCommand = 10;
+        header->oldestServerCommand = 0;
+    }
+
+    bool Read(int n, bool& res, ipcSnapshot_t& snapshot)
+    {
+        return SnapshotRing::Read(Base(), ring.GetSize(), slotEntities, n, res, snapshot);
+    }
+
+    IPC::SharedMemory ring;
+};
+
+TEST_F(SnapshotRingTest, ReadPublished)
+{
+    for (int n = 1; n <= 40; n++) {
+        Publish(n, n);
+    }
+
+    bool res;
+    ipcSnapshot_t snapshot;
+    snapshot.b.serverCommands = {"stale"};
+    ASSERT_TRUE(Read(35, res, snapshot));
+    ASSERT_TRUE(res);
+    EXPECT_EQ(35 * 50, snapshot.b.serverTime);
+    EXPECT_EQ(42, snapshot.b.ping);
+    EXPECT_EQ(7, snapshot.b.areamask[3]);
+    ASSERT_EQ(35U, snapshot.b.entities.size());
+    EXPECT_EQ(34, snapshot.b.entities[34].number);
+    EXPECT_EQ(35.0f, snapshot.b.entities[34].origin[0]);
+    EXPECT_TRUE(snapshot.b.serverCommands.empty());
+}
+
+TEST_F(SnapshotRingTest, SameAnswersAsEngine)
+{
+    Publish(40, 3);
+    bool res;
+    ipcSnapshot_t snapshot;
+
+    // Out of the backup
+    ASSERT_TRUE(Read(40 - SNAPSHOT_RING_SLOTS, res, snapshot));
+    EXPECT_FALSE(res);
+
+    // Invalid snapshot
+    SnapshotRing::Slot(Base(), slotEntities, 40 % SNAPSHOT_RING_SLOTS)->valid = false;
+    ASSERT_TRUE(Read(40, res, snapshot));
+    EXPECT_FALSE(res);
+}
+
+TEST_F(SnapshotRingTest, FallBackToEngine)
+{
+    Publish(40, 3);
+    bool res;
+    ipcSnapshot_t snapshot;
+    snapshotRingHeader_t* header = SnapshotRing::Header(Base());
+
+    // Snapshot from the future, the engine drops
+    EXPECT_FALSE(Read(41, res, snapshot));
+
+    // Never received
+    EXPECT_FALSE(Read(39, res, snapshot));
+
+    // Server commands to execute
+    header->lastExecutedServerCommand = 9;
+    EXPECT_FALSE(Read(40, res, snapshot));
+    header->lastExecutedServerCommand = 10;
+
+    // Reliable commands cycled out, the engine drops
+    header->oldestServerCommand = 12;
+    EXPECT_FALSE(Read(40, res, snapshot));
+    header->oldestServerCommand = 0;
+
+    // Not in the cgame frame
+    header->active = false;
+    EXPECT_FALSE(Read(40, res, snapshot));
+    header->active = true;
+
+    // Too many entities for the slot
+    Publish(41, slotEntities + 1);
+    EXPECT_FALSE(Read(41, res, snapshot));
+    EXPECT_TRUE(Read(40, res, snapshot));
+}
+
+// Compares getting a snapshot with CG_GETSNAPSHOT, through a socket to another
+// thread, and reading it from the ring.
+TEST(SnapshotRingBenchmark, DISABLED_Fetch)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int numEntities = 600;
+    constexpr int numFetches = 2000;
+
+    ipcSnapshot_t source;
+    source.b.entities.resize(numEntities);
+    for (int i = 0; i < numEntities; i++) {
+        source.b.entities[i].number = i;
+    }
+
+    auto sockets = IPC::Socket::CreatePair();
+    std::thread engine([&] {
+        for (int i = 0; i < numFetches; i++) {
+            Util::Reader request = sockets.second.RecvMsg();
+            Util::Writer reply;
+            reply.Write<bool>(true);
+            reply.Write<ipcSnapshot_t>(source);
+            sockets.second.SendMsg(reply);
+        }
+    });
+
+    auto start = Clock::now();
+    for (int i = 0; i < numFetches; i++) {
+        Util::Writer request;
+        request.Write<int>(i);
+        sockets.first.SendMsg(request);
+        Util::Reader reply = sockets.first.RecvMsg();
+        bool res = reply.Read<bool>();
+        ipcSnapshot_t snapshot = reply.Read<ipcSnapshot_t>();
+        ASSERT_TRUE(res);
+        ASSERT_EQ(size_t(numEntities), snapshot.b.entities.size());
+    }
+    std::chrono::duration<double, std::micro> messageTime = Clock::now() - start;
+    engine.join();
+
+    constexpr int ringEntities = 1024;
+    IPC::SharedMemory ring = IPC::SharedMemory::Create(SnapshotRing::Size(ringEntities));
+    snapshotRingSlot_t desc{};
+    desc.valid = true;
+    SnapshotRing::Write(ring.GetBase(), ringEntities, 0, desc, source.b.entities);
+    SnapshotRing::Header(ring.GetBase())->active = true;
+
+    start = Clock::now();
+    ipcSnapshot_t snapshot;
+    for (int i = 0; i < numFetches; i++) {
+        bool res;
+        ASSERT_TRUE(SnapshotRing::Read(ring.GetBase(), ring.GetSize(), ringEntities, 0, res, snapshot));
+        ASSERT_EQ(size_t(numEntities), snapshot.b.entities.size());
+    }
+    std::chrono::duration<double, std::micro> ringTime = Clock::now() - start;
+
+    Log::Notice("Snapshot with %d entities: %.1f us per GetSnapshotMsg, %.1f us per ring read",
+        numEntities, messageTime.count() / numFetches, ringTime.count() / numFetches);
+}
+
+} // namespace
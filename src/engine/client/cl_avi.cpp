@@ -434,6 +434,8 @@ bool CL_OpenAVIForWriting( const char *fileName )
 	return true;
 }
 
+static bool CL_CloseAVIFile();
+
 /*
 ===============
 CL_CheckFileSize
@@ -452,8 +454,8 @@ static bool CL_CheckFileSize( int bytesToAdd )
 	// we target can handle a 2Gb file
 	if ( newFileSize > INT_MAX )
 	{
-		// Close the current file...
-		CL_CloseAVI();
+		// Close the current file, the frames still being encoded go to the next one...
+		CL_CloseAVIFile();
 
 		// ...And open a new one
 		CL_OpenAVIForWriting( va( "%s_", afd.fileName ) );
@@ -533,12 +535,12 @@ void CL_TakeVideoFrame()
 
 /*
 ===============
-CL_CloseAVI
+CL_CloseAVIFile
 
 Closes the AVI file and writes an index chunk
 ===============
 */
-bool CL_CloseAVI()
+static bool CL_CloseAVIFile()
 {
 	int        indexRemainder;
 	int        indexSize = afd.numIndices * 16;
@@ -607,6 +609,23 @@ bool CL_CloseAVI()
 	return true;
 }
 
+/*
+===============
+CL_CloseAVI
+
+Writes the frames the renderer is still encoding and closes the AVI file
+===============
+*/
+bool CL_CloseAVI()
+{
+	if ( afd.fileOpen && re.FinishVideoFrames )
+	{
+		re.FinishVideoFrames();
+	}
+
+	return CL_CloseAVIFile();
+}
+
 /*
 ===============
 CL_VideoRecording
@@ -36,6 +36,7 @@ Maryland 20850 USA.
 
 #include "client.h"
 #include "cg_msgdef.h"
+#include "cg_snapshot_ring.h"
 
 #include "key_identification.h"
 
@@ -68,8 +69,12 @@ Maryland 20850 USA.
  * even in a deathmatch or singleplayer game, joining would start with team 1, even though there might not be another one
  * this allows several client logic (like team specific binds or configurations) to work no matter how the team is called or what its attributes are
  */
+static Cvar::Cvar<bool> cl_snapshotRing("cl_snapshotRing", "let the cgame read snapshots from shared memory", Cvar::NONE, true);
+
 static Cvar::Cvar<int> p_team("p_team", "team number of your team", Cvar::ROM, 0);
 
+static Log::Logger loadTimeLog("client.loadtime");
+
 /*
 ====================
 CL_GetUserCmd
@@ -961,7 +966,165 @@ static std::string DispatchRawDataSync( const std::string& data ) {
 #endif
 }
 
-CGameVM::CGameVM(): VM::VMBase("cgame", Cvar::CHEAT), services(nullptr), cmdBuffer("client")
+static_assert(SNAPSHOT_RING_SLOTS == PACKET_BACKUP, "the snapshot ring must mirror cl.snapshots");
+
+void CGameVM::PublishSnapshot(int messageNum)
+{
+	if (snapshotRing) {
+		WriteSnapshotRingSlot(messageNum & PACKET_MASK);
+	}
+}
+
+void CGameVM::WriteSnapshotRingSlot(int index)
+{
+	const clSnapshot_t& snapshot = cl.snapshots[index];
+	snapshotRingSlot_t desc{};
+	desc.messageNum = snapshot.messageNum;
+	desc.valid = snapshot.valid;
+	desc.serverCommandNum = snapshot.serverCommandNum;
+	desc.snapFlags = snapshot.snapFlags;
+	desc.ping = snapshot.ping;
+	desc.serverTime = snapshot.serverTime;
+	memcpy(desc.areamask, snapshot.areamask, sizeof(desc.areamask));
+	desc.ps = snapshot.ps;
+	SnapshotRing::Write(snapshotRing.GetBase(), snapshotRingEntities, index, desc, snapshot.entities);
+}
+
+void CGameVM::ClearSnapshotRing()
+{
+	if (!snapshotRing) {
+		return;
+	}
+
+	// Same as the cleared cl.snapshots, all invalid
+	for (int i = 0; i < SNAPSHOT_RING_SLOTS; i++) {
+		snapshotRingSlot_t* slot = SnapshotRing::Slot(snapshotRing.GetBase(), snapshotRingEntities, i);
+		slot->messageNum = 0;
+		slot->valid = false;
+	}
+}
+
+void CGameVM::UpdateSnapshotRingHeader(bool active)
+{
+	if (!snapshotRing) {
+		return;
+	}
+
+	snapshotRingActive = active;
+	snapshotRingHeader_t* header = SnapshotRing::Header(snapshotRing.GetBase());
+	header->active = active && cl_snapshotRing.Get();
+	header->latestMessageNum = cl.snap.messageNum;
+	header->lastExecutedServerCommand = clc.lastExecutedServerCommand;
+	header->oldestServerCommand = clc.serverCommandSequence - MAX_RELIABLE_COMMANDS + 1;
+}
+
+/*
+====================
+CL_RegisterAssets
+
+Registers a batch of assets in two passes. Their files are first read, and
+sounds and shader images decoded, on worker threads. The assets are then registered in order on
+the main thread, which only has to parse the files and upload them.
+====================
+*/
+static void CL_RegisterAssets(const std::vector<assetRegistration_t>& assets, std::vector<int>& handles)
+{
+	auto start = Sys::SteadyClock::now();
+
+	// The renderer decodes the shader images on its own threads
+	for (const assetRegistration_t& asset : assets) {
+		if (asset.type == assetType_t::SHADER)
+			re.PrefetchShader(asset.name.c_str());
+	}
+
+	std::atomic<size_t> next(0);
+	auto worker = [&] {
+		for (size_t i; (i = next++) < assets.size();) {
+			const assetRegistration_t& asset = assets[i];
+			switch (asset.type) {
+			case assetType_t::MODEL:
+				re.PrefetchModel(asset.name.c_str());
+				break;
+			case assetType_t::SKIN:
+			case assetType_t::ANIMATION:
+				re.PrefetchFile(asset.name.c_str());
+				break;
+			case assetType_t::SOUND:
+				Audio::PrefetchSFX(asset.name);
+				break;
+			default:
+				break;
+			}
+		}
+	};
+	size_t numThreads = std::min<size_t>(assets.size(), std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numThreads; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread: threads)
+		thread.join();
+
+	auto prefetched = Sys::SteadyClock::now();
+
+	handles.reserve(assets.size());
+	for (const assetRegistration_t& asset : assets) {
+		switch (asset.type) {
+		case assetType_t::MODEL:
+			handles.push_back(re.RegisterModel(asset.name.c_str()));
+			break;
+		case assetType_t::SKIN:
+			handles.push_back(re.RegisterSkin(asset.name.c_str()));
+			break;
+		case assetType_t::SHADER:
+			handles.push_back(re.RegisterShader(asset.name.c_str(), asset.flags));
+			break;
+		case assetType_t::SOUND:
+			handles.push_back(Audio::RegisterSFX(asset.name));
+			break;
+		case assetType_t::ANIMATION:
+			handles.push_back(re.RegisterAnimation(asset.name.c_str()));
+			break;
+		default:
+			handles.push_back(0);
+			break;
+		}
+	}
+	re.ClearPrefetchedFiles();
+
+	auto end = Sys::SteadyClock::now();
+	loadTimeLog.Verbose("registered %d assets in %d ms: %d ms reading files on %d threads, %d ms registering",
+		int(assets.size()),
+		std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(),
+		std::chrono::duration_cast<std::chrono::milliseconds>(prefetched - start).count(),
+		int(numThreads),
+		std::chrono::duration_cast<std::chrono::milliseconds>(end - prefetched).count());
+}
+
+/*
+====================
+CL_BuildSkeletons
+
+Builds the skeletons of a CG_R_BUILDSKELETONS batch, blending them if asked.
+====================
+*/
+void CL_BuildSkeletons(const std::vector<SkeletonBuild>& builds, std::vector<SkeletonBuildResult>& results, std::vector<SkeletonBone>& bones)
+{
+	refSkeleton_t skel, blend;
+	results.reserve(builds.size());
+	for (const SkeletonBuild& build : builds) {
+		skel.numBones = 0;
+		int res = re.BuildSkeleton(&skel, build.anim, build.startFrame, build.endFrame, build.lerp, build.clearOrigin);
+		if (res && build.blendAnim) {
+			blend.numBones = 0;
+			res = re.BuildSkeleton(&blend, build.blendAnim, build.blendStartFrame, build.blendEndFrame, build.blendLerp, build.clearOrigin)
+				&& re.BlendSkeleton(&skel, &blend, build.blendFrac);
+		}
+		Render::AppendSkeleton(skel, res, build.returnBones, results, bones);
+	}
+}
+
+CGameVM::CGameVM(): VM::VMBase("cgame", Cvar::CHEAT), services(nullptr), snapshotRingEntities(0), snapshotRingActive(false), cmdBuffer("client")
 {
 }
 
@@ -979,7 +1142,10 @@ void CGameVM::CGameStaticInit()
 
 void CGameVM::CGameInit(int serverMessageNum, int clientNum)
 {
+	auto start = Sys::SteadyClock::now();
 	this->SendMsg<CGameInitMsg>(serverMessageNum, clientNum, cls.windowConfig, cl.gameState);
+	loadTimeLog.Notice("cgame initialized in %d ms",
+		std::chrono::duration_cast<std::chrono::milliseconds>(Sys::SteadyClock::now() - start).count());
 	NetcodeTable psTable;
 	size_t psSize;
 	this->SendMsg<VM::GetNetcodeTablesMsg>(psTable, psSize);
@@ -995,11 +1161,22 @@ void CGameVM::CGameShutdown()
 	}
 	this->Free();
 	services = nullptr;
+	snapshotRing.Close();
 }
 
 void CGameVM::CGameDrawActiveFrame(int serverTime,  bool demoPlayback)
 {
-	this->SendMsg<CGameDrawActiveFrameMsg>(serverTime, demoPlayback);
+	UpdateSnapshotRingHeader(true);
+	cmdBuffer.StartConcurrentConsumption();
+	try {
+		this->SendMsg<CGameDrawActiveFrameMsg>(serverTime, demoPlayback);
+	} catch (...) {
+		UpdateSnapshotRingHeader(false);
+		cmdBuffer.StopConcurrentConsumption();
+		throw;
+	}
+	UpdateSnapshotRingHeader(false);
+	cmdBuffer.StopConcurrentConsumption();
 }
 
 bool CGameVM::CGameKeyDownEvent(Keyboard::Key key, bool repeat)
@@ -1068,12 +1245,14 @@ void CGameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 	int major = id >> 16;
 	int minor = id & 0xffff;
 	if (major == VM::QVM) {
+		IPC::CommandBufferHost::ConsumerPause pause(this->cmdBuffer);
 		this->QVMSyscall(minor, reader, channel);
 
 	} else if (major == VM::COMMAND_BUFFER) {
 		this->cmdBuffer.Syscall(minor, reader, channel);
 
 	} else if (major < VM::LAST_COMMON_SYSCALL) {
+		IPC::CommandBufferHost::ConsumerPause pause(this->cmdBuffer);
 		services->Syscall(major, minor, std::move(reader), channel);
 
 	} else {
@@ -1152,6 +1331,24 @@ void CGameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& cha
 		case CG_GETSNAPSHOT:
 			IPC::HandleMsg<GetSnapshotMsg>(channel, std::move(reader), [this] (int number, bool& res, ipcSnapshot_t& snapshot) {
 				res = CL_GetSnapshot(number, &snapshot);
+				// The server commands executed changed
+				UpdateSnapshotRingHeader(snapshotRingActive);
+			});
+			break;
+
+		case CG_SNAPSHOTRING_LOCATE:
+			IPC::HandleMsg<SnapshotRingLocateMsg>(channel, std::move(reader), [this] (IPC::SharedMemory shm, int slotEntities) {
+				if (slotEntities < 0 || slotEntities > MAX_GENTITIES || shm.GetSize() < SnapshotRing::Size(slotEntities)) {
+					Sys::Drop("CG_SNAPSHOTRING_LOCATE: invalid shared memory size");
+				}
+				if (!cl_snapshotRing.Get()) {
+					return;
+				}
+				snapshotRing = std::move(shm);
+				snapshotRingEntities = slotEntities;
+				for (int i = 0; i < PACKET_BACKUP; i++) {
+					WriteSnapshotRingSlot(i);
+				}
 			});
 			break;
 
@@ -1205,6 +1402,12 @@ void CGameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& cha
 			} );
 			break;
 
+		case CG_REGISTERASSETS:
+			IPC::HandleMsg<RegisterAssetsMsg>(channel, std::move(reader), [this] (const std::vector<assetRegistration_t>& assets, std::vector<int>& handles) {
+				CL_RegisterAssets(assets, handles);
+			});
+			break;
+
 		// All sounds
 
         case CG_S_REGISTERSOUND:
@@ -1291,6 +1494,12 @@ void CGameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& cha
 			});
 			break;
 
+		case CG_R_BUILDSKELETONS:
+			IPC::HandleMsg<Render::BuildSkeletonsMsg>(channel, std::move(reader), [this] (const std::vector<SkeletonBuild>& builds, std::vector<SkeletonBuildResult>& results, std::vector<SkeletonBone>& bones) {
+				CL_BuildSkeletons(builds, results, bones);
+			});
+			break;
+
 		case CG_R_BONEINDEX:
 			IPC::HandleMsg<Render::BoneIndexMsg>(channel, std::move(reader), [this] (int model, const std::string& boneName, int& index) {
 				index = re.BoneIndex(model, boneName.c_str());
@@ -1511,6 +1720,31 @@ template<typename Msg, typename Func> void HandleMsg(Util::Reader reader, Func&&
 CGameVM::CmdBuffer::CmdBuffer(std::string name): IPC::CommandBufferHost(name) {
 }
 
+// These only add to the scene and to the render command list of the
+// frontend. The synchronous syscalls pause the consumer thread (see
+// CGameVM::Syscall) as some of them, such as the model and shader
+// registration, change what these read. Entities aren't there as adding
+// one transforms it and builds its skeleton in the renderer's caches.
+bool CGameVM::CmdBuffer::IsThreadSafe(int major, int minor) {
+	if (major != VM::QVM) {
+		return false;
+	}
+
+	switch (minor) {
+		case CG_R_ADDPOLYTOSCENE:
+		case CG_R_ADDPOLYSTOSCENE:
+		case CG_R_ADDLIGHTTOSCENE:
+		case CG_R_SETCOLOR:
+		case CG_R_DRAWSTRETCHPIC:
+		case CG_R_DRAWROTATEDPIC:
+		case CG_R_ADD2DPOLYSINDEXED:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
 void CGameVM::CmdBuffer::HandleCommandBufferSyscall(int major, int minor, Util::Reader& reader) {
 	if (major == VM::QVM) {
 		switch (minor) {
@@ -754,6 +754,7 @@ Called before parsing a gamestate
 void CL_ClearState()
 {
 	ResetStruct( cl );
+	cgvm.ClearSnapshotRing();
 }
 
 /*
@@ -776,6 +777,7 @@ static void CL_SendDisconnect()
 		CL_WritePacket();
 		CL_WritePacket();
 		CL_WritePacket();
+		Sys_FlushPackets();
 	}
 }
 
@@ -2006,6 +2008,8 @@ CL_Frame
 */
 void CL_Frame( int msec )
 {
+	PROFILE_ZONE("CL_Frame");
+
 	if ( !com_cl_running->integer )
 	{
 		return;
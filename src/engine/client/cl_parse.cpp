@@ -317,6 +317,7 @@ void CL_ParseSnapshot( msg_t *msg )
 
 	// save the frame off in the backup array for later delta comparisons
 	cl.snapshots[ cl.snap.messageNum & PACKET_MASK ] = cl.snap;
+	cgvm.PublishSnapshot( cl.snap.messageNum );
 
 	if ( cl_shownet->integer == 3 )
 	{
@@ -342,16 +342,29 @@ public:
 	void CGameRocketFrame();
 	void CGameConsoleLine(const std::string& str);
 
+	// Mirror cl.snapshots in the ring shared with the cgame, if any
+	void PublishSnapshot(int messageNum);
+	void ClearSnapshotRing();
+
 private:
 	virtual void Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel) override final;
 	void QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& channel);
 
+	// Sets the header of the snapshot ring, active only during the cgame frame
+	void UpdateSnapshotRingHeader(bool active);
+	void WriteSnapshotRingSlot(int index);
+
 	std::unique_ptr<VM::CommonVMServices> services;
 
+	IPC::SharedMemory snapshotRing;
+	int snapshotRingEntities;
+	bool snapshotRingActive;
+
     class CmdBuffer: public IPC::CommandBufferHost {
         public:
             CmdBuffer(std::string name);
             virtual void HandleCommandBufferSyscall(int major, int minor, Util::Reader& reader) override final;
+            virtual bool IsThreadSafe(int major, int minor) override final;
     };
 
     CmdBuffer cmdBuffer;
@@ -651,6 +664,7 @@ void     CL_CGameRendering();
 void     CL_SetCGameTime();
 void     CL_FirstSnapshot();
 void     CL_OnTeamChanged( int newTeam );
+void     CL_BuildSkeletons( const std::vector<SkeletonBuild> &builds, std::vector<SkeletonBuildResult> &results, std::vector<SkeletonBone> &bones );
 
 //
 // cl_ui.c
@@ -32,7 +32,21 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace IPC {
 
-    CommandBufferHost::CommandBufferHost(std::string name): name(name), logs(name + ".commandBufferHost") {
+    CommandBufferHost::CommandBufferHost(std::string name): name(name), logs(name + ".commandBufferHost"),
+        concurrent("vm." + name + ".commandBuffer.concurrent", "handle the thread-safe messages of the " + name + " command buffer while the VM runs", Cvar::NONE, false),
+        consumerActive(false), consumerQuit(false) {
+    }
+
+    CommandBufferHost::~CommandBufferHost() {
+        if (consumerThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(consumerMutex);
+                consumerActive = false;
+                consumerQuit = true;
+            }
+            consumerCondition.notify_one();
+            consumerThread.join();
+        }
     }
 
     void CommandBufferHost::Syscall(int index, Util::Reader& reader, IPC::Channel& channel) {
@@ -54,6 +68,7 @@ namespace IPC {
     }
 
     void CommandBufferHost::Init(IPC::SharedMemory mem) {
+        std::lock_guard<std::mutex> lock(consumeMutex);
         shm = std::move(mem);
         buffer.Init(shm.GetBase(), shm.GetSize());
 
@@ -61,6 +76,9 @@ namespace IPC {
     }
 
     void CommandBufferHost::Consume() {
+        std::lock_guard<std::mutex> lock(consumeMutex);
+        CheckConsumerError();
+
         buffer.LoadWriterData();
         logs.Debug("Consuming up to %i data from buffer for %s", buffer.GetMaxReadLength(), name);
         bool consuming = true;
@@ -68,19 +86,23 @@ namespace IPC {
 
         while(consuming) {
             Util::Reader reader;
-            consuming = ConsumeOne(reader);
+            size_t length;
+            consuming = ConsumeOne(reader, length);
 
             if (consuming) {
                 uint32_t id = reader.Read<uint32_t>();
                 int major = id >> 16;
                 int minor = id & 0xffff;
                 this->HandleCommandBufferSyscall(major, minor, reader);
+
+                // The message was read in place, only now can it be overwritten
+                buffer.AdvanceReadPointer(length);
             }
             //TODO add more logic to stop consuming (e.g. when the socket is ready)
         }
     }
 
-    bool CommandBufferHost::ConsumeOne(Util::Reader& reader) {
+    bool CommandBufferHost::ConsumeOne(Util::Reader& reader, size_t& length) {
         if (!buffer.CanRead(sizeof(uint32_t))) {
             buffer.LoadWriterData();
             if (!buffer.CanRead(sizeof(uint32_t))) {
@@ -96,13 +118,140 @@ namespace IPC {
         if (!buffer.CanRead(size + sizeof(uint32_t))) {
             Sys::Drop("Command buffer for %s had an incomplete message write", name);
         }
-        std::vector<char>& readerData = reader.GetData();
-        readerData.resize(size);
-        buffer.Read(readerData.data(), size, sizeof(uint32_t));
-
-        buffer.AdvanceReadPointer(size + sizeof(uint32_t));
+        buffer.ReadInPlace(reader, size, sizeof(uint32_t));
+        length = size + sizeof(uint32_t);
 
         return true;
     }
 
+    void CommandBufferHost::StartConcurrentConsumption() {
+        if (!concurrent.Get() || !shm.GetBase()) {
+            return;
+        }
+
+        if (!consumerThread.joinable()) {
+            consumerThread = std::thread(&CommandBufferHost::ConsumerThread, this);
+        }
+        {
+            std::lock_guard<std::mutex> lock(consumerMutex);
+            consumerActive = true;
+        }
+        consumerCondition.notify_one();
+    }
+
+    void CommandBufferHost::StopConcurrentConsumption() {
+        {
+            std::lock_guard<std::mutex> lock(consumerMutex);
+            if (!consumerActive) {
+                return;
+            }
+            consumerActive = false;
+        }
+
+        // The consumer checks that it is active with this lock held so once
+        // we have it, it won't touch the buffer anymore.
+        std::lock_guard<std::mutex> lock(consumeMutex);
+        CheckConsumerError();
+    }
+
+    CommandBufferHost::ConsumerPause::ConsumerPause(CommandBufferHost& host): host(host) {
+        {
+            std::lock_guard<std::mutex> lock(host.consumerMutex);
+            wasActive = host.consumerActive;
+            host.consumerActive = false;
+        }
+
+        // Wait for the consumer to be done with the message it is handling
+        if (wasActive) {
+            std::lock_guard<std::mutex> lock(host.consumeMutex);
+        }
+    }
+
+    CommandBufferHost::ConsumerPause::~ConsumerPause() {
+        if (!wasActive) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(host.consumerMutex);
+            host.consumerActive = true;
+        }
+        host.consumerCondition.notify_one();
+    }
+
+    void CommandBufferHost::ConsumerThread() {
+        Sys::CatchDropsOnThisThread();
+
+        std::unique_lock<std::mutex> lock(consumerMutex);
+        while (true) {
+            consumerCondition.wait(lock, [this] { return consumerActive || consumerQuit; });
+            if (consumerQuit) {
+                return;
+            }
+
+            lock.unlock();
+            bool consumed = ConsumeThreadSafe();
+            lock.lock();
+
+            // Poll the buffer: VMs can't wake us up without a sync message as
+            // NaCl has no futex or eventfd, and that's what we try to avoid.
+            if (!consumed && consumerActive) {
+                consumerCondition.wait_for(lock, std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    bool CommandBufferHost::ConsumeThreadSafe() {
+        std::lock_guard<std::mutex> lock(consumeMutex);
+        bool consumed = false;
+
+        try {
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> activeLock(consumerMutex);
+                    if (!consumerActive || !consumerError.empty()) {
+                        break;
+                    }
+                }
+
+                Util::Reader reader;
+                size_t length;
+                if (!ConsumeOne(reader, length)) {
+                    break;
+                }
+
+                uint32_t id = reader.Read<uint32_t>();
+                int major = id >> 16;
+                int minor = id & 0xffff;
+                // Leave it and everything after it to the next flush
+                if (!IsThreadSafe(major, minor)) {
+                    break;
+                }
+
+                this->HandleCommandBufferSyscall(major, minor, reader);
+                buffer.AdvanceReadPointer(length);
+                consumed = true;
+            }
+        } catch (Sys::DropErr& err) {
+            std::lock_guard<std::mutex> activeLock(consumerMutex);
+            consumerError = err.what();
+        } catch (std::exception& err) {
+            std::lock_guard<std::mutex> activeLock(consumerMutex);
+            consumerError = err.what();
+        }
+
+        return consumed;
+    }
+
+    void CommandBufferHost::CheckConsumerError() {
+        std::string error;
+        {
+            std::lock_guard<std::mutex> lock(consumerMutex);
+            std::swap(error, consumerError);
+        }
+        if (!error.empty()) {
+            Sys::Drop(error);
+        }
+    }
+
 } // namespace IPC
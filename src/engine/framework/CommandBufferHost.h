@@ -39,23 +39,80 @@ namespace IPC {
     class CommandBufferHost {
         public:
             CommandBufferHost(std::string name);
-            virtual ~CommandBufferHost() = default;
+            virtual ~CommandBufferHost();
 
             void Syscall(int index, Util::Reader& reader, IPC::Channel& channel);
             void Close();
 
+            // Between these calls, if vm.<name>.commandBuffer.concurrent is
+            // set, messages declared thread-safe are handled on a consumer
+            // thread as soon as the VM writes them instead of waiting for the
+            // VM to flush the buffer. The consumer stops at the first message
+            // that isn't thread-safe, it is left with the ones after it for
+            // the flush which acts as a barrier, so the order is preserved.
+            // Only call them around a call to the VM: while the VM runs, the
+            // main thread is only busy handling its syscalls and it must be
+            // safe for the thread-safe handlers to run concurrently with
+            // these. StopConcurrentConsumption returns once the consumer
+            // thread is done with the buffer.
+            void StartConcurrentConsumption();
+            void StopConcurrentConsumption();
+
+            // Keeps the consumer thread away from the handlers while it
+            // exists. Put one around the handling of every synchronous
+            // syscall of the VM as these aren't safe to run concurrently with
+            // the thread-safe messages. It doesn't hold the lock during the
+            // syscall as a syscall may run a whole VM frame, which starts and
+            // stops the consumption again.
+            class ConsumerPause {
+                public:
+                    ConsumerPause(CommandBufferHost& host);
+                    ~ConsumerPause();
+
+                    ConsumerPause(const ConsumerPause&) = delete;
+                    ConsumerPause& operator=(const ConsumerPause&) = delete;
+
+                private:
+                    CommandBufferHost& host;
+                    bool wasActive;
+            };
+
+        protected:
+            void Init(IPC::SharedMemory mem);
+
+            void Consume();
+
         private:
             std::string name;
             Log::Logger logs;
+            Cvar::Cvar<bool> concurrent;
             IPC::CommandBuffer buffer;
             IPC::SharedMemory shm;
 
             virtual void HandleCommandBufferSyscall(int major, int minor, Util::Reader& reader) = 0;
+            // Whether the handler of the message can run on the consumer thread
+            virtual bool IsThreadSafe(int major, int minor) {
+                Q_UNUSED(major);
+                Q_UNUSED(minor);
+                return false;
+            }
 
-            void Init(IPC::SharedMemory mem);
+            bool ConsumeOne(Util::Reader& reader, size_t& length);
 
-            void Consume();
-            bool ConsumeOne(Util::Reader& reader);
+            // Protects the buffer, held while a message is being handled
+            std::mutex consumeMutex;
+
+            std::thread consumerThread;
+            std::mutex consumerMutex;
+            std::condition_variable consumerCondition;
+            bool consumerActive;
+            bool consumerQuit;
+            // Error of the consumer thread, rethrown on the main thread
+            std::string consumerError;
+
+            void ConsumerThread();
+            bool ConsumeThreadSafe();
+            void CheckConsumerError();
     };
 }
 
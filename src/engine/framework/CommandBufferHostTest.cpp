@@ -0,0 +1,292 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+#include "common/Common.h"
+#include "CommandBufferHost.h"
+
+namespace IPC {
+namespace {
+
+enum {
+    THREAD_SAFE,
+    NOT_THREAD_SAFE,
+    DROP,
+};
+
+static void BusyWait(std::chrono::nanoseconds duration) {
+    auto end = Sys::SteadyClock::now() + duration;
+    while (Sys::SteadyClock::now() < end) {}
+}
+
+class TestHost : public CommandBufferHost {
+public:
+    TestHost() : CommandBufferHost("test"), handledCount(0), mainThreadCount(0), work(0) {}
+
+    using CommandBufferHost::Init;
+    using CommandBufferHost::Consume;
+
+    void Reset() {
+        handled.clear();
+        handledCount = 0;
+        mainThreadCount = 0;
+        inSyncSyscall = false;
+        overlaps = 0;
+        work = std::chrono::nanoseconds(0);
+    }
+
+    // Written by the thread holding the buffer
+    std::vector<int> handled;
+    std::atomic<int> handledCount;
+    std::atomic<int> mainThreadCount;
+    // Set while the main thread pretends to handle a synchronous syscall
+    std::atomic<bool> inSyncSyscall;
+    std::atomic<int> overlaps;
+    std::chrono::nanoseconds work;
+
+private:
+    void HandleCommandBufferSyscall(int major, int minor, Util::Reader& reader) override {
+        Q_UNUSED(major);
+        int value = reader.Read<int>();
+        if (minor == DROP) {
+            handledCount++;
+            Sys::Drop("dropped %d", value);
+        }
+
+        if (inSyncSyscall) {
+            overlaps++;
+        }
+        BusyWait(work);
+        if (inSyncSyscall) {
+            overlaps++;
+        }
+        handled.push_back(value);
+        if (Sys::OnMainThread()) {
+            mainThreadCount++;
+        }
+        handledCount++;
+    }
+
+    bool IsThreadSafe(int major, int minor) override {
+        Q_UNUSED(major);
+        return minor != NOT_THREAD_SAFE;
+    }
+};
+
+class CommandBufferHostTest : public testing::Test {
+protected:
+    CommandBufferHostTest() : host(GetHost()) {
+        host.Reset();
+        IPC::SharedMemory shm = IPC::SharedMemory::Create(64 * 1024);
+        client.Init(shm.GetBase(), shm.GetSize());
+        client.Reset();
+        host.Init(std::move(shm));
+    }
+
+    ~CommandBufferHostTest() {
+        Cvar::SetValue("vm.test.commandBuffer.concurrent", "0");
+    }
+
+    // What CommandBufferClient does, without the flushing
+    void Send(int minor, int value) {
+        Util::Writer writer;
+        client.LoadReaderData();
+        client.BeginWrite(writer, sizeof(uint32_t));
+        writer.Write<uint32_t>(VM::QVM << 16 | minor);
+        writer.Write<int>(value);
+        ASSERT_TRUE(writer.InRing());
+
+        uint32_t size = writer.GetRingLength();
+        client.Write((char*)&size, sizeof(uint32_t));
+        client.AdvanceWritePointer(size + sizeof(uint32_t));
+    }
+
+    bool WaitForHandled(int count) {
+        auto timeout = Sys::SteadyClock::now() + std::chrono::seconds(5);
+        while (host.handledCount < count) {
+            if (Sys::SteadyClock::now() > timeout) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // The cvars of a host can't be registered twice so it is shared by the tests
+    static TestHost& GetHost() {
+        static TestHost host;
+        return host;
+    }
+
+    CommandBuffer client;
+    TestHost& host;
+};
+
+TEST_F(CommandBufferHostTest, Disabled)
+{
+    host.StartConcurrentConsumption();
+    Send(THREAD_SAFE, 1);
+    Sys::SleepFor(std::chrono::milliseconds(5));
+    EXPECT_EQ(0, host.handledCount);
+
+    host.Consume();
+    host.StopConcurrentConsumption();
+    EXPECT_EQ(std::vector<int>{1}, host.handled);
+    EXPECT_EQ(1, host.mainThreadCount);
+}
+
+TEST_F(CommandBufferHostTest, ConsumerStopsAtUnsafeMessages)
+{
+    Cvar::SetValue("vm.test.commandBuffer.concurrent", "1");
+    host.StartConcurrentConsumption();
+
+    for (int i = 0; i < 10; i++) {
+        Send(THREAD_SAFE, i);
+    }
+    ASSERT_TRUE(WaitForHandled(10));
+    EXPECT_EQ(0, host.mainThreadCount);
+
+    // Everything from the unsafe message on waits for the flush
+    Send(NOT_THREAD_SAFE, 10);
+    Send(THREAD_SAFE, 11);
+    Sys::SleepFor(std::chrono::milliseconds(5));
+    EXPECT_EQ(10, host.handledCount);
+
+    host.Consume();
+    EXPECT_EQ(12, host.handledCount);
+    EXPECT_EQ(2, host.mainThreadCount);
+
+    // The consumer picks up again after the flush
+    Send(THREAD_SAFE, 12);
+    ASSERT_TRUE(WaitForHandled(13));
+    host.StopConcurrentConsumption();
+
+    EXPECT_EQ(2, host.mainThreadCount);
+    for (int i = 0; i < 13; i++) {
+        EXPECT_EQ(i, host.handled[i]);
+    }
+
+    // Nothing happens after the barrier
+    Send(THREAD_SAFE, 13);
+    Sys::SleepFor(std::chrono::milliseconds(5));
+    EXPECT_EQ(13, host.handledCount);
+    host.Consume();
+    EXPECT_EQ(14, host.handledCount);
+}
+
+TEST_F(CommandBufferHostTest, SyncSyscallsPauseTheConsumer)
+{
+    constexpr int COUNT = 200;
+    Cvar::SetValue("vm.test.commandBuffer.concurrent", "1");
+    host.work = std::chrono::microseconds(20);
+    host.StartConcurrentConsumption();
+    for (int i = 0; i < COUNT; i++) {
+        Send(THREAD_SAFE, i);
+    }
+
+    // What the main thread does for the synchronous syscalls of the VM
+    auto timeout = Sys::SteadyClock::now() + std::chrono::seconds(5);
+    int numSyscalls = 0;
+    while (host.handledCount < COUNT && Sys::SteadyClock::now() < timeout) {
+        CommandBufferHost::ConsumerPause pause(host);
+        host.inSyncSyscall = true;
+        BusyWait(std::chrono::microseconds(20));
+        host.inSyncSyscall = false;
+        numSyscalls++;
+    }
+    EXPECT_EQ(COUNT, host.handledCount);
+    EXPECT_LT(0, numSyscalls);
+
+    // The consumption of a VM frame run by a syscall doesn't resume the consumer early
+    {
+        CommandBufferHost::ConsumerPause pause(host);
+        host.StartConcurrentConsumption();
+        host.StopConcurrentConsumption();
+        Send(THREAD_SAFE, COUNT);
+        Sys::SleepFor(std::chrono::milliseconds(5));
+        EXPECT_EQ(COUNT, host.handledCount);
+    }
+    ASSERT_TRUE(WaitForHandled(COUNT + 1));
+    host.StopConcurrentConsumption();
+
+    EXPECT_EQ(0, host.overlaps);
+    EXPECT_EQ(0, host.mainThreadCount);
+    for (int i = 0; i <= COUNT; i++) {
+        EXPECT_EQ(i, host.handled[i]);
+    }
+}
+
+TEST_F(CommandBufferHostTest, ConsumerErrorsAreRethrown)
+{
+    Cvar::SetValue("vm.test.commandBuffer.concurrent", "1");
+    host.StartConcurrentConsumption();
+    Send(DROP, 42);
+    ASSERT_TRUE(WaitForHandled(1));
+
+    try {
+        host.StopConcurrentConsumption();
+        FAIL() << "The error wasn't rethrown";
+    } catch (Sys::DropErr& err) {
+        EXPECT_EQ("dropped 42", err.what());
+    }
+}
+
+// Frame time with a cgame producing commands that take as long to produce as
+// to handle.
+TEST_F(CommandBufferHostTest, DISABLED_Benchmark)
+{
+    constexpr int FRAMES = 50;
+    constexpr int COMMANDS_PER_FRAME = 2000;
+    constexpr std::chrono::nanoseconds WORK(1000);
+    host.work = WORK;
+
+    for (const char* concurrent : {"0", "1"}) {
+        Cvar::SetValue("vm.test.commandBuffer.concurrent", concurrent);
+
+        auto start = Sys::SteadyClock::now();
+        for (int frame = 0; frame < FRAMES; frame++) {
+            host.StartConcurrentConsumption();
+            for (int i = 0; i < COMMANDS_PER_FRAME; i++) {
+                BusyWait(WORK);
+                Send(THREAD_SAFE, i);
+            }
+            host.Consume();
+            host.StopConcurrentConsumption();
+        }
+        double frameTime = std::chrono::duration<double, std::milli>(Sys::SteadyClock::now() - start).count() / FRAMES;
+
+        // The consumer thread can only help when it has a core of its own
+        Log::Notice("vm.test.commandBuffer.concurrent %s: %.2f ms per frame (%u hardware threads)",
+                    concurrent, frameTime, std::thread::hardware_concurrency());
+    }
+}
+
+} // namespace
+} // namespace IPC
@@ -35,6 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "framework/CrashDump.h"
 #include "framework/CvarSystem.h"
 #include "framework/LogSystem.h"
+#include "framework/ProfilerSystem.h"
 #include "framework/VirtualMachine.h"
 
 // Suppress warnings for unused [this] lambda captures.
@@ -74,6 +75,20 @@ namespace VM {
                     offset = static_cast<int>(difftime(localEpochTime, epochTime));
                 });
                 break;
+
+            case PROFILER_LOCATE:
+                IPC::HandleMsg<ProfilerLocateMsg>(channel, std::move(reader), [this](IPC::SharedMemory shm) {
+                    if (shm.GetSize() < sizeof(Profiler::SharedBuffer)) {
+                        Sys::Drop("%s profiler buffer is too small", vmName);
+                    }
+                    if (profilerBuffer) {
+                        Profiler::UnregisterSharedBuffer(profilerBuffer);
+                    }
+                    profilerShm = std::move(shm);
+                    profilerBuffer = static_cast<Profiler::SharedBuffer*>(profilerShm.GetBase());
+                    Profiler::RegisterSharedBuffer(vmName, profilerBuffer);
+                });
+                break;
         }
     }
 
@@ -372,7 +387,7 @@ namespace VM {
     // Misc, Dispatch
 
     CommonVMServices::CommonVMServices(VMBase& vm, Str::StringRef vmName, FS::Owner fileOwnership, int commandFlag)
-    :vmName(vmName), fileOwnership(fileOwnership), vm(vm), commandProxy(new ProxyCmd(*this, commandFlag)) {
+    :vmName(vmName), fileOwnership(fileOwnership), vm(vm), profilerBuffer(nullptr), commandProxy(new ProxyCmd(*this, commandFlag)) {
     }
 
     CommonVMServices::~CommonVMServices() {
@@ -380,6 +395,9 @@ namespace VM {
         //FIXME or iterate over the commands we registered, or add Cmd::RemoveByProxy()
         Cmd::RemoveSameCommands(*commandProxy.get());
         //TODO unregister cvars
+        if (profilerBuffer) {
+            Profiler::UnregisterSharedBuffer(profilerBuffer);
+        }
     }
 
     void CommonVMServices::Syscall(int major, int minor, Util::Reader reader, IPC::Channel& channel) {
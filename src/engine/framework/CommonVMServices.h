@@ -55,6 +55,9 @@ namespace VM {
             // Misc Related
             void HandleMiscSyscall(int minor, Util::Reader& reader, IPC::Channel& channel);
 
+            IPC::SharedMemory profilerShm;
+            Profiler::SharedBuffer* profilerBuffer;
+
             // Command Related
             void HandleCommandSyscall(int minor, Util::Reader& reader, IPC::Channel& channel);
 
@@ -28,6 +28,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ===========================================================================
 */
 
+#include <condition_variable>
+#include <thread>
+
 #include <common/FileSystem.h>
 #include "qcommon/q_shared.h"
 #include "qcommon/qcommon.h"
@@ -36,43 +39,291 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace Log {
     static Target* targets[MAX_TARGET_ID];
 
+    static Cvar::Cvar<bool> useWriterThread("logs.async", "process the logfile target on a separate thread", Cvar::NONE, true);
+    static Cvar::Range<Cvar::Cvar<int>> queueSize("logs.async.queueSize", "log2 of the number of events that can wait for the writer thread", Cvar::INIT | Cvar::TEMPORARY, 12, 6, 20);
+    static Cvar::Cvar<bool> blockWhenFull("logs.async.blockWhenFull", "wait for the writer thread instead of dropping events when the queue is full", Cvar::NONE, false);
 
-    //TODO make me reentrant // or check it is actually reentrant when using for (Event e : events) do stuff
-    //TODO think way more about thread safety
-    void Dispatch(Log::Event event, int targetControl) {
-        static std::vector<Log::Event> buffers[MAX_TARGET_ID];
-        static std::recursive_mutex bufferLocks[MAX_TARGET_ID];
+    EventQueue::EventQueue(size_t capacity)
+        : slots(new Slot[capacity]), mask(capacity - 1), enqueuePos(0), dequeuePos(0) {
+        ASSERT_EQ(capacity & mask, 0U);
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool EventQueue::Push(Log::Event& event, int targetControl) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[pos & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The consumer hasn't freed this slot yet
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->event = std::move(event);
+        slot->targetControl = targetControl;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool EventQueue::Pop(Log::Event& event, int& targetControl) {
+        Slot& slot = slots[dequeuePos & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+            return false;
+        }
+
+        event = std::move(slot.event);
+        targetControl = slot.targetControl;
+        slot.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+
+    static std::vector<Log::Event> buffers[MAX_TARGET_ID];
+    static std::recursive_mutex bufferLocks[MAX_TARGET_ID];
+
+    // Gives the buffered events to the target, keeping them for later if it
+    // can't process them yet. The lock of the target must be held.
+    static void ProcessBuffer(int targetId) {
+        auto& buffer = buffers[targetId];
+
+        bool processed = false;
+        if (targets[targetId]) {
+            processed = targets[targetId]->Process(buffer);
+        }
+
+        if (processed || buffer.size() > 512) {
+            buffer.clear();
+        }
+    }
+
+    static void ProcessEvent(int targetId, const Log::Event& event) {
+        std::lock_guard<std::recursive_mutex> guard(bufferLocks[targetId]);
+        buffers[targetId].push_back(event);
+        ProcessBuffer(targetId);
+    }
+
+    static void ProcessEvents(int targetId, std::vector<Log::Event>& events) {
+        std::lock_guard<std::recursive_mutex> guard(bufferLocks[targetId]);
+        auto& buffer = buffers[targetId];
+        std::move(events.begin(), events.end(), std::back_inserter(buffer));
+        events.clear();
+        ProcessBuffer(targetId);
+    }
+
+    namespace {
+        struct Writer {
+            std::unique_ptr<EventQueue> queue;
+            std::thread thread;
+            std::thread::id threadId;
+            std::atomic<bool> running{false};
+            std::atomic<bool> stopping{false};
+            std::atomic<uint64_t> dropped{0};
+            std::atomic<uint64_t> processed{0};
+
+            // Used by the producers to wake the writer thread and by the
+            // writer thread to wake the threads waiting for a flush
+            std::mutex mutex;
+            std::condition_variable wakeWriter;
+            std::condition_variable wakeFlushers;
+
+            // The thread uses this object so it can't outlive it
+            ~Writer() {
+                if (thread.joinable()) {
+                    stopping = true;
+                    wakeWriter.notify_one();
+                    thread.join();
+                }
+            }
+        };
+    }
+
+    static Writer writer;
+
+    static void WriterThread() {
+        std::vector<Log::Event> batches[MAX_TARGET_ID];
+        const int maxBatchSize = 256;
+
+        while (!writer.stopping.load(std::memory_order_acquire) && !Sys::IsProcessTerminating()) {
+            Log::Event event("");
+            int targetControl;
+            int batchSize = 0;
+
+            while (batchSize < maxBatchSize && writer.queue->Pop(event, targetControl)) {
+                for (int i = 0; i < MAX_TARGET_ID; i++) {
+                    if ((targetControl >> i) & 1) {
+                        batches[i].push_back(event);
+                    }
+                }
+                batchSize++;
+            }
+
+            if (batchSize == 0) {
+                std::unique_lock<std::mutex> lock(writer.mutex);
+                // Producers don't take the lock to push so a wakeup can be
+                // missed, the timeout bounds the latency in that case.
+                writer.wakeWriter.wait_for(lock, std::chrono::milliseconds(10));
+                continue;
+            }
+
+            uint64_t dropped = writer.dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped != 0) {
+                std::string text = Str::Format("^3Warn: %d log events were dropped", dropped);
+                for (int i = 0; i < MAX_TARGET_ID; i++) {
+                    if (targets[i] && targets[i]->IsAsynchronous()) {
+                        batches[i].emplace_back(text);
+                    }
+                }
+            }
+
+            for (int i = 0; i < MAX_TARGET_ID; i++) {
+                if (!batches[i].empty()) {
+                    ProcessEvents(i, batches[i]);
+                }
+            }
 
+            writer.processed.fetch_add(batchSize, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            writer.wakeFlushers.notify_all();
+        }
+    }
+
+    // Queues the event for the writer thread, returns false if it should be
+    // processed on this thread instead.
+    static bool QueueEvent(Log::Event& event, int targetControl) {
+        if (!writer.running.load(std::memory_order_acquire) || !useWriterThread.Get()) {
+            return false;
+        }
+
+        // Logs emitted while processing logs would deadlock if the queue is full
+        if (std::this_thread::get_id() == writer.threadId) {
+            return false;
+        }
+
+        while (!writer.queue->Push(event, targetControl)) {
+            if (!blockWhenFull.Get()) {
+                writer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            writer.wakeWriter.notify_one();
+            std::this_thread::yield();
+        }
+
+        writer.wakeWriter.notify_one();
+        return true;
+    }
+
+    void Dispatch(Log::Event event, int targetControl) {
         if (Sys::IsProcessTerminating()) {
             return;
         }
 
+        int asyncControl = 0;
+        for (int i = 0; i < MAX_TARGET_ID; i++) {
+            if (((targetControl >> i) & 1) && targets[i] && targets[i]->IsAsynchronous()) {
+                asyncControl |= 1 << i;
+            }
+        }
+
+        // The queue takes the event so give it a copy if some targets are
+        // processed on this thread
+        if (asyncControl == targetControl) {
+            if (QueueEvent(event, asyncControl)) {
+                return;
+            }
+        } else if (asyncControl != 0) {
+            Log::Event copy = event;
+            if (QueueEvent(copy, asyncControl)) {
+                targetControl &= ~asyncControl;
+            }
+        }
+
         for (int i = 0; i < MAX_TARGET_ID; i++) {
             if ((targetControl >> i) & 1) {
-                std::lock_guard<std::recursive_mutex> guard(bufferLocks[i]);
-                auto& buffer = buffers[i];
+                ProcessEvent(i, event);
+            }
+        }
+    }
 
-                buffer.push_back(event);
+    void StartWriterThread() {
+        if (writer.running) {
+            return;
+        }
 
-                bool processed = false;
-                if (targets[i]) {
-                    processed = targets[i]->Process(buffer);
-                }
+        writer.queue.reset(new EventQueue(size_t(1) << queueSize.Get()));
+        writer.stopping = false;
+        try {
+            writer.thread = std::thread(WriterThread);
+            writer.threadId = writer.thread.get_id();
+        } catch (std::system_error& err) {
+            Log::Warn("Could not create the log writer thread: %s", err.what());
+            return;
+        }
+        writer.running.store(true, std::memory_order_release);
+    }
+
+    void StopWriterThread() {
+        if (std::this_thread::get_id() == writer.threadId) {
+            return;
+        }
+        if (!writer.running.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            writer.stopping = true;
+        }
+        writer.wakeWriter.notify_one();
+        writer.thread.join();
 
-                if (processed || buffer.size() > 512) {
-                    buffer.clear();
+        // This thread is the consumer now, process what the writer left
+        Log::Event event("");
+        int targetControl;
+        while (writer.queue->Pop(event, targetControl)) {
+            for (int i = 0; i < MAX_TARGET_ID; i++) {
+                if ((targetControl >> i) & 1) {
+                    ProcessEvent(i, event);
                 }
             }
         }
     }
 
+    void FlushEvents(std::chrono::milliseconds timeout) {
+        if (!writer.running.load(std::memory_order_acquire) || std::this_thread::get_id() == writer.threadId) {
+            return;
+        }
+
+        uint64_t target = writer.queue->PushedCount();
+        std::unique_lock<std::mutex> lock(writer.mutex);
+        writer.wakeWriter.notify_one();
+        writer.wakeFlushers.wait_for(lock, timeout, [target] {
+            return writer.processed.load(std::memory_order_acquire) >= target;
+        });
+    }
+
+    uint64_t DroppedEventCount() {
+        return writer.dropped.load(std::memory_order_relaxed);
+    }
+
     void RegisterTarget(TargetId id, Target* target) {
         targets[id] = target;
     }
 
     Target::Target() = default;
 
-    void Target::Register(TargetId id) {
+    void Target::Register(TargetId id, bool asynchronous) {
+        this->asynchronous = asynchronous;
         Log::RegisterTarget(id, this);
     }
 
@@ -104,7 +355,7 @@ namespace Log {
     class LogFileTarget: public Target {
         public:
             LogFileTarget() {
-                this->Register(LOGFILE);
+                this->Register(LOGFILE, true);
             }
 
             virtual bool Process(const std::vector<Log::Event>& events) override {
@@ -114,9 +365,14 @@ namespace Log {
                 }
 
                 if (logFile) {
+                    std::string text;
                     for (auto& event : events) {
-                        logFile.Printf("%s\n", event.text);
+                        text += event.text;
+                        text += '\n';
                     }
+                    // Errors can't be logged from here, the events are dropped
+                    std::error_code err;
+                    logFile.Write(text.data(), text.size(), err);
                     return true;
                 } else {
                     return false;
@@ -150,6 +406,8 @@ namespace Log {
     }
 
     void FlushLogFile() {
+        FlushEvents();
+
         std::error_code err;
         logfile.logFile.Flush(err);
         if (err) {
@@ -31,6 +31,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef FRAMEWORK_LOG_SYSTEM_H_
 #define FRAMEWORK_LOG_SYSTEM_H_
 
+#include <atomic>
+#include <memory>
+
 /*
  * The log system takes log events from different sources and forwards them
  * to a number of targets. The event and the targets are decoupled so that
@@ -39,6 +42,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  * A full list of the targets and "printing" facilities can be found in
  * common/Log
+ *
+ * Once StartWriterThread has been called, events for asynchronous targets
+ * (only the log file, the consoles aren't thread safe) are pushed in a bounded queue and processed in
+ * batches by a writer thread, so that the threads producing logs don't wait
+ * on the IO. When the queue is full the events are dropped (and counted)
+ * unless logs.async.blockWhenFull is set.
  */
 
 namespace Log {
@@ -50,8 +59,24 @@ namespace Log {
     // Open the log file and start writing to it
     void OpenLogFile();
 
+    // Start processing the events of asynchronous targets on a separate thread.
+    // Must be called after the crash handler is set up as it may fork.
+    void StartWriterThread();
+
+    // Processes the events left in the queue and joins the writer thread,
+    // the events are processed synchronously afterwards.
+    void StopWriterThread();
+
+    // Waits until the writer thread processed all the events queued so far,
+    // or until the timeout expired. Returns immediately on the writer thread.
+    void FlushEvents(std::chrono::milliseconds timeout = std::chrono::seconds(1));
+
+    // Flushes the pending events then the log file
     void FlushLogFile();
 
+    // Number of events dropped because the queue was full
+    uint64_t DroppedEventCount();
+
     class Target {
         public:
             Target();
@@ -63,9 +88,55 @@ namespace Log {
             // Can be called by any thread.
             virtual bool Process(const std::vector<Log::Event>& events) = 0;
 
+            // True if the events are processed on the writer thread
+            bool IsAsynchronous() const {
+                return asynchronous;
+            }
+
         protected:
             // Register itself as the target with this id
-            void Register(TargetId id);
+            void Register(TargetId id, bool asynchronous = false);
+
+        private:
+            bool asynchronous = false;
+    };
+
+    // Bounded lock-free queue of events with many producers and one consumer.
+    // Each slot has a sequence number telling whether it can be written to
+    // or read from for the current lap around the ring.
+    class EventQueue {
+        public:
+            // capacity must be a power of 2
+            explicit EventQueue(size_t capacity);
+
+            // Returns false, without taking the event, if the queue is full
+            bool Push(Log::Event& event, int targetControl);
+
+            // Must only be called by the consumer thread
+            bool Pop(Log::Event& event, int& targetControl);
+
+            // Number of events pushed since the creation of the queue
+            uint64_t PushedCount() const {
+                return enqueuePos.load(std::memory_order_acquire);
+            }
+
+        private:
+            struct Slot {
+                std::atomic<size_t> sequence;
+                Log::Event event = Log::Event("");
+                int targetControl = 0;
+            };
+
+            // The positions are kept on separate cache lines with padding
+            // rather than alignas, which heap allocation doesn't honor in C++14
+            static constexpr size_t CACHE_LINE_SIZE = 64;
+
+            std::unique_ptr<Slot[]> slots;
+            size_t mask;
+            char padding0[CACHE_LINE_SIZE];
+            std::atomic<size_t> enqueuePos;
+            char padding1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+            size_t dequeuePos;
     };
 
     // Internal
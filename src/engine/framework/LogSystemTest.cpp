@@ -0,0 +1,121 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <thread>
+
+#include <gtest/gtest.h>
+#include "common/Common.h"
+#include "LogSystem.h"
+
+namespace Log {
+namespace {
+
+TEST(EventQueueTest, FirstInFirstOut)
+{
+    EventQueue queue(4);
+    Log::Event event("");
+    int targetControl;
+
+    EXPECT_FALSE(queue.Pop(event, targetControl));
+
+    // Go around the ring a few times
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 3; i++) {
+            Log::Event pushed(std::to_string(i));
+            ASSERT_TRUE(queue.Push(pushed, i));
+        }
+        for (int i = 0; i < 3; i++) {
+            ASSERT_TRUE(queue.Pop(event, targetControl));
+            EXPECT_EQ(std::to_string(i), event.text);
+            EXPECT_EQ(i, targetControl);
+        }
+        EXPECT_FALSE(queue.Pop(event, targetControl));
+    }
+    EXPECT_EQ(9U, queue.PushedCount());
+}
+
+TEST(EventQueueTest, Full)
+{
+    EventQueue queue(2);
+    Log::Event a("a"), b("b"), c("c");
+    ASSERT_TRUE(queue.Push(a, 0));
+    ASSERT_TRUE(queue.Push(b, 0));
+
+    // The event is left untouched when it can't be queued
+    EXPECT_FALSE(queue.Push(c, 0));
+    EXPECT_EQ("c", c.text);
+
+    Log::Event event("");
+    int targetControl;
+    ASSERT_TRUE(queue.Pop(event, targetControl));
+    EXPECT_EQ("a", event.text);
+    EXPECT_TRUE(queue.Push(c, 0));
+}
+
+TEST(EventQueueTest, ManyProducers)
+{
+    constexpr int numProducers = 4;
+    constexpr int numEvents = 20000;
+    EventQueue queue(64);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < numProducers; producer++) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < numEvents; i++) {
+                Log::Event event(std::to_string(i));
+                while (!queue.Push(event, producer)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Events of each producer come out in the order they were pushed
+    int next[numProducers] = {};
+    int received = 0;
+    while (received < numProducers * numEvents) {
+        Log::Event event("");
+        int producer;
+        if (!queue.Pop(event, producer)) {
+            std::this_thread::yield();
+            continue;
+        }
+        EXPECT_EQ(std::to_string(next[producer]), event.text);
+        next[producer]++;
+        received++;
+    }
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+}
+
+} // namespace
+} // namespace Log
@@ -0,0 +1,221 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "ProfilerSystem.h"
+#include "common/FileSystem.h"
+
+namespace Profiler {
+
+    static Log::Logger profilerLogs("common.profiler");
+
+    namespace {
+        struct SharedBufferInfo {
+            std::string name;
+            SharedBuffer* buffer;
+        };
+
+        struct Process {
+            std::string name;
+            std::vector<Zone> zones;
+        };
+    }
+
+    static std::mutex sharedBuffersMutex;
+    static std::vector<SharedBufferInfo> sharedBuffers;
+
+    static bool capturing = false;
+    static int framesLeft = 0;
+    static std::string captureFilename;
+    static int64_t captureStart = 0;
+    // Zones of the VMs that went away during the capture
+    static std::vector<Process> orphanProcesses;
+
+    void RegisterSharedBuffer(Str::StringRef name, SharedBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(sharedBuffersMutex);
+        buffer->count = 0;
+        buffer->enabled = capturing;
+        sharedBuffers.push_back({name, buffer});
+    }
+
+    void UnregisterSharedBuffer(SharedBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(sharedBuffersMutex);
+        for (auto it = sharedBuffers.begin(); it != sharedBuffers.end(); ++it) {
+            if (it->buffer == buffer) {
+                if (capturing) {
+                    orphanProcesses.push_back({it->name, CollectZones(*buffer)});
+                }
+                sharedBuffers.erase(it);
+                return;
+            }
+        }
+    }
+
+    static void SetAllEnabled(bool enable) {
+        SetEnabled(enable);
+
+        std::lock_guard<std::mutex> lock(sharedBuffersMutex);
+        for (auto& info : sharedBuffers) {
+            info.buffer->enabled = enable;
+            if (enable) {
+                info.buffer->count = 0;
+            }
+        }
+    }
+
+    void StartCapture(int numFrames, Str::StringRef filename) {
+        // Drop what was recorded by a previous capture
+        if (capturing) {
+            StopCapture();
+        }
+        CollectZones();
+
+        capturing = true;
+        framesLeft = numFrames;
+        captureFilename = filename;
+        captureStart = Now();
+        SetAllEnabled(true);
+    }
+
+    bool Capturing() {
+        return capturing;
+    }
+
+    static void WriteCapture() {
+        std::string filename = captureFilename;
+        std::string trace = StopCapture();
+
+        try {
+            FS::File f = FS::HomePath::OpenWrite(filename);
+            f.Write(trace.data(), trace.size());
+            Log::Notice("Wrote profile to %s", filename);
+        } catch (const std::system_error& error) {
+            Log::Warn("Couldn't write %s: %s", filename, error.what());
+        }
+    }
+
+    void Frame() {
+        if (capturing && --framesLeft <= 0) {
+            WriteCapture();
+        }
+    }
+
+    static std::string EscapeJSON(Str::StringRef text) {
+        std::string result;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                result.push_back('\\');
+                result.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                result += Str::Format("\\u%04x", static_cast<int>(c));
+            } else {
+                result.push_back(c);
+            }
+        }
+        return result;
+    }
+
+    // See the "Trace Event Format" documentation: zones are "complete" events
+    // with microsecond timestamps and each process gets a name metadata event.
+    static std::string ChromeTrace(const std::vector<Process>& processes, int64_t start) {
+        std::string json = "{\"traceEvents\":[\n";
+        bool first = true;
+        auto addEvent = [&](std::string event) {
+            if (!first) {
+                json += ",\n";
+            }
+            first = false;
+            json += event;
+        };
+
+        for (size_t pid = 0; pid < processes.size(); pid++) {
+            const Process& process = processes[pid];
+            addEvent(Str::Format("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"%s\"}}",
+                                 pid, EscapeJSON(process.name)));
+            for (const Zone& zone : process.zones) {
+                addEvent(Str::Format("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                     EscapeJSON(zone.name), pid, zone.thread,
+                                     (zone.start - start) / 1000.0, (zone.end - zone.start) / 1000.0));
+            }
+        }
+
+        json += "\n],\"displayTimeUnit\":\"ns\"}\n";
+        return json;
+    }
+
+    std::string StopCapture() {
+        SetAllEnabled(false);
+        capturing = false;
+
+        std::vector<Process> processes;
+        processes.push_back({"engine", CollectZones()});
+        {
+            std::lock_guard<std::mutex> lock(sharedBuffersMutex);
+            for (auto& info : sharedBuffers) {
+                processes.push_back({info.name, CollectZones(*info.buffer)});
+            }
+        }
+        for (auto& process : orphanProcesses) {
+            processes.push_back(std::move(process));
+        }
+        orphanProcesses.clear();
+
+        size_t numZones = 0;
+        for (const Process& process : processes) {
+            numZones += process.zones.size();
+        }
+        profilerLogs.Verbose("Captured %d zones in %d processes", numZones, processes.size());
+
+        return ChromeTrace(processes, captureStart);
+    }
+
+    class ProfileCmd: public Cmd::StaticCmd {
+        public:
+            ProfileCmd(): StaticCmd("profile", Cmd::BASE, "records the profiler zones of the next frames") {
+            }
+
+            void Run(const Cmd::Args& args) const override {
+                int numFrames;
+                if (args.Argc() < 2 || args.Argc() > 3 || !Str::ParseInt(numFrames, args.Argv(1)) || numFrames <= 0) {
+                    PrintUsage(args, "<frames> [<name>]", "records the profiler zones of the next frames to profiles/<name>.json");
+                    return;
+                }
+
+                std::string name = args.Argc() == 3 ? args.Argv(2) : "profile";
+                if (!Str::IsSuffix(".json", name)) {
+                    name += ".json";
+                }
+
+                StartCapture(numFrames, "profiles/" + name);
+                Print("Profiling the next %d frames", numFrames);
+            }
+    };
+    static ProfileCmd ProfileCmdRegistration;
+
+} // namespace Profiler
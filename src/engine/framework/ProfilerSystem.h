@@ -0,0 +1,63 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef FRAMEWORK_PROFILER_SYSTEM_H_
+#define FRAMEWORK_PROFILER_SYSTEM_H_
+
+#include "common/Common.h"
+
+/*
+ * Engine side of the profiler: it gathers the zones of the engine threads and
+ * of the VMs for a number of frames and exports them as Chrome trace event
+ * JSON, which can be opened in chrome://tracing or https://ui.perfetto.dev
+ */
+
+namespace Profiler {
+
+    // Zones recorded in the buffer are collected with the engine ones, under
+    // the given process name.
+    void RegisterSharedBuffer(Str::StringRef name, SharedBuffer* buffer);
+    void UnregisterSharedBuffer(SharedBuffer* buffer);
+
+    // Enables the profiler until numFrames calls to Frame() happened, then
+    // the trace is written to the file in the homepath.
+    void StartCapture(int numFrames, Str::StringRef filename);
+    bool Capturing();
+
+    // To be called at the start of each frame.
+    void Frame();
+
+    // Disables the profiler and returns the trace of the zones recorded since
+    // the start of the capture.
+    std::string StopCapture();
+
+} // namespace Profiler
+
+#endif // FRAMEWORK_PROFILER_SYSTEM_H_
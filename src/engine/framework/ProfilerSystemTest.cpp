@@ -0,0 +1,189 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+#include "common/Common.h"
+#include "ProfilerSystem.h"
+
+namespace Profiler {
+namespace {
+
+class ProfilerTest : public testing::Test {
+protected:
+    void SetUp() override {
+        SetEnabled(false);
+        CollectZones();
+    }
+
+    void TearDown() override {
+        SetEnabled(false);
+    }
+};
+
+TEST_F(ProfilerTest, DisabledRecordsNothing)
+{
+    {
+        PROFILE_ZONE("disabled");
+    }
+    EXPECT_TRUE(CollectZones().empty());
+}
+
+TEST_F(ProfilerTest, NestedZones)
+{
+    SetEnabled(true);
+    {
+        PROFILE_ZONE("outer");
+        {
+            PROFILE_ZONE("inner");
+        }
+    }
+    SetEnabled(false);
+
+    std::vector<Zone> zones = CollectZones();
+    ASSERT_EQ(2U, zones.size());
+    // Zones are recorded when they end
+    const Zone& inner = zones[0];
+    const Zone& outer = zones[1];
+    EXPECT_EQ("inner", inner.name);
+    EXPECT_EQ("outer", outer.name);
+    EXPECT_LE(outer.start, inner.start);
+    EXPECT_LE(inner.start, inner.end);
+    EXPECT_LE(inner.end, outer.end);
+    EXPECT_EQ(outer.thread, inner.thread);
+
+    EXPECT_TRUE(CollectZones().empty());
+}
+
+TEST_F(ProfilerTest, Threads)
+{
+    SetEnabled(true);
+    {
+        PROFILE_ZONE("main");
+    }
+    std::thread thread([] {
+        PROFILE_ZONE("thread");
+    });
+    thread.join();
+    SetEnabled(false);
+
+    std::vector<Zone> zones = CollectZones();
+    ASSERT_EQ(2U, zones.size());
+    EXPECT_NE(zones[0].name, zones[1].name);
+    EXPECT_NE(zones[0].thread, zones[1].thread);
+}
+
+TEST_F(ProfilerTest, ExitedThreadBuffersRecycled)
+{
+    SetEnabled(true);
+    auto runThread = [] {
+        std::thread thread([] {
+            PROFILE_ZONE("thread");
+        });
+        thread.join();
+    };
+
+    runThread();
+    // The zones of an exited thread can still be collected
+    ASSERT_EQ(1U, CollectZones().size());
+    size_t numBuffers = NumThreadBuffers();
+
+    for (int i = 0; i < 10; i++) {
+        runThread();
+        std::vector<Zone> zones = CollectZones();
+        ASSERT_EQ(1U, zones.size());
+        EXPECT_EQ("thread", zones[0].name);
+    }
+    SetEnabled(false);
+
+    EXPECT_EQ(numBuffers, NumThreadBuffers());
+}
+
+TEST_F(ProfilerTest, SharedBuffer)
+{
+    std::unique_ptr<SharedBuffer> buffer(new SharedBuffer);
+    RegisterSharedBuffer("testvm", buffer.get());
+    EXPECT_EQ(0U, buffer->enabled.load());
+
+    StartCapture(1, "unused.json");
+    EXPECT_EQ(1U, buffer->enabled.load());
+
+    // Pretend to be the VM for a moment
+    UseSharedBuffer(buffer.get());
+    EXPECT_TRUE(Enabled());
+    {
+        PROFILE_ZONE("vmZone");
+    }
+    UseSharedBuffer(nullptr);
+    {
+        PROFILE_ZONE("engineZone");
+    }
+
+    std::string trace = StopCapture();
+    EXPECT_FALSE(Capturing());
+    EXPECT_EQ(0U, buffer->enabled.load());
+    EXPECT_EQ(0U, buffer->count.load());
+    UnregisterSharedBuffer(buffer.get());
+
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"engine\"}"));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"testvm\"}"));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"engineZone\",\"ph\":\"X\",\"pid\":0,"));
+    EXPECT_NE(std::string::npos, trace.find("{\"name\":\"vmZone\",\"ph\":\"X\",\"pid\":1,"));
+}
+
+TEST_F(ProfilerTest, SharedBufferFull)
+{
+    std::unique_ptr<SharedBuffer> buffer(new SharedBuffer);
+    buffer->enabled = 1;
+    buffer->count = 0;
+
+    UseSharedBuffer(buffer.get());
+    for (int i = 0; i < SharedBuffer::NUM_ENTRIES + 10; i++) {
+        PROFILE_ZONE("a zone name that is longer than the space reserved for it in the shared buffer");
+    }
+    UseSharedBuffer(nullptr);
+
+    std::vector<Zone> zones = CollectZones(*buffer);
+    ASSERT_EQ(static_cast<size_t>(SharedBuffer::NUM_ENTRIES), zones.size());
+    EXPECT_EQ(SharedBuffer::NAME_LENGTH - 1, static_cast<int>(zones[0].name.size()));
+    EXPECT_TRUE(CollectZones(*buffer).empty());
+}
+
+TEST_F(ProfilerTest, ChromeTraceEscaping)
+{
+    StartCapture(1, "unused.json");
+    RecordZone("quote\" backslash\\ newline\n", Now(), Now());
+    std::string trace = StopCapture();
+
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"quote\\\" backslash\\\\ newline\\u000a\""));
+    EXPECT_EQ(0U, trace.find("{\"traceEvents\":["));
+}
+
+} // namespace
+} // namespace Profiler
@@ -187,6 +187,8 @@ namespace Resource {
             int Size() const;
 
             Handle<T> GetResource(Str::StringRef name) const;
+            // True if the resource is registered and its data is loaded.
+            bool IsLoaded(Str::StringRef name) const;
             std::shared_ptr<T> GetDefaultResource() const {
                 return defaultValue;
             }
@@ -321,6 +323,12 @@ namespace Resource {
 
         return Handle<T>(it->second, this);
     }
+
+    template<typename T>
+    bool Manager<T>::IsLoaded(Str::StringRef name) const {
+        auto it = resources.find(name);
+        return it != resources.end() && it->second->loaded;
+    }
 }
 
 #endif //FRAMEWORK_RESOURCE_H_
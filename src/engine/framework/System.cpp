@@ -521,6 +521,9 @@ static void Shutdown(bool error, Str::StringRef message)
 		Cvar::Shutdown();
 	}
 
+	// Print the pending logs while the terminal is still set up
+	Log::StopWriterThread();
+
 	// Always run CON_Shutdown, because it restores the terminal to a usable state.
 	CON_Shutdown();
 
@@ -562,6 +565,9 @@ void Error(Str::StringRef message)
 	Log::Warn(message);
 	PrintStackTrace();
 
+	// Get the error out of the writer thread in case the shutdown crashes
+	Log::FlushLogFile();
+
 	Shutdown(true, message);
 
 	OSExit(1);
@@ -949,6 +955,8 @@ static void Init(int argc, char** argv)
 		BreakpadInit();
 	}
 
+	Log::StartWriterThread();
+
 	// Start a thread which reads commands from the singleton socket
 	try {
 		std::thread(ReadSingletonSocket).detach();
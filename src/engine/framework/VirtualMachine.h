@@ -111,7 +111,7 @@ struct VMParams {
 class VMBase {
 public:
 	VMBase(std::string name_, int vmTypeCvarFlags)
-		: processHandle(Sys::INVALID_HANDLE), name(name_), type(TYPE_NACL), params(name_, vmTypeCvarFlags) {}
+		: processHandle(Sys::INVALID_HANDLE), name(name_), type(TYPE_NACL), params(name_, vmTypeCvarFlags), numMessages(0) {}
 
 	// Create the VM for the named module. This will automatically free any existing VM.
 	void Create();
@@ -128,13 +128,25 @@ public:
 	// Make sure the VM is closed on exit
 	virtual ~VMBase();
 
+	// Number of messages exchanged with the VM so far, in both directions
+	uint64_t GetNumMessages() const
+	{
+		return numMessages;
+	}
+
 	// Send a message to the VM
 	template<typename Msg, typename... Args> void SendMsg(Args&&... args)
 	{
+		PROFILE_ZONE("VM SendMsg");
+		SendPendingMsgs();
+
 		// Marking lambda as mutable to work around a bug in gcc 4.6
 		LogMessage(false, true, Msg::id);
+		numMessages++;
 		IPC::SendMsg<Msg>(rootChannel, [this](uint32_t id, Util::Reader reader) mutable {
+			PROFILE_ZONE("VM HandleMsg");
 			LogMessage(true, true, id);
+			numMessages++;
 			Syscall(id, std::move(reader), rootChannel);
 			LogMessage(true, false, id);
 		}, std::forward<Args>(args)...);
@@ -156,6 +168,11 @@ protected:
 	// System call handler
 	virtual void Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel) = 0;
 
+	// Called before each message is sent to the VM, including those sent by
+	// the common services, to send the messages that were queued before it
+	// so that the VM gets everything in order.
+	virtual void SendPendingMsgs() {}
+
 private:
 	void FreeInProcessVM();
 
@@ -178,6 +195,8 @@ private:
 	FS::File syscallLogFile;
 
 	void LogMessage(bool vmToEngine, bool start, int id);
+
+	uint64_t numMessages;
 };
 
 } // namespace VM
@@ -54,6 +54,9 @@ namespace Audio {
         return 0;
     }
 
+    void PrefetchSFX(Str::StringRef) {
+    }
+
     void EndRegistration() {
     }
 
@@ -74,6 +74,10 @@ void RE_GlyphChar( fontInfo_t *, int, glyphInfo_t *glyph )
 	glyph->glyph = 1;
 	glyph->shaderName[0] = '\0';
 }
+void RE_PrefetchModel( const char * ) { }
+void RE_PrefetchFile( const char * ) { }
+void RE_ClearPrefetchedFiles() { }
+void RE_PrefetchShader( const char * ) { }
 void RE_LoadWorldMap( const char * ) { }
 void RE_SetWorldVisData( const byte * ) { }
 void RE_EndRegistration() { }
@@ -115,6 +119,7 @@ bool R_inPVVS( const vec3_t, const vec3_t )
 	return false;
 }
 void RE_TakeVideoFrame( int, int, byte*, byte*, bool ) { }
+void RE_FinishVideoFrames() { }
 int RE_RegisterAnimation( const char* )
 {
 	return 1;
@@ -198,6 +203,10 @@ refexport_t    *GetRefAPI( int, refimport_t* )
     re.RegisterModel = RE_RegisterModel;
     re.RegisterSkin = RE_RegisterSkin;
     re.RegisterShader = RE_RegisterShader;
+    re.PrefetchModel = RE_PrefetchModel;
+    re.PrefetchFile = RE_PrefetchFile;
+    re.ClearPrefetchedFiles = RE_ClearPrefetchedFiles;
+    re.PrefetchShader = RE_PrefetchShader;
     re.RegisterFont = RE_RegisterFont;
     re.GlyphChar = RE_GlyphChar;
     re.UnregisterFont = RE_UnregisterFont;
@@ -238,6 +247,7 @@ refexport_t    *GetRefAPI( int, refimport_t* )
     re.inPVVS = R_inPVVS;
 
     re.TakeVideoFrame = RE_TakeVideoFrame;
+    re.FinishVideoFrames = RE_FinishVideoFrames;
 
     // RB: alternative skeletal animation system
     re.RegisterAnimation = RE_RegisterAnimation;
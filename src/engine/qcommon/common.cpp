@@ -48,6 +48,7 @@ Maryland 20850 USA.
 #include "framework/CvarSystem.h"
 #include "framework/LogSystem.h"
 #include "framework/OmpSystem.h"
+#include "framework/ProfilerSystem.h"
 #include "framework/System.h"
 #include "sys/sys_events.h"
 #include <common/FileSystem.h>
@@ -439,6 +440,9 @@ void Com_EventLoop()
 				}
 			}
 
+			// send the replies to the packets all at once
+			Sys_FlushPackets();
+
 			return;
 		}
 
@@ -784,6 +788,9 @@ static Cvar::Cvar<bool> showTraceStats("common.showTraceStats", "are physics tra
 
 void Com_Frame()
 {
+	Profiler::Frame();
+	PROFILE_ZONE("Com_Frame");
+
 	Omp::SetupThreads();
 
 	int             msec, minMsec;
@@ -958,6 +965,8 @@ void Com_Frame()
 
 	CL_Frame( msec );
 
+	Sys_FlushPackets();
+
 	if ( com_speeds->integer )
 	{
 		timeAfter = Sys::Milliseconds();
@@ -1026,11 +1035,11 @@ void Com_Frame()
 	//
 	if ( showTraceStats.Get() )
 	{
-		extern int c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
-		extern int c_pointcontents;
+		extern std::atomic<int> c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
+		extern std::atomic<int> c_pointcontents;
 
-		Log::Notice( "%4i traces  (%ib %ip %it) %4i points", c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces,
-		            c_pointcontents );
+		Log::Notice( "%4i traces  (%ib %ip %it) %4i points", c_traces.load(), c_brush_traces.load(), c_patch_traces.load(),
+		            c_trisoup_traces.load(), c_pointcontents.load() );
 		c_traces = 0;
 		c_brush_traces = 0;
 		c_patch_traces = 0;
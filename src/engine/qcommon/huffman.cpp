@@ -473,6 +473,113 @@ void Huff_offsetTransmit( huff_t *huff, int ch, byte *fout, int *offset )
 	*offset = bloc;
 }
 
+//clears data along the way like Huff_putBit, but a byte at a time
+void Huff_putBits( uint64_t bits, int count, byte *fout, int *offset )
+{
+	int pos = *offset;
+
+	while ( count > 0 )
+	{
+		int x = pos >> 3;
+		int y = pos & 7;
+		int n = std::min( 8 - y, count );
+
+		if ( !y )
+		{
+			fout[ x ] = 0;
+		}
+
+		fout[ x ] |= ( bits & ( ( 1 << n ) - 1 ) ) << y;
+		bits >>= n;
+		count -= n;
+		pos += n;
+	}
+
+	*offset = pos;
+}
+
+// returns at least 17 bits starting at offset, the first bit in the lowest position
+// reads 3 bytes, so the caller must make sure they are inside the buffer
+uint32_t Huff_peekBits( const byte *fin, int offset )
+{
+	const byte *p = fin + ( offset >> 3 );
+	uint32_t window = p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 );
+
+	return window >> ( offset & 7 );
+}
+
+/* Precompute the codes of a tree which won't be updated anymore */
+void Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor )
+{
+	for ( int ch = 0; ch < HMAX; ch++ )
+	{
+		huffCode_t *code = &table->encode[ ch ];
+		code->bits = 0;
+		code->length = 0;
+
+		// going up from the leaf, so the root bit, which is sent first, ends up lowest
+		for ( node_t *node = compressor->loc[ ch ]; node && node->parent; node = node->parent )
+		{
+			if ( code->length >= 32 )
+			{
+				Sys::Error( "Huff_BuildTable: code for symbol %d is too long", ch );
+			}
+
+			code->bits = ( code->bits << 1 ) | ( node->parent->right == node );
+			code->length++;
+		}
+	}
+
+	for ( int i = 0; i < ( 1 << HUFF_LOOKUP_BITS ); i++ )
+	{
+		huffDecode_t *entry = &table->decode[ i ];
+		node_t *node = decompressor->tree;
+		int length = 0;
+
+		while ( node && node->symbol == INTERNAL_NODE && length < HUFF_LOOKUP_BITS )
+		{
+			node = ( ( i >> length ) & 1 ) ? node->right : node->left;
+			length++;
+		}
+
+		if ( node && node->symbol != INTERNAL_NODE )
+		{
+			entry->symbol = node->symbol;
+			entry->length = length;
+		}
+		else
+		{
+			entry->symbol = 0;
+			entry->length = 0;
+		}
+	}
+
+	table->tree = decompressor->tree;
+}
+
+/* Send a symbol using the precomputed code */
+void Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset )
+{
+	const huffCode_t &code = table->encode[ ch ];
+	Huff_putBits( code.bits, code.length, fout, offset );
+}
+
+/* Get a symbol, looking up HUFF_LOOKUP_BITS at once */
+void Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int *offset )
+{
+	const huffDecode_t &entry = table->decode[ Huff_peekBits( fin, *offset ) & ( ( 1 << HUFF_LOOKUP_BITS ) - 1 ) ];
+
+	if ( entry.length )
+	{
+		*ch = entry.symbol;
+		*offset += entry.length;
+		return;
+	}
+
+	// rare long code, do it the slow way
+	Huff_offsetReceive( table->tree, ch, fin, offset );
+}
+
 void Huff_Decompress( msg_t *mbuf, int offset )
 {
 	int    ch, cch, i, j, size;
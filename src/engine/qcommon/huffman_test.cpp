@@ -0,0 +1,288 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+#include <random>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "qcommon/q_shared.h"
+#include "qcommon/qcommon.h"
+
+namespace {
+
+// A static tree built the same way as the one in msg.cpp, with weights following
+// the Fibonacci sequence for the first symbols so that some codes are longer than
+// HUFF_LOOKUP_BITS and the fallback path is exercised.
+class HuffmanTableTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        huff = std::make_unique<huffman_t>();
+        Huff_Init( huff.get() );
+
+        int weights[ HMAX ];
+        int a = 1, b = 1;
+        for ( int ch = 0; ch < HMAX; ch++ )
+        {
+            if ( ch < 18 )
+            {
+                weights[ ch ] = a;
+                int next = a + b;
+                a = b;
+                b = next;
+            }
+            else
+            {
+                weights[ ch ] = 100 + ( ch * 37 ) % 500;
+            }
+        }
+
+        for ( int ch = 0; ch < HMAX; ch++ )
+        {
+            for ( int j = 0; j < weights[ ch ]; j++ )
+            {
+                Huff_addRef( &huff->compressor, ( byte ) ch );
+                Huff_addRef( &huff->decompressor, ( byte ) ch );
+            }
+        }
+
+        table = std::make_unique<huffTable_t>();
+        Huff_BuildTable( table.get(), &huff->compressor, &huff->decompressor );
+    }
+
+    std::unique_ptr<huffman_t> huff;
+    std::unique_ptr<huffTable_t> table;
+};
+
+TEST_F(HuffmanTableTest, HasLongCodes)
+{
+    int longest = 0;
+    for ( const huffCode_t& code : table->encode )
+    {
+        EXPECT_GT( code.length, 0 );
+        longest = std::max( longest, code.length );
+    }
+    EXPECT_GT( longest, HUFF_LOOKUP_BITS );
+}
+
+TEST_F(HuffmanTableTest, EncodeMatchesTree)
+{
+    std::mt19937 rng( 42 );
+    std::vector<byte> treeOut( 1 << 16 ), tableOut( 1 << 16 );
+    int treeBit = 0, tableBit = 0;
+
+    for ( int n = 0; n < 20000; n++ )
+    {
+        int ch = rng() % HMAX;
+        Huff_offsetTransmit( &huff->compressor, ch, treeOut.data(), &treeBit );
+        Huff_tableTransmit( table.get(), ch, tableOut.data(), &tableBit );
+        ASSERT_EQ( treeBit, tableBit );
+    }
+
+    treeOut.resize( ( treeBit + 7 ) >> 3 );
+    tableOut.resize( ( tableBit + 7 ) >> 3 );
+    EXPECT_EQ( treeOut, tableOut );
+}
+
+TEST_F(HuffmanTableTest, DecodeMatchesTree)
+{
+    std::mt19937 rng( 1337 );
+    std::vector<byte> buffer( 1 << 16 );
+    std::vector<int> symbols;
+    int bit = 0;
+
+    for ( int n = 0; n < 20000; n++ )
+    {
+        int ch = rng() % HMAX;
+        symbols.push_back( ch );
+        Huff_offsetTransmit( &huff->compressor, ch, buffer.data(), &bit );
+    }
+
+    int treeBit = 0, tableBit = 0;
+    for ( int expected : symbols )
+    {
+        int treeCh, tableCh;
+        Huff_offsetReceive( huff->decompressor.tree, &treeCh, buffer.data(), &treeBit );
+        Huff_tableReceive( table.get(), &tableCh, buffer.data(), &tableBit );
+        ASSERT_EQ( expected, treeCh );
+        ASSERT_EQ( expected, tableCh );
+        ASSERT_EQ( treeBit, tableBit );
+    }
+}
+
+// Garbage input must be decoded the same way as the tree walk does it
+TEST_F(HuffmanTableTest, DecodeRandomBits)
+{
+    std::mt19937 rng( 7 );
+    std::vector<byte> buffer( 1 << 14 );
+    for ( byte& b : buffer )
+    {
+        b = rng();
+    }
+
+    int treeBit = 0, tableBit = 0;
+    while ( ( tableBit >> 3 ) + 8 < int( buffer.size() ) )
+    {
+        int treeCh, tableCh;
+        Huff_offsetReceive( huff->decompressor.tree, &treeCh, buffer.data(), &treeBit );
+        Huff_tableReceive( table.get(), &tableCh, buffer.data(), &tableBit );
+        ASSERT_EQ( treeCh, tableCh );
+        ASSERT_EQ( treeBit, tableBit );
+    }
+}
+
+TEST(MsgBitsTest, RoundTrip)
+{
+    std::mt19937 rng( 1234 );
+    std::vector<byte> buffer( MAX_MSGLEN );
+    std::vector<std::pair<int, int>> written;
+    msg_t msg;
+
+    MSG_Init( &msg, buffer.data(), buffer.size() );
+    MSG_Bitstream( &msg );
+
+    while ( msg.cursize < MAX_MSGLEN - 64 )
+    {
+        int bits = 1 + rng() % 32;
+        if ( bits < 32 && rng() % 2 )
+        {
+            bits = -bits;
+        }
+        int value = rng();
+        MSG_WriteBits( &msg, value, bits );
+        written.emplace_back( value, bits );
+    }
+    ASSERT_FALSE( msg.overflowed );
+
+    MSG_BeginReading( &msg );
+    for ( const auto& w : written )
+    {
+        int bits = abs( w.second );
+        int expected = w.first;
+        if ( bits < 32 )
+        {
+            expected &= ( 1 << bits ) - 1;
+            if ( w.second < 0 && ( expected & ( 1 << ( bits - 1 ) ) ) )
+            {
+                expected |= -1 ^ ( ( 1 << bits ) - 1 );
+            }
+        }
+        ASSERT_EQ( expected, MSG_ReadBits( &msg, w.second ) );
+    }
+    EXPECT_EQ( msg.readcount, msg.cursize );
+}
+
+// Copying encoded bits at any bit position must give the same bits as encoding them there
+TEST(MsgBitsTest, WriteEncodedBits)
+{
+    std::mt19937 rng( 4321 );
+    std::vector<byte> encodedBuf( 1024 ), directBuf( 4096 ), splicedBuf( 4096 );
+    msg_t encoded, direct, spliced;
+
+    MSG_Init( &encoded, encodedBuf.data(), encodedBuf.size() );
+    MSG_Init( &direct, directBuf.data(), directBuf.size() );
+    MSG_Init( &spliced, splicedBuf.data(), splicedBuf.size() );
+
+    std::vector<std::pair<int, int>> values;
+    for ( int n = 0; n < 100; n++ )
+    {
+        values.emplace_back( rng(), 1 + rng() % 32 );
+        MSG_WriteBits( &encoded, values.back().first, values.back().second );
+    }
+
+    for ( int prefix = 1; prefix <= 16; prefix++ )
+    {
+        MSG_WriteBits( &direct, prefix, prefix );
+        MSG_WriteBits( &spliced, prefix, prefix );
+
+        for ( const auto& v : values )
+        {
+            MSG_WriteBits( &direct, v.first, v.second );
+        }
+        MSG_WriteEncodedBits( &spliced, encodedBuf.data(), encoded.bit, encoded.uncompsize );
+
+        ASSERT_EQ( direct.bit, spliced.bit );
+        ASSERT_EQ( direct.cursize, spliced.cursize );
+        ASSERT_EQ( direct.uncompsize, spliced.uncompsize );
+    }
+
+    ASSERT_FALSE( direct.overflowed );
+    directBuf.resize( direct.cursize );
+    splicedBuf.resize( spliced.cursize );
+    EXPECT_EQ( directBuf, splicedBuf );
+}
+
+// Run with --gtest_also_run_disabled_tests
+TEST_F(HuffmanTableTest, DISABLED_Benchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr int numSymbols = 1 << 22;
+
+    std::mt19937 rng( 99 );
+    std::vector<int> symbols( numSymbols );
+    for ( int& ch : symbols )
+    {
+        // skew towards the frequent symbols like real traffic
+        ch = 18 + rng() % ( HMAX - 18 );
+    }
+    std::vector<byte> buffer( numSymbols * 4 );
+
+    auto time = [&]( const char* name, auto&& fn ) {
+        auto start = Clock::now();
+        fn();
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        Log::Notice( "%s: %.2f ns/symbol", name, elapsed.count() / numSymbols );
+    };
+
+    int bit = 0;
+    time( "tree encode", [&] {
+        for ( int ch : symbols ) Huff_offsetTransmit( &huff->compressor, ch, buffer.data(), &bit );
+    } );
+    bit = 0;
+    time( "table encode", [&] {
+        for ( int ch : symbols ) Huff_tableTransmit( table.get(), ch, buffer.data(), &bit );
+    } );
+
+    int ch, sum = 0;
+    bit = 0;
+    time( "tree decode", [&] {
+        for ( int n = 0; n < numSymbols; n++ ) { Huff_offsetReceive( huff->decompressor.tree, &ch, buffer.data(), &bit ); sum += ch; }
+    } );
+    bit = 0;
+    time( "table decode", [&] {
+        for ( int n = 0; n < numSymbols; n++ ) { Huff_tableReceive( table.get(), &ch, buffer.data(), &bit ); sum -= ch; }
+    } );
+    EXPECT_EQ( sum, 0 );
+}
+
+} // namespace
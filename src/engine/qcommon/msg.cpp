@@ -37,8 +37,22 @@ Maryland 20850 USA.
 #include "qcommon.h"
 
 static huffman_t msgHuff;
+static huffTable_t msgHuffTable;
 static bool  msgInit = false;
 
+/*
+The field usage counts of the prioritise commands live in the shared field
+tables, the parallel snapshot encoding updates them atomically so that they
+are the same as with the serial encoding.
+*/
+static void MSG_CountFieldUsage( netField_t *field )
+{
+#if defined(_OPENMP)
+	#pragma omp atomic
+#endif
+	field->used++;
+}
+
 /*
 ==============================================================================
 
@@ -190,30 +204,72 @@ void MSG_WriteBits( msg_t *msg, int value, int bits )
 	}
 	else
 	{
-		{
-			int nbits;
+		// gather the raw bits and the codes, and write them out in one go
+		int nbits = bits & 7;
+		uint64_t acc = value & ( ( 1 << nbits ) - 1 );
+		int accBits = nbits;
 
-			nbits = bits & 7;
+		value = ( value >> nbits );
+		bits = bits - nbits;
 
-			for ( i = 0; i < nbits; i++ )
+		for ( i = 0; i < bits; i += 8 )
+		{
+			const huffCode_t &code = msgHuffTable.encode[ value & 0xff ];
+
+			if ( accBits + code.length > 64 )
 			{
-				Huff_putBit( ( value & 1 ), msg->data, &msg->bit );
-				value = ( value >> 1 );
+				Huff_putBits( acc, accBits, msg->data, &msg->bit );
+				acc = 0;
+				accBits = 0;
 			}
 
-			bits = bits - nbits;
-		}
-
-		for ( i = 0; i < bits; i += 8 )
-		{
-			Huff_offsetTransmit( &msgHuff.compressor, ( value & 0xff ), msg->data, &msg->bit );
+			acc |= uint64_t( code.bits ) << accBits;
+			accBits += code.length;
 			value = ( value >> 8 );
 		}
 
+		Huff_putBits( acc, accBits, msg->data, &msg->bit );
+
 		msg->cursize = ( msg->bit >> 3 ) + 1;
 	}
 }
 
+// copies bits that were written by MSG_WriteBits into another message,
+// which gives the same result as writing them again since the Huffman
+// codes don't depend on where they start
+void MSG_WriteEncodedBits( msg_t *msg, const byte *data, int bits, int uncompsize )
+{
+	msg->uncompsize += uncompsize;
+
+	if ( bits == 0 )
+	{
+		return;
+	}
+
+	if ( msg->maxsize - msg->cursize < 32 + ( bits >> 3 ) )
+	{
+		msg->overflowed = true;
+		return;
+	}
+
+	if ( msg->oob )
+	{
+		Sys::Drop( "MSG_WriteEncodedBits: not a bitstream" );
+	}
+
+	for ( ; bits >= 8; bits -= 8 )
+	{
+		Huff_putBits( *data++, 8, msg->data, &msg->bit );
+	}
+
+	if ( bits )
+	{
+		Huff_putBits( *data & ( ( 1 << bits ) - 1 ), bits, msg->data, &msg->bit );
+	}
+
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
 int MSG_ReadBits( msg_t *msg, int bits )
 {
 	int      value;
@@ -264,14 +320,33 @@ int MSG_ReadBits( msg_t *msg, int bits )
 	}
 	else
 	{
-		for ( i = 0; i < ( bits & 7 ); i++ )
+		// Huff_peekBits looks 3 bytes ahead, so near the end of the buffer
+		// fall back to reading one bit at a time
+		if ( ( msg->bit >> 3 ) + 3 <= msg->maxsize )
 		{
-			value |= ( Huff_getBit( msg->data, &msg->bit ) << i );
+			i = bits & 7;
+			value = Huff_peekBits( msg->data, msg->bit ) & ( ( 1 << i ) - 1 );
+			msg->bit += i;
+		}
+		else
+		{
+			for ( i = 0; i < ( bits & 7 ); i++ )
+			{
+				value |= ( Huff_getBit( msg->data, &msg->bit ) << i );
+			}
 		}
 
 		for ( ; i < bits; i += 8 )
 		{
-			Huff_offsetReceive( msgHuff.decompressor.tree, &get, msg->data, &msg->bit );
+			if ( ( msg->bit >> 3 ) + 3 <= msg->maxsize )
+			{
+				Huff_tableReceive( &msgHuffTable, &get, msg->data, &msg->bit );
+			}
+			else
+			{
+				Huff_offsetReceive( msgHuff.decompressor.tree, &get, msg->data, &msg->bit );
+			}
+
 			value |= get << i;
 		}
 
@@ -814,6 +889,66 @@ void MSG_PrioritiseEntitystateFields()
 static const int FLOAT_INT_BITS = 13;
 static const int FLOAT_INT_BIAS = ( 1 << ( FLOAT_INT_BITS - 1 ) );
 
+/*
+==================
+MSG_DeltaEntityFields
+
+Returns the number of fields to send, up to the last one that changed, and
+counts the changed fields in the usage statistics.
+==================
+*/
+static int MSG_DeltaEntityFields( const entityState_t *from, const entityState_t *to )
+{
+	int lc = 0;
+
+	// build the change vector as bytes so it is endian independent
+	for ( int i = 0; i < int( ARRAY_LEN( entityStateFields ) ); i++ )
+	{
+		netField_t *field = &entityStateFields[ i ];
+		auto fromF = reinterpret_cast<const int *>( reinterpret_cast<const byte *>( from ) + field->offset );
+		auto toF = reinterpret_cast<const int *>( reinterpret_cast<const byte *>( to ) + field->offset );
+
+		if ( *fromF != *toF )
+		{
+			lc = i + 1;
+
+			MSG_CountFieldUsage( field );
+		}
+	}
+
+	return lc;
+}
+
+/*
+==================
+MSG_CountDeltaEntityFields
+
+For a delta reused from another client, counts its fields as if it had been
+written again.
+==================
+*/
+void MSG_CountDeltaEntityFields( const entityState_t *from, const entityState_t *to )
+{
+	MSG_DeltaEntityFields( from, to );
+}
+
+/*
+==================
+MSG_EntityStateFieldUsage
+==================
+*/
+std::vector<int> MSG_EntityStateFieldUsage()
+{
+	std::vector<int> usage;
+
+	for ( const netField_t &field : entityStateFields )
+	{
+		usage.push_back( field.used );
+	}
+
+	return usage;
+}
+
 /*
 ==================
 MSG_WriteDeltaEntity
@@ -864,21 +999,7 @@ void MSG_WriteDeltaEntity( msg_t *msg, const entityState_t *from, const entitySt
 		Sys::Error( "MSG_WriteDeltaEntity: Bad entity number: %i", to->number );
 	}
 
-	lc = 0;
-
-	// build the change vector as bytes so it is endian independent
-	for ( i = 0, field = entityStateFields; i < numFields; i++, field++ )
-	{
-		fromF = ( int * )( ( byte * ) from + field->offset );
-		toF = ( int * )( ( byte * ) to + field->offset );
-
-		if ( *fromF != *toF )
-		{
-			lc = i + 1;
-
-			field->used++;
-		}
-	}
+	lc = MSG_DeltaEntityFields( from, to );
 
 	if ( lc == 0 )
 	{
@@ -1303,7 +1424,7 @@ void MSG_WriteDeltaPlayerstate(
 		{
 			lc = i + 1;
 
-			field->used++;
+			MSG_CountFieldUsage( field );
 		}
 	}
 
@@ -1794,6 +1915,8 @@ void MSG_initHuffman()
 			Huff_addRef( &msgHuff.decompressor, ( byte ) i );  /* Do update */
 		}
 	}
+
+	Huff_BuildTable( &msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor );
 }
 
 //===========================================================================
@@ -104,6 +104,10 @@ static bool winsockInitialized = false;
 #               include <sys/filio.h>
 #       endif
 
+#       ifdef __linux__
+#               include <sys/epoll.h>
+#       endif
+
 using SOCKET = int;
 constexpr SOCKET INVALID_SOCKET{-1};
 constexpr SOCKET SOCKET_ERROR{-1};
@@ -154,6 +158,44 @@ static struct ipv6_mreq    curgroup;
 // And the currently bound address.
 static struct sockaddr_in6 boundto;
 
+#ifdef __linux__
+/*
+On Linux the packets are received with recvmmsg and sent with sendmmsg, many at a time, and
+NET_Sleep waits on an epoll instance, so that a busy server makes fewer system calls.
+*/
+static Cvar::Cvar<bool> net_batchSyscalls( "net_batchSyscalls",
+	"receive and send the packets in batches and wait for them with epoll", Cvar::NONE, true );
+
+static const int MAX_PACKET_BATCH = 32;
+
+enum
+{
+	BATCH_IP,
+	BATCH_IP6,
+	BATCH_MULTICAST6,
+	NUM_BATCHES
+};
+
+struct packetBatch_t
+{
+	struct mmsghdr          msgs[ MAX_PACKET_BATCH ];
+	struct iovec            iovecs[ MAX_PACKET_BATCH ];
+	struct sockaddr_storage addrs[ MAX_PACKET_BATCH ];
+	netadr_t                to[ MAX_PACKET_BATCH ];
+	byte                    data[ MAX_PACKET_BATCH ][ MAX_MSGLEN ];
+	int                     count;
+	// next received packet to return
+	int                     next;
+};
+
+// Received packets waiting to be returned by Sys_GetPacket, one batch per socket
+static std::unique_ptr<packetBatch_t> recvBatches[ NUM_BATCHES ];
+// Packets waiting to be sent by Sys_FlushPackets
+static std::unique_ptr<packetBatch_t> sendBatches[ BATCH_IP6 + 1 ];
+
+static int epollFd = -1;
+#endif
+
 #ifndef IF_NAMESIZE
 #define IF_NAMESIZE 16
 #endif
@@ -570,6 +612,81 @@ bool        NET_IsLocalAddress( const netadr_t& adr )
 
 //=============================================================================
 
+#ifdef __linux__
+static packetBatch_t *NET_GetBatch( std::unique_ptr<packetBatch_t> &batch )
+{
+	if ( !batch )
+	{
+		batch.reset( new packetBatch_t );
+		batch->count = 0;
+		batch->next = 0;
+
+		for ( int i = 0; i < MAX_PACKET_BATCH; i++ )
+		{
+			struct msghdr &hdr = batch->msgs[ i ].msg_hdr;
+			memset( &hdr, 0, sizeof( hdr ) );
+			hdr.msg_name = &batch->addrs[ i ];
+			hdr.msg_iov = &batch->iovecs[ i ];
+			hdr.msg_iovlen = 1;
+			batch->iovecs[ i ].iov_base = batch->data[ i ];
+		}
+	}
+
+	return batch.get();
+}
+#endif
+
+/*
+==================
+NET_RecvFrom
+
+Like recvfrom, but drains the socket a batch at a time when possible
+==================
+*/
+static int NET_RecvFrom( SOCKET sock, int batchNum, msg_t *net_message, struct sockaddr_storage *from, socklen_t *fromlen )
+{
+#ifdef __linux__
+	packetBatch_t *batch = recvBatches[ batchNum ].get();
+
+	if ( ( batch && batch->next < batch->count ) || net_batchSyscalls.Get() )
+	{
+		if ( !batch || batch->next == batch->count )
+		{
+			batch = NET_GetBatch( recvBatches[ batchNum ] );
+
+			for ( int i = 0; i < MAX_PACKET_BATCH; i++ )
+			{
+				batch->msgs[ i ].msg_hdr.msg_namelen = sizeof( batch->addrs[ i ] );
+				batch->iovecs[ i ].iov_len = sizeof( batch->data[ i ] );
+			}
+
+			int ret = recvmmsg( sock, batch->msgs, MAX_PACKET_BATCH, MSG_DONTWAIT, nullptr );
+
+			if ( ret <= 0 )
+			{
+				batch->count = batch->next = 0;
+				return SOCKET_ERROR;
+			}
+
+			batch->count = ret;
+			batch->next = 0;
+		}
+
+		int i = batch->next++;
+		int length = std::min<int>( batch->msgs[ i ].msg_len, net_message->maxsize );
+		memcpy( net_message->data, batch->data[ i ], length );
+		*fromlen = std::min<socklen_t>( batch->msgs[ i ].msg_hdr.msg_namelen, *fromlen );
+		memcpy( from, &batch->addrs[ i ], *fromlen );
+
+		return length;
+	}
+#else
+	Q_UNUSED( batchNum );
+#endif
+
+	return recvfrom( sock, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) from, fromlen );
+}
+
 /*
 ==================
 Sys_GetPacket
@@ -588,7 +705,7 @@ bool Sys_GetPacket( netadr_t *net_from, msg_t *net_message )
 	if ( ip_socket != INVALID_SOCKET )
 	{
 		fromlen = sizeof( from );
-		ret = recvfrom( ip_socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
+		ret = NET_RecvFrom( ip_socket, BATCH_IP, net_message, &from, &fromlen );
 
 		if ( ret == SOCKET_ERROR )
 		{
@@ -638,7 +755,7 @@ bool Sys_GetPacket( netadr_t *net_from, msg_t *net_message )
 	if ( ip6_socket != INVALID_SOCKET )
 	{
 		fromlen = sizeof( from );
-		ret = recvfrom( ip6_socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
+		ret = NET_RecvFrom( ip6_socket, BATCH_IP6, net_message, &from, &fromlen );
 
 		if ( ret == SOCKET_ERROR )
 		{
@@ -668,7 +785,7 @@ bool Sys_GetPacket( netadr_t *net_from, msg_t *net_message )
 	if ( multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket )
 	{
 		fromlen = sizeof( from );
-		ret = recvfrom( multicast6_socket, ( char * ) net_message->data, net_message->maxsize, 0, ( struct sockaddr * ) &from, &fromlen );
+		ret = NET_RecvFrom( multicast6_socket, BATCH_MULTICAST6, net_message, &from, &fromlen );
 
 		if ( ret == SOCKET_ERROR )
 		{
@@ -702,9 +819,137 @@ bool Sys_GetPacket( netadr_t *net_from, msg_t *net_message )
 
 static char socksBuf[ 4096 ];
 
+/*
+==================
+NET_ReportSendError
+==================
+*/
+static void NET_ReportSendError( const netadr_t& to, sa_family_t family )
+{
+	int err = socketError;
+
+	// wouldblock is silent
+	if ( err == net::errc::resource_unavailable_try_again )
+	{
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if ( ( err == net::errc::address_not_available ) && ( ( to.type == netadrtype_t::NA_BROADCAST ) ) )
+	{
+		return;
+	}
+
+	if ( family == AF_INET )
+	{
+		Log::Notice( "Sys_SendPacket (ipv4): %s", NET_ErrorString() );
+	}
+	else if ( family == AF_INET6 )
+	{
+		Log::Notice( "Sys_SendPacket (ipv6): %s", NET_ErrorString() );
+	}
+	else
+	{
+		Log::Notice( "Sys_SendPacket (%i): %s", family , NET_ErrorString() );
+	}
+}
+
+#ifdef __linux__
+/*
+==================
+NET_FlushSendBatch
+==================
+*/
+static void NET_FlushSendBatch( SOCKET sock, packetBatch_t *batch )
+{
+	int sent = 0;
+
+	while ( sent < batch->count )
+	{
+		int ret = sendmmsg( sock, batch->msgs + sent, batch->count - sent, 0 );
+
+		// skip the packet which failed
+		if ( ret <= 0 )
+		{
+			NET_ReportSendError( batch->to[ sent ], batch->addrs[ sent ].ss_family );
+			sent++;
+			continue;
+		}
+
+		sent += ret;
+	}
+
+	batch->count = 0;
+}
+
+/*
+==================
+NET_QueuePacket
+
+Returns false if the packet must be sent right away
+==================
+*/
+static bool NET_QueuePacket( SOCKET sock, int batchNum, int length, const void *data, const netadr_t& to, const struct sockaddr_storage& addr )
+{
+	packetBatch_t *batch = sendBatches[ batchNum ].get();
+
+	if ( ( !batch || batch->count == 0 ) && !net_batchSyscalls.Get() )
+	{
+		return false;
+	}
+
+	batch = NET_GetBatch( sendBatches[ batchNum ] );
+
+	// keep the packets in order
+	if ( length > MAX_MSGLEN )
+	{
+		NET_FlushSendBatch( sock, batch );
+		return false;
+	}
+
+	if ( batch->count == MAX_PACKET_BATCH )
+	{
+		NET_FlushSendBatch( sock, batch );
+	}
+
+	int i = batch->count++;
+	memcpy( batch->data[ i ], data, length );
+	batch->iovecs[ i ].iov_len = length;
+	batch->addrs[ i ] = addr;
+	batch->msgs[ i ].msg_hdr.msg_namelen = addr.ss_family == AF_INET ? sizeof( struct sockaddr_in ) : sizeof( struct sockaddr_in6 );
+	batch->to[ i ] = to;
+
+	return true;
+}
+#endif
+
+/*
+==================
+Sys_FlushPackets
+
+Sends the packets queued by Sys_SendPacket
+==================
+*/
+void Sys_FlushPackets()
+{
+#ifdef __linux__
+	if ( sendBatches[ BATCH_IP ] && ip_socket != INVALID_SOCKET )
+	{
+		NET_FlushSendBatch( ip_socket, sendBatches[ BATCH_IP ].get() );
+	}
+
+	if ( sendBatches[ BATCH_IP6 ] && ip6_socket != INVALID_SOCKET )
+	{
+		NET_FlushSendBatch( ip6_socket, sendBatches[ BATCH_IP6 ].get() );
+	}
+#endif
+}
+
 /*
 ==================
 Sys_SendPacket
+
+On Linux the packet is only queued, see Sys_FlushPackets
 ==================
 */
 void Sys_SendPacket( int length, const void *data, const netadr_t& to )
@@ -748,42 +993,31 @@ void Sys_SendPacket( int length, const void *data, const netadr_t& to )
 	{
 		if ( addr.ss_family == AF_INET )
 		{
+#ifdef __linux__
+			if ( NET_QueuePacket( ip_socket, BATCH_IP, length, data, to, addr ) )
+			{
+				return;
+			}
+#endif
+
 			ret = sendto( ip_socket, ( const char* )data, length, 0, ( struct sockaddr * ) &addr, sizeof( struct sockaddr_in ) );
 		}
 		else if ( addr.ss_family == AF_INET6 )
 		{
+#ifdef __linux__
+			if ( NET_QueuePacket( ip6_socket, BATCH_IP6, length, data, to, addr ) )
+			{
+				return;
+			}
+#endif
+
 			ret = sendto( ip6_socket, ( const char* )data, length, 0, ( struct sockaddr * ) &addr, sizeof( struct sockaddr_in6 ) );
 		}
 	}
 
 	if ( ret == SOCKET_ERROR )
 	{
-		int err = socketError;
-
-		// wouldblock is silent
-		if ( err == net::errc::resource_unavailable_try_again )
-		{
-			return;
-		}
-
-		// some PPP links do not allow broadcasts and return an error
-		if ( ( err == net::errc::address_not_available ) && ( ( to.type == netadrtype_t::NA_BROADCAST ) ) )
-		{
-			return;
-		}
-
-		if ( addr.ss_family == AF_INET )
-		{
-			Log::Notice( "Sys_SendPacket (ipv4): %s", NET_ErrorString() );
-		}
-		else if ( addr.ss_family == AF_INET6 )
-		{
-			Log::Notice( "Sys_SendPacket (ipv6): %s", NET_ErrorString() );
-		}
-		else
-		{
-			Log::Notice( "Sys_SendPacket (%i): %s", addr.ss_family , NET_ErrorString() );
-		}
+		NET_ReportSendError( to, addr.ss_family );
 	}
 }
 
@@ -1594,6 +1828,47 @@ static int NET_EnsureValidPortNo( int port )
 	return ( port < 1024 ) ? 1024 : port; // the usual 1024 reserved ports
 }
 
+#ifdef __linux__
+/*
+====================
+NET_OpenEpoll
+
+Creates the epoll instance NET_Sleep waits on, NET_Sleep uses select if it fails
+====================
+*/
+static void NET_OpenEpoll()
+{
+	epollFd = epoll_create1( EPOLL_CLOEXEC );
+
+	if ( epollFd == -1 )
+	{
+		Log::Warn( "epoll_create1: %s", NET_ErrorString() );
+		return;
+	}
+
+	for ( SOCKET sock : { ip_socket, ip6_socket } )
+	{
+		if ( sock == INVALID_SOCKET )
+		{
+			continue;
+		}
+
+		struct epoll_event event;
+		memset( &event, 0, sizeof( event ) );
+		event.events = EPOLLIN;
+		event.data.fd = sock;
+
+		if ( epoll_ctl( epollFd, EPOLL_CTL_ADD, sock, &event ) == -1 )
+		{
+			Log::Warn( "epoll_ctl: %s", NET_ErrorString() );
+			close( epollFd );
+			epollFd = -1;
+			return;
+		}
+	}
+}
+#endif
+
 /*
 ====================
 NET_OpenIP
@@ -1679,6 +1954,10 @@ static void NET_OpenIP( bool serverMode )
 		NET_OpenSocks( port );
 	}
 
+#ifdef __linux__
+	NET_OpenEpoll();
+#endif
+
 	Cvar_Set( "net_currentPort", va( "%i", port ) );
 	Cvar_Set( "net_currentPort6", va( "%i", port6 ) );
 }
@@ -1751,6 +2030,26 @@ void NET_DisableNetworking()
 
 	networkingEnabled = false;
 
+	Sys_FlushPackets();
+
+#ifdef __linux__
+	for ( std::unique_ptr<packetBatch_t> &batch : recvBatches )
+	{
+		batch = nullptr;
+	}
+
+	for ( std::unique_ptr<packetBatch_t> &batch : sendBatches )
+	{
+		batch = nullptr;
+	}
+
+	if ( epollFd != -1 )
+	{
+		close( epollFd );
+		epollFd = -1;
+	}
+#endif
+
 	if ( ip_socket != INVALID_SOCKET )
 	{
 		closesocket( ip_socket );
@@ -1849,6 +2148,18 @@ void NET_Sleep( int msec )
 		return;
 	}
 
+	// send the replies before waiting for more packets
+	Sys_FlushPackets();
+
+#ifdef __linux__
+	if ( epollFd != -1 && net_batchSyscalls.Get() )
+	{
+		struct epoll_event events[ 2 ];
+		epoll_wait( epollFd, events, ARRAY_LEN( events ), msec );
+		return;
+	}
+#endif
+
 	FD_ZERO( &fdset );
 
 	if ( ip_socket != INVALID_SOCKET )
@@ -0,0 +1,206 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "qcommon/qcommon.h"
+#include "qcommon/sys.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// A socket on the loopback exchanging packets with the engine's IPv4 socket
+class NetIPTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        enginePort = atoi(Cvar::GetValue("net_currentPort").c_str());
+        if (enginePort <= 0) {
+            GTEST_SKIP() << "The engine has no IPv4 socket";
+        }
+
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_NE(-1, sock);
+
+        int bufferSize = 4 * 1024 * 1024;
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(0, bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        socklen_t addrLen = sizeof(addr);
+        ASSERT_EQ(0, getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &addrLen));
+        port = ntohs(addr.sin_port);
+
+        ASSERT_TRUE(NET_StringToAdr(va("127.0.0.1:%d", port), &adr, netadrtype_t::NA_IP));
+
+        oldBatchSyscalls = Cvar::GetValue("net_batchSyscalls");
+    }
+
+    void TearDown() override
+    {
+        if (sock != -1) {
+            close(sock);
+            Cvar::SetValue("net_batchSyscalls", oldBatchSyscalls);
+        }
+    }
+
+    void SendToEngine(const std::string& packet)
+    {
+        sockaddr_in to{};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        to.sin_port = htons(enginePort);
+        ASSERT_EQ(ssize_t(packet.size()),
+            sendto(sock, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&to), sizeof(to)));
+    }
+
+    // Returns false on timeout
+    bool ReceiveFromEngine(std::string& packet)
+    {
+        pollfd fd{sock, POLLIN, 0};
+        if (poll(&fd, 1, 1000) != 1) {
+            return false;
+        }
+        char buffer[2048];
+        ssize_t size = recv(sock, buffer, sizeof(buffer), 0);
+        packet.assign(buffer, std::max<ssize_t>(size, 0));
+        return size >= 0;
+    }
+
+    // Returns false on timeout, skips the packets coming from other hosts
+    bool GetPacket(std::string& packet)
+    {
+        static byte data[MAX_MSGLEN];
+        for (int tries = 0; tries < 100; tries++) {
+            msg_t msg;
+            netadr_t from;
+            MSG_Init(&msg, data, sizeof(data));
+            if (!Sys_GetPacket(&from, &msg)) {
+                NET_Sleep(10);
+                continue;
+            }
+            if (NET_CompareAdr(from, adr)) {
+                packet.assign(reinterpret_cast<char*>(msg.data + msg.readcount), msg.cursize - msg.readcount);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int enginePort = 0;
+    int port = 0;
+    int sock = -1;
+    netadr_t adr;
+    std::string oldBatchSyscalls;
+};
+
+TEST_F(NetIPTest, Receive)
+{
+    for (const char* batch : {"0", "1"}) {
+        Cvar::SetValue("net_batchSyscalls", batch);
+        for (int i = 0; i < 100; i++) {
+            SendToEngine(Str::Format("packet %d", i));
+        }
+        for (int i = 0; i < 100; i++) {
+            std::string packet;
+            ASSERT_TRUE(GetPacket(packet)) << "batch " << batch << ", packet " << i;
+            EXPECT_EQ(Str::Format("packet %d", i), packet);
+        }
+    }
+}
+
+TEST_F(NetIPTest, Send)
+{
+    for (const char* batch : {"0", "1"}) {
+        Cvar::SetValue("net_batchSyscalls", batch);
+        for (int i = 0; i < 100; i++) {
+            std::string packet = Str::Format("packet %d", i);
+            Sys_SendPacket(packet.size(), packet.data(), adr);
+        }
+        Sys_FlushPackets();
+        for (int i = 0; i < 100; i++) {
+            std::string packet;
+            ASSERT_TRUE(ReceiveFromEngine(packet)) << "batch " << batch << ", packet " << i;
+            EXPECT_EQ(Str::Format("packet %d", i), packet);
+        }
+    }
+}
+
+// Load generator: floods the engine with small packets and sends back as many
+TEST_F(NetIPTest, DISABLED_Benchmark)
+{
+    constexpr int ROUNDS = 400;
+    constexpr int PACKETS_PER_ROUND = 250;
+
+    for (const char* batch : {"0", "1"}) {
+        Cvar::SetValue("net_batchSyscalls", batch);
+        std::string packet(64, 'x');
+
+        auto start = Sys::SteadyClock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            for (int i = 0; i < PACKETS_PER_ROUND; i++) {
+                SendToEngine(packet);
+            }
+            for (int i = 0; i < PACKETS_PER_ROUND; i++) {
+                ASSERT_TRUE(GetPacket(packet));
+            }
+        }
+        double receiveTime = std::chrono::duration<double>(Sys::SteadyClock::now() - start).count();
+
+        start = Sys::SteadyClock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            for (int i = 0; i < PACKETS_PER_ROUND; i++) {
+                Sys_SendPacket(packet.size(), packet.data(), adr);
+            }
+            Sys_FlushPackets();
+            for (int i = 0; i < PACKETS_PER_ROUND; i++) {
+                ASSERT_TRUE(ReceiveFromEngine(packet));
+            }
+        }
+        double sendTime = std::chrono::duration<double>(Sys::SteadyClock::now() - start).count();
+
+        Log::Notice("net_batchSyscalls %s: received %.0f packets/s, sent %.0f packets/s", batch,
+            ROUNDS * PACKETS_PER_ROUND / receiveTime, ROUNDS * PACKETS_PER_ROUND / sendTime);
+    }
+}
+
+} // namespace
+#endif // _WIN32
@@ -65,6 +65,7 @@ struct usercmd_t;
 struct entityState_t;
 
 void  MSG_WriteBits( msg_t *msg, int value, int bits );
+void  MSG_WriteEncodedBits( msg_t *msg, const byte *data, int bits, int uncompsize );
 
 void  MSG_WriteByte( msg_t *sb, int c );
 void  MSG_WriteShort( msg_t *sb, int c );
@@ -92,6 +93,8 @@ void  MSG_WriteDeltaUsercmd( msg_t *msg, usercmd_t *from, usercmd_t *to );
 void  MSG_ReadDeltaUsercmd( msg_t *msg, usercmd_t *from, usercmd_t *to );
 
 void  MSG_WriteDeltaEntity( msg_t *msg, const entityState_t *from, const entityState_t *to, bool force );
+void  MSG_CountDeltaEntityFields( const entityState_t *from, const entityState_t *to );
+std::vector<int> MSG_EntityStateFieldUsage();
 void  MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *to, int number );
 
 void MSG_InitNetcodeTables(NetcodeTable playerStateTable, int playerStateSize);
@@ -744,6 +747,31 @@ struct huffman_t
     huff_t decompressor;
 };
 
+/* Lookup tables for a static (no longer adapting) tree, so that symbols can be
+ * coded without walking the tree one bit at a time. The codes are exactly the
+ * ones the tree produces, so the output is bit-for-bit identical. */
+
+#define HUFF_LOOKUP_BITS 11
+
+struct huffCode_t
+{
+    uint32_t bits; /* first transmitted bit in the lowest position */
+    int      length; /* 0 if the symbol is not in the tree */
+};
+
+struct huffDecode_t
+{
+    int symbol;
+    int length; /* 0 if the code is longer than HUFF_LOOKUP_BITS */
+};
+
+struct huffTable_t
+{
+    node_t       *tree; /* to walk codes longer than HUFF_LOOKUP_BITS */
+    huffCode_t   encode[ HMAX ];
+    huffDecode_t decode[ 1 << HUFF_LOOKUP_BITS ];
+};
+
 void             Huff_Compress( msg_t *buf, int offset );
 void             Huff_Decompress( msg_t *buf, int offset );
 void             Huff_Init( huffman_t *huff );
@@ -754,6 +782,11 @@ void             Huff_offsetReceive( node_t *node, int *ch, byte *fin, int *offs
 void             Huff_offsetTransmit( huff_t *huff, int ch, byte *fout, int *offset );
 void             Huff_putBit( int bit, byte *fout, int *offset );
 int              Huff_getBit( byte *fout, int *offset );
+void             Huff_putBits( uint64_t bits, int count, byte *fout, int *offset );
+uint32_t         Huff_peekBits( const byte *fin, int offset );
+void             Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor );
+void             Huff_tableTransmit( const huffTable_t *table, int ch, byte *fout, int *offset );
+void             Huff_tableReceive( const huffTable_t *table, int *ch, byte *fin, int *offset );
 
 void Trans_LoadDefaultLanguage();
 #endif // QCOMMON_H_
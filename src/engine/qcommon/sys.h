@@ -44,6 +44,7 @@ Maryland 20850 USA.
 #define NETWORK_LAN_RATE 99999
 
 void Sys_SendPacket(int length, const void *data, const netadr_t& to);
+void Sys_FlushPackets();
 bool Sys_GetPacket(netadr_t *net_from, msg_t *net_message);
 
 bool Sys_StringToAdr(const char *s, netadr_t *a, netadrtype_t family);
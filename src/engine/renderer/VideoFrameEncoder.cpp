@@ -0,0 +1,174 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+// VideoFrameEncoder.cpp
+
+#include "VideoFrameEncoder.h"
+#include "tr_local.h"
+
+VideoFrameEncoder::VideoFrameEncoder( int numThreads, size_t maxQueuedFrames, int quality, WriteFunc write ) :
+	maxQueuedFrames( std::max<size_t>( maxQueuedFrames, 1 ) ), quality( quality ), write( std::move( write ) ) {
+	for ( int i = 0; i < numThreads; i++ ) {
+		threads.emplace_back( &VideoFrameEncoder::EncodeThread, this );
+	}
+}
+
+VideoFrameEncoder::~VideoFrameEncoder() {
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		quit = true;
+	}
+
+	frameQueued.notify_all();
+
+	for ( std::thread &thread : threads ) {
+		thread.join();
+	}
+}
+
+void VideoFrameEncoder::Encode( Frame &frame ) const {
+	frame.jpeg.resize( frame.pixels.size() );
+	frame.size = SaveJPGToBuffer( frame.jpeg.data(), frame.jpeg.size(), quality,
+		frame.width, frame.height, frame.pixels.data() );
+}
+
+void VideoFrameEncoder::EncodeThread() {
+	std::unique_lock<std::mutex> lock( mutex );
+
+	while ( true ) {
+		frameQueued.wait( lock, [&] { return quit || numTaken < frames.size(); } );
+
+		if ( quit ) {
+			return;
+		}
+
+		Frame &frame = *frames[ numTaken++ ];
+		lock.unlock();
+
+		Encode( frame );
+
+		lock.lock();
+		frame.encoded = true;
+		frameEncoded.notify_all();
+	}
+}
+
+void VideoFrameEncoder::Submit( const byte *pixels, int width, int height, int stride ) {
+	// make room by writing the oldest frames
+	while ( true ) {
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+
+			if ( frames.size() < maxQueuedFrames ) {
+				break;
+			}
+		}
+
+		WriteFrame( true );
+	}
+
+	std::unique_ptr<Frame> frame;
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		if ( !freeFrames.empty() ) {
+			frame = std::move( freeFrames.back() );
+			freeFrames.pop_back();
+		}
+	}
+
+	if ( !frame ) {
+		frame.reset( new Frame() );
+	}
+
+	// drop the padding of the lines
+	int lineLen = width * 3;
+	frame->pixels.resize( lineLen * height );
+
+	for ( int i = 0; i < height; i++ ) {
+		memcpy( frame->pixels.data() + i * lineLen, pixels + i * stride, lineLen );
+	}
+
+	frame->width = width;
+	frame->height = height;
+	frame->encoded = false;
+
+	if ( threads.empty() ) {
+		Encode( *frame );
+		write( frame->jpeg.data(), frame->size );
+
+		std::lock_guard<std::mutex> lock( mutex );
+		freeFrames.push_back( std::move( frame ) );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		frames.push_back( std::move( frame ) );
+	}
+
+	frameQueued.notify_one();
+}
+
+bool VideoFrameEncoder::WriteFrame( bool wait ) {
+	std::unique_ptr<Frame> frame;
+
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+
+		if ( frames.empty() ) {
+			return false;
+		}
+
+		if ( !frames.front()->encoded ) {
+			if ( !wait ) {
+				return false;
+			}
+
+			frameEncoded.wait( lock, [&] { return frames.front()->encoded; } );
+		}
+
+		frame = std::move( frames.front() );
+		frames.pop_front();
+		numTaken--;
+	}
+
+	write( frame->jpeg.data(), frame->size );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	freeFrames.push_back( std::move( frame ) );
+
+	return true;
+}
+
+void VideoFrameEncoder::WriteFrames( bool wait ) {
+	while ( WriteFrame( wait ) ) {
+	}
+}
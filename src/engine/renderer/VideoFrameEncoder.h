@@ -0,0 +1,98 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+// VideoFrameEncoder.h
+
+#ifndef VIDEO_FRAME_ENCODER_H
+#define VIDEO_FRAME_ENCODER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/Common.h"
+
+/* Encodes the frames of a video capture to JPEG on worker threads. The
+frames are written in the order they were submitted, by the thread which
+submits them, so the writer doesn't have to be thread-safe. At most
+maxQueuedFrames frames are pending, submitting a frame waits for the
+oldest one to be encoded when the queue is full. Without threads the
+frames are encoded when they are submitted. */
+class VideoFrameEncoder {
+	public:
+	using WriteFunc = std::function<void( const byte *data, int size )>;
+
+	VideoFrameEncoder( int numThreads, size_t maxQueuedFrames, int quality, WriteFunc write );
+	~VideoFrameEncoder();
+
+	// Copies the RGB pixels of a frame, stride bytes apart from a line to
+	// the next, starting from the bottom line
+	void Submit( const byte *pixels, int width, int height, int stride );
+
+	// Writes the frames encoded so far, or all the pending frames
+	void WriteFrames( bool wait );
+
+	int NumThreads() const {
+		return threads.size();
+	}
+
+	private:
+	struct Frame {
+		std::vector<byte> pixels;
+		std::vector<byte> jpeg;
+		int width;
+		int height;
+		int size;
+		bool encoded;
+	};
+
+	void Encode( Frame &frame ) const;
+	bool WriteFrame( bool wait );
+	void EncodeThread();
+
+	const size_t maxQueuedFrames;
+	const int quality;
+	WriteFunc write;
+
+	std::mutex mutex;
+	std::condition_variable frameQueued;
+	std::condition_variable frameEncoded;
+	// pending frames in submission order, the first numTaken are taken by the threads
+	std::deque<std::unique_ptr<Frame>> frames;
+	size_t numTaken = 0;
+	std::vector<std::unique_ptr<Frame>> freeFrames;
+	bool quit = false;
+	std::vector<std::thread> threads;
+};
+
+#endif // VIDEO_FRAME_ENCODER_H
@@ -0,0 +1,130 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+
+#include "engine/renderer/tr_local.h"
+#include "engine/renderer/VideoFrameEncoder.h"
+
+namespace {
+
+constexpr int WIDTH = 320;
+constexpr int HEIGHT = 240;
+// lines padded like glReadPixels does with GL_PACK_ALIGNMENT 8
+constexpr int STRIDE = ( WIDTH * 3 + 7 ) & ~7;
+
+std::vector<byte> SyntheticFrame(int frame)
+{
+    std::vector<byte> pixels(STRIDE * HEIGHT, 0xAA);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            byte* pixel = pixels.data() + y * STRIDE + x * 3;
+            pixel[0] = x + frame;
+            pixel[1] = y * 2 - frame;
+            pixel[2] = (x ^ y) + frame * 7;
+        }
+    }
+    return pixels;
+}
+
+std::vector<byte> EncodeSerially(const std::vector<byte>& pixels)
+{
+    std::vector<byte> packed(WIDTH * HEIGHT * 3);
+    for (int y = 0; y < HEIGHT; y++) {
+        memcpy(packed.data() + y * WIDTH * 3, pixels.data() + y * STRIDE, WIDTH * 3);
+    }
+    std::vector<byte> jpeg(packed.size());
+    int size = SaveJPGToBuffer(jpeg.data(), jpeg.size(), 90, WIDTH, HEIGHT, packed.data());
+    jpeg.resize(size);
+    return jpeg;
+}
+
+TEST(VideoFrameEncoderTest, SameAsSerial)
+{
+    constexpr int FRAMES = 12;
+
+    std::vector<std::vector<byte>> frames;
+    for (int i = 0; i < FRAMES; i++) {
+        frames.push_back(SyntheticFrame(i));
+    }
+
+    for (int numThreads : {0, 1, 4}) {
+        std::vector<std::vector<byte>> written;
+        {
+            VideoFrameEncoder encoder(numThreads, 3, 90, [&](const byte* data, int size) {
+                written.emplace_back(data, data + size);
+            });
+            for (int i = 0; i < FRAMES; i++) {
+                encoder.Submit(frames[i].data(), WIDTH, HEIGHT, STRIDE);
+                encoder.WriteFrames(false);
+                // no more than 3 frames pending
+                EXPECT_LE(i + 1 - int(written.size()), 3);
+            }
+            encoder.WriteFrames(true);
+        }
+
+        ASSERT_EQ(FRAMES, int(written.size())) << numThreads << " threads";
+        for (int i = 0; i < FRAMES; i++) {
+            EXPECT_EQ(EncodeSerially(frames[i]), written[i]) << "frame " << i << ", " << numThreads << " threads";
+        }
+    }
+}
+
+TEST(VideoFrameEncoderTest, DISABLED_Benchmark)
+{
+    constexpr int FRAMES = 200;
+    int numThreads = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+
+    std::vector<byte> pixels = SyntheticFrame(0);
+
+    for (int threads : {0, numThreads}) {
+        int written = 0;
+        auto start = Sys::SteadyClock::now();
+        {
+            VideoFrameEncoder encoder(threads, 2 * threads, 90, [&](const byte*, int) { written++; });
+            for (int i = 0; i < FRAMES; i++) {
+                encoder.Submit(pixels.data(), WIDTH, HEIGHT, STRIDE);
+                encoder.WriteFrames(false);
+            }
+            encoder.WriteFrames(true);
+        }
+        auto duration = Sys::SteadyClock::now() - start;
+
+        EXPECT_EQ(FRAMES, written);
+        Log::Notice("encoded %d frames with %d threads: %.1f frames per second", FRAMES, threads,
+            FRAMES / std::chrono::duration<double>(duration).count());
+    }
+}
+
+} // namespace
@@ -62,6 +62,8 @@ set(RENDERERLIST
     ${ENGINE_DIR}/renderer/tr_vbo.cpp
     ${ENGINE_DIR}/renderer/VBO.h
     ${ENGINE_DIR}/renderer/VertexSpecification.h
+    ${ENGINE_DIR}/renderer/VideoFrameEncoder.cpp
+    ${ENGINE_DIR}/renderer/VideoFrameEncoder.h
     ${ENGINE_DIR}/renderer/tr_video.cpp
     ${ENGINE_DIR}/renderer/tr_world.cpp
     ${ENGINE_DIR}/sys/sdl_glimp.cpp
@@ -70,4 +72,10 @@ set(RENDERERLIST
 
 set(RENDERERTESTLIST
     ${ENGINE_DIR}/renderer/gl_shader_test.cpp
+    ${ENGINE_DIR}/renderer/tr_animation_test.cpp
+    ${ENGINE_DIR}/renderer/tr_bsp_test.cpp
+    ${ENGINE_DIR}/renderer/tr_image_decode_test.cpp
+    ${ENGINE_DIR}/renderer/tr_shade_calc_test.cpp
+    ${ENGINE_DIR}/renderer/tr_shader_test.cpp
+    ${ENGINE_DIR}/renderer/VideoFrameEncoderTest.cpp
 )
@@ -69,7 +69,208 @@ void R_InitAnimations()
 	strcpy( anim->name, "<default animation>" );
 }
 
-static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const char *name )
+/*
+===============
+MD5 animation cache
+
+The .md5anim files are parsed into a binary representation that is cached
+in the homepath, so that they don't have to be tokenized again on the next
+loads. It is laid out as: md5AnimCacheHeader_t, the key of the source file
+padded to 4 bytes, the channels, the bounds of the frames and the animated
+components of the frames, frame after frame.
+===============
+*/
+static Cvar::Cvar<bool> r_md5AnimCache( "r_md5AnimCache", "cache the parsed md5 animations in the homepath", Cvar::NONE, true );
+
+static const char MD5ANIM_CACHE_IDENT[ 4 ] = { 'M', 'D', '5', 'B' };
+static const uint32_t MD5ANIM_CACHE_VERSION = 1;
+
+struct md5AnimCacheHeader_t
+{
+	char     ident[ 4 ];
+	uint32_t version;
+	uint32_t keySize;
+	uint32_t numFrames;
+	uint32_t numChannels;
+	int32_t  frameRate;
+	uint32_t numAnimatedComponents;
+};
+
+struct md5AnimCacheChannel_t
+{
+	char     name[ MAX_QPATH ];
+	int32_t  parentIndex;
+	uint32_t componentsBits;
+	uint32_t componentsOffset;
+	vec3_t   baseOrigin;
+	quat_t   baseQuat;
+};
+
+// Number of animated components of a channel, taken from the frames
+static uint32_t R_MD5ChannelComponents( uint32_t componentsBits )
+{
+	uint32_t count = 0;
+
+	for ( uint32_t bit = COMPONENT_BIT_TX; bit <= COMPONENT_BIT_QZ; bit <<= 1 )
+	{
+		if ( componentsBits & bit )
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static std::string R_MD5AnimCachePath( const char *name )
+{
+	return Str::Format( "animcache/%s.bin", name );
+}
+
+static std::string R_ReadMD5AnimCache( const char *name )
+{
+	std::error_code err;
+	FS::File cacheFile = FS::HomePath::OpenRead( R_MD5AnimCachePath( name ), err );
+
+	if ( err )
+	{
+		return "";
+	}
+
+	std::string binary = cacheFile.ReadAll( err );
+	return err ? "" : binary;
+}
+
+static void R_WriteMD5AnimCache( const char *name, const std::string &binary )
+{
+	std::string cachePath = R_MD5AnimCachePath( name );
+	std::error_code err;
+	FS::File cacheFile = FS::HomePath::OpenWrite( cachePath, err );
+
+	if ( !err )
+	{
+		cacheFile.Write( binary.data(), binary.size(), err );
+		cacheFile.Close( err );
+	}
+
+	if ( err )
+	{
+		Log::Warn( "Failed to write the animation cache %s: %s", cachePath, err.message() );
+	}
+}
+
+/*
+===============
+R_LoadMD5AnimBinary
+
+Loads the binary representation of a .md5anim file, returns false if it
+is invalid or if it was made from another version of the file.
+===============
+*/
+static bool R_LoadMD5AnimBinary( skelAnimation_t *skelAnim, const std::string &binary, const std::string &key )
+{
+	md5AnimCacheHeader_t header;
+
+	if ( binary.size() < sizeof( header ) )
+	{
+		return false;
+	}
+
+	memcpy( &header, binary.data(), sizeof( header ) );
+
+	if ( memcmp( header.ident, MD5ANIM_CACHE_IDENT, sizeof( header.ident ) ) || header.version != MD5ANIM_CACHE_VERSION )
+	{
+		return false;
+	}
+
+	if ( !header.numFrames || header.numFrames > UINT16_MAX || header.numChannels > UINT8_MAX )
+	{
+		return false;
+	}
+
+	size_t channelsOffset = PAD( sizeof( header ) + uint64_t( header.keySize ), sizeof( float ) );
+	size_t boundsOffset = channelsOffset + header.numChannels * sizeof( md5AnimCacheChannel_t );
+	size_t componentsOffset = boundsOffset + header.numFrames * 6 * sizeof( float );
+	size_t numComponents = size_t( header.numFrames ) * header.numAnimatedComponents;
+
+	if ( header.numAnimatedComponents > binary.size() / sizeof( float )
+		|| binary.size() != componentsOffset + numComponents * sizeof( float ) )
+	{
+		return false;
+	}
+
+	if ( binary.compare( sizeof( header ), header.keySize, key ) )
+	{
+		return false;
+	}
+
+	const char *data = binary.data();
+
+	// The skeletons are built from the channels without further checks
+	for ( uint32_t i = 0; i < header.numChannels; i++ )
+	{
+		md5AnimCacheChannel_t cacheChannel;
+		memcpy( &cacheChannel, data + channelsOffset + i * sizeof( cacheChannel ), sizeof( cacheChannel ) );
+
+		if ( cacheChannel.parentIndex < INT8_MIN || cacheChannel.parentIndex >= int32_t( header.numChannels )
+			|| cacheChannel.componentsBits > UINT8_MAX || cacheChannel.componentsOffset > UINT16_MAX
+			|| cacheChannel.componentsOffset + R_MD5ChannelComponents( cacheChannel.componentsBits ) > header.numAnimatedComponents )
+		{
+			return false;
+		}
+	}
+
+	md5Animation_t *anim = (md5Animation_t*) ri.Hunk_Alloc( sizeof( *anim ), ha_pref::h_low );
+
+	anim->numFrames = header.numFrames;
+	anim->numChannels = header.numChannels;
+	anim->frameRate = header.frameRate;
+	anim->numAnimatedComponents = header.numAnimatedComponents;
+
+	anim->channels = (md5Channel_t*) ri.Hunk_Alloc( sizeof( md5Channel_t ) * anim->numChannels, ha_pref::h_low );
+
+	for ( int i = 0; i < anim->numChannels; i++ )
+	{
+		md5AnimCacheChannel_t cacheChannel;
+		memcpy( &cacheChannel, data + channelsOffset + i * sizeof( cacheChannel ), sizeof( cacheChannel ) );
+
+		md5Channel_t *channel = &anim->channels[ i ];
+		Q_strncpyz( channel->name, cacheChannel.name, sizeof( channel->name ) );
+		channel->parentIndex = cacheChannel.parentIndex;
+		channel->componentsBits = cacheChannel.componentsBits;
+		channel->componentsOffset = cacheChannel.componentsOffset;
+		VectorCopy( cacheChannel.baseOrigin, channel->baseOrigin );
+		QuatCopy( cacheChannel.baseQuat, channel->baseQuat );
+	}
+
+	// the components of all the frames are copied at once
+	anim->frames = (md5Frame_t*) ri.Hunk_Alloc( sizeof( md5Frame_t ) * anim->numFrames, ha_pref::h_low );
+	float *components = (float*) ri.Hunk_Alloc( sizeof( float ) * numComponents, ha_pref::h_low );
+	memcpy( components, data + componentsOffset, sizeof( float ) * numComponents );
+
+	for ( int i = 0; i < anim->numFrames; i++ )
+	{
+		md5Frame_t *frame = &anim->frames[ i ];
+		memcpy( frame->bounds, data + boundsOffset + i * 6 * sizeof( float ), 6 * sizeof( float ) );
+		frame->components = components + size_t( i ) * anim->numAnimatedComponents;
+	}
+
+	skelAnim->type = animType_t::AT_MD5;
+	skelAnim->md5 = anim;
+
+	return true;
+}
+
+/*
+===============
+R_LoadMD5Anim
+
+Parses a .md5anim file, the animation is allocated from the hunk unless
+another allocator is given.
+===============
+*/
+static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const char *name,
+	void *( *alloc )( int size, ha_pref pref ) = ri.Hunk_Alloc )
 {
 	int            i;
 	md5Animation_t *anim;
@@ -82,7 +283,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const
 	buf_p = buffer;
 
 	skelAnim->type = animType_t::AT_MD5;
-	skelAnim->md5 = anim = (md5Animation_t*) ri.Hunk_Alloc( sizeof( *anim ), ha_pref::h_low );
+	skelAnim->md5 = anim = (md5Animation_t*) alloc( sizeof( *anim ), ha_pref::h_low );
 
 	// skip MD5Version indent string
 	COM_ParseExt2( &buf_p, false );
@@ -173,7 +374,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const
 	}
 
 	// parse all the channels
-	anim->channels = (md5Channel_t*) ri.Hunk_Alloc( sizeof( md5Channel_t ) * anim->numChannels, ha_pref::h_low );
+	anim->channels = (md5Channel_t*) alloc( sizeof( md5Channel_t ) * anim->numChannels, ha_pref::h_low );
 
 	for ( i = 0, channel = anim->channels; i < anim->numChannels; i++, channel++ )
 	{
@@ -196,6 +397,13 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const
 
 		token = COM_ParseExt2( &buf_p, false );
 		channel->componentsOffset = atoi( token );
+
+		if ( channel->componentsOffset + R_MD5ChannelComponents( channel->componentsBits ) > uint32_t( anim->numAnimatedComponents ) )
+		{
+			Log::Warn( "RE_RegisterAnimation: '%s' has channel '%s' with components out of the %i animated components",
+			           name, channel->name, anim->numAnimatedComponents );
+			return false;
+		}
 	}
 
 	// parse }
@@ -224,7 +432,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const
 		return false;
 	}
 
-	anim->frames = (md5Frame_t*) ri.Hunk_Alloc( sizeof( md5Frame_t ) * anim->numFrames, ha_pref::h_low );
+	anim->frames = (md5Frame_t*) alloc( sizeof( md5Frame_t ) * anim->numFrames, ha_pref::h_low );
 
 	for ( i = 0, frame = anim->frames; i < anim->numFrames; i++, frame++ )
 	{
@@ -392,7 +600,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const
 			return false;
 		}
 
-		frame->components = (float*) ri.Hunk_Alloc( sizeof( float ) * anim->numAnimatedComponents, ha_pref::h_low );
+		frame->components = (float*) alloc( sizeof( float ) * anim->numAnimatedComponents, ha_pref::h_low );
 
 		for (unsigned j = 0; j < anim->numAnimatedComponents; j++ )
 		{
@@ -414,6 +622,55 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, const char *buffer, const
 	return true;
 }
 
+/*
+===============
+R_MD5AnimToBinary
+
+Gives the binary representation of a parsed animation, for the cache.
+===============
+*/
+static std::string R_MD5AnimToBinary( const md5Animation_t *anim, const std::string &key )
+{
+	md5AnimCacheHeader_t header = {};
+	memcpy( header.ident, MD5ANIM_CACHE_IDENT, sizeof( header.ident ) );
+	header.version = MD5ANIM_CACHE_VERSION;
+	header.keySize = key.size();
+	header.numFrames = anim->numFrames;
+	header.numChannels = anim->numChannels;
+	header.frameRate = anim->frameRate;
+	header.numAnimatedComponents = anim->numAnimatedComponents;
+
+	std::string binary;
+	binary.append( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	binary.append( key );
+	binary.resize( PAD( binary.size(), sizeof( float ) ) );
+
+	for ( int i = 0; i < anim->numChannels; i++ )
+	{
+		const md5Channel_t *channel = &anim->channels[ i ];
+		md5AnimCacheChannel_t cacheChannel = {};
+		Q_strncpyz( cacheChannel.name, channel->name, sizeof( cacheChannel.name ) );
+		cacheChannel.parentIndex = channel->parentIndex;
+		cacheChannel.componentsBits = channel->componentsBits;
+		cacheChannel.componentsOffset = channel->componentsOffset;
+		VectorCopy( channel->baseOrigin, cacheChannel.baseOrigin );
+		QuatCopy( channel->baseQuat, cacheChannel.baseQuat );
+		binary.append( reinterpret_cast<const char*>( &cacheChannel ), sizeof( cacheChannel ) );
+	}
+
+	for ( int i = 0; i < anim->numFrames; i++ )
+	{
+		binary.append( reinterpret_cast<const char*>( anim->frames[ i ].bounds ), 6 * sizeof( float ) );
+	}
+
+	for ( int i = 0; i < anim->numFrames; i++ )
+	{
+		binary.append( reinterpret_cast<const char*>( anim->frames[ i ].components ), anim->numAnimatedComponents * sizeof( float ) );
+	}
+
+	return binary;
+}
+
 /*
 ===============
 RE_RegisterAnimationIQM
@@ -531,9 +788,17 @@ qhandle_t RE_RegisterAnimation( const char *name )
 		return 0;
 	}
 
+	std::string key = R_PakFileCacheKey( name );
+	bool useCache = r_md5AnimCache.Get() && !key.empty();
+
+	if ( useCache && R_LoadMD5AnimBinary( anim, R_ReadMD5AnimCache( name ), key ) )
+	{
+		return anim->index;
+	}
+
 	// load and parse the .md5anim file
 	std::error_code err;
-	std::string buffer = FS::PakPath::ReadFile( name, err );
+	std::string buffer = R_ReadPrefetchedFile( name, err );
 
 	if ( err )
 	{
@@ -543,6 +808,11 @@ qhandle_t RE_RegisterAnimation( const char *name )
 	if ( Str::IsPrefix( MD5_IDENTSTRING, buffer ) )
 	{
 		loaded = R_LoadMD5Anim( anim, buffer.c_str(), name );
+
+		if ( loaded && useCache )
+		{
+			R_WriteMD5AnimCache( name, R_MD5AnimToBinary( anim->md5, key ) );
+		}
 	}
 	else
 	{
@@ -605,6 +875,75 @@ public:
 };
 static ListAnimationsCmd listAnimationsCmdRegistration;
 
+// Heap memory of the animations parsed by buildAnimationCache
+static std::vector<std::unique_ptr<byte[]>> parseAllocations;
+
+static void *ParseAlloc( int size, ha_pref )
+{
+	parseAllocations.emplace_back( new byte[ size ]() );
+	return parseAllocations.back().get();
+}
+
+class BuildAnimationCacheCmd : public Cmd::StaticCmd
+{
+public:
+	BuildAnimationCacheCmd() : StaticCmd(
+		"buildAnimationCache", Cmd::RENDERER, "parse the md5 animations of the loaded paks into the animation cache") {}
+
+	void Run( const Cmd::Args & ) const override
+	{
+		int numBuilt = 0, numCached = 0, numFailed = 0;
+
+		for ( const std::string &name : FS::PakPath::ListFilesRecursive( "" ) )
+		{
+			if ( !Str::IsISuffix( ".md5anim", name ) )
+			{
+				continue;
+			}
+
+			std::string key = R_PakFileCacheKey( name );
+			std::string binary = R_ReadMD5AnimCache( name.c_str() );
+			md5AnimCacheHeader_t header;
+
+			// only check the key, a cache file that is otherwise invalid is rebuilt on load
+			if ( binary.size() >= sizeof( header ) )
+			{
+				memcpy( &header, binary.data(), sizeof( header ) );
+
+				if ( header.version == MD5ANIM_CACHE_VERSION && !binary.compare( sizeof( header ), header.keySize, key ) )
+				{
+					numCached++;
+					continue;
+				}
+			}
+
+			std::error_code err;
+			std::string buffer = FS::PakPath::ReadFile( name, err );
+			skelAnimation_t anim = {};
+
+			// the animations are not registered so they are not kept on the hunk
+			bool parsed = !err && Str::IsPrefix( MD5_IDENTSTRING, buffer )
+				&& R_LoadMD5Anim( &anim, buffer.c_str(), name.c_str(), ParseAlloc );
+
+			if ( parsed )
+			{
+				R_WriteMD5AnimCache( name.c_str(), R_MD5AnimToBinary( anim.md5, key ) );
+				numBuilt++;
+			}
+			else
+			{
+				Print( "couldn't parse '%s'", name );
+				numFailed++;
+			}
+
+			parseAllocations.clear();
+		}
+
+		Print( "%i animations cached, %i already cached, %i failed", numBuilt, numCached, numFailed );
+	}
+};
+static BuildAnimationCacheCmd buildAnimationCacheCmdRegistration;
+
 /*
 =============
 R_CullMD5
@@ -1019,12 +1358,131 @@ void R_TransformSkeleton( refSkeleton_t* skel, const float scale ) {
 	skel->type = refSkeletonType_t::SK_ABSOLUTE;
 }
 
+/*
+==============
+Skeleton cache
+
+The same skeleton is often built several times in a frame: by the cgame to
+place effects on bones, then by the renderer for the entity, for each of the
+entities sharing an animation state... Successful builds are kept until the
+next frame, keyed by the arguments of RE_BuildSkeleton which fully determine
+the result.
+==============
+*/
+static Cvar::Cvar<bool> r_skeletonCache( "r_skeletonCache", "reuse the skeletons built during the frame", Cvar::NONE, true );
+
+namespace {
+struct SkeletonCacheKey
+{
+	qhandle_t hAnim;
+	int startFrame;
+	int endFrame;
+	float frac;
+	bool clearOrigin;
+
+	bool operator==( const SkeletonCacheKey& other ) const
+	{
+		return hAnim == other.hAnim && startFrame == other.startFrame && endFrame == other.endFrame
+			&& frac == other.frac && clearOrigin == other.clearOrigin;
+	}
+};
+
+struct SkeletonCacheKeyHash
+{
+	size_t operator()( const SkeletonCacheKey& key ) const
+	{
+		uint32_t fracBits;
+		memcpy( &fracBits, &key.frac, sizeof( fracBits ) );
+		size_t hash = key.hAnim;
+		hash = hash * 31 + key.startFrame;
+		hash = hash * 31 + key.endFrame;
+		hash = hash * 31 + fracBits;
+		return hash * 2 + key.clearOrigin;
+	}
+};
+}
+
+// Only the bones in use are kept, in a shared array, so the memory only grows
+// with the skeletons actually built. A full refSkeleton_t takes 12 KiB.
+struct CachedSkeleton
+{
+	refSkeletonType_t type;
+	unsigned short numBones;
+	vec3_t bounds[ 2 ];
+	size_t firstBone;
+};
+
+// 64 skeletons of 256 bones, about 1.5 MiB
+static const size_t MAX_CACHED_BONES = 64 * MAX_BONES;
+
+static std::unordered_map<SkeletonCacheKey, CachedSkeleton, SkeletonCacheKeyHash> skeletonCache;
+static std::vector<refBone_t> cachedBones;
+static int skeletonCacheFrame = -1;
+
+void R_ClearSkeletonCache()
+{
+	skeletonCache.clear();
+	cachedBones.clear();
+	skeletonCacheFrame = -1;
+}
+
+static int R_BuildSkeleton( refSkeleton_t *skel, qhandle_t hAnim, int startFrame, int endFrame, float frac, bool clearOrigin );
+
 /*
 ==============
 RE_BuildSkeleton
 ==============
 */
 int RE_BuildSkeleton( refSkeleton_t *skel, qhandle_t hAnim, int startFrame, int endFrame, float frac, bool clearOrigin )
+{
+	if ( !r_skeletonCache.Get() )
+	{
+		return R_BuildSkeleton( skel, hAnim, startFrame, endFrame, frac, clearOrigin );
+	}
+
+	if ( skeletonCacheFrame != tr.frameCount )
+	{
+		skeletonCache.clear();
+		cachedBones.clear();
+		skeletonCacheFrame = tr.frameCount;
+	}
+
+	SkeletonCacheKey key { hAnim, startFrame, endFrame, frac, clearOrigin };
+	auto it = skeletonCache.find( key );
+
+	if ( it != skeletonCache.end() )
+	{
+		const CachedSkeleton &cached = it->second;
+		skel->type = cached.type;
+		skel->numBones = cached.numBones;
+		VectorCopy( cached.bounds[ 0 ], skel->bounds[ 0 ] );
+		VectorCopy( cached.bounds[ 1 ], skel->bounds[ 1 ] );
+		std::copy_n( cachedBones.begin() + cached.firstBone, cached.numBones, skel->bones );
+		return true;
+	}
+
+	// Failures are not cached so that they are still reported
+	if ( !R_BuildSkeleton( skel, hAnim, startFrame, endFrame, frac, clearOrigin ) )
+	{
+		return false;
+	}
+
+	if ( cachedBones.size() + skel->numBones <= MAX_CACHED_BONES )
+	{
+		CachedSkeleton cached;
+		cached.type = skel->type;
+		cached.numBones = skel->numBones;
+		VectorCopy( skel->bounds[ 0 ], cached.bounds[ 0 ] );
+		VectorCopy( skel->bounds[ 1 ], cached.bounds[ 1 ] );
+		cached.firstBone = cachedBones.size();
+		cachedBones.insert( cachedBones.end(), skel->bones, skel->bones + skel->numBones );
+		skeletonCache.emplace( key, cached );
+	}
+
+	return true;
+}
+
+static int R_BuildSkeleton( refSkeleton_t *skel, qhandle_t hAnim, int startFrame, int endFrame, float frac, bool clearOrigin )
 {
 	skelAnimation_t *skelAnim;
 
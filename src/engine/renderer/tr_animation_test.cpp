@@ -0,0 +1,231 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/FileSystem.h"
+
+#include "engine/renderer/tr_local.h"
+
+namespace {
+
+const char* const ANIMATION_NAME = "models/animcache/test.md5anim";
+
+struct SkeletonParams
+{
+    int startFrame;
+    int endFrame;
+    float frac;
+};
+
+const SkeletonParams SKELETON_PARAMS[] = {
+    { 0, 0, 0.0f },
+    { 0, 1, 0.25f },
+    { 1, 3, 0.5f },
+    { 3, 2, 0.9f },
+    { 2, 7, 0.3f }, // clamped
+};
+
+// Only used when the renderer was not started
+void* TestHunkAlloc(int size, ha_pref)
+{
+    static std::vector<std::unique_ptr<byte[]>> blocks;
+    blocks.emplace_back(new byte[size]());
+    return blocks.back().get();
+}
+
+// Registers the test animation and builds its skeletons, then unregisters it
+class AnimationCacheTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        const FS::PakInfo* pak = FS::FindPak("testdata", "src");
+        if (!pak) {
+            FAIL() << "Test data not available - some tests will be skipped. Please add daemon/pkg/ to the pak path";
+        }
+        FS::PakPath::LoadPak(*pak);
+    }
+
+    void SetUp() override
+    {
+        if (!ri.Hunk_Alloc) {
+            ri.Hunk_Alloc = TestHunkAlloc;
+        }
+
+        if (tr.numAnimations == 0) {
+            R_InitAnimations();
+        }
+
+        numAnimations = tr.numAnimations;
+
+        // Don't get the skeletons of the previous registration
+        Cvar::SetValue("r_skeletonCache", "0");
+    }
+
+    void TearDown() override
+    {
+        tr.numAnimations = numAnimations;
+        Cvar::SetValue("r_skeletonCache", "1");
+        Cvar::SetValue("r_md5AnimCache", "1");
+    }
+
+    std::vector<refSkeleton_t> BuildSkeletons(bool useCache)
+    {
+        Cvar::SetValue("r_md5AnimCache", useCache ? "1" : "0");
+        qhandle_t anim = RE_RegisterAnimation(ANIMATION_NAME);
+        EXPECT_NE(anim, 0);
+
+        std::vector<refSkeleton_t> skeletons;
+        for (const SkeletonParams& params : SKELETON_PARAMS) {
+            skeletons.emplace_back();
+            EXPECT_TRUE(RE_BuildSkeleton(&skeletons.back(), anim, params.startFrame, params.endFrame, params.frac, false));
+        }
+
+        tr.numAnimations = numAnimations;
+        return skeletons;
+    }
+
+    // Writes the cache of the test animation and returns it with the offset
+    // and size of its key, the channels follow the key
+    std::string WriteCache(size_t& keyOffset, size_t& keySize)
+    {
+        std::error_code ignored;
+        FS::HomePath::DeleteFile(cachePath, ignored);
+        BuildSkeletons(true);
+
+        std::string cache = FS::HomePath::OpenRead(cachePath).ReadAll();
+        std::string key = R_PakFileCacheKey(ANIMATION_NAME);
+        keyOffset = cache.find(key);
+        keySize = key.size();
+        return cache;
+    }
+
+    const std::string cachePath = Str::Format("animcache/%s.bin", ANIMATION_NAME);
+
+    int numAnimations;
+};
+
+void ExpectSameSkeletons(const std::vector<refSkeleton_t>& parsed, const std::vector<refSkeleton_t>& cached)
+{
+    ASSERT_EQ(parsed.size(), cached.size());
+
+    for (size_t i = 0; i < parsed.size(); i++) {
+        const refSkeleton_t& a = parsed[i];
+        const refSkeleton_t& b = cached[i];
+
+        ASSERT_EQ(a.numBones, 3u);
+        ASSERT_EQ(a.numBones, b.numBones);
+        EXPECT_EQ(a.type, b.type);
+
+        for (int j = 0; j < 3; j++) {
+            EXPECT_EQ(a.bounds[0][j], b.bounds[0][j]);
+            EXPECT_EQ(a.bounds[1][j], b.bounds[1][j]);
+        }
+
+        for (unsigned j = 0; j < a.numBones; j++) {
+            EXPECT_EQ(a.bones[j].parentIndex, b.bones[j].parentIndex);
+            EXPECT_EQ(a.bones[j].t.scale, b.bones[j].t.scale);
+
+            for (int k = 0; k < 3; k++) {
+                EXPECT_EQ(a.bones[j].t.trans[k], b.bones[j].t.trans[k]);
+            }
+
+            for (int k = 0; k < 4; k++) {
+                EXPECT_EQ(a.bones[j].t.rot[k], b.bones[j].t.rot[k]);
+            }
+        }
+    }
+}
+
+TEST_F(AnimationCacheTest, SameBones)
+{
+    // Parsed from the text
+    std::vector<refSkeleton_t> parsed = BuildSkeletons(false);
+
+    // The first registration with the cache writes it
+    BuildSkeletons(true);
+    ASSERT_TRUE(FS::HomePath::FileExists(cachePath));
+    std::string cache = FS::HomePath::OpenRead(cachePath).ReadAll();
+    auto written = FS::HomePath::FileTimestamp(cachePath);
+
+    // It is not rewritten when it is loaded
+    ExpectSameSkeletons(parsed, BuildSkeletons(true));
+    EXPECT_EQ(written, FS::HomePath::FileTimestamp(cachePath));
+    EXPECT_EQ(cache, FS::HomePath::OpenRead(cachePath).ReadAll());
+}
+
+TEST_F(AnimationCacheTest, StaleCache)
+{
+    std::vector<refSkeleton_t> parsed = BuildSkeletons(false);
+
+    // A valid cache made from another version of the file is ignored and replaced
+    size_t keyOffset, keySize;
+    std::string cache = WriteCache(keyOffset, keySize);
+    ASSERT_NE(keyOffset, std::string::npos);
+
+    // Another timestamp, the key ends with a newline
+    std::string stale = cache;
+    stale[keyOffset + keySize - 2] ^= 1;
+    FS::HomePath::OpenWrite(cachePath).Write(stale.data(), stale.size());
+
+    ExpectSameSkeletons(parsed, BuildSkeletons(true));
+    EXPECT_EQ(cache, FS::HomePath::OpenRead(cachePath).ReadAll());
+}
+
+TEST_F(AnimationCacheTest, InvalidChannels)
+{
+    std::vector<refSkeleton_t> parsed = BuildSkeletons(false);
+
+    size_t keyOffset, keySize;
+    std::string cache = WriteCache(keyOffset, keySize);
+    ASSERT_NE(keyOffset, std::string::npos);
+
+    // The channel starts with its name then has the parent index, the
+    // component bits and the offset of the components
+    size_t channel = PAD(keyOffset + keySize, sizeof(float));
+    size_t parentIndex = channel + MAX_QPATH;
+    size_t componentsOffset = parentIndex + 2 * sizeof(uint32_t);
+
+    // A parent out of the channels and components out of the frames
+    for (auto patch : {std::make_pair(parentIndex, 3), std::make_pair(componentsOffset, 1 << 20)}) {
+        std::string invalid = cache;
+        int32_t value = patch.second;
+        memcpy(&invalid[patch.first], &value, sizeof(value));
+        FS::HomePath::OpenWrite(cachePath).Write(invalid.data(), invalid.size());
+
+        // Parsed again from the text
+        ExpectSameSkeletons(parsed, BuildSkeletons(true));
+        EXPECT_EQ(cache, FS::HomePath::OpenRead(cachePath).ReadAll());
+    }
+}
+
+} // namespace
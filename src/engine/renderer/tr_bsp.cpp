@@ -1156,7 +1156,7 @@ static void ParseTriSurf( dsurface_t* ds, drawVert_t* verts, bspSurface_t* surf,
 	surface->plane.dist = plane.dist;
 }
 
-static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf )
+static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf, bool cachedGrid )
 {
 	srfGridMesh_t        *grid;
 	int                  width, height, numPoints;
@@ -1249,6 +1249,14 @@ static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf )
 		R_ColorShiftLightingBytes( points[ i ].lightColor.ToArray() );
 	}
 
+	// the grid is restored from the world geometry cache after all the surfaces are parsed,
+	// the control points are still checked above to warn about the same bad vertices
+	if ( cachedGrid )
+	{
+		surf->data = nullptr;
+		return;
+	}
+
 	// center texture coords
 	for( int j = 0; j < 2; j++ ) {
 		tcOffset[ j ] = 0.5f * (stBounds[ 1 ][ j ] + stBounds[ 0 ][ j ]);
@@ -2590,6 +2598,512 @@ void R_MovePatchSurfacesToHunk()
 	}
 }
 
+/*
+===============
+World geometry cache
+
+The patch meshes of the world, once subdivided, stitched and with their
+LoD errors fixed, and the deduplicated vertices and indices of the world
+VBO are cached in the homepath, so that loading the same map again skips
+these stages. It is laid out as: worldCacheHeader_t, the key padded to 4
+bytes, the surface numbers of the renderer surfaces in the VBO order, the
+VBO vertices and indices, then for each patch mesh a worldCacheGrid_t
+followed by its LoD errors, triangles and vertices.
+===============
+*/
+static Cvar::Cvar<bool> r_worldGeometryCache( "r_worldGeometryCache", "cache the processed world geometry in the homepath", Cvar::NONE, true );
+
+static const char WORLD_CACHE_IDENT[ 4 ] = { 'W', 'G', 'E', 'O' };
+static const uint32_t WORLD_CACHE_VERSION = 1;
+
+struct worldCacheHeader_t
+{
+	char     ident[ 4 ];
+	uint32_t version;
+	uint32_t keySize;
+	uint32_t numRendererSurfaces;
+	uint32_t numVerts;
+	uint32_t numIndices;
+	uint32_t numGrids;
+};
+
+struct worldCacheGrid_t
+{
+	uint32_t surfaceNum;
+	vec3_t   bounds[ 2 ];
+	vec3_t   origin;
+	float    radius;
+	vec3_t   lodOrigin;
+	float    lodRadius;
+	int32_t  lodFixed;
+	int32_t  lodStitched;
+	int32_t  width;
+	int32_t  height;
+	int32_t  numTriangles;
+};
+
+// The cache of the map being loaded, only kept until the world VBO is built
+static struct
+{
+	std::string key;
+	std::string binary;
+} s_worldCache;
+
+/*
+===============
+R_WorldGeometryCacheKey
+
+Everything the processed geometry depends on besides the map file: the
+tessellation settings and the lighting parameters applied to the vertex
+colors.
+===============
+*/
+static std::string R_WorldGeometryCacheKey( const char *name )
+{
+	std::string key = R_PakFileCacheKey( name );
+
+	if ( key.empty() )
+	{
+		return "";
+	}
+
+	return key + Str::Format( "%s %u %g %d %d %d %d %d %d %d %d\n", ENGINE_VERSION, sizeof( srfVert_t ),
+		r_subdivisions->value, r_stitchCurves->integer, r_singleShader->integer,
+		tr.worldLightMapping, tr.worldDeluxeMapping, tr.worldLinearizeTexture, tr.worldLinearizeLightMap,
+		tr.overbrightBits, tr.mapOverBrightBits );
+}
+
+static std::string R_WorldGeometryCachePath( const char *name )
+{
+	return Str::Format( "worldcache/%s.bin", name );
+}
+
+static std::string R_ReadWorldGeometryCache( const char *name )
+{
+	std::error_code err;
+	FS::File cacheFile = FS::HomePath::OpenRead( R_WorldGeometryCachePath( name ), err );
+
+	if ( err )
+	{
+		return "";
+	}
+
+	std::string binary = cacheFile.ReadAll( err );
+	return err ? "" : binary;
+}
+
+static void R_WriteWorldGeometryCache( const char *name, const std::string &binary )
+{
+	std::string cachePath = R_WorldGeometryCachePath( name );
+	std::error_code err;
+	FS::File cacheFile = FS::HomePath::OpenWrite( cachePath, err );
+
+	if ( !err )
+	{
+		cacheFile.Write( binary.data(), binary.size(), err );
+		cacheFile.Close( err );
+	}
+
+	if ( err )
+	{
+		Log::Warn( "Failed to write the world geometry cache %s: %s", cachePath, err.message() );
+	}
+}
+
+/*
+===============
+R_CheckWorldCacheHeader
+
+Returns false if the cache was made from another version of the map or
+with other settings, otherwise gives the offset of the patch meshes.
+===============
+*/
+static bool R_CheckWorldCacheHeader( const std::string &binary, const std::string &key,
+	worldCacheHeader_t &header, size_t &gridsOffset )
+{
+	if ( binary.size() < sizeof( header ) )
+	{
+		return false;
+	}
+
+	memcpy( &header, binary.data(), sizeof( header ) );
+
+	if ( memcmp( header.ident, WORLD_CACHE_IDENT, sizeof( header.ident ) ) || header.version != WORLD_CACHE_VERSION )
+	{
+		return false;
+	}
+
+	size_t surfacesOffset = PAD( sizeof( header ) + uint64_t( header.keySize ), sizeof( float ) );
+	uint64_t vboSize = uint64_t( header.numRendererSurfaces ) * sizeof( uint32_t )
+		+ uint64_t( header.numVerts ) * sizeof( srfVert_t ) + uint64_t( header.numIndices ) * sizeof( glIndex_t );
+
+	if ( surfacesOffset > binary.size() || vboSize > binary.size() - surfacesOffset )
+	{
+		return false;
+	}
+
+	if ( binary.compare( sizeof( header ), header.keySize, key ) )
+	{
+		return false;
+	}
+
+	gridsOffset = surfacesOffset + vboSize;
+	return true;
+}
+
+/*
+===============
+R_BuildWorldGeometryCache
+
+Serializes the patch meshes of the world and the VBO data made from the
+renderer surfaces.
+===============
+*/
+std::string R_BuildWorldGeometryCache( const world_t *world, const std::string &key,
+	bspSurface_t **rendererSurfaces, int numSurfaces,
+	const srfVert_t *verts, int numVerts, const glIndex_t *indices, int numIndices )
+{
+	worldCacheHeader_t header = {};
+	memcpy( header.ident, WORLD_CACHE_IDENT, sizeof( header.ident ) );
+	header.version = WORLD_CACHE_VERSION;
+	header.keySize = key.size();
+	header.numRendererSurfaces = numSurfaces;
+	header.numVerts = numVerts;
+	header.numIndices = numIndices;
+
+	for ( int i = 0; i < world->numSurfaces; i++ )
+	{
+		if ( *world->surfaces[ i ].data == surfaceType_t::SF_GRID )
+		{
+			header.numGrids++;
+		}
+	}
+
+	std::string binary;
+	binary.append( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	binary.append( key );
+	binary.resize( PAD( binary.size(), sizeof( float ) ) );
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		uint32_t surfaceNum = rendererSurfaces[ i ] - world->surfaces;
+		binary.append( reinterpret_cast<const char*>( &surfaceNum ), sizeof( surfaceNum ) );
+	}
+
+	binary.append( reinterpret_cast<const char*>( verts ), numVerts * sizeof( srfVert_t ) );
+	binary.append( reinterpret_cast<const char*>( indices ), numIndices * sizeof( glIndex_t ) );
+
+	for ( int i = 0; i < world->numSurfaces; i++ )
+	{
+		const srfGridMesh_t *grid = ( const srfGridMesh_t * ) world->surfaces[ i ].data;
+
+		if ( grid->surfaceType != surfaceType_t::SF_GRID )
+		{
+			continue;
+		}
+
+		worldCacheGrid_t cacheGrid = {};
+		cacheGrid.surfaceNum = i;
+		VectorCopy( grid->bounds[ 0 ], cacheGrid.bounds[ 0 ] );
+		VectorCopy( grid->bounds[ 1 ], cacheGrid.bounds[ 1 ] );
+		VectorCopy( grid->origin, cacheGrid.origin );
+		cacheGrid.radius = grid->radius;
+		VectorCopy( grid->lodOrigin, cacheGrid.lodOrigin );
+		cacheGrid.lodRadius = grid->lodRadius;
+		cacheGrid.lodFixed = grid->lodFixed;
+		cacheGrid.lodStitched = grid->lodStitched;
+		cacheGrid.width = grid->width;
+		cacheGrid.height = grid->height;
+		cacheGrid.numTriangles = grid->numTriangles;
+
+		binary.append( reinterpret_cast<const char*>( &cacheGrid ), sizeof( cacheGrid ) );
+		binary.append( reinterpret_cast<const char*>( grid->widthLodError ), grid->width * sizeof( float ) );
+		binary.append( reinterpret_cast<const char*>( grid->heightLodError ), grid->height * sizeof( float ) );
+		binary.append( reinterpret_cast<const char*>( grid->triangles ), grid->numTriangles * sizeof( srfTriangle_t ) );
+		binary.append( reinterpret_cast<const char*>( grid->verts ), grid->numVerts * sizeof( srfVert_t ) );
+	}
+
+	return binary;
+}
+
+/*
+===============
+R_LoadWorldGridsCache
+
+Restores the patch meshes into the surfaces of the world which have no
+data yet, returns false without touching them if the cache doesn't have
+exactly these.
+===============
+*/
+bool R_LoadWorldGridsCache( world_t *world, const std::string &binary, const std::string &key )
+{
+	worldCacheHeader_t header;
+	size_t gridsOffset;
+
+	if ( !R_CheckWorldCacheHeader( binary, key, header, gridsOffset ) )
+	{
+		return false;
+	}
+
+	int numMissing = 0;
+
+	for ( int i = 0; i < world->numSurfaces; i++ )
+	{
+		if ( !world->surfaces[ i ].data )
+		{
+			numMissing++;
+		}
+	}
+
+	if ( header.numGrids != uint32_t( numMissing ) )
+	{
+		return false;
+	}
+
+	// check all the grids before restoring any
+	std::vector<bool> restored( world->numSurfaces );
+	const char *data = binary.data();
+	size_t offset = gridsOffset;
+
+	for ( uint32_t i = 0; i < header.numGrids; i++ )
+	{
+		worldCacheGrid_t cacheGrid;
+
+		if ( binary.size() - offset < sizeof( cacheGrid ) )
+		{
+			return false;
+		}
+
+		memcpy( &cacheGrid, data + offset, sizeof( cacheGrid ) );
+		offset += sizeof( cacheGrid );
+
+		if ( cacheGrid.surfaceNum >= uint32_t( world->numSurfaces ) || world->surfaces[ cacheGrid.surfaceNum ].data
+			|| restored[ cacheGrid.surfaceNum ] )
+		{
+			return false;
+		}
+
+		if ( cacheGrid.width < 1 || cacheGrid.width > MAX_GRID_SIZE || cacheGrid.height < 1 || cacheGrid.height > MAX_GRID_SIZE
+			|| cacheGrid.numTriangles < 0 || cacheGrid.numTriangles > SHADER_MAX_TRIANGLES )
+		{
+			return false;
+		}
+
+		int numVerts = cacheGrid.width * cacheGrid.height;
+		size_t size = ( cacheGrid.width + cacheGrid.height ) * sizeof( float )
+			+ cacheGrid.numTriangles * sizeof( srfTriangle_t ) + numVerts * sizeof( srfVert_t );
+
+		if ( binary.size() - offset < size )
+		{
+			return false;
+		}
+
+		const char *triangles = data + offset + ( cacheGrid.width + cacheGrid.height ) * sizeof( float );
+
+		for ( int j = 0; j < cacheGrid.numTriangles * 3; j++ )
+		{
+			int index;
+			memcpy( &index, triangles + j * sizeof( int ), sizeof( int ) );
+
+			if ( index < 0 || index >= numVerts )
+			{
+				return false;
+			}
+		}
+
+		restored[ cacheGrid.surfaceNum ] = true;
+		offset += size;
+	}
+
+	if ( offset != binary.size() )
+	{
+		return false;
+	}
+
+	offset = gridsOffset;
+
+	for ( uint32_t i = 0; i < header.numGrids; i++ )
+	{
+		worldCacheGrid_t cacheGrid;
+		memcpy( &cacheGrid, data + offset, sizeof( cacheGrid ) );
+		offset += sizeof( cacheGrid );
+
+		srfGridMesh_t *grid = (srfGridMesh_t*) ri.Hunk_Alloc( sizeof( srfGridMesh_t ), ha_pref::h_low );
+		*grid = {};
+
+		grid->surfaceType = surfaceType_t::SF_GRID;
+		VectorCopy( cacheGrid.bounds[ 0 ], grid->bounds[ 0 ] );
+		VectorCopy( cacheGrid.bounds[ 1 ], grid->bounds[ 1 ] );
+		VectorCopy( cacheGrid.origin, grid->origin );
+		grid->radius = cacheGrid.radius;
+		VectorCopy( cacheGrid.lodOrigin, grid->lodOrigin );
+		grid->lodRadius = cacheGrid.lodRadius;
+		grid->lodFixed = cacheGrid.lodFixed;
+		grid->lodStitched = cacheGrid.lodStitched;
+		grid->width = cacheGrid.width;
+		grid->height = cacheGrid.height;
+		grid->numTriangles = cacheGrid.numTriangles;
+		grid->numVerts = grid->width * grid->height;
+
+		grid->widthLodError = (float*) ri.Hunk_Alloc( grid->width * sizeof( float ), ha_pref::h_low );
+		memcpy( grid->widthLodError, data + offset, grid->width * sizeof( float ) );
+		offset += grid->width * sizeof( float );
+
+		grid->heightLodError = (float*) ri.Hunk_Alloc( grid->height * sizeof( float ), ha_pref::h_low );
+		memcpy( grid->heightLodError, data + offset, grid->height * sizeof( float ) );
+		offset += grid->height * sizeof( float );
+
+		grid->triangles = (srfTriangle_t*) ri.Hunk_Alloc( grid->numTriangles * sizeof( srfTriangle_t ), ha_pref::h_low );
+		memcpy( grid->triangles, data + offset, grid->numTriangles * sizeof( srfTriangle_t ) );
+		offset += grid->numTriangles * sizeof( srfTriangle_t );
+
+		grid->verts = (srfVert_t*) ri.Hunk_Alloc( grid->numVerts * sizeof( srfVert_t ), ha_pref::h_low );
+		memcpy( grid->verts, data + offset, grid->numVerts * sizeof( srfVert_t ) );
+		offset += grid->numVerts * sizeof( srfVert_t );
+
+		world->surfaces[ cacheGrid.surfaceNum ].data = ( surfaceType_t * ) grid;
+	}
+
+	return true;
+}
+
+/*
+===============
+R_LoadWorldVertsCache
+
+Fills the VBO data and the first index of the renderer surfaces, returns
+false if the cache was made from other surfaces. The surfaces may come in
+another order than when the cache was made, as their order depends on the
+shaders: each surface keeps its triangles, only their place in the IBO
+changes.
+===============
+*/
+bool R_LoadWorldVertsCache( const world_t *world, const std::string &binary, const std::string &key,
+	bspSurface_t **rendererSurfaces, int numSurfaces,
+	srfVert_t *verts, int maxVerts, glIndex_t *indices, int numIndices, int &numVertsOut )
+{
+	worldCacheHeader_t header;
+	size_t gridsOffset;
+
+	if ( !R_CheckWorldCacheHeader( binary, key, header, gridsOffset ) )
+	{
+		return false;
+	}
+
+	if ( header.numRendererSurfaces != uint32_t( numSurfaces ) || header.numVerts > uint32_t( maxVerts )
+		|| header.numIndices != uint32_t( numIndices ) )
+	{
+		return false;
+	}
+
+	const char *data = binary.data() + PAD( sizeof( header ) + header.keySize, sizeof( float ) );
+
+	// where the triangles of each surface are in the cached IBO
+	std::vector<int> cachedFirstIndex( world->numSurfaces, -1 );
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		cachedFirstIndex[ rendererSurfaces[ i ] - world->surfaces ] = -2;
+	}
+
+	int firstIndex = 0;
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		uint32_t surfaceNum;
+		memcpy( &surfaceNum, data + i * sizeof( surfaceNum ), sizeof( surfaceNum ) );
+
+		if ( surfaceNum >= uint32_t( world->numSurfaces ) || cachedFirstIndex[ surfaceNum ] != -2 )
+		{
+			return false;
+		}
+
+		cachedFirstIndex[ surfaceNum ] = firstIndex;
+		firstIndex += ( ( srfGeneric_t * ) world->surfaces[ surfaceNum ].data )->numTriangles * 3;
+	}
+
+	if ( firstIndex != numIndices )
+	{
+		return false;
+	}
+
+	data += numSurfaces * sizeof( uint32_t );
+	const char *cachedIndices = data + header.numVerts * sizeof( srfVert_t );
+
+	for ( int i = 0; i < numIndices; i++ )
+	{
+		glIndex_t index;
+		memcpy( &index, cachedIndices + i * sizeof( index ), sizeof( index ) );
+
+		if ( index >= header.numVerts )
+		{
+			return false;
+		}
+	}
+
+	memcpy( verts, data, header.numVerts * sizeof( srfVert_t ) );
+
+	// the surfaces are laid out in order in the IBO
+	firstIndex = 0;
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		bspSurface_t *surface = rendererSurfaces[ i ];
+		srfGeneric_t *srf = ( srfGeneric_t * ) surface->data;
+		int count = srf->numTriangles * 3;
+
+		memcpy( indices + firstIndex, cachedIndices + cachedFirstIndex[ surface - world->surfaces ] * sizeof( glIndex_t ),
+			count * sizeof( glIndex_t ) );
+		srf->firstIndex = firstIndex;
+		firstIndex += count;
+
+		// MergeDuplicateVertices fixes the vertices of the surfaces as well, not only the VBO ones
+		for ( srfTriangle_t *triangle = srf->triangles; triangle < srf->triangles + srf->numTriangles; triangle++ )
+		{
+			for ( int j = 0; j < 3; j++ )
+			{
+				ValidateVertex( &srf->verts[ triangle->indexes[ j ] ], -1, surface->shader );
+			}
+		}
+	}
+
+	numVertsOut = header.numVerts;
+	return true;
+}
+
+/*
+===============
+R_MergeWorldVertices
+
+Fills the world VBO data, from the world geometry cache if it has the same
+surfaces, otherwise by merging the duplicate vertices of the renderer
+surfaces, then the cache is written again if a key is given. Returns true
+if the cache was used.
+===============
+*/
+bool R_MergeWorldVertices( const world_t *world, const std::string &binary, const std::string &key,
+	bspSurface_t **rendererSurfaces, int numSurfaces,
+	srfVert_t *verts, int maxVerts, glIndex_t *indices, int maxIndices, int &numVerts, int &numIndices )
+{
+	numIndices = maxIndices;
+
+	if ( R_LoadWorldVertsCache( world, binary, key, rendererSurfaces, numSurfaces, verts, maxVerts, indices, numIndices, numVerts ) )
+	{
+		Log::Debug( "...loaded %i world VBO vertices from the world geometry cache", numVerts );
+		return true;
+	}
+
+	MergeDuplicateVertices( rendererSurfaces, numSurfaces, verts, maxVerts, indices, maxIndices, numVerts, numIndices );
+
+	if ( !key.empty() )
+	{
+		R_WriteWorldGeometryCache( world->name, R_BuildWorldGeometryCache( world, key,
+			rendererSurfaces, numSurfaces, verts, numVerts, indices, numIndices ) );
+	}
+
+	return false;
+}
+
 /*
 =================
 R_CreateClusters
@@ -2754,7 +3268,8 @@ static void R_CreateWorldVBO() {
 
 	int numVerts;
 	int numIndices;
-	MergeDuplicateVertices( rendererSurfaces, numSurfaces, vboVerts, numVertsInitial, vboIdxs, 3 * numTriangles, numVerts, numIndices );
+	R_MergeWorldVertices( &s_worldData, s_worldCache.binary, s_worldCache.key, rendererSurfaces, numSurfaces,
+		vboVerts, numVertsInitial, vboIdxs, 3 * numTriangles, numVerts, numIndices );
 
 	if ( glConfig.usingMaterialSystem ) {
 		OptimiseMapGeometryMaterial( &s_worldData, rendererSurfaces, numSurfaces, vboVerts, numVerts, vboIdxs, numIndices );
@@ -2850,12 +3365,16 @@ static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 	s_worldData.surfaces = out;
 	s_worldData.numSurfaces = count;
 
+	worldCacheHeader_t cacheHeader;
+	size_t cacheGridsOffset;
+	bool cachedGrids = R_CheckWorldCacheHeader( s_worldCache.binary, s_worldCache.key, cacheHeader, cacheGridsOffset );
+
 	for ( i = 0; i < count; i++, in++, out++ )
 	{
 		switch ( LittleLong( in->surfaceType ) )
 		{
 			case mapSurfaceType_t::MST_PATCH:
-				ParseMesh( in, dv, out );
+				ParseMesh( in, dv, out, cachedGrids );
 				numMeshes++;
 				break;
 
@@ -2898,6 +3417,28 @@ static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 	Log::Debug( "...loaded %d faces, %i meshes, %i trisurfs, %i flares (skipped) %i foliages", numFaces, numMeshes, numTriSurfs,
 	           numFlares, numFoliages );
 
+	if ( cachedGrids )
+	{
+		if ( R_LoadWorldGridsCache( &s_worldData, s_worldCache.binary, s_worldCache.key ) )
+		{
+			Log::Debug( "...loaded %u patch meshes from the world geometry cache", cacheHeader.numGrids );
+			return;
+		}
+
+		// the cache doesn't match the map, parse the patches that were skipped
+		s_worldCache.binary.clear();
+
+		in = ( dsurface_t * )( fileBase + surfs->fileofs );
+
+		for ( i = 0; i < count; i++ )
+		{
+			if ( !s_worldData.surfaces[ i ].data )
+			{
+				ParseMesh( &in[ i ], dv, &s_worldData.surfaces[ i ], false );
+			}
+		}
+	}
+
 	if ( r_stitchCurves->integer )
 	{
 		R_StitchAllPatches();
@@ -3115,6 +3656,9 @@ static void R_LoadShaders( lump_t *l )
 
 		out[ i ].surfaceFlags = LittleLong( out[ i ].surfaceFlags );
 		out[ i ].contentFlags = LittleLong( out[ i ].contentFlags );
+
+		// start decoding the images while the rest of the map is loaded
+		RE_PrefetchShader( out[ i ].shader );
 	}
 }
 
@@ -4861,6 +5405,10 @@ void RE_LoadWorldMap( const char *name )
 
 	R_LoadPlanes( &header->lumps[ LUMP_PLANES ] );
 
+	// the lighting parameters used by the cache key are known at this point
+	s_worldCache.key = r_worldGeometryCache.Get() ? R_WorldGeometryCacheKey( name ) : "";
+	s_worldCache.binary = s_worldCache.key.empty() ? "" : R_ReadWorldGeometryCache( name );
+
 	R_LoadSurfaces( &header->lumps[ LUMP_SURFACES ], &header->lumps[ LUMP_DRAWVERTS ], &header->lumps[ LUMP_DRAWINDEXES ] );
 
 	R_LoadMarksurfaces( &header->lumps[ LUMP_LEAFSURFACES ] );
@@ -4883,6 +5431,8 @@ void RE_LoadWorldMap( const char *name )
 	R_CreateWorldVBO();
 	R_CreateClusters();
 
+	s_worldCache = {};
+
 	if ( tr.hasSkybox ) {
 		FinishSkybox();
 	}
@@ -0,0 +1,419 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/FileSystem.h"
+
+#include "engine/renderer/tr_local.h"
+#include "engine/renderer/GeometryOptimiser.h"
+
+namespace {
+
+const std::string CACHE_KEY = "maps/test.bsp test 0.1 0 0\n";
+
+// Only used when the renderer was not started
+void* TestHunkAlloc( int size, ha_pref )
+{
+    static std::vector<std::unique_ptr<byte[]>> blocks;
+    blocks.emplace_back( new byte[ size ]() );
+    return blocks.back().get();
+}
+
+srfVert_t Vert( float x, float y, float z )
+{
+    srfVert_t vert{};
+    VectorSet( vert.xyz, x, y, z );
+    vert.st[ 0 ] = x * 0.125f;
+    vert.st[ 1 ] = y * 0.125f;
+    vert.lightmap[ 0 ] = 0.5f;
+    vert.lightmap[ 1 ] = 0.25f;
+    VectorSet( vert.normal, 0.0f, 0.0f, 1.0f );
+    vert.lightColor = Color::Color32Bit( 200, 100, 50, 255 );
+    return vert;
+}
+
+template<typename T>
+T* HunkArray( int count )
+{
+    return static_cast<T*>( TestHunkAlloc( count * sizeof( T ), ha_pref::h_low ) );
+}
+
+// A flat grid mesh of width * height vertices at the given height
+srfGridMesh_t* Grid( int width, int height, float z )
+{
+    srfGridMesh_t* grid = HunkArray<srfGridMesh_t>( 1 );
+    grid->surfaceType = surfaceType_t::SF_GRID;
+    grid->width = width;
+    grid->height = height;
+    grid->numVerts = width * height;
+    grid->verts = HunkArray<srfVert_t>( grid->numVerts );
+    grid->widthLodError = HunkArray<float>( width );
+    grid->heightLodError = HunkArray<float>( height );
+    grid->numTriangles = 2 * ( width - 1 ) * ( height - 1 );
+    grid->triangles = HunkArray<srfTriangle_t>( grid->numTriangles );
+
+    for ( int i = 0; i < height; i++ ) {
+        grid->heightLodError[ i ] = i * 0.5f;
+
+        for ( int j = 0; j < width; j++ ) {
+            grid->widthLodError[ j ] = j * 0.25f;
+            grid->verts[ i * width + j ] = Vert( j, i, z );
+        }
+    }
+
+    srfTriangle_t* tri = grid->triangles;
+    for ( int i = 0; i < height - 1; i++ ) {
+        for ( int j = 0; j < width - 1; j++ ) {
+            int v = i * width + j;
+            *tri++ = { { v, v + width, v + 1 } };
+            *tri++ = { { v + 1, v + width, v + width + 1 } };
+        }
+    }
+
+    VectorSet( grid->bounds[ 0 ], 0.0f, 0.0f, z );
+    VectorSet( grid->bounds[ 1 ], width - 1, height - 1, z );
+    VectorSet( grid->lodOrigin, 1.0f, 2.0f, z );
+    grid->lodRadius = 3.0f;
+    grid->lodFixed = 1;
+    grid->lodStitched = 1;
+    return grid;
+}
+
+// Two patch meshes, a triangle surface sharing vertices with the first one and
+// a skipped surface, merged in a different order than the surfaces of the map
+class WorldGeometryCacheTest : public ::testing::Test
+{
+protected:
+    WorldGeometryCacheTest()
+    {
+        if ( !ri.Hunk_Alloc ) {
+            ri.Hunk_Alloc = TestHunkAlloc;
+        }
+
+        srfGeneric_t* triangles = HunkArray<srfGeneric_t>( 1 );
+        triangles->surfaceType = surfaceType_t::SF_TRIANGLES;
+        triangles->numVerts = 3;
+        triangles->verts = HunkArray<srfVert_t>( 3 );
+        triangles->verts[ 0 ] = Vert( 0, 0, 0 );
+        triangles->verts[ 1 ] = Vert( 1, 0, 0 );
+        triangles->verts[ 2 ] = Vert( 5, 5, 5 );
+        triangles->numTriangles = 1;
+        triangles->triangles = HunkArray<srfTriangle_t>( 1 );
+        triangles->triangles[ 0 ] = { { 0, 1, 2 } };
+
+        surfaces[ 0 ].data = ( surfaceType_t* ) Grid( 3, 3, 0.0f );
+        surfaces[ 1 ].data = ( surfaceType_t* ) triangles;
+        surfaces[ 2 ].data = &skipData;
+        surfaces[ 3 ].data = ( surfaceType_t* ) Grid( 2, 3, 4.0f );
+
+        for ( bspSurface_t& surface : surfaces ) {
+            surface.shader = &shader;
+        }
+
+        world.surfaces = surfaces;
+        world.numSurfaces = ARRAY_LEN( surfaces );
+    }
+
+    std::vector<bspSurface_t*> RendererSurfaces( world_t* surfacesWorld )
+    {
+        return { &surfacesWorld->surfaces[ 3 ], &surfacesWorld->surfaces[ 0 ], &surfacesWorld->surfaces[ 1 ] };
+    }
+
+    // Builds the VBO data like R_CreateWorldVBO does without the cache
+    void MergeVertices()
+    {
+        rendererSurfaces = RendererSurfaces( &world );
+
+        int numVertsIn = 0;
+        int numIndicesIn = 0;
+        for ( bspSurface_t* surface : rendererSurfaces ) {
+            srfGeneric_t* srf = ( srfGeneric_t* ) surface->data;
+            numVertsIn += srf->numVerts;
+            numIndicesIn += srf->numTriangles * 3;
+        }
+
+        verts.resize( numVertsIn );
+        indices.resize( numIndicesIn );
+        MergeDuplicateVertices( rendererSurfaces.data(), rendererSurfaces.size(), verts.data(), numVertsIn,
+                                indices.data(), numIndicesIn, numVerts, numIndices );
+        ASSERT_LT( numVerts, numVertsIn );
+    }
+
+    std::string BuildCache()
+    {
+        return R_BuildWorldGeometryCache( &world, CACHE_KEY, rendererSurfaces.data(), rendererSurfaces.size(),
+                                          verts.data(), numVerts, indices.data(), numIndices );
+    }
+
+    // The world as R_LoadSurfaces leaves it when the patch meshes are cached
+    void ResetCachedWorld()
+    {
+        std::copy( std::begin( surfaces ), std::end( surfaces ), cachedSurfaces );
+        cachedSurfaces[ 0 ].data = nullptr;
+        cachedSurfaces[ 3 ].data = nullptr;
+        ( ( srfGeneric_t* ) cachedSurfaces[ 1 ].data )->firstIndex = -1;
+
+        cachedWorld.surfaces = cachedSurfaces;
+        cachedWorld.numSurfaces = ARRAY_LEN( cachedSurfaces );
+    }
+
+    shader_t shader{};
+    surfaceType_t skipData = surfaceType_t::SF_SKIP;
+    bspSurface_t surfaces[ 4 ]{};
+    bspSurface_t cachedSurfaces[ 4 ]{};
+    world_t world{};
+    world_t cachedWorld{};
+
+    std::vector<bspSurface_t*> rendererSurfaces;
+    std::vector<srfVert_t> verts;
+    std::vector<glIndex_t> indices;
+    int numVerts;
+    int numIndices;
+};
+
+void ExpectSameVerts( const srfVert_t* a, const srfVert_t* b, int numVerts )
+{
+    for ( int i = 0; i < numVerts; i++ ) {
+        for ( int j = 0; j < 3; j++ ) {
+            EXPECT_EQ( a[ i ].xyz[ j ], b[ i ].xyz[ j ] );
+            EXPECT_EQ( a[ i ].normal[ j ], b[ i ].normal[ j ] );
+        }
+
+        for ( int j = 0; j < 2; j++ ) {
+            EXPECT_EQ( a[ i ].st[ j ], b[ i ].st[ j ] );
+            EXPECT_EQ( a[ i ].lightmap[ j ], b[ i ].lightmap[ j ] );
+        }
+
+        for ( int j = 0; j < 4; j++ ) {
+            EXPECT_EQ( a[ i ].qtangent[ j ], b[ i ].qtangent[ j ] );
+        }
+
+        EXPECT_EQ( a[ i ].lightColor.Red(), b[ i ].lightColor.Red() );
+        EXPECT_EQ( a[ i ].lightColor.Alpha(), b[ i ].lightColor.Alpha() );
+    }
+}
+
+void ExpectSameGrid( const srfGridMesh_t* a, const srfGridMesh_t* b )
+{
+    ASSERT_EQ( b->surfaceType, surfaceType_t::SF_GRID );
+    ASSERT_EQ( a->width, b->width );
+    ASSERT_EQ( a->height, b->height );
+    ASSERT_EQ( a->numVerts, b->numVerts );
+    ASSERT_EQ( a->numTriangles, b->numTriangles );
+
+    for ( int i = 0; i < 3; i++ ) {
+        EXPECT_EQ( a->bounds[ 0 ][ i ], b->bounds[ 0 ][ i ] );
+        EXPECT_EQ( a->bounds[ 1 ][ i ], b->bounds[ 1 ][ i ] );
+        EXPECT_EQ( a->lodOrigin[ i ], b->lodOrigin[ i ] );
+    }
+
+    EXPECT_EQ( a->lodRadius, b->lodRadius );
+    EXPECT_EQ( a->lodFixed, b->lodFixed );
+    EXPECT_EQ( a->lodStitched, b->lodStitched );
+    EXPECT_TRUE( std::equal( a->widthLodError, a->widthLodError + a->width, b->widthLodError ) );
+    EXPECT_TRUE( std::equal( a->heightLodError, a->heightLodError + a->height, b->heightLodError ) );
+
+    for ( int i = 0; i < a->numTriangles; i++ ) {
+        for ( int j = 0; j < 3; j++ ) {
+            EXPECT_EQ( a->triangles[ i ].indexes[ j ], b->triangles[ i ].indexes[ j ] );
+        }
+    }
+
+    ExpectSameVerts( a->verts, b->verts, a->numVerts );
+}
+
+TEST_F( WorldGeometryCacheTest, SameGeometry )
+{
+    MergeVertices();
+    std::string binary = BuildCache();
+
+    std::vector<int> firstIndexes;
+    for ( bspSurface_t* surface : rendererSurfaces ) {
+        firstIndexes.push_back( ( ( srfGeneric_t* ) surface->data )->firstIndex );
+    }
+
+    ResetCachedWorld();
+    ASSERT_TRUE( R_LoadWorldGridsCache( &cachedWorld, binary, CACHE_KEY ) );
+    ExpectSameGrid( ( srfGridMesh_t* ) surfaces[ 0 ].data, ( srfGridMesh_t* ) cachedSurfaces[ 0 ].data );
+    ExpectSameGrid( ( srfGridMesh_t* ) surfaces[ 3 ].data, ( srfGridMesh_t* ) cachedSurfaces[ 3 ].data );
+    EXPECT_EQ( cachedSurfaces[ 2 ].data, &skipData );
+
+    std::vector<bspSurface_t*> cachedRendererSurfaces = RendererSurfaces( &cachedWorld );
+    std::vector<srfVert_t> cachedVerts( verts.size() );
+    std::vector<glIndex_t> cachedIndices( indices.size() );
+    int cachedNumVerts;
+    ASSERT_TRUE( R_LoadWorldVertsCache( &cachedWorld, binary, CACHE_KEY, cachedRendererSurfaces.data(),
+                                        cachedRendererSurfaces.size(), cachedVerts.data(), cachedVerts.size(),
+                                        cachedIndices.data(), numIndices, cachedNumVerts ) );
+
+    ASSERT_EQ( cachedNumVerts, numVerts );
+    ExpectSameVerts( verts.data(), cachedVerts.data(), numVerts );
+    EXPECT_EQ( indices, cachedIndices );
+
+    for ( size_t i = 0; i < cachedRendererSurfaces.size(); i++ ) {
+        EXPECT_EQ( ( ( srfGeneric_t* ) cachedRendererSurfaces[ i ]->data )->firstIndex, firstIndexes[ i ] );
+    }
+}
+
+TEST_F( WorldGeometryCacheTest, StaleCache )
+{
+    MergeVertices();
+    std::string binary = BuildCache();
+    ResetCachedWorld();
+
+    // Made from another version of the map
+    EXPECT_FALSE( R_LoadWorldGridsCache( &cachedWorld, binary, "maps/test.bsp test 0.2 0 0\n" ) );
+
+    // Truncated
+    EXPECT_FALSE( R_LoadWorldGridsCache( &cachedWorld, binary.substr( 0, binary.size() - 1 ), CACHE_KEY ) );
+
+    // Not the same patch meshes
+    cachedSurfaces[ 3 ].data = surfaces[ 3 ].data;
+    EXPECT_FALSE( R_LoadWorldGridsCache( &cachedWorld, binary, CACHE_KEY ) );
+
+    // The surfaces are left for the patches to be parsed again
+    EXPECT_EQ( cachedSurfaces[ 0 ].data, nullptr );
+}
+
+// The shaders decide the order of the renderer surfaces, the cache still
+// gives each surface its own triangles
+TEST_F( WorldGeometryCacheTest, OtherSurfaceOrder )
+{
+    MergeVertices();
+    std::string binary = BuildCache();
+
+    std::vector<int> firstIndexes;
+    for ( bspSurface_t* surface : rendererSurfaces ) {
+        firstIndexes.push_back( ( ( srfGeneric_t* ) surface->data )->firstIndex );
+    }
+
+    std::vector<bspSurface_t*> otherSurfaces = { rendererSurfaces[ 2 ], rendererSurfaces[ 0 ], rendererSurfaces[ 1 ] };
+    std::vector<int> otherFirstIndexes = { firstIndexes[ 2 ], firstIndexes[ 0 ], firstIndexes[ 1 ] };
+    std::vector<srfVert_t> cachedVerts( verts.size() );
+    std::vector<glIndex_t> cachedIndices( indices.size() );
+    int cachedNumVerts;
+    ASSERT_TRUE( R_LoadWorldVertsCache( &world, binary, CACHE_KEY, otherSurfaces.data(), otherSurfaces.size(),
+                                        cachedVerts.data(), cachedVerts.size(), cachedIndices.data(), numIndices,
+                                        cachedNumVerts ) );
+    ASSERT_EQ( cachedNumVerts, numVerts );
+
+    int firstIndex = 0;
+    for ( size_t i = 0; i < otherSurfaces.size(); i++ ) {
+        srfGeneric_t* srf = ( srfGeneric_t* ) otherSurfaces[ i ]->data;
+        EXPECT_EQ( firstIndex, srf->firstIndex );
+
+        for ( int j = 0; j < srf->numTriangles * 3; j++ ) {
+            ExpectSameVerts( &verts[ indices[ otherFirstIndexes[ i ] + j ] ], &cachedVerts[ cachedIndices[ firstIndex + j ] ], 1 );
+        }
+        firstIndex += srf->numTriangles * 3;
+    }
+    EXPECT_EQ( numIndices, firstIndex );
+}
+
+TEST_F( WorldGeometryCacheTest, OtherSurfaces )
+{
+    MergeVertices();
+    std::string binary = BuildCache();
+
+    rendererSurfaces.pop_back();
+    std::vector<srfVert_t> cachedVerts( verts.size() );
+    std::vector<glIndex_t> cachedIndices( indices.size() );
+    int cachedNumVerts;
+    EXPECT_FALSE( R_LoadWorldVertsCache( &world, binary, CACHE_KEY, rendererSurfaces.data(), rendererSurfaces.size(),
+                                         cachedVerts.data(), cachedVerts.size(), cachedIndices.data(),
+                                         numIndices - 3, cachedNumVerts ) );
+}
+
+// MergeDuplicateVertices fixes the bad vertices of the surfaces, so does a cache hit
+TEST_F( WorldGeometryCacheTest, ValidatesSurfaceVertices )
+{
+    MergeVertices();
+    std::string binary = BuildCache();
+
+    srfGeneric_t* triangles = ( srfGeneric_t* ) surfaces[ 1 ].data;
+    triangles->verts[ 2 ].xyz[ 0 ] = NAN;
+    triangles->verts[ 2 ].st[ 1 ] = INFINITY;
+
+    std::vector<srfVert_t> cachedVerts( verts.size() );
+    std::vector<glIndex_t> cachedIndices( indices.size() );
+    int cachedNumVerts;
+    ASSERT_TRUE( R_LoadWorldVertsCache( &world, binary, CACHE_KEY, rendererSurfaces.data(), rendererSurfaces.size(),
+                                        cachedVerts.data(), cachedVerts.size(), cachedIndices.data(), numIndices,
+                                        cachedNumVerts ) );
+    EXPECT_EQ( 0.0f, triangles->verts[ 2 ].xyz[ 0 ] );
+    EXPECT_EQ( 0.0f, triangles->verts[ 2 ].st[ 1 ] );
+}
+
+// What R_CreateWorldVBO does: the cache is only written when it can't be used
+TEST_F( WorldGeometryCacheTest, WrittenOnlyWhenStale )
+{
+    Q_strncpyz( world.name, "maps/worldcachetest.bsp", sizeof( world.name ) );
+    const std::string cachePath = "worldcache/maps/worldcachetest.bsp.bin";
+    std::error_code ignored;
+    FS::HomePath::DeleteFile( cachePath, ignored );
+
+    rendererSurfaces = RendererSurfaces( &world );
+    int maxVerts = 0;
+    int maxIndices = 0;
+    for ( bspSurface_t* surface : rendererSurfaces ) {
+        srfGeneric_t* srf = ( srfGeneric_t* ) surface->data;
+        maxVerts += srf->numVerts;
+        maxIndices += srf->numTriangles * 3;
+    }
+    verts.resize( maxVerts );
+    indices.resize( maxIndices );
+
+    auto merge = [&]( const std::string& binary ) {
+        return R_MergeWorldVertices( &world, binary, CACHE_KEY, rendererSurfaces.data(), rendererSurfaces.size(),
+                                     verts.data(), maxVerts, indices.data(), maxIndices, numVerts, numIndices );
+    };
+
+    EXPECT_FALSE( merge( "" ) );
+    ASSERT_TRUE( FS::HomePath::FileExists( cachePath ) );
+    std::string binary = FS::HomePath::OpenRead( cachePath ).ReadAll();
+    EXPECT_EQ( maxIndices, numIndices );
+
+    // Another surface order uses the cache as it is
+    FS::HomePath::DeleteFile( cachePath );
+    std::swap( rendererSurfaces[ 0 ], rendererSurfaces[ 2 ] );
+    EXPECT_TRUE( merge( binary ) );
+    EXPECT_FALSE( FS::HomePath::FileExists( cachePath ) );
+
+    // Made with other settings
+    EXPECT_FALSE( R_MergeWorldVertices( &world, binary, "maps/worldcachetest.bsp test 0.2 0 0\n", rendererSurfaces.data(),
+                                        rendererSurfaces.size(), verts.data(), maxVerts, indices.data(), maxIndices,
+                                        numVerts, numIndices ) );
+    EXPECT_TRUE( FS::HomePath::FileExists( cachePath ) );
+    FS::HomePath::DeleteFile( cachePath );
+}
+
+} // namespace
@@ -820,6 +820,8 @@ Returns the number of msec spent in the back end
 */
 void RE_EndFrame( int *frontEndMsec, int *backEndMsec )
 {
+	PROFILE_ZONE("RE_EndFrame");
+
 	SwapBuffersCommand *cmd;
 
 	if ( !tr.registered )
@@ -1727,13 +1727,13 @@ static void R_LoadImageWithLoader( const char* fileName, const char* altName, co
 
 /*
 =================
-R_LoadImage
+R_DecodeImage
 
 Loads any of the supported image types into a canonical
 32 bit format.
 =================
 */
-static void R_LoadImage( const char *name, byte **pic, int *width, int *height,
+static void R_DecodeImage( const char *name, byte **pic, int *width, int *height,
 			 int *numLayers, int *numMips,
 			 int *bits )
 {
@@ -1810,6 +1810,294 @@ static void R_LoadImage( const char *name, byte **pic, int *width, int *height,
 	}
 }
 
+/*
+===============
+Image decode queue
+
+Decoding the images is most of the time spent loading a map. The images
+referenced by the shaders are decoded ahead on worker threads, see
+R_PrefetchImage, so that R_LoadImage only has to pick up the pixels and the
+main thread only has to upload them.
+===============
+*/
+static Cvar::Range<Cvar::Cvar<int>> r_imageDecodeThreads( "r_imageDecodeThreads",
+	"threads decoding the images referenced by shaders ahead, -1 for one per core but one, 0 to disable",
+	Cvar::NONE, -1, -1, 64 );
+
+enum class imageDecodeState_t
+{
+	QUEUED,
+	DECODING,
+	DONE,
+	FAILED,
+};
+
+struct decodedImage_t
+{
+	imageDecodeState_t state;
+	byte *pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ];
+	int width;
+	int height;
+	int numLayers;
+	int numMips;
+	int bits;
+};
+
+static struct
+{
+	std::mutex mutex;
+	std::condition_variable jobAdded;
+	std::condition_variable jobDone;
+	std::deque<std::string> jobs;
+	std::unordered_map<std::string, decodedImage_t> images;
+	int numDecoding;
+	bool quit;
+	std::vector<std::thread> threads;
+} imageDecodeQueue;
+
+static void R_FreeDecodedImage( decodedImage_t &image )
+{
+	// The loaders allocate all the mips and layers at once
+	if ( image.state == imageDecodeState_t::DONE && image.pic[ 0 ] )
+	{
+		Z_Free( image.pic[ 0 ] );
+	}
+}
+
+static void R_ImageDecodeThread()
+{
+	// The loaders drop on invalid images
+	Sys::CatchDropsOnThisThread();
+
+	auto &queue = imageDecodeQueue;
+	std::unique_lock<std::mutex> lock( queue.mutex );
+
+	while ( true )
+	{
+		queue.jobAdded.wait( lock, [&] { return queue.quit || !queue.jobs.empty(); } );
+
+		if ( queue.quit )
+		{
+			return;
+		}
+
+		std::string name = std::move( queue.jobs.front() );
+		queue.jobs.pop_front();
+		queue.images[ name ].state = imageDecodeState_t::DECODING;
+		queue.numDecoding++;
+		lock.unlock();
+
+		decodedImage_t image = {};
+		image.state = imageDecodeState_t::DONE;
+
+		try
+		{
+			R_DecodeImage( name.c_str(), image.pic, &image.width, &image.height,
+				&image.numLayers, &image.numMips, &image.bits );
+		}
+		catch ( Sys::DropErr& )
+		{
+			// It is decoded again by R_LoadImage to report the error
+			R_FreeDecodedImage( image );
+			image.state = imageDecodeState_t::FAILED;
+		}
+
+		lock.lock();
+		queue.images[ name ] = image;
+		queue.numDecoding--;
+		queue.jobDone.notify_all();
+	}
+}
+
+void R_StartImageDecodeThreads()
+{
+	int numThreads = r_imageDecodeThreads.Get();
+
+	if ( numThreads < 0 )
+	{
+		numThreads = std::max( 0, int( std::thread::hardware_concurrency() ) - 1 );
+	}
+
+	auto &queue = imageDecodeQueue;
+	queue.quit = false;
+
+	for ( int i = 0; i < numThreads; i++ )
+	{
+		queue.threads.emplace_back( R_ImageDecodeThread );
+	}
+
+	Log::Debug( "Decoding images on %d threads", numThreads );
+}
+
+void R_StopImageDecodeThreads()
+{
+	auto &queue = imageDecodeQueue;
+	R_ClearImagePrefetches();
+
+	{
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		queue.quit = true;
+	}
+
+	queue.jobAdded.notify_all();
+
+	for ( std::thread &thread : queue.threads )
+	{
+		thread.join();
+	}
+
+	queue.threads.clear();
+}
+
+/*
+===============
+R_PrefetchImage
+
+Queues the decoding of an image which is about to be loaded.
+===============
+*/
+void R_PrefetchImage( const char *imageName0 )
+{
+	auto &queue = imageDecodeQueue;
+
+	if ( queue.threads.empty() )
+	{
+		return;
+	}
+
+	std::string imageName = FS::Path::NormalizeSlashes( imageName0 );
+
+	// Already loaded, whatever the parameters
+	unsigned hash = GenerateImageHashValue( imageName.c_str() );
+
+	for ( image_t *image = r_imageHashTable[ hash ]; image; image = image->next )
+	{
+		if ( Str::IsIEqual( imageName, image->name ) )
+		{
+			return;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( queue.mutex );
+
+		if ( !queue.images.emplace( imageName, decodedImage_t{} ).second )
+		{
+			return;
+		}
+
+		queue.jobs.push_back( std::move( imageName ) );
+	}
+
+	queue.jobAdded.notify_one();
+}
+
+/*
+===============
+R_ClearImagePrefetches
+
+Drops the images decoded ahead which were not loaded, once the
+registration is done.
+===============
+*/
+void R_ClearImagePrefetches()
+{
+	auto &queue = imageDecodeQueue;
+	std::unique_lock<std::mutex> lock( queue.mutex );
+
+	queue.jobs.clear();
+	queue.jobDone.wait( lock, [&] { return queue.numDecoding == 0; } );
+
+	for ( auto &entry : queue.images )
+	{
+		R_FreeDecodedImage( entry.second );
+	}
+
+	queue.images.clear();
+}
+
+/*
+===============
+R_FinishImagePrefetches
+
+Waits until the queued images are decoded, returns the number of images
+ready to be loaded.
+===============
+*/
+size_t R_FinishImagePrefetches()
+{
+	auto &queue = imageDecodeQueue;
+	std::unique_lock<std::mutex> lock( queue.mutex );
+
+	queue.jobDone.wait( lock, [&] { return queue.jobs.empty() && queue.numDecoding == 0; } );
+
+	return std::count_if( queue.images.begin(), queue.images.end(), []( const std::pair<const std::string, decodedImage_t> &entry ) {
+		return entry.second.state == imageDecodeState_t::DONE;
+	} );
+}
+
+// Gets the image from the decode queue if it was prefetched
+static bool R_TakeDecodedImage( const char *name, byte **pic, int *width, int *height,
+	int *numLayers, int *numMips, int *bits )
+{
+	auto &queue = imageDecodeQueue;
+	std::unique_lock<std::mutex> lock( queue.mutex );
+
+	auto it = queue.images.find( name );
+
+	if ( it == queue.images.end() )
+	{
+		return false;
+	}
+
+	// Don't wait for the images queued before it
+	if ( it->second.state == imageDecodeState_t::QUEUED )
+	{
+		queue.jobs.erase( std::find( queue.jobs.begin(), queue.jobs.end(), it->first ) );
+		queue.images.erase( it );
+		return false;
+	}
+
+	queue.jobDone.wait( lock, [&] { return it->second.state != imageDecodeState_t::DECODING; } );
+
+	decodedImage_t image = it->second;
+	queue.images.erase( it );
+
+	if ( image.state == imageDecodeState_t::FAILED )
+	{
+		return false;
+	}
+
+	// Give the same results as the loader
+	pic[ 0 ] = image.pic[ 0 ];
+
+	for ( int i = 1; i < MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS && image.pic[ i ]; i++ )
+	{
+		pic[ i ] = image.pic[ i ];
+	}
+
+	*width = image.width;
+	*height = image.height;
+	*numLayers = image.numLayers;
+	*numMips = image.numMips;
+	*bits |= image.bits;
+
+	return true;
+}
+
+void R_LoadImage( const char *name, byte **pic, int *width, int *height,
+	int *numLayers, int *numMips, int *bits )
+{
+	// Cached images in the homepath are never prefetched
+	if ( !( *bits & IF_HOMEPATH ) && name
+		&& R_TakeDecodedImage( name, pic, width, height, numLayers, numMips, bits ) )
+	{
+		return;
+	}
+
+	R_DecodeImage( name, pic, width, height, numLayers, numMips, bits );
+}
+
 /*
 ===============
 R_FindImageFile
@@ -2205,6 +2493,15 @@ image_t *R_FindCubeImage( const char *name, imageParams_t &imageParams )
 			pic[ i ] = nullptr;
 		}
 
+		// Decode the faces in parallel, the missing ones are quickly skipped
+		for ( const multifileCubeMapFormat_t &format : multifileCubeMapFormats )
+		{
+			for ( const char *suffix : format.suffixes )
+			{
+				R_PrefetchImage( Str::Format( "%s%s%s", name, format.sep, suffix ).c_str() );
+			}
+		}
+
 		for ( const multifileCubeMapFormat_t &format : multifileCubeMapFormats )
 		{
 			int greatestEdge = 0;
@@ -2801,6 +3098,8 @@ void R_InitImages()
 
 	// create default texture and white texture
 	R_CreateBuiltinImages();
+
+	R_StartImageDecodeThreads();
 }
 
 /*
@@ -2812,6 +3111,8 @@ void R_ShutdownImages()
 {
 	Log::Debug("------- R_ShutdownImages -------" );
 
+	R_StopImageDecodeThreads();
+
 	for ( image_t *image : tr.images )
 	{
 		if ( image->texture->IsResident() ) {
@@ -0,0 +1,188 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/FileSystem.h"
+
+#include "engine/renderer/tr_local.h"
+
+namespace {
+
+struct DecodedImage
+{
+    byte* pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ] = {};
+    int width = 0;
+    int height = 0;
+    int numLayers = 0;
+    int numMips = 0;
+    int bits = IF_NONE;
+
+    explicit DecodedImage(const std::string& name)
+    {
+        R_LoadImage(name.c_str(), pic, &width, &height, &numLayers, &numMips, &bits);
+    }
+
+    ~DecodedImage()
+    {
+        if (pic[0]) {
+            Z_Free(pic[0]);
+        }
+    }
+};
+
+// Decodes the test images through the decode queue and serially.
+class ImageDecodeTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        const FS::PakInfo* pak = FS::FindPak("testdata", "src");
+        if (!pak) {
+            FAIL() << "Test data not available - some tests will be skipped. Please add daemon/pkg/ to the pak path";
+        }
+        FS::PakPath::LoadPak(*pak);
+    }
+
+    void SetUp() override
+    {
+        for (const std::string& filename : FS::PakPath::ListFiles("textures/imagedecode")) {
+            images.push_back("textures/imagedecode/" + filename);
+        }
+        ASSERT_FALSE(images.empty());
+
+        Cvar::SetValue("r_imageDecodeThreads", "2");
+        R_StartImageDecodeThreads();
+    }
+
+    void TearDown() override
+    {
+        R_StopImageDecodeThreads();
+        Cvar::SetValue("r_imageDecodeThreads", "-1");
+    }
+
+    std::vector<std::string> images;
+};
+
+TEST_F(ImageDecodeTest, SameAsSerial)
+{
+    for (const std::string& name : images) {
+        R_PrefetchImage(name.c_str());
+    }
+
+    size_t numDecoded = R_FinishImagePrefetches();
+    ASSERT_EQ(images.size(), numDecoded);
+
+    for (const std::string& name : images) {
+        // The first load picks up the prefetched image, the second one decodes it again
+        DecodedImage queued(name);
+        EXPECT_EQ(--numDecoded, R_FinishImagePrefetches()) << name << " was not taken from the decode queue";
+        DecodedImage serial(name);
+
+        ASSERT_NE(queued.pic[0], nullptr) << name;
+        ASSERT_NE(serial.pic[0], nullptr) << name;
+        EXPECT_NE(queued.pic[0], serial.pic[0]) << name;
+        EXPECT_EQ(queued.width, serial.width) << name;
+        EXPECT_EQ(queued.height, serial.height) << name;
+        EXPECT_EQ(queued.numLayers, serial.numLayers) << name;
+        EXPECT_EQ(queued.numMips, serial.numMips) << name;
+        EXPECT_EQ(queued.bits, serial.bits) << name;
+        EXPECT_EQ(0, memcmp(queued.pic[0], serial.pic[0], serial.width * serial.height * 4)) << name;
+    }
+}
+
+TEST_F(ImageDecodeTest, MissingImage)
+{
+    R_PrefetchImage("textures/imagedecode/missing");
+
+    DecodedImage image("textures/imagedecode/missing");
+    EXPECT_EQ(image.pic[0], nullptr);
+}
+
+TEST_F(ImageDecodeTest, CorruptImage)
+{
+    const char* name = "textures/imagedecode_corrupt/corrupt.tga";
+
+    // The decode thread fails without bringing the engine down
+    R_PrefetchImage(name);
+    EXPECT_EQ(0U, R_FinishImagePrefetches());
+
+    // Then the error is reported when the image is loaded
+    EXPECT_THROW(DecodedImage image(name), Sys::DropErr);
+}
+
+TEST_F(ImageDecodeTest, ClearPrefetches)
+{
+    for (const std::string& name : images) {
+        R_PrefetchImage(name.c_str());
+    }
+
+    // Whatever was decoded is dropped and the images are decoded again
+    R_ClearImagePrefetches();
+
+    for (const std::string& name : images) {
+        DecodedImage image(name);
+        EXPECT_NE(image.pic[0], nullptr) << name;
+    }
+}
+
+TEST_F(ImageDecodeTest, DISABLED_Benchmark)
+{
+    constexpr int ROUNDS = 200;
+
+    auto start = Sys::SteadyClock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+        for (const std::string& name : images) {
+            DecodedImage image(name);
+        }
+    }
+    auto serial = Sys::SteadyClock::now() - start;
+
+    start = Sys::SteadyClock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+        for (const std::string& name : images) {
+            R_PrefetchImage(name.c_str());
+        }
+        for (const std::string& name : images) {
+            DecodedImage image(name);
+        }
+    }
+    auto queued = Sys::SteadyClock::now() - start;
+
+    Log::Notice("decoded %d images: %d us serially, %d us with the decode queue",
+        int(ROUNDS * images.size()),
+        int(std::chrono::duration_cast<std::chrono::microseconds>(serial).count()),
+        int(std::chrono::duration_cast<std::chrono::microseconds>(queued).count()));
+}
+
+} // namespace
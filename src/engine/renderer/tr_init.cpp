@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "GeometryCache.h"
 #include "GeometryOptimiser.h"
 #include "EntityCache.h"
+#include "VideoFrameEncoder.h"
 
 #ifdef _WIN32
 	extern "C" {
@@ -339,6 +340,31 @@ Cvar::Cvar<int> r_rendererAPI( "r_rendererAPI", "Renderer API: 0: OpenGL, 1: Vul
 		}
 	}
 
+	/*
+	** R_PakFileCacheKey
+	**
+	** Identifies the version of a file of the paks, for the caches of data
+	** derived from it in the homepath. The file contents are expected to
+	** change with the pak version or, for pakdirs, with the file timestamp,
+	** which is taken with its sub-second part for the files rewritten quickly.
+	*/
+	std::string R_PakFileCacheKey( Str::StringRef path )
+	{
+		const FS::LoadedPakInfo *pak = FS::PakPath::LocateFile( path );
+
+		if ( !pak )
+		{
+			return "";
+		}
+
+		std::error_code err;
+		auto timestamp = FS::PakPath::FileTimestamp( path, err );
+
+		return Str::Format( "%s %s %s %u %d\n", path, pak->name, pak->version,
+			pak->realChecksum ? *pak->realChecksum : 0,
+			std::chrono::duration_cast<std::chrono::nanoseconds>( timestamp.time_since_epoch() ).count() );
+	}
+
 	/*
 	** InitOpenGL
 	**
@@ -780,6 +806,57 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 
 //============================================================================
 
+static Cvar::Range<Cvar::Cvar<int>> r_videoEncodeThreads( "r_videoEncodeThreads",
+	"threads encoding the motion JPEG video frames, -1 for one per core but one, 0 to encode on the render thread",
+	Cvar::NONE, -1, -1, 32 );
+
+static std::unique_ptr<VideoFrameEncoder> videoFrameEncoder;
+
+/*
+==================
+R_EncodeVideoFrame
+
+The frames are encoded on the encoder threads and written in order
+by the backend once they are done, a few frames later
+==================
+*/
+static void R_EncodeVideoFrame( const byte *pixels, int width, int height, int stride )
+{
+	if ( !videoFrameEncoder )
+	{
+		int numThreads = r_videoEncodeThreads.Get();
+
+		if ( numThreads < 0 )
+		{
+			numThreads = std::max( 0, int( std::thread::hardware_concurrency() ) - 1 );
+		}
+
+		videoFrameEncoder.reset( new VideoFrameEncoder( numThreads, 2 * numThreads, 90,
+			[]( const byte *data, int size ) { ri.CL_WriteAVIVideoFrame( data, size ); } ) );
+	}
+
+	videoFrameEncoder->Submit( pixels, width, height, stride );
+	videoFrameEncoder->WriteFrames( false );
+}
+
+/*
+==================
+RE_FinishVideoFrames
+
+Writes the frames still being encoded, before the video is closed
+==================
+*/
+void RE_FinishVideoFrames()
+{
+	R_SyncRenderThread();
+
+	if ( videoFrameEncoder )
+	{
+		videoFrameEncoder->WriteFrames( true );
+		videoFrameEncoder.reset();
+	}
+}
+
 	/*
 	==================
 	RB_TakeVideoFrameCmd
@@ -791,7 +868,6 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 		int                       lineLen, captureLineLen;
 		byte                      *pixels;
 		int                       i;
-		int                       outputSize;
 		int                       j;
 		int                       aviLineLen;
 
@@ -811,14 +887,7 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 
 			if ( motionJpeg )
 			{
-				// Drop alignment and line padding bytes
-				for ( i = 0; i < height; ++i )
-				{
-					memmove( captureBuffer + i * lineLen, pixels + i * captureLineLen, lineLen );
-				}
-
-				outputSize = SaveJPGToBuffer( encodeBuffer, 3 * width * height, 90, width, height, captureBuffer );
-				ri.CL_WriteAVIVideoFrame( encodeBuffer, outputSize );
+				R_EncodeVideoFrame( pixels, width, height, captureLineLen );
 			}
 			else
 			{
@@ -1527,7 +1596,7 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 
 		if ( tr.registered )
 		{
-			R_SyncRenderThread();
+			RE_FinishVideoFrames();
 
 			CIN_CloseAllVideos();
 			R_ShutdownBackend();
@@ -1537,6 +1606,7 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 			R_ShutdownVisTests();
 		}
 
+		R_ClearSkeletonCache();
 		R_DoneFreeType();
 
 		if ( glConfig.usingMaterialSystem ) {
@@ -1568,6 +1638,8 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 	void RE_EndRegistration()
 	{
 		R_SyncRenderThread();
+		R_ClearImagePrefetches();
+
 		if ( r_lazyShaders.Get() == 1 ) {
 			if ( tr.world->numFogs > 0 )
 			{
@@ -1664,6 +1736,10 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 
 		re.RegisterSkin = RE_RegisterSkin;
 		re.RegisterShader = RE_RegisterShader;
+		re.PrefetchModel = RE_PrefetchModel;
+		re.PrefetchFile = RE_PrefetchFile;
+		re.PrefetchShader = RE_PrefetchShader;
+		re.ClearPrefetchedFiles = RE_ClearPrefetchedFiles;
 
 		re.LoadWorld = RE_LoadWorldMap;
 		re.SetWorldVisData = RE_SetWorldVisData;
@@ -1711,6 +1787,7 @@ ScreenshotCmd screenshotPNGRegistration("screenshotPNG", ssFormat_t::SSF_PNG, "p
 
 		// XreaL BEGIN
 		re.TakeVideoFrame = RE_TakeVideoFrame;
+		re.FinishVideoFrames = RE_FinishVideoFrames;
 
 		re.RegisterAnimation = RE_RegisterAnimation;
 		re.CheckSkeleton = RE_CheckSkeleton;
@@ -697,7 +697,7 @@ enum class ssaoMode {
 	  CGEN_CUSTOM_RGBs, // multiple expressions
 	};
 
-	enum class opcode_t
+	enum class opcode_t : uint8_t
 	{
 	  OP_BAD,
 	  // logic operators
@@ -775,13 +775,49 @@ enum
 	EXP_SRGB = BIT( 1 ),
 };
 
+	// What the value of a compiled expression depends on
+	enum class expDependency_t : uint8_t
+	{
+	  EXP_CONSTANT,    // folded when parsing the shader
+	  EXP_PER_FRAME,   // time and blending mode, cached until they change
+	  EXP_PER_ENTITY,  // entity parms, run for every draw
+	  EXP_INTERPRETED  // didn't fit in the bytecode, uses RB_InterpretExpression
+	};
+
+	// A register instruction of a compiled expression: variables are loaded
+	// into dest, operators compute dest from src1 and src2. An operand equal
+	// to EXP_IMMEDIATE is the folded constant in value instead of a register,
+	// and value is the table index for OP_TABLE.
+#define EXP_IMMEDIATE 0xff
+	struct expInstruction_t
+	{
+		opcode_t type;
+		uint8_t  dest;
+		uint8_t  src1;
+		uint8_t  src2;
+		float    value;
+	};
+
 #define MAX_EXPRESSION_OPS 32
+#define MAX_EXPRESSION_CODE 16
 	struct expression_t
 	{
 		expOperation_t ops[ MAX_EXPRESSION_OPS ];
 		size_t numOps;
 		int bits;
 
+		// Filled by R_CompileExpression from the postfix ops
+		expInstruction_t code[ MAX_EXPRESSION_CODE ];
+		uint8_t numCode;
+		expDependency_t dependency;
+		float constant;
+
+		// Result of a per-frame expression for the last time and blending mode
+		mutable bool cacheValid;
+		mutable bool cachedLinearBlending;
+		mutable float cachedTime;
+		mutable float cachedValue;
+
 		bool operator==( const expression_t& other ) {
 			if ( numOps != other.numOps ) {
 				return false;
@@ -2976,6 +3012,10 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	void      RE_SetWorldVisData( const byte *vis );
 	qhandle_t RE_RegisterModel( const char *name );
 	qhandle_t RE_RegisterSkin( const char *name );
+	void      RE_PrefetchModel( const char *name );
+	void      RE_PrefetchFile( const char *name );
+	void      RE_ClearPrefetchedFiles();
+	std::string R_ReadPrefetchedFile( const char *name, std::error_code &err );
 	void      RE_Shutdown( bool destroyWindow );
 
 	void R_ProcessLightmap( byte *bytes, int width, int height, int bits ); // Arnout
@@ -2985,6 +3025,18 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	bool   R_Init();
 
 	void AssertCvarRange( cvar_t *cv, float minVal, float maxVal, bool shouldBeIntegral );
+	std::string R_PakFileCacheKey( Str::StringRef path );
+
+	std::string R_BuildWorldGeometryCache( const world_t *world, const std::string &key,
+		bspSurface_t **rendererSurfaces, int numSurfaces,
+		const srfVert_t *verts, int numVerts, const glIndex_t *indices, int numIndices );
+	bool R_LoadWorldGridsCache( world_t *world, const std::string &binary, const std::string &key );
+	bool R_LoadWorldVertsCache( const world_t *world, const std::string &binary, const std::string &key,
+		bspSurface_t **rendererSurfaces, int numSurfaces,
+		srfVert_t *verts, int maxVerts, glIndex_t *indices, int numIndices, int &numVertsOut );
+	bool R_MergeWorldVertices( const world_t *world, const std::string &binary, const std::string &key,
+		bspSurface_t **rendererSurfaces, int numSurfaces,
+		srfVert_t *verts, int maxVerts, glIndex_t *indices, int maxIndices, int &numVerts, int &numIndices );
 
 	bool   R_GetModeInfo( int *width, int *height, int mode );
 
@@ -3005,6 +3057,13 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	image_t *R_FindImageFile( const char *name, imageParams_t &imageParams );
 	image_t *R_FindCubeImage( const char *name, imageParams_t &imageParams );
 
+	void R_StartImageDecodeThreads();
+	void R_StopImageDecodeThreads();
+	void R_PrefetchImage( const char *name );
+	void R_ClearImagePrefetches();
+	size_t R_FinishImagePrefetches();
+	void R_LoadImage( const char *name, byte **pic, int *width, int *height, int *numLayers, int *numMips, int *bits );
+
 	image_t *R_CreateImage( const char *name, const byte **pic, int width, int height, int numMips, const imageParams_t &imageParams,
 		const uint32_t samples = 0, const bool fixedSampleLocations = true );
 
@@ -3031,11 +3090,14 @@ void GL_CompressedTexSubImage3D( GLenum target, GLint level, GLint xOffset, GLin
 	*/
 	qhandle_t RE_RegisterShader( const char *name, int flags );
 	qhandle_t RE_RegisterShaderFromImage( const char *name, image_t *image );
+	void      RE_PrefetchShader( const char *name );
 
 	shader_t  *R_FindShader( const char *name, int flags );
 	shader_t  *R_GetShaderByHandle( qhandle_t hShader );
 	const char *RE_GetShaderNameFromHandle( qhandle_t shader );
 	void      R_InitShaders();
+	bool      R_ScanShaderFiles( bool useCache );
+	const char *FindShaderInShaderText( const char *shaderName );
 	void      R_RemapShader( const char *oldShader, const char *newShader, const char *timeOffset );
 
 	/*
@@ -3378,6 +3440,7 @@ void GLimp_LogComment_( std::string comment );
 	int             RE_CheckSkeleton( refSkeleton_t *skel, qhandle_t hModel, qhandle_t hAnim );
 	int             RE_BuildSkeleton( refSkeleton_t *skel, qhandle_t anim, int startFrame, int endFrame, float frac,
 	                                  bool clearOrigin );
+	void            R_ClearSkeletonCache();
 	void R_TransformSkeleton( refSkeleton_t* skel, const float scale );
 	int             RE_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float frac );
 	int             RE_AnimNumFrames( qhandle_t hAnim );
@@ -3402,7 +3465,9 @@ void GLimp_LogComment_( std::string comment );
 
 	float    RB_EvalWaveForm( const waveForm_t *wf );
 	float    RB_EvalWaveFormClamped( const waveForm_t *wf );
+	bool     R_CompileExpression( expression_t *exp );
 	float    RB_EvalExpression( const expression_t *exp, float defaultValue );
+	float    RB_InterpretExpression( const expression_t *exp, float defaultValue );
 
 	void     RB_CalcTexMatrix( const textureBundle_t *bundle, matrix_t matrix );
 
@@ -3672,6 +3737,7 @@ void GLimp_LogComment_( std::string comment );
 
 // video stuff
 	void       RE_TakeVideoFrame( int width, int height, byte *captureBuffer, byte *encodeBuffer, bool motionJpeg );
+	void       RE_FinishVideoFrames();
 
 // cubemap reflections stuff
 	void R_BuildCubeMaps();
@@ -72,6 +72,110 @@ model_t        *R_AllocModel()
 	return mod;
 }
 
+/*
+====================
+R_MD3FileName
+
+The file of a LoD of an MD3 model: the name ending with a 3 for LoD 0,
+name_1.md3 for LoD 1...
+====================
+*/
+static std::string R_MD3FileName( const char *name, int lod )
+{
+	std::string filename = name;
+
+	if ( lod != 0 )
+	{
+		size_t dot = filename.rfind( '.' );
+
+		if ( dot != std::string::npos )
+		{
+			filename.erase( dot );
+		}
+
+		filename += Str::Format( "_%d.md3", lod );
+	}
+
+	filename.back() = '3'; // try MD3 first
+
+	return filename;
+}
+
+/*
+====================
+Asset prefetching
+
+When the cgame registers many assets at once, their files are read on worker
+threads with RE_PrefetchModel and RE_PrefetchFile. The registration functions
+then get them from R_ReadPrefetchedFile and only have to parse them. The
+files which were not used are dropped by RE_ClearPrefetchedFiles.
+====================
+*/
+static std::mutex prefetchMutex;
+static std::unordered_map<std::string, std::string> prefetchedFiles;
+
+void RE_PrefetchFile( const char *name )
+{
+	std::error_code err;
+	std::string buffer = FS::PakPath::ReadFile( name, err );
+
+	// Missing files are looked for again when registering
+	if ( err )
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock( prefetchMutex );
+	prefetchedFiles[ name ] = std::move( buffer );
+}
+
+void RE_PrefetchModel( const char *name )
+{
+	if ( !name[ 0 ] || strlen( name ) >= MAX_QPATH )
+	{
+		return;
+	}
+
+	if ( strstr( name, ".iqm" ) || strstr( name, ".md5mesh" ) )
+	{
+		RE_PrefetchFile( name );
+		return;
+	}
+
+	for ( int lod = 0; lod < MD3_MAX_LODS; lod++ )
+	{
+		RE_PrefetchFile( R_MD3FileName( name, lod ).c_str() );
+	}
+}
+
+void RE_ClearPrefetchedFiles()
+{
+	{
+		std::lock_guard<std::mutex> lock( prefetchMutex );
+		prefetchedFiles.clear();
+	}
+
+	R_ClearImagePrefetches();
+}
+
+std::string R_ReadPrefetchedFile( const char *name, std::error_code &err )
+{
+	{
+		std::lock_guard<std::mutex> lock( prefetchMutex );
+		auto it = prefetchedFiles.find( name );
+
+		if ( it != prefetchedFiles.end() )
+		{
+			std::string buffer = std::move( it->second );
+			prefetchedFiles.erase( it );
+			err.clear();
+			return buffer;
+		}
+	}
+
+	return FS::PakPath::ReadFile( name, err );
+}
+
 /*
 ====================
 RE_RegisterModel
@@ -144,7 +248,7 @@ qhandle_t RE_RegisterModel( const char *name )
 
 		loaded = false;
 		std::error_code err;
-		std::string buffer = FS::PakPath::ReadFile( name, err );
+		std::string buffer = R_ReadPrefetchedFile( name, err );
 
 		if ( !err )
 		{
@@ -165,27 +269,10 @@ qhandle_t RE_RegisterModel( const char *name )
 
 	for ( lod = MD3_MAX_LODS - 1; lod >= 0; lod-- )
 	{
-		char filename[ 1024 ];
-
-		strcpy( filename, name );
-
-		if ( lod != 0 )
-		{
-			char namebuf[ 80 ];
-
-			if ( strrchr( filename, '.' ) )
-			{
-				*strrchr( filename, '.' ) = 0;
-			}
-
-			Com_sprintf( namebuf, sizeof( namebuf ), "_%d.md3", lod );
-			strcat( filename, namebuf );
-		}
-
-		filename[ strlen( filename ) - 1 ] = '3';  // try MD3 first
+		std::string filename = R_MD3FileName( name, lod );
 
 		std::error_code err;
-		std::string buffer = FS::PakPath::ReadFile( filename, err );
+		std::string buffer = R_ReadPrefetchedFile( filename.c_str(), err );
 
 		// LoDs are optional
 		if ( err )
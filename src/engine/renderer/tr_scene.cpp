@@ -589,6 +589,8 @@ to handle mirrors,
 */
 void RE_RenderScene( const refdef_t *fd )
 {
+	PROFILE_ZONE("RE_RenderScene");
+
 	int         startTime;
 
 	if ( !tr.registered )
@@ -210,7 +210,316 @@ static float GetOpValue( const expOperation_t *op )
 
 const char* GetOpName(opcode_t type);
 
-static float EvalExpression( const expression_t *exp, float defaultValue )
+static float LookupTable( int tableIndex, float value )
+{
+	shaderTable_t *table = tr.shaderTables[ tableIndex ];
+	int numValues = table->numValues;
+
+	float index = value * numValues; // float index into the table?s elements
+	float lerp = index - floor( index );  // being inbetween two elements of the table
+
+	int oldIndex = ( int ) index;
+	int newIndex = ( int ) index + 1;
+
+	if ( table->clamp )
+	{
+		// clamp indices to table-range
+		oldIndex = Math::Clamp( oldIndex, 0, numValues - 1 );
+		newIndex = Math::Clamp( newIndex, 0, numValues - 1 );
+	}
+	else
+	{
+		// wrap around indices
+		oldIndex %= numValues;
+		newIndex %= numValues;
+	}
+
+	if ( table->snap )
+	{
+		// use fixed value
+		return table->values[ oldIndex ];
+	}
+
+	// lerp value
+	return table->values[ oldIndex ] + ( ( table->values[ newIndex ] - table->values[ oldIndex ] ) * lerp );
+}
+
+static float ApplyOperator( opcode_t type, float value1, float value2 )
+{
+	switch ( type )
+	{
+		case opcode_t::OP_LAND:
+			return value1 && value2;
+
+		case opcode_t::OP_LOR:
+			return value1 || value2;
+
+		case opcode_t::OP_GE:
+			return value1 >= value2;
+
+		case opcode_t::OP_LE:
+			return value1 <= value2;
+
+		case opcode_t::OP_LEQ:
+			return value1 == value2;
+
+		case opcode_t::OP_LNE:
+			return value1 != value2;
+
+		case opcode_t::OP_ADD:
+			return value1 + value2;
+
+		case opcode_t::OP_SUB:
+			return value1 - value2;
+
+		case opcode_t::OP_DIV:
+			// don't divide by zero
+			return value2 == 0 ? value1 : value1 / value2;
+
+		case opcode_t::OP_MOD:
+			// same for the integer division
+			return ( int ) value2 == 0 ? value1 : ( float )( ( int ) value1 % ( int ) value2 );
+
+		case opcode_t::OP_MUL:
+			return value1 * value2;
+
+		case opcode_t::OP_LT:
+			return value1 < value2;
+
+		case opcode_t::OP_GT:
+			return value1 > value2;
+
+		default:
+			return 0;
+	}
+}
+
+// Dependency of the value of an operand, OP_NUM and the opcodes that are
+// constant in this renderer are folded.
+static expDependency_t GetOpDependency( opcode_t type )
+{
+	switch ( type )
+	{
+		case opcode_t::OP_TIME:
+		case opcode_t::OP_NAIVE_BLENDING:
+		case opcode_t::OP_LINEAR_BLENDING:
+			return expDependency_t::EXP_PER_FRAME;
+
+		case opcode_t::OP_PARM0:
+		case opcode_t::OP_PARM1:
+		case opcode_t::OP_PARM2:
+		case opcode_t::OP_PARM3:
+		case opcode_t::OP_PARM4:
+			return expDependency_t::EXP_PER_ENTITY;
+
+		default:
+			return expDependency_t::EXP_CONSTANT;
+	}
+}
+
+/*
+===============
+R_CompileExpression
+
+Turns the postfix ops of an expression into register instructions, the
+register of a value being its depth in the stack of the interpreter.
+Constant subexpressions are evaluated here. Returns false if the ops are
+not a valid postfix expression.
+===============
+*/
+bool R_CompileExpression( expression_t *exp )
+{
+	struct stackValue_t
+	{
+		bool  constant;
+		float value;
+	};
+
+	stackValue_t stack[ MAX_EXPRESSION_OPS ];
+	size_t depth = 0;
+	bool overflow = false;
+
+	exp->numCode = 0;
+	exp->dependency = expDependency_t::EXP_CONSTANT;
+	exp->constant = 0;
+	exp->cacheValid = false;
+
+	auto emit = [ & ]( opcode_t type, size_t dest, uint8_t src1, uint8_t src2, float value )
+	{
+		if ( exp->numCode == MAX_EXPRESSION_CODE )
+		{
+			overflow = true;
+			return;
+		}
+
+		expInstruction_t &instruction = exp->code[ exp->numCode++ ];
+		instruction.type = type;
+		instruction.dest = dest;
+		instruction.src1 = src1;
+		instruction.src2 = src2;
+		instruction.value = value;
+	};
+
+	for ( size_t i = 0; i < exp->numOps; i++ )
+	{
+		const expOperation_t &op = exp->ops[ i ];
+
+		switch ( op.type )
+		{
+			case opcode_t::OP_BAD:
+				return false;
+
+			case opcode_t::OP_NEG:
+			case opcode_t::OP_TABLE:
+				{
+					if ( depth < 1 )
+					{
+						return false;
+					}
+
+					stackValue_t &value = stack[ depth - 1 ];
+
+					if ( value.constant )
+					{
+						value.value = op.type == opcode_t::OP_NEG ? -value.value : LookupTable( ( int ) op.value, value.value );
+					}
+					else
+					{
+						emit( op.type, depth - 1, depth - 1, EXP_IMMEDIATE, op.value );
+					}
+
+					break;
+				}
+
+			case opcode_t::OP_LAND:
+			case opcode_t::OP_LOR:
+			case opcode_t::OP_GE:
+			case opcode_t::OP_LE:
+			case opcode_t::OP_LEQ:
+			case opcode_t::OP_LNE:
+			case opcode_t::OP_ADD:
+			case opcode_t::OP_SUB:
+			case opcode_t::OP_DIV:
+			case opcode_t::OP_MOD:
+			case opcode_t::OP_MUL:
+			case opcode_t::OP_LT:
+			case opcode_t::OP_GT:
+				{
+					if ( depth < 2 )
+					{
+						return false;
+					}
+
+					stackValue_t &value1 = stack[ depth - 2 ];
+					stackValue_t &value2 = stack[ depth - 1 ];
+
+					if ( value1.constant && value2.constant )
+					{
+						value1.value = ApplyOperator( op.type, value1.value, value2.value );
+					}
+					else
+					{
+						// at most one of them is folded so they can share the immediate
+						float immediate = value1.constant ? value1.value : value2.value;
+						emit( op.type, depth - 2,
+						      value1.constant ? EXP_IMMEDIATE : depth - 2,
+						      value2.constant ? EXP_IMMEDIATE : depth - 1, immediate );
+						value1.constant = false;
+					}
+
+					depth--;
+					break;
+				}
+
+			default:
+				{
+					expDependency_t dependency = GetOpDependency( op.type );
+
+					if ( dependency == expDependency_t::EXP_CONSTANT )
+					{
+						expOperation_t constantOp = op;
+						stack[ depth ] = { true, GetOpValue( &constantOp ) };
+					}
+					else
+					{
+						emit( op.type, depth, EXP_IMMEDIATE, EXP_IMMEDIATE, 0 );
+						stack[ depth ] = { false, 0 };
+						exp->dependency = std::max( exp->dependency, dependency );
+					}
+
+					depth++;
+					break;
+				}
+		}
+	}
+
+	if ( depth < 1 )
+	{
+		return false;
+	}
+
+	// like the interpreter, the result is the bottom of the stack
+	if ( stack[ 0 ].constant )
+	{
+		exp->numCode = 0;
+		exp->dependency = expDependency_t::EXP_CONSTANT;
+		exp->constant = stack[ 0 ].value;
+	}
+	else if ( overflow )
+	{
+		exp->numCode = 0;
+		exp->dependency = expDependency_t::EXP_INTERPRETED;
+	}
+
+	return true;
+}
+
+static float RunExpression( const expression_t *exp )
+{
+	float registers[ MAX_EXPRESSION_OPS ];
+
+	for ( size_t i = 0; i < exp->numCode; i++ )
+	{
+		const expInstruction_t &instruction = exp->code[ i ];
+
+		switch ( instruction.type )
+		{
+			case opcode_t::OP_NEG:
+				registers[ instruction.dest ] = -registers[ instruction.src1 ];
+				break;
+
+			case opcode_t::OP_TABLE:
+				registers[ instruction.dest ] = LookupTable( ( int ) instruction.value, registers[ instruction.src1 ] );
+				break;
+
+			case opcode_t::OP_TIME:
+			case opcode_t::OP_PARM0:
+			case opcode_t::OP_PARM1:
+			case opcode_t::OP_PARM2:
+			case opcode_t::OP_PARM3:
+			case opcode_t::OP_PARM4:
+			case opcode_t::OP_NAIVE_BLENDING:
+			case opcode_t::OP_LINEAR_BLENDING:
+				{
+					expOperation_t op = { instruction.type, 0 };
+					registers[ instruction.dest ] = GetOpValue( &op );
+					break;
+				}
+
+			default:
+				{
+					float value1 = instruction.src1 == EXP_IMMEDIATE ? instruction.value : registers[ instruction.src1 ];
+					float value2 = instruction.src2 == EXP_IMMEDIATE ? instruction.value : registers[ instruction.src2 ];
+					registers[ instruction.dest ] = ApplyOperator( instruction.type, value1, value2 );
+					break;
+				}
+		}
+	}
+
+	return registers[ 0 ];
+}
+
+float RB_InterpretExpression( const expression_t *exp, float defaultValue )
 {
 	ASSERT( exp );
 
@@ -291,13 +600,6 @@ static float EvalExpression( const expression_t *exp, float defaultValue )
 
 			case opcode_t::OP_TABLE:
 				{
-					shaderTable_t *table;
-					int           numValues;
-					float         index;
-					float         lerp;
-					int           oldIndex;
-					int           newIndex;
-
 					if ( numOps < 1 )
 					{
 						Log::Warn("shader %s has numOps < 1 for table operator", tess.surfaceShader->name );
@@ -307,41 +609,7 @@ static float EvalExpression( const expression_t *exp, float defaultValue )
 					value1 = GetOpValue( &ops[ numOps - 1 ] );
 					numOps--;
 
-					table = tr.shaderTables[( int ) op.value ];
-
-					numValues = table->numValues;
-
-					index = value1 * numValues; // float index into the table?s elements
-					lerp = index - floor( index );  // being inbetween two elements of the table
-
-					oldIndex = ( int ) index;
-					newIndex = ( int ) index + 1;
-
-					if ( table->clamp )
-					{
-						// clamp indices to table-range
-						oldIndex = Math::Clamp( oldIndex, 0, numValues - 1 );
-						newIndex = Math::Clamp( newIndex, 0, numValues - 1 );
-					}
-					else
-					{
-						// wrap around indices
-						oldIndex %= numValues;
-						newIndex %= numValues;
-					}
-
-					if ( table->snap )
-					{
-						// use fixed value
-						value = table->values[ oldIndex ];
-					}
-					else
-					{
-						// lerp value
-						value = table->values[ oldIndex ] + ( ( table->values[ newIndex ] - table->values[ oldIndex ] ) * lerp );
-					}
-
-					//Log::Notice("%s: %i %i %f", table->name, oldIndex, newIndex, value);
+					value = LookupTable( ( int ) op.value, value1 );
 
 					// push result
 					op.type = opcode_t::OP_NUM;
@@ -365,73 +633,7 @@ static float EvalExpression( const expression_t *exp, float defaultValue )
 					value1 = GetOpValue( &ops[ numOps - 1 ] );
 					numOps--;
 
-					switch ( op.type )
-					{
-						case opcode_t::OP_LAND:
-							value = value1 && value2;
-							break;
-
-						case opcode_t::OP_LOR:
-							value = value1 || value2;
-							break;
-
-						case opcode_t::OP_GE:
-							value = value1 >= value2;
-							break;
-
-						case opcode_t::OP_LE:
-							value = value1 <= value2;
-							break;
-
-						case opcode_t::OP_LEQ:
-							value = value1 == value2;
-							break;
-
-						case opcode_t::OP_LNE:
-							value = value1 != value2;
-							break;
-
-						case opcode_t::OP_ADD:
-							value = value1 + value2;
-							break;
-
-						case opcode_t::OP_SUB:
-							value = value1 - value2;
-							break;
-
-						case opcode_t::OP_DIV:
-							if ( value2 == 0 )
-							{
-								// don't divide by zero
-								value = value1;
-							}
-							else
-							{
-								value = value1 / value2;
-							}
-
-							break;
-
-						case opcode_t::OP_MOD:
-							value = ( float )( ( int ) value1 % ( int ) value2 );
-							break;
-
-						case opcode_t::OP_MUL:
-							value = value1 * value2;
-							break;
-
-						case opcode_t::OP_LT:
-							value = value1 < value2;
-							break;
-
-						case opcode_t::OP_GT:
-							value = value1 > value2;
-							break;
-
-						default:
-							value = value1 = value2 = 0;
-							break;
-					}
+					value = ApplyOperator( op.type, value1, value2 );
 
 					// push result
 					op.type = opcode_t::OP_NUM;
@@ -449,7 +651,40 @@ float RB_EvalExpression( const expression_t *exp, float defaultValue )
 {
 	ASSERT( exp );
 
-	float value = EvalExpression( exp, defaultValue );
+	if ( !exp->numOps )
+	{
+		return defaultValue;
+	}
+
+	float value;
+
+	switch ( exp->dependency )
+	{
+		case expDependency_t::EXP_CONSTANT:
+			value = exp->constant;
+			break;
+
+		case expDependency_t::EXP_PER_FRAME:
+			if ( !exp->cacheValid || exp->cachedTime != backEnd.refdef.floatTime
+			     || exp->cachedLinearBlending != tr.worldLinearizeTexture )
+			{
+				exp->cachedValue = RunExpression( exp );
+				exp->cachedTime = backEnd.refdef.floatTime;
+				exp->cachedLinearBlending = tr.worldLinearizeTexture;
+				exp->cacheValid = true;
+			}
+
+			value = exp->cachedValue;
+			break;
+
+		case expDependency_t::EXP_PER_ENTITY:
+			value = RunExpression( exp );
+			break;
+
+		default:
+			value = RB_InterpretExpression( exp, defaultValue );
+			break;
+	}
 
 	if ( exp->bits & EXP_CLAMP )
 	{
@@ -0,0 +1,226 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+
+#include "engine/renderer/tr_local.h"
+
+namespace {
+
+expOperation_t Op( opcode_t type, float value = 0 )
+{
+    return { type, value };
+}
+
+expOperation_t Num( float value )
+{
+    return { opcode_t::OP_NUM, value };
+}
+
+expression_t Compile( std::initializer_list<expOperation_t> ops )
+{
+    expression_t exp{};
+    std::copy( ops.begin(), ops.end(), exp.ops );
+    exp.numOps = ops.size();
+    EXPECT_TRUE( R_CompileExpression( &exp ) );
+    return exp;
+}
+
+// Sets the frame and entity state the expressions read, and restores it
+class ShaderExpressionTest : public ::testing::Test
+{
+protected:
+    ShaderExpressionTest()
+        : oldRefdef( backEnd.refdef ), oldEntity( backEnd.currentEntity ), oldTable( tr.shaderTables[ 0 ] ),
+          oldLinearize( tr.worldLinearizeTexture )
+    {
+        entity = {};
+        entity.e.shaderRGBA = Color::Color32Bit( 255, 51, 0, 128 );
+        entity.e.shaderTime = 2.5f;
+
+        table = {};
+        table.numValues = ARRAY_LEN( tableValues );
+        table.values = tableValues;
+        tr.shaderTables[ 0 ] = &table;
+
+        backEnd.refdef.floatTime = 12.75f;
+        backEnd.currentEntity = nullptr;
+        tr.worldLinearizeTexture = false;
+    }
+
+    ~ShaderExpressionTest()
+    {
+        backEnd.refdef = oldRefdef;
+        backEnd.currentEntity = oldEntity;
+        tr.shaderTables[ 0 ] = oldTable;
+        tr.worldLinearizeTexture = oldLinearize;
+    }
+
+    trRefdef_t oldRefdef;
+    trRefEntity_t *oldEntity;
+    shaderTable_t *oldTable;
+    bool oldLinearize;
+
+    trRefEntity_t entity;
+    shaderTable_t table;
+    float tableValues[ 4 ] = { 0.0f, 1.0f, 0.5f, -1.0f };
+};
+
+TEST_F( ShaderExpressionTest, ConstantFolding )
+{
+    // ( 2 + 3 ) * -4 % 7 with a table lookup
+    expression_t exp = Compile( { Num( 2 ), Num( 3 ), Op( opcode_t::OP_ADD ), Num( 4 ), Op( opcode_t::OP_NEG ),
+                                  Op( opcode_t::OP_MUL ), Num( 7 ), Op( opcode_t::OP_MOD ), Num( 0.3f ), Op( opcode_t::OP_TABLE, 0 ),
+                                  Op( opcode_t::OP_ADD ) } );
+    EXPECT_EQ( exp.dependency, expDependency_t::EXP_CONSTANT );
+    EXPECT_EQ( exp.numCode, 0 );
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), RB_InterpretExpression( &exp, 0 ) );
+
+    // Opcodes that are constant in this renderer fold too
+    exp = Compile( { Op( opcode_t::OP_FRAGMENTSHADERS ), Op( opcode_t::OP_GLOBAL3 ), Op( opcode_t::OP_LAND ) } );
+    EXPECT_EQ( exp.dependency, expDependency_t::EXP_CONSTANT );
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), 1.0f );
+}
+
+TEST_F( ShaderExpressionTest, Dependency )
+{
+    expression_t exp = Compile( { Op( opcode_t::OP_TIME ), Num( 0.5f ), Op( opcode_t::OP_MUL ) } );
+    EXPECT_EQ( exp.dependency, expDependency_t::EXP_PER_FRAME );
+    EXPECT_EQ( exp.numCode, 2 );
+
+    exp = Compile( { Op( opcode_t::OP_LINEAR_BLENDING ), Num( 2 ), Op( opcode_t::OP_ADD ) } );
+    EXPECT_EQ( exp.dependency, expDependency_t::EXP_PER_FRAME );
+
+    exp = Compile( { Op( opcode_t::OP_PARM0 ), Op( opcode_t::OP_TIME ), Op( opcode_t::OP_MUL ) } );
+    EXPECT_EQ( exp.dependency, expDependency_t::EXP_PER_ENTITY );
+}
+
+TEST_F( ShaderExpressionTest, InvalidPostfix )
+{
+    expression_t exp{};
+    exp.ops[ 0 ] = Num( 1 );
+    exp.ops[ 1 ] = Op( opcode_t::OP_ADD );
+    exp.numOps = 2;
+    EXPECT_FALSE( R_CompileExpression( &exp ) );
+}
+
+TEST_F( ShaderExpressionTest, SameAsInterpreter )
+{
+    std::vector<expression_t> expressions = {
+        Compile( { Op( opcode_t::OP_TIME ) } ),
+        Compile( { Num( 1 ), Op( opcode_t::OP_TIME ), Op( opcode_t::OP_SUB ) } ),
+        Compile( { Op( opcode_t::OP_TIME ), Num( 3 ), Op( opcode_t::OP_MOD ), Num( 0 ), Op( opcode_t::OP_DIV ) } ),
+        Compile( { Op( opcode_t::OP_TIME ), Num( 0.1f ), Op( opcode_t::OP_MUL ), Op( opcode_t::OP_TABLE, 0 ), Op( opcode_t::OP_NEG ) } ),
+        Compile( { Op( opcode_t::OP_PARM0 ), Op( opcode_t::OP_PARM1 ), Op( opcode_t::OP_PARM2 ), Op( opcode_t::OP_ADD ),
+                   Op( opcode_t::OP_MUL ), Op( opcode_t::OP_PARM3 ), Num( 0.5f ), Op( opcode_t::OP_GT ), Op( opcode_t::OP_LOR ) } ),
+        Compile( { Num( 2 ), Op( opcode_t::OP_PARM4 ), Op( opcode_t::OP_TIME ), Op( opcode_t::OP_ADD ), Op( opcode_t::OP_DIV ) } ),
+        Compile( { Op( opcode_t::OP_NAIVE_BLENDING ), Op( opcode_t::OP_TIME ), Num( 12 ), Op( opcode_t::OP_GE ), Op( opcode_t::OP_LAND ) } ),
+        // several values left on the stack, the bottom one is the result
+        Compile( { Op( opcode_t::OP_TIME ), Num( 2 ), Num( 3 ), Op( opcode_t::OP_ADD ) } ),
+    };
+
+    for ( trRefEntity_t *currentEntity : { static_cast<trRefEntity_t *>( nullptr ), &entity } )
+    {
+        backEnd.currentEntity = currentEntity;
+
+        for ( float time : { 0.0f, 0.75f, 12.75f, 100.0f } )
+        {
+            backEnd.refdef.floatTime = time;
+
+            for ( size_t i = 0; i < expressions.size(); i++ )
+            {
+                EXPECT_EQ( RB_EvalExpression( &expressions[ i ], -1 ), RB_InterpretExpression( &expressions[ i ], -1 ) )
+                    << "expression " << i << " at time " << time;
+            }
+        }
+    }
+}
+
+TEST_F( ShaderExpressionTest, PerFrameCache )
+{
+    expression_t exp = Compile( { Op( opcode_t::OP_TIME ), Num( 2 ), Op( opcode_t::OP_MUL ) } );
+
+    backEnd.refdef.floatTime = 1.0f;
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), 2.0f );
+    EXPECT_TRUE( exp.cacheValid );
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), 2.0f );
+
+    backEnd.refdef.floatTime = 3.0f;
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), 6.0f );
+
+    exp = Compile( { Op( opcode_t::OP_LINEAR_BLENDING ) } );
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), 0.0f );
+    tr.worldLinearizeTexture = true;
+    EXPECT_EQ( RB_EvalExpression( &exp, 0 ), 1.0f );
+}
+
+TEST_F( ShaderExpressionTest, DISABLED_Benchmark )
+{
+    constexpr int ROUNDS = 1000000;
+    backEnd.currentEntity = &entity;
+
+    struct namedExpression_t
+    {
+        const char *name;
+        expression_t exp;
+    };
+
+    namedExpression_t expressions[] = {
+        { "constant", Compile( { Num( 0.25f ), Num( 2 ), Op( opcode_t::OP_MUL ), Op( opcode_t::OP_TABLE, 0 ) } ) },
+        { "per-frame", Compile( { Op( opcode_t::OP_TIME ), Num( 0.5f ), Op( opcode_t::OP_MUL ), Op( opcode_t::OP_TABLE, 0 ),
+                                  Num( 0.5f ), Op( opcode_t::OP_MUL ), Num( 0.5f ), Op( opcode_t::OP_ADD ) } ) },
+        { "per-entity", Compile( { Op( opcode_t::OP_PARM0 ), Op( opcode_t::OP_TIME ), Op( opcode_t::OP_MUL ), Num( 1 ),
+                                   Op( opcode_t::OP_PARM3 ), Op( opcode_t::OP_SUB ), Op( opcode_t::OP_ADD ) } ) },
+    };
+
+    for ( namedExpression_t &named : expressions )
+    {
+        for ( bool compiled : { false, true } )
+        {
+            float sum = 0;
+            auto start = Sys::SteadyClock::now();
+
+            for ( int i = 0; i < ROUNDS; i++ )
+            {
+                // a new frame every 100 evaluations
+                backEnd.refdef.floatTime = i / 100;
+                sum += compiled ? RB_EvalExpression( &named.exp, 0 ) : RB_InterpretExpression( &named.exp, 0 );
+            }
+
+            std::chrono::duration<double, std::nano> elapsed = Sys::SteadyClock::now() - start;
+            Log::Notice( "%s %s: %.1f ns per evaluation (sum %f)", named.name, compiled ? "compiled" : "interpreted",
+                         elapsed.count() / ROUNDS, sum );
+        }
+    }
+}
+
+} // namespace
@@ -35,9 +35,50 @@ static const int FILE_HASH_SIZE       = 1024;
 static shader_t      *shaderHashTable[ FILE_HASH_SIZE ];
 
 static const int MAX_SHADERTEXT_HASH  = 2048;
-static const char          **shaderTextHashTable[ MAX_SHADERTEXT_HASH ];
 
-static char          *s_shaderText;
+/* The index of the shader scripts, built by ScanAndLoadShaderFiles or read
+from the homepath, see R_ScanShaderFiles. It is laid out as:
+shaderIndexHeader_t, the name offsets of the files, the shaders, the tables,
+then the names, starting with the key of the index. */
+static const uint32_t SHADER_INDEX_VERSION = 1;
+
+struct shaderIndexHeader_t
+{
+	uint32_t version;
+	uint32_t numFiles;
+	uint32_t numShaders;
+	uint32_t numTables;
+	uint32_t namesSize;
+};
+
+struct shaderIndexEntry_t
+{
+	uint32_t name; // offset in the names
+	uint32_t file;
+	uint32_t offset; // offset in the text of the file
+};
+
+static Cvar::Cvar<bool> r_shaderIndexCache( "r_shaderIndexCache",
+	"cache the index of the shader scripts in the homepath", Cvar::NONE, true );
+
+static std::string shaderIndex;
+static const shaderIndexHeader_t *shaderIndexHeader;
+static const uint32_t *shaderIndexFiles;
+static const shaderIndexEntry_t *shaderIndexShaders;
+static const shaderIndexEntry_t *shaderIndexTables;
+static const char *shaderIndexNames;
+
+// the shaders of the index by hash of their name, in lookup order
+static std::vector<uint32_t> shaderTextHashTable[ MAX_SHADERTEXT_HASH ];
+
+// the compressed text of the shader files, only read once a shader is looked up
+struct shaderTextFile_t
+{
+	bool loaded;
+	std::string text;
+};
+
+static std::vector<shaderTextFile_t> shaderTextFiles;
 
 // the shader is parsed into these global variables, then copied into
 // dynamically allocated memory if it is valid.
@@ -885,8 +926,13 @@ static void ParseExpression( const char **text, expression_t *exp, int bits = 0
 		}
 	}
 
-	// everything went ok
 	exp->numOps = numOps;
+
+	if ( !R_CompileExpression( exp ) )
+	{
+		Log::Warn("invalid postfix expression in shader '%s'", shader.name );
+		exp->numOps = 0;
+	}
 }
 
 /*
@@ -6157,6 +6203,43 @@ static shader_t *FinishShader()
 
 //========================================================================================
 
+/*
+====================
+R_ShaderFileText
+
+Reads and compresses a shader file of the index the first time one of its
+shaders is looked up.
+====================
+*/
+static const std::string *R_ShaderFileText( uint32_t file )
+{
+	shaderTextFile_t &textFile = shaderTextFiles[ file ];
+
+	if ( !textFile.loaded )
+	{
+		const char *filename = shaderIndexNames + shaderIndexFiles[ file ];
+
+		std::error_code err;
+		textFile.text = FS::PakPath::ReadFile( filename, err );
+		textFile.loaded = true;
+
+		if ( err )
+		{
+			Log::Warn( "Couldn't load shader file %s", filename );
+			textFile.text.clear();
+		}
+		else
+		{
+			// ydnar: unixify all shaders
+			COM_FixPath( &textFile.text[ 0 ] );
+
+			textFile.text.resize( COM_Compress( &textFile.text[ 0 ] ) );
+		}
+	}
+
+	return &textFile.text;
+}
+
 /*
 ====================
 FindShaderInShaderText
@@ -6169,23 +6252,31 @@ return nullptr if not found
 If found, it will return a valid shader
 =====================
 */
-static const char    *FindShaderInShaderText( const char *shaderName )
+const char *FindShaderInShaderText( const char *shaderName )
 {
-	const char *token, *p;
+	int hash = generateHashValue( shaderName, MAX_SHADERTEXT_HASH );
 
-	int  i, hash;
+	for ( uint32_t shaderNum : shaderTextHashTable[ hash ] )
+	{
+		const shaderIndexEntry_t &entry = shaderIndexShaders[ shaderNum ];
 
-	hash = generateHashValue( shaderName, MAX_SHADERTEXT_HASH );
+		if ( Q_stricmp( shaderIndexNames + entry.name, shaderName ) )
+		{
+			continue;
+		}
 
-	for ( i = 0; shaderTextHashTable[ hash ][ i ]; i++ )
-	{
-		p = shaderTextHashTable[ hash ][ i ];
-		token = COM_ParseExt2( &p, true );
+		const std::string *text = R_ShaderFileText( entry.file );
 
-		if ( !Q_stricmp( token, shaderName ) )
+		if ( entry.offset >= text->size() )
 		{
-			return p;
+			return nullptr;
 		}
+
+		// step over the name
+		const char *p = text->c_str() + entry.offset;
+		COM_ParseExt2( &p, true );
+
+		return p;
 	}
 
 	// if the shader is not in the table, it must not exist
@@ -6431,6 +6522,138 @@ shader_t       *R_FindShader( const char *name, int flags )
 	return FinishShader();
 }
 
+static void PrefetchShaderMap( const char **text )
+{
+	std::string map = COM_ParseExt2( text, false );
+
+	// Image names with spaces are joined by ParseMap, don't bother with them.
+	if ( map.empty() || map[ 0 ] == '$' || map[ 0 ] == '*'
+		|| map.find( '(' ) != std::string::npos || COM_ParseExt2( text, false )[ 0 ] )
+	{
+		return;
+	}
+
+	R_PrefetchImage( map.c_str() );
+}
+
+/*
+===============
+RE_PrefetchShader
+
+Queues the images a shader is likely to load for decoding on the image
+decode threads, so the following R_FindShader only has to upload them.
+This is only a guess from a quick scan of the shader text, images that
+are missed are decoded as usual and unused ones are dropped at the end
+of the registration.
+===============
+*/
+void RE_PrefetchShader( const char *name )
+{
+	char strippedName[ MAX_QPATH ];
+
+	if ( !name[ 0 ] || strlen( name ) >= MAX_QPATH )
+	{
+		return;
+	}
+
+	COM_StripExtension3( FS::Path::NormalizeSlashes( name ).c_str(),
+	                     strippedName, sizeof( strippedName ) );
+
+	int hash = generateHashValue( strippedName, FILE_HASH_SIZE );
+
+	for ( shader_t *sh = shaderHashTable[ hash ]; sh; sh = sh->next )
+	{
+		if ( !Q_stricmp( sh->name, strippedName ) )
+		{
+			return;
+		}
+	}
+
+	const char *text = FindShaderInShaderText( strippedName );
+
+	if ( !text )
+	{
+		// implicit shader
+		R_PrefetchImage( strippedName );
+		return;
+	}
+
+	int depth = 0;
+
+	do
+	{
+		const char *token = COM_ParseExt2( &text, true );
+
+		if ( !token[ 0 ] )
+		{
+			break;
+		}
+		else if ( !Q_stricmp( token, "{" ) )
+		{
+			depth++;
+		}
+		else if ( !Q_stricmp( token, "}" ) )
+		{
+			depth--;
+		}
+		else if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "clampMap" )
+			|| !Q_stricmp( token, "diffuseMap" ) )
+		{
+			PrefetchShaderMap( &text );
+		}
+		else if ( !Q_stricmp( token, "normalMap" ) || !Q_stricmp( token, "normalHeightMap" ) )
+		{
+			if ( glConfig.normalMapping || glConfig.reliefMapping )
+			{
+				PrefetchShaderMap( &text );
+			}
+		}
+		else if ( !Q_stricmp( token, "heightMap" ) )
+		{
+			if ( glConfig.reliefMapping )
+			{
+				PrefetchShaderMap( &text );
+			}
+		}
+		else if ( !Q_stricmp( token, "specularMap" ) )
+		{
+			if ( glConfig.specularMapping )
+			{
+				PrefetchShaderMap( &text );
+			}
+		}
+		else if ( !Q_stricmp( token, "physicalMap" ) )
+		{
+			if ( glConfig.physicalMapping )
+			{
+				PrefetchShaderMap( &text );
+			}
+		}
+		else if ( !Q_stricmp( token, "glowMap" ) )
+		{
+			if ( r_glowMapping->integer )
+			{
+				PrefetchShaderMap( &text );
+			}
+		}
+		else if ( !Q_stricmp( token, "animMap" ) )
+		{
+			// skip the frequency
+			COM_ParseExt2( &text, false );
+
+			for ( token = COM_ParseExt2( &text, false ); token[ 0 ]; token = COM_ParseExt2( &text, false ) )
+			{
+				R_PrefetchImage( token );
+			}
+		}
+		else if ( !Q_strnicmp( token, "implicit", 8 ) && Q_stricmp( token, "implicitMapGL1" ) )
+		{
+			token = COM_ParseExt2( &text, false );
+			R_PrefetchImage( token[ 0 ] && Q_stricmp( token, "-" ) ? token : strippedName );
+		}
+	} while ( depth > 0 );
+}
+
 // This is used for textures for 2D rendering generated at runtime.
 qhandle_t RE_RegisterShaderFromImage( const char *name, image_t *image )
 {
@@ -6737,7 +6960,13 @@ public:
 
 		ParseExpression( &buffer_p, &exp );
 
+		static const char* const dependencyNames[] = { "constant", "per-frame", "per-entity", "interpreted" };
+
 		Print( "%i total ops", exp.numOps );
+		if ( exp.numOps )
+		{
+			Print( "%i instructions, %s", int( exp.numCode ), dependencyNames[ Util::ordinal( exp.dependency ) ] );
+		}
 		Print( "%f result", RB_EvalExpression( &exp, 0 ) );
 	}
 };
@@ -6745,35 +6974,195 @@ static ShaderExpCmd shaderExpCmdRegistration;
 
 /*
 ====================
-ScanAndLoadShaderFiles
+ParseShaderTable
 
-Finds and loads all .shader files, combining them into
-a single large text block that can be scanned for shader names
-=====================
+Parses a shader table, the "table" keyword being already read.
+====================
 */
-static void ScanAndLoadShaderFiles()
+static void ParseShaderTable( const char **text )
 {
-	std::vector<std::string> buffers;
-	const char *p;
-	const char *oldp, *token;
-	char *textEnd;
-	const char **hashMem;
-	int  shaderTextHashTableSizes[ MAX_SHADERTEXT_HASH ], hash, size;
-	char filename[ MAX_QPATH ];
-	size_t sum = 0;
+	const char    *token;
+	int           depth;
+	float         values[ FUNCTABLE_SIZE ];
+	int           numValues;
+	shaderTable_t *tb;
+	bool      alreadyCreated;
+	int           hash;
 
-	Log::Debug("----- ScanAndLoadShaderFiles -----" );
+	// zeroes shader table, booleans can be assumed as false
+	table = {};
 
-	// load and parse shader files
-	for ( const std::string& basename : FS::PakPath::ListFiles("scripts") )
+	token = COM_ParseExt2( text, true );
+
+	Q_strncpyz( table.name, token, sizeof( table.name ) );
+
+	// check if already created
+	alreadyCreated = false;
+	hash = generateHashValue( table.name, MAX_SHADERTABLE_HASH );
+
+	for ( tb = shaderTableHashTable[ hash ]; tb; tb = tb->next )
 	{
-		if ( !Str::IsISuffix( ".shader", basename ) )
+		if ( Q_stricmp( tb->name, table.name ) == 0 )
+		{
+			// match found
+			alreadyCreated = true;
+			break;
+		}
+	}
+
+	depth = 0;
+	numValues = 0;
+
+	do
+	{
+		token = COM_ParseExt2( text, true );
+
+		if ( !Q_stricmp( token, "snap" ) )
+		{
+			table.snap = true;
+		}
+		else if ( !Q_stricmp( token, "clamp" ) )
+		{
+			table.clamp = true;
+		}
+		else if ( token[ 0 ] == '{' )
+		{
+			depth++;
+		}
+		else if ( token[ 0 ] == '}' )
+		{
+			depth--;
+		}
+		else if ( token[ 0 ] == ',' )
 		{
 			continue;
 		}
+		else
+		{
+			if ( numValues == FUNCTABLE_SIZE )
+			{
+				Log::Warn("FUNCTABLE_SIZE hit" );
+				break;
+			}
 
-		Com_sprintf( filename, sizeof( filename ), "scripts/%s", basename.c_str() );
+			values[ numValues++ ] = atof( token );
+		}
+	}
+	while ( depth && *text );
 
+	if ( !alreadyCreated )
+	{
+		Log::Debug("...generating '%s'", table.name );
+		GeneratePermanentShaderTable( values, numValues );
+	}
+}
+
+/*
+====================
+R_UseShaderIndex
+
+Checks an index of the shader files and sets it as the current one.
+====================
+*/
+static bool R_UseShaderIndex( std::string index, const std::string &key )
+{
+	if ( index.size() < sizeof( shaderIndexHeader_t ) )
+	{
+		return false;
+	}
+
+	auto *header = reinterpret_cast<const shaderIndexHeader_t*>( index.data() );
+
+	if ( header->version != SHADER_INDEX_VERSION )
+	{
+		return false;
+	}
+
+	uint64_t namesOffset = sizeof( shaderIndexHeader_t ) + uint64_t( header->numFiles ) * sizeof( uint32_t )
+		+ ( uint64_t( header->numShaders ) + header->numTables ) * sizeof( shaderIndexEntry_t );
+
+	if ( index.size() != namesOffset + header->namesSize || !header->namesSize )
+	{
+		return false;
+	}
+
+	auto *files = reinterpret_cast<const uint32_t*>( header + 1 );
+	auto *shaders = reinterpret_cast<const shaderIndexEntry_t*>( files + header->numFiles );
+	const char *names = index.data() + namesOffset;
+
+	// the names start with the key
+	if ( names[ header->namesSize - 1 ] != '\0' || key != names )
+	{
+		return false;
+	}
+
+	for ( uint32_t i = 0; i < header->numFiles; i++ )
+	{
+		if ( files[ i ] >= header->namesSize )
+		{
+			return false;
+		}
+	}
+
+	for ( uint32_t i = 0; i < header->numShaders + header->numTables; i++ )
+	{
+		if ( shaders[ i ].name >= header->namesSize || shaders[ i ].file >= header->numFiles )
+		{
+			return false;
+		}
+	}
+
+	shaderIndex = std::move( index );
+	shaderIndexHeader = reinterpret_cast<const shaderIndexHeader_t*>( shaderIndex.data() );
+	shaderIndexFiles = reinterpret_cast<const uint32_t*>( shaderIndexHeader + 1 );
+	shaderIndexShaders = reinterpret_cast<const shaderIndexEntry_t*>( shaderIndexFiles + shaderIndexHeader->numFiles );
+	shaderIndexTables = shaderIndexShaders + shaderIndexHeader->numShaders;
+	shaderIndexNames = shaderIndex.data() + namesOffset;
+
+	for ( auto &bucket : shaderTextHashTable )
+	{
+		bucket.clear();
+	}
+
+	for ( uint32_t i = 0; i < shaderIndexHeader->numShaders; i++ )
+	{
+		int hash = generateHashValue( shaderIndexNames + shaderIndexShaders[ i ].name, MAX_SHADERTEXT_HASH );
+		shaderTextHashTable[ hash ].push_back( i );
+	}
+
+	shaderTextFiles.clear();
+	shaderTextFiles.resize( shaderIndexHeader->numFiles );
+
+	return true;
+}
+
+/*
+====================
+ScanAndLoadShaderFiles
+
+Finds and loads all .shader files, and indexes the shaders and the
+tables they contain so that they can be scanned for shader names
+=====================
+*/
+static std::string ScanAndLoadShaderFiles( const std::vector<std::string> &filenames, const std::string &key,
+	std::vector<std::string> &texts )
+{
+	std::vector<uint32_t> files;
+	std::vector<shaderIndexEntry_t> shaders, tables;
+	std::string names;
+
+	auto addName = [&]( const char *name ) -> uint32_t
+	{
+		uint32_t offset = names.size();
+		names.append( name, strlen( name ) + 1 );
+		return offset;
+	};
+
+	addName( key.c_str() );
+
+	// load and parse shader files
+	for ( const std::string &filename : filenames )
+	{
 		Log::Debug("loading '%s' shader file", filename );
 		std::error_code err;
 		std::string buffer = FS::PakPath::ReadFile( filename, err );
@@ -6784,7 +7173,8 @@ static void ScanAndLoadShaderFiles()
 			continue;
 		}
 
-		p = buffer.c_str();
+		const char *p = buffer.c_str();
+		const char *token;
 		bool syntaxError = false;
 
 		while ( true )
@@ -6819,169 +7209,215 @@ static void ScanAndLoadShaderFiles()
 
 		if ( !syntaxError )
 		{
-			sum += buffer.size();
-			buffers.push_back( std::move( buffer ) );
+			// ydnar: unixify all shaders
+			COM_FixPath( &buffer[ 0 ] );
+
+			buffer.resize( COM_Compress( &buffer[ 0 ] ) );
+
+			files.push_back( addName( filename.c_str() ) );
+			texts.push_back( std::move( buffer ) );
 		}
 	}
 
-	// build single large buffer
-	s_shaderText = (char*) ri.Hunk_Alloc( sum + buffers.size() * 2, ha_pref::h_low );
-	s_shaderText[ 0 ] = '\0';
-	textEnd = s_shaderText;
-
-	for ( auto i = buffers.rbegin(); i != buffers.rend(); ++i )
+	// the shaders of the last files take precedence
+	for ( uint32_t file = files.size(); file-- > 0; )
 	{
-		strcat( textEnd, i->c_str() );
-		strcat( textEnd, "\n" );
-		textEnd += strlen( textEnd );
+		const char *text = texts[ file ].c_str();
+		const char *p = text;
+
+		// look for shader names
+		while ( true )
+		{
+			const char *oldp = p;
+			const char *token = COM_ParseExt( &p, true );
+
+			if ( token[ 0 ] == 0 )
+			{
+				break;
+			}
+
+			// skip shader tables, they are parsed once the index is loaded
+			if ( !Q_stricmp( token, "table" ) )
+			{
+				token = COM_ParseExt2( &p, true );
+				tables.push_back( { addName( token ), file, uint32_t( oldp - text ) } );
+			}
+			else
+			{
+				shaders.push_back( { addName( token ), file, uint32_t( oldp - text ) } );
+			}
+
+			SkipBracedSection( &p );
+		}
 	}
 
-	// ydnar: unixify all shaders
-	COM_FixPath( s_shaderText );
+	shaderIndexHeader_t header = {};
+	header.version = SHADER_INDEX_VERSION;
+	header.numFiles = files.size();
+	header.numShaders = shaders.size();
+	header.numTables = tables.size();
+	header.namesSize = names.size();
+
+	std::string index;
+	index.append( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+	index.append( reinterpret_cast<const char*>( files.data() ), files.size() * sizeof( uint32_t ) );
+	index.append( reinterpret_cast<const char*>( shaders.data() ), shaders.size() * sizeof( shaderIndexEntry_t ) );
+	index.append( reinterpret_cast<const char*>( tables.data() ), tables.size() * sizeof( shaderIndexEntry_t ) );
+	index.append( names );
 
-	COM_Compress( s_shaderText );
+	return index;
+}
 
-	memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
-	size = 0;
+/*
+====================
+R_PruneShaderIndexCache
 
-	p = s_shaderText;
+An index is written for each set of shader files, keep only the ones of the
+last few sets so that switching between games or mods doesn't rebuild them.
+====================
+*/
+static const size_t MAX_SHADER_INDEX_FILES = 8;
 
-	// look for shader names
-	while ( true )
-	{
-		token = COM_ParseExt2( &p, true );
+static void R_PruneShaderIndexCache()
+{
+	std::vector<std::pair<std::chrono::system_clock::time_point, std::string>> indexes;
+	std::error_code err;
 
-		if ( token[ 0 ] == 0 )
+	for ( const std::string& filename : FS::HomePath::ListFiles( "shaderindex", err ) )
+	{
+		if ( !Str::IsSuffix( ".bin", filename ) )
 		{
-			break;
+			continue;
 		}
 
-		// skip shader tables
-		if ( !Q_stricmp( token, "table" ) )
-		{
-			// skip table name
-			token = COM_ParseExt2( &p, true );
+		std::string path = "shaderindex/" + filename;
+		auto timestamp = FS::HomePath::FileTimestamp( path, err );
 
-			SkipBracedSection( &p );
-		}
-		else
+		if ( !err )
 		{
-			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
-			shaderTextHashTableSizes[ hash ]++;
-			size++;
-			SkipBracedSection( &p );
+			indexes.emplace_back( timestamp, std::move( path ) );
 		}
 	}
 
-	size += MAX_SHADERTEXT_HASH;
+	if ( indexes.size() <= MAX_SHADER_INDEX_FILES )
+	{
+		return;
+	}
 
-	hashMem = (const char**) ri.Hunk_Alloc( size * sizeof( char * ), ha_pref::h_low );
+	// The oldest first
+	std::sort( indexes.begin(), indexes.end() );
 
-	for ( int i = 0; i < MAX_SHADERTEXT_HASH; i++ )
+	for ( size_t i = 0; i < indexes.size() - MAX_SHADER_INDEX_FILES; i++ )
 	{
-		shaderTextHashTable[ i ] = hashMem;
-		hashMem += shaderTextHashTableSizes[ i ] + 1;
+		Log::Debug( "Deleting the old shader index %s", indexes[ i ].second );
+		FS::HomePath::DeleteFile( indexes[ i ].second, err );
 	}
+}
 
-	memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
+/*
+====================
+R_ScanShaderFiles
 
-	p = s_shaderText;
+Indexes the shaders of all the .shader files. The index is cached in the
+homepath for the current set of shader files, so that most of the time
+only the text of the shaders actually used has to be read. Returns whether
+the index was read from the cache.
+====================
+*/
+bool R_ScanShaderFiles( bool useCache )
+{
+	Log::Debug("----- ScanAndLoadShaderFiles -----" );
 
-	// look for shader names
-	while ( true )
-	{
-		oldp = p;
-		token = COM_ParseExt( &p, true );
+	int start = Sys::Milliseconds();
 
-		if ( token[ 0 ] == 0 )
+	std::vector<std::string> filenames;
+	std::string key;
+
+	for ( const std::string& basename : FS::PakPath::ListFiles("scripts") )
+	{
+		if ( !Str::IsISuffix( ".shader", basename ) )
 		{
-			break;
+			continue;
 		}
 
-		// parse shader tables
-		if ( !Q_stricmp( token, "table" ) )
-		{
-			int           depth;
-			float         values[ FUNCTABLE_SIZE ];
-			int           numValues;
-			shaderTable_t *tb;
-			bool      alreadyCreated;
+		std::string filename = "scripts/" + basename;
+		key += R_PakFileCacheKey( filename );
+		filenames.push_back( std::move( filename ) );
+	}
 
-			// zeroes shader table, booleans can be assumed as false
-			table = {};
+	std::string cachePath = Str::Format( "shaderindex/%x.bin", std::hash<std::string>()( key ) );
+	bool cached = false;
 
-			token = COM_ParseExt2( &p, true );
+	if ( useCache )
+	{
+		std::error_code err;
+		FS::File cacheFile = FS::HomePath::OpenRead( cachePath, err );
 
-			Q_strncpyz( table.name, token, sizeof( table.name ) );
+		if ( !err )
+		{
+			std::string index = cacheFile.ReadAll( err );
+			cached = !err && R_UseShaderIndex( std::move( index ), key );
+		}
+	}
+
+	if ( !cached )
+	{
+		std::vector<std::string> texts;
+		std::string index = ScanAndLoadShaderFiles( filenames, key, texts );
 
-			// check if already created
-			alreadyCreated = false;
-			hash = generateHashValue( table.name, MAX_SHADERTABLE_HASH );
+		if ( useCache )
+		{
+			std::error_code err;
+			FS::File cacheFile = FS::HomePath::OpenWrite( cachePath, err );
 
-			for ( tb = shaderTableHashTable[ hash ]; tb; tb = tb->next )
+			if ( !err )
 			{
-				if ( Q_stricmp( tb->name, table.name ) == 0 )
-				{
-					// match found
-					alreadyCreated = true;
-					break;
-				}
+				cacheFile.Write( index.data(), index.size(), err );
+				cacheFile.Close( err );
 			}
 
-			depth = 0;
-			numValues = 0;
-
-			do
+			if ( err )
 			{
-				token = COM_ParseExt2( &p, true );
+				Log::Warn( "Failed to write the shader index %s: %s", cachePath, err.message() );
+			}
 
-				if ( !Q_stricmp( token, "snap" ) )
-				{
-					table.snap = true;
-				}
-				else if ( !Q_stricmp( token, "clamp" ) )
-				{
-					table.clamp = true;
-				}
-				else if ( token[ 0 ] == '{' )
-				{
-					depth++;
-				}
-				else if ( token[ 0 ] == '}' )
-				{
-					depth--;
-				}
-				else if ( token[ 0 ] == ',' )
-				{
-					continue;
-				}
-				else
-				{
-					if ( numValues == FUNCTABLE_SIZE )
-					{
-						Log::Warn("FUNCTABLE_SIZE hit" );
-						break;
-					}
+			R_PruneShaderIndexCache();
+		}
 
-					values[ numValues++ ] = atof( token );
-				}
-			}
-			while ( depth && p );
+		if ( !R_UseShaderIndex( std::move( index ), key ) )
+		{
+			Sys::Error( "Invalid shader index" );
+		}
 
-			if ( !alreadyCreated )
-			{
-				Log::Debug("...generating '%s'", table.name );
-				GeneratePermanentShaderTable( values, numValues );
-			}
+		// the files were already read
+		for ( size_t i = 0; i < texts.size(); i++ )
+		{
+			shaderTextFiles[ i ].loaded = true;
+			shaderTextFiles[ i ].text = std::move( texts[ i ] );
 		}
-		else
+	}
+
+	// parse shader tables
+	for ( uint32_t i = 0; i < shaderIndexHeader->numTables; i++ )
+	{
+		const shaderIndexEntry_t &entry = shaderIndexTables[ i ];
+		const std::string *text = R_ShaderFileText( entry.file );
+
+		if ( entry.offset < text->size() )
 		{
-			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
-			shaderTextHashTable[ hash ][ shaderTextHashTableSizes[ hash ]++ ] = oldp;
+			// step over the "table"
+			const char *p = text->c_str() + entry.offset;
+			COM_ParseExt2( &p, true );
 
-			SkipBracedSection( &p );
+			ParseShaderTable( &p );
 		}
 	}
+
+	Log::Debug( "...indexed %u shaders from %u files in %d ms%s",
+		shaderIndexHeader->numShaders, shaderIndexHeader->numFiles,
+		Sys::Milliseconds() - start, cached ? " (cached)" : "" );
+
+	return cached;
 }
 
 /*
@@ -7023,7 +7459,7 @@ void R_InitShaders()
 
 	CreateInternalShaders();
 
-	ScanAndLoadShaderFiles();
+	R_ScanShaderFiles( r_shaderIndexCache.Get() );
 }
 
 /*
@@ -0,0 +1,108 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <gtest/gtest.h>
+
+#include "common/Common.h"
+#include "common/FileSystem.h"
+
+#include "engine/renderer/tr_local.h"
+
+namespace {
+
+const char* const SHADER_NAMES[] = {
+    "white",
+    "test/shaderindex/plain",
+    "test/shaderindex/comments",
+    "test/shaderindex/implicit",
+};
+
+// The text of the shaders, empty if they are not found
+std::vector<std::string> ShaderBodies()
+{
+    std::vector<std::string> bodies;
+
+    for (const char* name : SHADER_NAMES) {
+        const char* start = FindShaderInShaderText(name);
+        const char* end = start;
+
+        if (start && SkipBracedSection(&end)) {
+            bodies.emplace_back(start, end);
+        } else {
+            bodies.emplace_back();
+        }
+    }
+
+    return bodies;
+}
+
+class ShaderIndexTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        const FS::PakInfo* pak = FS::FindPak("testdata", "src");
+        if (!pak) {
+            FAIL() << "Test data not available - some tests will be skipped. Please add daemon/pkg/ to the pak path";
+        }
+        FS::PakPath::LoadPak(*pak);
+    }
+};
+
+TEST_F(ShaderIndexTest, CachedSameAsUncached)
+{
+    EXPECT_FALSE(R_ScanShaderFiles(false));
+    std::vector<std::string> uncached = ShaderBodies();
+
+    // The first scan writes the index, unless a previous run did
+    R_ScanShaderFiles(true);
+    EXPECT_TRUE(R_ScanShaderFiles(true));
+    std::vector<std::string> cached = ShaderBodies();
+
+    for (size_t i = 0; i < uncached.size(); i++) {
+        EXPECT_NE(uncached[i], "") << SHADER_NAMES[i];
+        EXPECT_EQ(uncached[i], cached[i]) << SHADER_NAMES[i];
+    }
+
+    EXPECT_EQ(FindShaderInShaderText("test/shaderindex/missing"), nullptr);
+}
+
+TEST_F(ShaderIndexTest, CompressedText)
+{
+    R_ScanShaderFiles(true);
+
+    for (const std::string& body : ShaderBodies()) {
+        EXPECT_EQ(body.find("//"), std::string::npos);
+        EXPECT_EQ(body.find("/*"), std::string::npos);
+        EXPECT_EQ(body.find('\\'), std::string::npos);
+    }
+}
+
+} // namespace
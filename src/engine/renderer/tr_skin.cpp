@@ -213,7 +213,7 @@ qhandle_t RE_RegisterSkin( const char *name )
 
 	// load and parse the skin file
 	std::error_code err;
-	std::string text = FS::PakPath::ReadFile( name, err );
+	std::string text = R_ReadPrefetchedFile( name, err );
 
 	if ( err )
 	{
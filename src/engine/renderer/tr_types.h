@@ -189,6 +189,46 @@ struct alignas(16) refSkeleton_t
 	refBone_t         bones[ MAX_BONES ];
 };
 
+// One skeleton of a CG_R_BUILDSKELETONS batch: the skeleton of anim,
+// blended with the one of blendAnim if it is set.
+struct SkeletonBuild
+{
+	qhandle_t anim;
+	int       startFrame;
+	int       endFrame;
+	float     lerp;
+
+	qhandle_t blendAnim; // 0 for no blending
+	int       blendStartFrame;
+	int       blendEndFrame;
+	float     blendLerp;
+	float     blendFrac;
+
+	bool8_t   clearOrigin;
+
+	// Send the bones back, otherwise the skeleton only stays in the
+	// renderer's cache for the entities using the same animation
+	bool8_t   returnBones;
+};
+
+// Reply to one SkeletonBuild, the bones are sent in a separate array as
+// refSkeleton_t is too big and over-aligned to go in a vector.
+struct SkeletonBuildResult
+{
+	int               result;
+	refSkeletonType_t type;
+	int               numBones; // 0 if the bones were not requested
+	vec3_t            bounds[ 2 ];
+};
+
+struct SkeletonBone
+{
+	short  parentIndex;
+	quat_t rot;
+	vec3_t trans;
+	vec_t  scale;
+};
+
 // XreaL END
 
 enum EntityTag : uint8_t {
@@ -51,7 +51,6 @@ Maryland 20850 USA.
 struct svEntity_t
 {
 	entityState_t        baseline; // for delta compression of initial sighting
-	int                  snapshotCounter; // used to prevent double adding from portal views
 };
 
 enum class serverState_t
@@ -67,7 +66,6 @@ struct server_t
 	bool      restarting; // if true, send configstring changes during SS_LOADING
 	int           serverId; // changes each server start
 	int           restartedServerId; // serverId before a map_restart
-	int             snapshotCounter; // incremented for each snapshot built
 	int             timeResidual; // <= 1000 / sv_frame->value
 	int             nextFrameTime; // when time > nextFrameTime, process world
 
@@ -110,6 +108,7 @@ struct clientSnapshot_t
 	int           first_entity; // into the circular sv_packet_entities[]
 	// the entities MUST be in increasing state number
 	// order, otherwise the delta compression will fail
+	int sharedDeltaFrame; // svs.snapshotFrame the entity states were copied in, 0 if their deltas can't be shared
 	int messageSent; // time the message was transmitted
 	int messageAcked; // time the message was acked
 	int messageSize; // used to rate drop packets
@@ -240,6 +239,7 @@ struct serverStatic_t
 	int           numSnapshotEntities; // sv_maxClients.Get()*PACKET_BACKUP*MAX_PACKET_ENTITIES
 	int           nextSnapshotEntities; // next snapshotEntities to use
 	std::unique_ptr<entityState_t[]> snapshotEntities; // [numSnapshotEntities]
+	int           snapshotFrame; // incremented each time snapshots are sent to the clients
 	receipt_t     infoReceipts[ MAX_INFO_RECEIPTS ];
 
 	int       sampleTimes[ SERVER_PERFORMANCECOUNTER_SAMPLES ];
@@ -265,16 +265,29 @@ public:
 	void GameClientUserInfoChanged(int clientNum);
 	void GameClientDisconnect(int clientNum);
 	void GameClientCommand(int clientNum, const char* command);
-	void GameClientThink(int clientNum);
+	void GameClientThink(int clientNum, const usercmd_t& cmd);
+	void FlushClientThinks();
 	void GameRunFrame(int levelTime);
 	NORETURN void BotAIStartFrame(int levelTime);
 
+	void LogFrameStats();
+
 private:
 	virtual void Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel) override final;
 	void QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& channel);
+	virtual void SendPendingMsgs() override final;
 
 	IPC::SharedMemory shmRegion;
 
+	// usercmds waiting to be sent in a single GAME_CLIENT_THINK_BATCH
+	bool clientThinkBatch;
+	std::vector<std::pair<int, usercmd_t>> pendingClientThinks;
+
+	// for LogFrameStats
+	uint64_t statsMessages;
+	int statsThinks;
+	int statsFrames;
+
 	std::unique_ptr<VM::CommonVMServices> services;
 };
 
@@ -374,6 +387,13 @@ void SV_UpdateServerCommandsToClient( client_t *client, msg_t *msg );
 void SV_SendMessageToClient( msg_t *msg, client_t *client );
 void SV_SendClientMessages();
 void SV_SendClientSnapshot( client_t *client );
+void SV_BuildClientSnapshot( client_t *client );
+void SV_WriteClientSnapshot( client_t *client, msg_t *msg );
+void SV_WriteClientSnapshots( client_t *const *clients, msg_t *msgs, int count, bool parallel );
+void SV_BuildEntityIndex();
+void SV_ClearEntityIndex();
+void SV_BeginSharedDeltas();
+void SV_EndSharedDeltas();
 
 //bani
 void SV_SendClientIdle( client_t *client );
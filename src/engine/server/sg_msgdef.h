@@ -55,7 +55,9 @@ enum gameImport_t
   BOT_DEBUG_DRAW,
 
   DISPATCH_RAWDATA,
-  DISPATCH_RAWDATASYNC
+  DISPATCH_RAWDATASYNC,
+
+  G_ENABLE_CLIENT_THINK_BATCH
 };
 
 using LocateGameDataMsg1 = IPC::Message<IPC::Id<VM::QVM, G_LOCATE_GAME_DATA1>, IPC::SharedMemory, int, int, int>;
@@ -125,6 +127,8 @@ using DispatchRawDataSyncMsg = IPC::SyncMessage<
     IPC::Message<IPC::Id<VM::QVM, DISPATCH_RAWDATASYNC>, std::string>,
     IPC::Reply<std::string>
 >;
+// tells the engine the sgame handles GAME_CLIENT_THINK_BATCH
+using EnableClientThinkBatchMsg = IPC::Message<IPC::Id<VM::QVM, G_ENABLE_CLIENT_THINK_BATCH>>;
 
 
 
@@ -166,6 +170,9 @@ enum gameExport_t
   BOT_VISIBLEFROMPOS, // bool ()( vec3_t srcOrig, int srcNum, dstOrig, int dstNum, bool isDummy );
   BOT_CHECKATTACKATPOS, // bool ()( int entityNum, int enemyNum, vec3_t position,
   //              bool ducking, bool allowWorldHit );
+
+  GAME_CLIENT_THINK_BATCH, // void ()( std::vector<std::pair<int, usercmd_t>> thinks );
+  // same as a GAME_CLIENT_THINK for each clientNum, with the usercmd it would have got
 };
 
 using GameStaticInitMsg = IPC::SyncMessage<
@@ -196,6 +203,9 @@ using GameClientCommandMsg = IPC::SyncMessage<
 using GameClientThinkMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, GAME_CLIENT_THINK>, int>
 >;
+using GameClientThinkBatchMsg = IPC::SyncMessage<
+	IPC::Message<IPC::Id<VM::QVM, GAME_CLIENT_THINK_BATCH>, std::vector<std::pair<int, usercmd_t>>>
+>;
 using GameRunFrameMsg = IPC::SyncMessage<
 	IPC::Message<IPC::Id<VM::QVM, GAME_RUN_FRAME>, int>
 >;
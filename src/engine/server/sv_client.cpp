@@ -1216,7 +1216,7 @@ void SV_ClientThink( client_t *cl, usercmd_t *cmd )
 		return; // may have been kicked during the last usercmd
 	}
 
-	gvm.GameClientThink( cl - svs.clients );
+	gvm.GameClientThink( cl - svs.clients, *cmd );
 }
 
 /*
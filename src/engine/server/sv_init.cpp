@@ -673,6 +673,7 @@ void SV_QuickShutdown( const char *finalmsg )
 	if ( svs.clients )
 	{
 		SV_FinalCommand( va( "print %s", Cmd_QuoteString( finalmsg ) ), true );
+		Sys_FlushPackets();
 	}
 
 	SV_ShutdownGameProgs();
@@ -1308,6 +1308,8 @@ happen before SV_Frame is called
 */
 void SV_Frame( int msec )
 {
+	PROFILE_ZONE("SV_Frame");
+
 	int        frameMsec;
 	int        startTime;
 	int        frameStartTime = 0, frameEndTime;
@@ -1393,6 +1395,9 @@ void SV_Frame( int msec )
 	// update ping based on the all received frames
 	SV_CalcPings();
 
+	// run the usercmds received since the last frame
+	gvm.FlushClientThinks();
+
 	// run the game simulation in chunks
 	while ( sv.timeResidual >= frameMsec )
 	{
@@ -1418,6 +1423,8 @@ void SV_Frame( int msec )
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat( HEARTBEAT_GAME );
 
+	gvm.LogFrameStats();
+
 	frameEndTime = Sys::Milliseconds();
 
 	svs.totalFrameTime += ( frameEndTime - frameStartTime );
@@ -49,6 +49,11 @@ Maryland 20850 USA.
 #include "../renderer-vulkan/DispatchRawData.h"
 #endif
 
+static Cvar::Cvar<bool> sv_batchClientThinks("sv_batchClientThinks",
+	"send the usercmds to the sgame once per frame, if it supports it", Cvar::NONE, true);
+
+static Log::Logger gameIPCLog("server.gameIPC");
+
 // Suppress warnings for unused [this] lambda captures.
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wunused-lambda-capture"
@@ -352,11 +357,16 @@ static std::string DispatchRawDataSync( const std::string& data ) {
 #endif
 }
 
-GameVM::GameVM(): VM::VMBase("sgame", Cvar::NONE), services(nullptr) {
+GameVM::GameVM(): VM::VMBase("sgame", Cvar::NONE),
+	clientThinkBatch(false), statsMessages(0), statsThinks(0), statsFrames(0), services(nullptr) {
 }
 
 void GameVM::Start()
 {
+	// the new sgame has to ask for it again
+	clientThinkBatch = false;
+	pendingClientThinks.clear();
+
 	services = std::unique_ptr<VM::CommonVMServices>(new VM::CommonVMServices(*this, "SGame", FS::Owner::SGAME, Cmd::SGAME_VM));
 
 	this->Create();
@@ -428,9 +438,37 @@ void GameVM::GameClientCommand(int clientNum, const char* command)
 	this->SendMsg<GameClientCommandMsg>(clientNum, command);
 }
 
-void GameVM::GameClientThink(int clientNum)
+// When the sgame supports it, the usercmds are queued and sent together before
+// the next message to the sgame, so that their order with the other calls is kept.
+void GameVM::GameClientThink(int clientNum, const usercmd_t& cmd)
+{
+	statsThinks++;
+
+	if (!clientThinkBatch || !sv_batchClientThinks.Get()) {
+		this->SendMsg<GameClientThinkMsg>(clientNum);
+		return;
+	}
+
+	pendingClientThinks.emplace_back(clientNum, cmd);
+}
+
+void GameVM::FlushClientThinks()
 {
-	this->SendMsg<GameClientThinkMsg>(clientNum);
+	if (pendingClientThinks.empty()) {
+		return;
+	}
+
+	// the sgame calls back into the engine while thinking, which may flush again
+	std::vector<std::pair<int, usercmd_t>> thinks;
+	std::swap(thinks, pendingClientThinks);
+	this->SendMsg<GameClientThinkBatchMsg>(thinks);
+}
+
+// Every message to the sgame, including the commands and cvar changes sent by
+// the common services, comes after the usercmds received before it.
+void GameVM::SendPendingMsgs()
+{
+	this->FlushClientThinks();
 }
 
 void GameVM::GameRunFrame(int levelTime)
@@ -443,6 +481,24 @@ void GameVM::BotAIStartFrame(int)
 	Sys::Drop("GameVM::BotAIStartFrame not implemented");
 }
 
+// Called once per server frame
+void GameVM::LogFrameStats()
+{
+	if (++statsFrames < MAX_BPS_WINDOW) {
+		return;
+	}
+
+	uint64_t messages = this->GetNumMessages();
+
+	gameIPCLog.Debug("sgame IPC: %.1f messages, %.1f usercmds per frame (batched: %s)",
+	                 float(messages - statsMessages) / statsFrames, float(statsThinks) / statsFrames,
+	                 clientThinkBatch && sv_batchClientThinks.Get() ? "yes" : "no");
+
+	statsMessages = messages;
+	statsThinks = 0;
+	statsFrames = 0;
+}
+
 void GameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 {
 	int major = id >> 16;
@@ -635,6 +691,12 @@ void GameVM::QVMSyscall(int syscallNum, Util::Reader& reader, IPC::Channel& chan
 		} );
 		break;
 
+	case G_ENABLE_CLIENT_THINK_BATCH:
+		IPC::HandleMsg<EnableClientThinkBatchMsg>(channel, std::move(reader), [this] {
+			clientThinkBatch = true;
+		});
+		break;
+
 	default:
 		Sys::Drop("Bad game system trap: %d", syscallNum);
 	}
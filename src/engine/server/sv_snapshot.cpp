@@ -32,6 +32,10 @@ Maryland 20850 USA.
 ===========================================================================
 */
 
+#include <bitset>
+#include <exception>
+#include <mutex>
+
 #include "server.h"
 #include "qcommon/sys.h"
 
@@ -61,6 +65,195 @@ static Cvar::Cvar<bool> sv_novis("sv_novis", "skip PVS check when transmitting e
 
 static Log::Logger bandwidthLog("server.bandwidth");
 
+static Cvar::Cvar<bool> sv_parallelSnapshots("sv_parallelSnapshots",
+	"build and encode the client snapshots on several threads", Cvar::NONE, false);
+
+/*
+=============================================================================
+
+Shared entity deltas
+
+All the clients getting a snapshot in the same call to SV_SendClientMessages
+get the same entity states, and most of them delta them from the baseline or
+from the same previous frame. So each delta is encoded only once per frame and
+the bits are copied into the other clients' messages. The snapshots may be
+written on several threads, so the cache is protected by a mutex and the
+encoded bits never move once they are added.
+
+=============================================================================
+*/
+
+static Cvar::Cvar<bool> sv_shareEntityDeltas("sv_shareEntityDeltas",
+	"encode the entity deltas once per frame for all the clients", Cvar::NONE, true);
+
+static Log::Logger deltaCacheLog("server.deltaCache");
+
+static const int MAX_ENTITY_DELTA_BYTES = 1024;
+static const int DELTA_CACHE_CHUNK_BYTES = 64 * 1024;
+static const int BASELINE_DELTA_FRAME = -1;
+
+struct entityDelta_t
+{
+	const byte *data;
+	int        bits;
+	int        uncompsize;
+};
+
+static int                                         deltaCacheFrame; // 0 when deltas aren't shared
+static std::mutex                                  deltaCacheMutex;
+static std::unordered_map<uint64_t, entityDelta_t> deltaCache;
+static std::vector<std::unique_ptr<byte[]>>        deltaCacheChunks; // kept from one frame to the next
+static int                                         deltaCacheChunk;
+static int                                         deltaCacheChunkUsed;
+static int                                         deltaCacheHits;
+static int                                         deltaCacheMisses;
+static int                                         deltaCacheWindowSteps;
+
+/*
+=============
+SV_BeginSharedDeltas
+=============
+*/
+void SV_BeginSharedDeltas()
+{
+	svs.snapshotFrame++;
+
+	deltaCache.clear();
+	deltaCacheChunk = 0;
+	deltaCacheChunkUsed = 0;
+
+	deltaCacheFrame = sv_shareEntityDeltas.Get() ? svs.snapshotFrame : 0;
+}
+
+/*
+=============
+SV_EndSharedDeltas
+=============
+*/
+void SV_EndSharedDeltas()
+{
+	// snapshots built from elsewhere, like SV_FinalCommand, are not shared
+	deltaCacheFrame = 0;
+
+	if ( ++deltaCacheWindowSteps < MAX_BPS_WINDOW )
+	{
+		return;
+	}
+
+	int total = deltaCacheHits + deltaCacheMisses;
+
+	if ( total > 0 )
+	{
+		deltaCacheLog.Debug( "shared entity deltas: %i hits, %i misses (%.1f%%) over %i frames",
+		                     deltaCacheHits, deltaCacheMisses, 100.0f * deltaCacheHits / total, deltaCacheWindowSteps );
+	}
+
+	deltaCacheWindowSteps = 0;
+	deltaCacheHits = 0;
+	deltaCacheMisses = 0;
+}
+
+/*
+=============
+SV_AllocDeltaCacheData
+
+Must be called with deltaCacheMutex locked.
+=============
+*/
+static byte *SV_AllocDeltaCacheData( int size )
+{
+	if ( deltaCacheChunkUsed + size > DELTA_CACHE_CHUNK_BYTES )
+	{
+		deltaCacheChunk++;
+		deltaCacheChunkUsed = 0;
+	}
+
+	if ( deltaCacheChunk == int( deltaCacheChunks.size() ) )
+	{
+		deltaCacheChunks.emplace_back( new byte[ DELTA_CACHE_CHUNK_BYTES ] );
+	}
+
+	byte *data = deltaCacheChunks[ deltaCacheChunk ].get() + deltaCacheChunkUsed;
+	deltaCacheChunkUsed += size;
+	return data;
+}
+
+/*
+=============
+SV_WriteSharedDeltaEntity
+
+Same as MSG_WriteDeltaEntity, but reuses the bits encoded for another client
+when the from state (identified by entity number and the frame it was copied
+in) is the same.
+=============
+*/
+static void SV_WriteSharedDeltaEntity( msg_t *msg, const entityState_t *from, int fromFrame,
+                                       const entityState_t *to, int toFrame, bool force )
+{
+	if ( !deltaCacheFrame || toFrame != deltaCacheFrame || !fromFrame )
+	{
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	uint64_t      key = ( uint64_t( uint32_t( fromFrame ) ) << 32 ) | uint32_t( to->number );
+	entityDelta_t delta;
+
+	{
+		std::lock_guard<std::mutex> lock( deltaCacheMutex );
+		auto it = deltaCache.find( key );
+
+		if ( it != deltaCache.end() )
+		{
+			delta = it->second;
+			deltaCacheHits++;
+		}
+		else
+		{
+			delta.data = nullptr;
+		}
+	}
+
+	// the field usage statistics count every written delta
+	if ( delta.data )
+	{
+		MSG_CountDeltaEntityFields( from, to );
+	}
+
+	if ( !delta.data )
+	{
+		byte  buf[ MAX_ENTITY_DELTA_BYTES ];
+		msg_t bufMsg;
+
+		MSG_Init( &bufMsg, buf, sizeof( buf ) );
+		MSG_WriteDeltaEntity( &bufMsg, from, to, force );
+
+		if ( bufMsg.overflowed )
+		{
+			MSG_WriteDeltaEntity( msg, from, to, force );
+			return;
+		}
+
+		int size = ( bufMsg.bit + 7 ) >> 3;
+
+		std::lock_guard<std::mutex> lock( deltaCacheMutex );
+		auto inserted = deltaCache.emplace( key, entityDelta_t{} );
+
+		// another thread may have encoded the same delta in the meantime
+		if ( inserted.second )
+		{
+			byte *data = SV_AllocDeltaCacheData( size );
+			memcpy( data, buf, size );
+			inserted.first->second = { data, bufMsg.bit, bufMsg.uncompsize };
+		}
+
+		delta = inserted.first->second;
+		deltaCacheMisses++;
+	}
+
+	MSG_WriteEncodedBits( msg, delta.data, delta.bits, delta.uncompsize );
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -122,7 +315,7 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, clientSnapshot_
 			// delta update from old position
 			// because the force parm is false, this will not result
 			// in any bytes being emitted if the entity has not changed at all
-			MSG_WriteDeltaEntity( msg, oldent, newent, false );
+			SV_WriteSharedDeltaEntity( msg, oldent, from->sharedDeltaFrame, newent, to->sharedDeltaFrame, false );
 			oldindex++;
 			newindex++;
 			continue;
@@ -131,7 +324,8 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, clientSnapshot_
 		if ( newnum < oldnum )
 		{
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity( msg, &sv.svEntities[ newnum ].baseline, newent, true );
+			SV_WriteSharedDeltaEntity( msg, &sv.svEntities[ newnum ].baseline, BASELINE_DELTA_FRAME,
+			                           newent, to->sharedDeltaFrame, true );
 			newindex++;
 			continue;
 		}
@@ -285,6 +479,7 @@ struct snapshotEntityNumbers_t
 {
 	int numSnapshotEntities;
 	int snapshotEntities[ MAX_SNAPSHOT_ENTITIES ];
+	std::bitset<MAX_GENTITIES> added; // used to prevent double adding from portal views
 };
 
 /*
@@ -321,12 +516,12 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt,
                                  snapshotEntityNumbers_t *eNums )
 {
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter )
+	if ( eNums->added[ svEnt - sv.svEntities ] )
 	{
 		return;
 	}
 
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[ svEnt - sv.svEntities ] = true;
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES )
@@ -338,6 +533,202 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt,
 	eNums->numSnapshotEntities++;
 }
 
+/*
+=============================================================================
+
+Entity cluster index
+
+The entities are linked by the sgame, so instead of tracking changes the
+index is rebuilt once in SV_SendClientMessages. Each snapshot then only
+goes through the entities touching a cluster of its PVS, plus the ones
+which may be sent regardless of the PVS.
+
+=============================================================================
+*/
+
+static Cvar::Cvar<bool> sv_entityClusterIndex("sv_entityClusterIndex",
+	"only check the entities in potentially visible clusters when building snapshots", Cvar::NONE, true);
+
+static bool             entityIndexValid;
+static int              entityIndexNumClusters;
+static std::vector<int> entityIndexClusterStart; // [numClusters + 1], into entityIndexEntities
+static std::vector<int> entityIndexEntities;
+static std::vector<int> entityIndexAlways; // checked whatever the PVS
+
+static const int ENTITY_INDEX_ALWAYS = -1;
+
+/*
+===============
+SV_EntityIndexClusters
+
+Returns the clusters an entity must be indexed in, or ENTITY_INDEX_ALWAYS
+if it can't be decided from the PVS alone.
+===============
+*/
+static int SV_EntityIndexClusters( const sharedEntity_t *ent, const int **clusters )
+{
+	if ( ent->r.svFlags & ( SVF_BROADCAST | SVF_BROADCAST_ONCE | SVF_CLIENTS_IN_RANGE ) )
+	{
+		return ENTITY_INDEX_ALWAYS;
+	}
+
+	int num;
+
+	if ( ent->r.svFlags & SVF_IGNOREBMODELEXTENTS )
+	{
+		*clusters = &ent->r.originCluster;
+		num = 1;
+	}
+	else
+	{
+		if ( ent->r.numClusters < 0 || ent->r.numClusters > MAX_ENT_CLUSTERS || ent->r.lastCluster )
+		{
+			return ENTITY_INDEX_ALWAYS;
+		}
+
+		*clusters = ent->r.clusternums;
+		num = ent->r.numClusters;
+	}
+
+	for ( int i = 0; i < num; i++ )
+	{
+		if ( ( *clusters )[ i ] < 0 || ( *clusters )[ i ] >= entityIndexNumClusters )
+		{
+			return ENTITY_INDEX_ALWAYS;
+		}
+	}
+
+	return num;
+}
+
+/*
+===============
+SV_BuildEntityIndex
+===============
+*/
+void SV_BuildEntityIndex()
+{
+	entityIndexValid = false;
+
+	if ( !sv_entityClusterIndex.Get() || sv_novis.Get() || sv.state == serverState_t::SS_DEAD || !sv.gentities )
+	{
+		return;
+	}
+
+	entityIndexNumClusters = CM_NumClusters();
+	entityIndexClusterStart.assign( entityIndexNumClusters + 1, 0 );
+	entityIndexAlways.clear();
+
+	// count the entities of each cluster
+	for ( int e = 0; e < sv.num_entities; e++ )
+	{
+		sharedEntity_t *ent = SV_GentityNum( e );
+		const int      *clusters;
+
+		if ( !ent->r.linked )
+		{
+			continue;
+		}
+
+		if ( ent->s.number != e )
+		{
+			Log::Debug( "FIXING ENT->S.NUMBER!!!" );
+			ent->s.number = e;
+		}
+
+		if ( ent->r.svFlags & SVF_NOCLIENT )
+		{
+			continue;
+		}
+
+		int num = SV_EntityIndexClusters( ent, &clusters );
+
+		if ( num == ENTITY_INDEX_ALWAYS )
+		{
+			entityIndexAlways.push_back( e );
+			continue;
+		}
+
+		for ( int i = 0; i < num; i++ )
+		{
+			entityIndexClusterStart[ clusters[ i ] + 1 ]++;
+		}
+	}
+
+	for ( int c = 0; c < entityIndexNumClusters; c++ )
+	{
+		entityIndexClusterStart[ c + 1 ] += entityIndexClusterStart[ c ];
+	}
+
+	// then fill them, in entity order
+	std::vector<int> fill( entityIndexClusterStart.begin(), entityIndexClusterStart.end() - 1 );
+	entityIndexEntities.resize( entityIndexClusterStart.back() );
+
+	for ( int e = 0; e < sv.num_entities; e++ )
+	{
+		sharedEntity_t *ent = SV_GentityNum( e );
+		const int      *clusters;
+
+		if ( !ent->r.linked || ( ent->r.svFlags & SVF_NOCLIENT ) )
+		{
+			continue;
+		}
+
+		int num = SV_EntityIndexClusters( ent, &clusters );
+
+		for ( int i = 0; i < num; i++ )
+		{
+			entityIndexEntities[ fill[ clusters[ i ] ]++ ] = e;
+		}
+	}
+
+	entityIndexValid = true;
+}
+
+/*
+===============
+SV_ClearEntityIndex
+
+Called once the game may move entities again.
+===============
+*/
+void SV_ClearEntityIndex()
+{
+	entityIndexValid = false;
+}
+
+/*
+===============
+SV_EntityIndexCandidates
+
+Lists, in increasing order, the entities which may be visible with this PVS.
+===============
+*/
+static void SV_EntityIndexCandidates( const byte *pvs, std::vector<int> &candidates )
+{
+	candidates = entityIndexAlways;
+
+	for ( int c = 0; c < entityIndexNumClusters; c++ )
+	{
+		if ( !pvs[ c >> 3 ] )
+		{
+			c |= 7;
+			continue;
+		}
+
+		if ( pvs[ c >> 3 ] & ( 1 << ( c & 7 ) ) )
+		{
+			candidates.insert( candidates.end(),
+			                   entityIndexEntities.begin() + entityIndexClusterStart[ c ],
+			                   entityIndexEntities.begin() + entityIndexClusterStart[ c + 1 ] );
+		}
+	}
+
+	// entities touching several clusters are listed several times
+	std::sort( candidates.begin(), candidates.end() );
+	candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+}
+
 /*
 ===============
 SV_AddEntitiesVisibleFromPoint
@@ -384,8 +775,19 @@ static void SV_AddEntitiesVisibleFromPoint( client_t* client, vec3_t origin, cli
 		SV_AddEntitiesVisibleFromPoint( client, playerEnt->s.origin2, frame, eNums );
 	}
 
-	for ( e = 0; e < sv.num_entities; e++ )
+	// without the index, go through all the entities
+	std::vector<int> candidates;
+	int              numCandidates = sv.num_entities;
+
+	if ( entityIndexValid )
+	{
+		SV_EntityIndexCandidates( clientpvs, candidates );
+		numCandidates = candidates.size();
+	}
+
+	for ( int candidate = 0; candidate < numCandidates; candidate++ )
 	{
+		e = entityIndexValid ? candidates[ candidate ] : candidate;
 		ent = SV_GentityNum( e );
 
 		// never send entities that aren't linked in
@@ -446,7 +848,7 @@ static void SV_AddEntitiesVisibleFromPoint( client_t* client, vec3_t origin, cli
 		svEnt = SV_SvEntityForGentity( ent );
 
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter )
+		if ( eNums->added[ svEnt - sv.svEntities ] )
 		{
 			continue;
 		}
@@ -559,7 +961,7 @@ static void SV_AddEntitiesVisibleFromPoint( client_t* client, vec3_t origin, cli
 
 				master = SV_SvEntityForGentity( ment );
 
-				if ( master->snapshotCounter == sv.snapshotCounter || !ment->r.linked )
+				if ( eNums->added[ master - sv.svEntities ] || !ment->r.linked )
 				{
 					continue;
 				}
@@ -611,7 +1013,7 @@ static void SV_AddEntitiesVisibleFromPoint( client_t* client, vec3_t origin, cli
 						continue;
 					}
 
-					if ( master->snapshotCounter == sv.snapshotCounter )
+					if ( eNums->added[ master - sv.svEntities ] )
 					{
 						continue;
 					}
@@ -653,10 +1055,13 @@ static void SV_AddEntitiesVisibleFromPoint( client_t* client, vec3_t origin, cli
 
 /*
 =============
-SV_BuildClientSnapshot
+SV_BuildSnapshotEntityNumbers
 
 Decides which entities are going to be visible to the client, and
-copies off the playerstate and areabits.
+copies off the playerstate and areabits. Only writes to the client's
+own frame, so it can be run for several clients at once.
+
+Returns false if the client has nothing to build a snapshot for.
 
 This properly handles multiple recursive portals, but the render
 currently doesn't.
@@ -664,36 +1069,31 @@ currently doesn't.
 For viewing through other player's eyes, clent can be something other than client->gentity
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client )
+static bool SV_BuildSnapshotEntityNumbers( client_t *client, snapshotEntityNumbers_t *entityNumbers )
 {
 	vec3_t                  org;
 	clientSnapshot_t        *frame;
-	snapshotEntityNumbers_t entityNumbers;
 	int                     i;
-	sharedEntity_t          *ent;
-	entityState_t           *state;
-	svEntity_t              *svEnt;
 	sharedEntity_t          *clent;
 	int                     clientNum;
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	entityNumbers->numSnapshotEntities = 0;
+	entityNumbers->added.reset();
 	memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
 	// show_bug.cgi?id=62
 	frame->num_entities = 0;
+	frame->sharedDeltaFrame = 0;
 
 	clent = client->gentity;
 
 	if ( !clent || client->state == clientState_t::CS_ZOMBIE )
 	{
-		return;
+		return false;
 	}
 
 	// grab the current playerState_t
@@ -709,9 +1109,7 @@ static void SV_BuildClientSnapshot( client_t *client )
 		Sys::Drop( "SV_SvEntityForGentity: bad gEnt" );
 	}
 
-	svEnt = &sv.svEntities[ clientNum ];
-
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	entityNumbers->added[ clientNum ] = true;
 
 	if ( clent->r.svFlags & SVF_SELF_PORTAL_EXCLUSIVE )
 	{
@@ -727,14 +1125,14 @@ static void SV_BuildClientSnapshot( client_t *client )
 
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
-	SV_AddEntitiesVisibleFromPoint( client, org, frame, &entityNumbers /*, false, client->netchan.remoteAddress.type == NA_LOOPBACK */ );
+	SV_AddEntitiesVisibleFromPoint( client, org, frame, entityNumbers /*, false, client->netchan.remoteAddress.type == NA_LOOPBACK */ );
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
 	// to work correctly.  This also catches the error condition
 	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities,
-	       sizeof( entityNumbers.snapshotEntities[ 0 ] ), SV_QsortEntityNumbers );
+	qsort( entityNumbers->snapshotEntities, entityNumbers->numSnapshotEntities,
+	       sizeof( entityNumbers->snapshotEntities[ 0 ] ), SV_QsortEntityNumbers );
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -743,14 +1141,29 @@ static void SV_BuildClientSnapshot( client_t *client )
 		( ( int * ) frame->areabits ) [ i ] = ( ( int * ) frame->areabits ) [ i ] ^ -1;
 	}
 
-	// copy the entity states out
+	return true;
+}
+
+/*
+=============
+SV_CopySnapshotEntities
+
+Copies the entity states out to svs.snapshotEntities. Clients must go
+through this one at a time and in the same order to get the same slots.
+=============
+*/
+static void SV_CopySnapshotEntities( client_t *client, const snapshotEntityNumbers_t *entityNumbers )
+{
+	clientSnapshot_t *frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	frame->num_entities = 0;
 	frame->first_entity = svs.nextSnapshotEntities;
+	frame->sharedDeltaFrame = deltaCacheFrame;
 
-	for ( i = 0; i < entityNumbers.numSnapshotEntities; i++ )
+	for ( int i = 0; i < entityNumbers->numSnapshotEntities; i++ )
 	{
-		ent = SV_GentityNum( entityNumbers.snapshotEntities[ i ] );
-		state = &svs.snapshotEntities[ svs.nextSnapshotEntities % svs.numSnapshotEntities ];
+		sharedEntity_t *ent = SV_GentityNum( entityNumbers->snapshotEntities[ i ] );
+		entityState_t  *state = &svs.snapshotEntities[ svs.nextSnapshotEntities % svs.numSnapshotEntities ];
 		*state = ent->s;
 		svs.nextSnapshotEntities++;
 
@@ -764,6 +1177,105 @@ static void SV_BuildClientSnapshot( client_t *client )
 	}
 }
 
+/*
+=============
+SV_BuildClientSnapshot
+=============
+*/
+void SV_BuildClientSnapshot( client_t *client )
+{
+	snapshotEntityNumbers_t entityNumbers;
+
+	if ( SV_BuildSnapshotEntityNumbers( client, &entityNumbers ) )
+	{
+		SV_CopySnapshotEntities( client, &entityNumbers );
+	}
+}
+
+/*
+=============
+SV_RethrowFirstError
+
+Exceptions must not escape an OpenMP parallel region, so the clients' errors
+are kept until the end of the loop and the one of the first client is thrown,
+as the serial loop would have done.
+=============
+*/
+static void SV_RethrowFirstError( const std::vector<std::exception_ptr> &errors )
+{
+	for ( const std::exception_ptr &error : errors )
+	{
+		if ( error )
+		{
+			std::rethrow_exception( error );
+		}
+	}
+}
+
+/*
+=============
+SV_WriteClientSnapshots
+
+Builds and writes the snapshots of several clients, with the same result as
+calling SV_BuildClientSnapshot and SV_WriteClientSnapshot for each of them in
+turn. Deciding which entities are visible and encoding the messages are done
+in parallel, only the entity states are copied to svs.snapshotEntities one
+client after the other.
+
+The delta of a client may not be taken from a frame whose entities were
+overwritten by the copies of the following clients, which the serial loop
+would still have used if the ring of entity states was about to wrap.
+=============
+*/
+void SV_WriteClientSnapshots( client_t *const *clients, msg_t *msgs, int count, bool parallel )
+{
+	std::vector<snapshotEntityNumbers_t> entityNumbers( count );
+	std::vector<char>                    built( count ); // not vector<bool>, each thread writes its own element
+	std::vector<std::exception_ptr>      errors( count );
+
+#if !defined(_OPENMP)
+	Q_UNUSED( parallel );
+#endif
+
+	#pragma omp parallel for if ( parallel ) schedule( dynamic )
+	for ( int i = 0; i < count; i++ )
+	{
+		try
+		{
+			built[ i ] = SV_BuildSnapshotEntityNumbers( clients[ i ], &entityNumbers[ i ] );
+		}
+		catch ( ... )
+		{
+			errors[ i ] = std::current_exception();
+		}
+	}
+
+	SV_RethrowFirstError( errors );
+
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( built[ i ] )
+		{
+			SV_CopySnapshotEntities( clients[ i ], &entityNumbers[ i ] );
+		}
+	}
+
+	#pragma omp parallel for if ( parallel ) schedule( dynamic )
+	for ( int i = 0; i < count; i++ )
+	{
+		try
+		{
+			SV_WriteClientSnapshot( clients[ i ], &msgs[ i ] );
+		}
+		catch ( ... )
+		{
+			errors[ i ] = std::current_exception();
+		}
+	}
+
+	SV_RethrowFirstError( errors );
+}
+
 /*
 ====================
 SV_RateMsec
@@ -925,6 +1437,55 @@ void SV_SendClientIdle( client_t *client )
 	sv.ubpsTotalBytes += msg.uncompsize / 8; // NERVE - SMF - net debugging
 }
 
+/*
+=======================
+SV_WriteClientSnapshot
+
+Writes the reliable commands and the snapshot which was just built for the
+client. Only reads the server state and writes to the client, so it can be
+run for several clients at once.
+=======================
+*/
+void SV_WriteClientSnapshot( client_t *client, msg_t *msg )
+{
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotToClient( client, msg );
+}
+
+/*
+=======================
+SV_FinishClientSnapshot
+=======================
+*/
+static void SV_FinishClientSnapshot( client_t *client, msg_t *msg )
+{
+	// Add any download data if the client is downloading
+	SV_WriteDownloadToClient( client, msg );
+
+	// check for overflow
+	if ( msg->overflowed )
+	{
+		Log::Warn("msg overflowed for %s", client->name );
+		MSG_Clear( msg );
+
+		SV_DropClient( client, "Msg overflowed" );
+		return;
+	}
+
+	SV_SendMessageToClient( msg, client );
+
+	sv.bpsTotalBytes += msg->cursize; // NERVE - SMF - net debugging
+	sv.ubpsTotalBytes += msg->uncompsize / 8; // NERVE - SMF - net debugging
+}
+
 /*
 =======================
 SV_SendClientSnapshot
@@ -962,34 +1523,37 @@ void SV_SendClientSnapshot( client_t *client )
 
 	MSG_Init( &msg, msg_buf, sizeof( msg_buf ) );
 
-	// NOTE, MRE: all server->client messages now acknowledge
-	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	SV_WriteClientSnapshot( client, &msg );
+	SV_FinishClientSnapshot( client, &msg );
+}
 
-	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+/*
+=======================
+SV_SendClientSnapshots
 
-	// send over all the relevant entityState_t
-	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+Same as SV_SendClientSnapshot for several active or zombie clients, but their
+snapshots are built and written on several threads. The messages are then
+sent in order.
+=======================
+*/
+static void SV_SendClientSnapshots( const std::vector<client_t *> &clients )
+{
+	static std::vector<byte> msgBuffers; // kept from one frame to the next
+	std::vector<msg_t>       msgs( clients.size() );
 
-	// Add any download data if the client is downloading
-	SV_WriteDownloadToClient( client, &msg );
+	msgBuffers.resize( clients.size() * MAX_MSGLEN );
 
-	// check for overflow
-	if ( msg.overflowed )
+	for ( size_t i = 0; i < clients.size(); i++ )
 	{
-		Log::Warn("msg overflowed for %s", client->name );
-		MSG_Clear( &msg );
-
-		SV_DropClient( client, "Msg overflowed" );
-		return;
+		MSG_Init( &msgs[ i ], msgBuffers.data() + i * MAX_MSGLEN, MAX_MSGLEN );
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	SV_WriteClientSnapshots( clients.data(), msgs.data(), clients.size(), true );
 
-	sv.bpsTotalBytes += msg.cursize; // NERVE - SMF - net debugging
-	sv.ubpsTotalBytes += msg.uncompsize / 8; // NERVE - SMF - net debugging
+	for ( size_t i = 0; i < clients.size(); i++ )
+	{
+		SV_FinishClientSnapshot( clients[ i ], &msgs[ i ] );
+	}
 }
 
 /*
@@ -1000,6 +1564,8 @@ SV_SendClientMessages
 
 void SV_SendClientMessages()
 {
+	PROFILE_ZONE("SV_SendClientMessages");
+
 	client_t *c;
 	int      numclients = 0; // NERVE - SMF - net debugging
 
@@ -1009,6 +1575,12 @@ void SV_SendClientMessages()
 	// Gordon: update any changed configstrings from this frame
 	SV_UpdateConfigStrings();
 
+	SV_BeginSharedDeltas();
+	SV_BuildEntityIndex();
+
+	// clients whose snapshot is built on several threads
+	std::vector<client_t *> snapshotClients;
+
 	// send a message to each connected client
 	for ( int i = 0; i < sv_maxClients.Get(); i++ )
 	{
@@ -1044,10 +1616,25 @@ void SV_SendClientMessages()
 			continue;
 		}
 
+		if ( sv_parallelSnapshots.Get()
+		     && ( c->state == clientState_t::CS_ACTIVE || c->state == clientState_t::CS_ZOMBIE ) )
+		{
+			snapshotClients.push_back( c );
+			continue;
+		}
+
 		// generate and send a new message
 		SV_SendClientSnapshot( c );
 	}
 
+	if ( !snapshotClients.empty() )
+	{
+		SV_SendClientSnapshots( snapshotClients );
+	}
+
+	SV_ClearEntityIndex();
+	SV_EndSharedDeltas();
+
 	// NERVE - SMF - net debugging
 	bandwidthLog.DoDebugCode( [numclients] {
 		if ( numclients <= 0 )
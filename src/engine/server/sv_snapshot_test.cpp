@@ -0,0 +1,336 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2026, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include <chrono>
+#include <random>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "common/FileSystem.h"
+#include "server.h"
+
+namespace {
+
+#define PSF(x) int(offsetof(OpaquePlayerState, x))
+
+// Builds snapshots for clients spread over the plat23 test map, with synthetic
+// entities linked the way the sgame does it.
+class SnapshotTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        const FS::PakInfo* pak = FS::FindPak("testdata", "src");
+        if (!pak) {
+            FAIL() << "Test data not available - some tests will be skipped. Please add daemon/pkg/ to the pak path";
+        }
+        FS::PakPath::LoadPak(*pak);
+        CM_LoadMap("plat23_1.13.4");
+
+        // normally sent by the sgame, only the fields known by the engine
+        MSG_InitNetcodeTables({
+            {"origin[0]", PSF(origin[0]), 0, 0},
+            {"origin[1]", PSF(origin[1]), 0, 0},
+            {"origin[2]", PSF(origin[2]), 0, 0},
+            {"viewheight", PSF(viewheight), -8, 0},
+            {"clientNum", PSF(clientNum), 8, 0},
+            {"commandTime", PSF(commandTime), 32, 0},
+        }, sizeof(OpaquePlayerState));
+    }
+
+    static void TearDownTestSuite()
+    {
+        CM_ClearMap();
+    }
+
+    void SetUp() override
+    {
+        oldState = sv.state;
+        oldNumSnapshotEntities = svs.numSnapshotEntities;
+        oldSnapshotEntities = std::move(svs.snapshotEntities);
+        oldClients = svs.clients;
+    }
+
+    void TearDown() override
+    {
+        SV_ClearEntityIndex();
+        sv.state = oldState;
+        sv.gentities = nullptr;
+        sv.gameClients = nullptr;
+        sv.num_entities = 0;
+        svs.numSnapshotEntities = oldNumSnapshotEntities;
+        svs.snapshotEntities = std::move(oldSnapshotEntities);
+        svs.clients = oldClients;
+    }
+
+    void LinkEntity(sharedEntity_t& ent, const vec3_t origin, float size)
+    {
+        int leafs[128];
+        int lastLeaf;
+
+        VectorCopy(origin, ent.s.origin);
+        VectorSet(ent.r.absmin, origin[0] - size, origin[1] - size, origin[2] - size);
+        VectorSet(ent.r.absmax, origin[0] + size, origin[1] + size, origin[2] + size);
+
+        int numLeafs = CM_BoxLeafnums(ent.r.absmin, ent.r.absmax, leafs, ARRAY_LEN(leafs), &lastLeaf);
+        if (!numLeafs) {
+            return;
+        }
+
+        ent.r.areanum = ent.r.areanum2 = -1;
+        for (int i = 0; i < numLeafs; i++) {
+            int area = CM_LeafArea(leafs[i]);
+            if (area != -1) {
+                if (ent.r.areanum != -1 && ent.r.areanum != area) {
+                    ent.r.areanum2 = area;
+                } else {
+                    ent.r.areanum = area;
+                }
+            }
+        }
+
+        int i;
+        for (i = 0; i < numLeafs; i++) {
+            int cluster = CM_LeafCluster(leafs[i]);
+            if (cluster != -1) {
+                ent.r.clusternums[ent.r.numClusters++] = cluster;
+                if (ent.r.numClusters == MAX_ENT_CLUSTERS) {
+                    break;
+                }
+            }
+        }
+        if (i != numLeafs) {
+            ent.r.lastCluster = CM_LeafCluster(lastLeaf);
+        }
+
+        ent.r.originCluster = CM_LeafCluster(CM_PointLeafnum(origin));
+        ent.r.linked = true;
+    }
+
+    void SetUpWorld(int numClients, int numEntities, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        vec3_t mins, maxs;
+        CM_ModelBounds(CM_InlineModel(0), mins, maxs);
+        auto randomPoint = [&](vec3_t point) {
+            for (int j = 0; j < 3; j++) {
+                point[j] = mins[j] + (maxs[j] - mins[j]) * std::uniform_real_distribution<float>()(rng);
+            }
+        };
+
+        entities.assign(numEntities, {});
+        playerStates.assign(numClients, {});
+        clients.reset(new client_t[numClients]());
+        snapshotEntities.reset(new entityState_t[1 << 16]);
+
+        for (int e = 0; e < numEntities; e++) {
+            sharedEntity_t& ent = entities[e];
+            vec3_t origin;
+            randomPoint(origin);
+            ent.s.number = e;
+            LinkEntity(ent, origin, e % 3 ? 16.0f : 256.0f);
+
+            switch (e % 53) {
+            case 1: ent.r.svFlags |= SVF_BROADCAST; break;
+            case 2: ent.r.svFlags |= SVF_NOCLIENT; break;
+            case 3: ent.r.linked = false; break;
+            case 4: ent.r.svFlags |= SVF_IGNOREBMODELEXTENTS; break;
+            case 5: ent.r.svFlags |= SVF_SINGLECLIENT; ent.r.singleClient = e % numClients; break;
+            case 6: ent.r.svFlags |= SVF_CLIENTS_IN_RANGE; ent.r.clientRadius = 512.0f; break;
+            }
+        }
+
+        for (int c = 0; c < numClients; c++) {
+            OpaquePlayerState& ps = playerStates[c];
+            ps.clientNum = c;
+            VectorCopy(entities[c].s.origin, ps.origin);
+            clients[c].state = clientState_t::CS_ACTIVE;
+            clients[c].gentity = &entities[c];
+        }
+
+        sv.state = serverState_t::SS_GAME;
+        sv.gentities = reinterpret_cast<byte*>(entities.data());
+        sv.gentitySize = sizeof(sharedEntity_t);
+        sv.num_entities = numEntities;
+        sv.gameClients = reinterpret_cast<const byte*>(playerStates.data());
+        sv.gameClientSize = sizeof(OpaquePlayerState);
+        svs.clients = clients.get();
+        svs.snapshotEntities = std::move(snapshotEntities);
+        svs.numSnapshotEntities = 1 << 16;
+        svs.nextSnapshotEntities = 0;
+    }
+
+    std::vector<int> SnapshotEntities(client_t& client)
+    {
+        SV_BuildClientSnapshot(&client);
+        const clientSnapshot_t& frame = client.frames[client.netchan.outgoingSequence & PACKET_MASK];
+        std::vector<int> numbers;
+        for (int i = 0; i < frame.num_entities; i++) {
+            numbers.push_back(svs.snapshotEntities[(frame.first_entity + i) % svs.numSnapshotEntities].number);
+        }
+        return numbers;
+    }
+
+    // Writes the messages of a few frames for all the clients, with entities
+    // changing between frames and clients acknowledging some of the frames.
+    std::vector<std::string> WriteFrames(int numClients, bool parallel)
+    {
+        constexpr int numEntities = 1500;
+        SetUpWorld(numClients, numEntities, 7);
+
+        std::vector<std::string> messages;
+        std::vector<byte> buffers(numClients * MAX_MSGLEN);
+        std::vector<msg_t> msgs(numClients);
+        std::vector<client_t*> clientPointers;
+        for (int c = 0; c < numClients; c++) {
+            clientPointers.push_back(&clients[c]);
+        }
+
+        for (int frame = 1; frame <= 8; frame++) {
+            for (int e = frame; e < numEntities; e += 5) {
+                entities[e].s.pos.trBase[0] += 8.0f * frame;
+                entities[e].s.eventParm = frame;
+            }
+
+            for (int c = 0; c < numClients; c++) {
+                playerStates[c].commandTime = 50 * frame;
+            }
+
+            SV_BeginSharedDeltas();
+            SV_BuildEntityIndex();
+
+            for (int c = 0; c < numClients; c++) {
+                clients[c].netchan.outgoingSequence = frame;
+                clients[c].deltaMessage = (frame + c) % 3 ? frame - 1 : 0;
+                MSG_Init(&msgs[c], buffers.data() + c * MAX_MSGLEN, MAX_MSGLEN);
+            }
+
+            if (parallel) {
+                SV_WriteClientSnapshots(clientPointers.data(), msgs.data(), numClients, true);
+            } else {
+                for (int c = 0; c < numClients; c++) {
+                    SV_BuildClientSnapshot(&clients[c]);
+                    SV_WriteClientSnapshot(&clients[c], &msgs[c]);
+                }
+            }
+
+            SV_ClearEntityIndex();
+            SV_EndSharedDeltas();
+
+            for (const msg_t& msg : msgs) {
+                EXPECT_FALSE(msg.overflowed);
+                messages.emplace_back(reinterpret_cast<const char*>(msg.data), msg.cursize);
+            }
+        }
+
+        return messages;
+    }
+
+    std::vector<sharedEntity_t> entities;
+    std::vector<OpaquePlayerState> playerStates;
+    std::unique_ptr<client_t[]> clients;
+    std::unique_ptr<entityState_t[]> snapshotEntities;
+
+    serverState_t oldState;
+    int oldNumSnapshotEntities;
+    std::unique_ptr<entityState_t[]> oldSnapshotEntities;
+    client_t* oldClients;
+};
+
+TEST_F(SnapshotTest, SameEntitiesAsFullScan)
+{
+    const int numClients = sv_maxClients.Get();
+    SetUpWorld(numClients, 1500, 42);
+
+    for (int c = 0; c < numClients; c++) {
+        SV_ClearEntityIndex();
+        std::vector<int> scanned = SnapshotEntities(clients[c]);
+        SV_BuildEntityIndex();
+        std::vector<int> indexed = SnapshotEntities(clients[c]);
+        EXPECT_EQ(scanned, indexed) << "client " << c;
+    }
+}
+
+TEST_F(SnapshotTest, ParallelSameBytesAsSerial)
+{
+    const int numClients = sv_maxClients.Get();
+    std::vector<int> usage = MSG_EntityStateFieldUsage();
+    std::vector<std::string> serial = WriteFrames(numClients, false);
+    std::vector<int> serialUsage = MSG_EntityStateFieldUsage();
+    std::vector<std::string> parallel = WriteFrames(numClients, true);
+    std::vector<int> parallelUsage = MSG_EntityStateFieldUsage();
+
+    // The statistics of the prioritise commands are the same too
+    for (size_t i = 0; i < usage.size(); i++) {
+        EXPECT_EQ(serialUsage[i] - usage[i], parallelUsage[i] - serialUsage[i]) << "field " << i;
+    }
+    EXPECT_NE(usage, serialUsage);
+
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t i = 0; i < serial.size(); i++) {
+        EXPECT_EQ(serial[i], parallel[i]) << "frame " << i / numClients + 1 << ", client " << i % numClients;
+    }
+}
+
+// Run with --gtest_also_run_disabled_tests, and -set sv_maxclients for more clients
+TEST_F(SnapshotTest, DISABLED_Benchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    const int numClients = sv_maxClients.Get();
+    constexpr int numFrames = 50;
+
+    for (int numEntities : {1000, 2000, 4000}) {
+        SetUpWorld(numClients, numEntities, 1337);
+
+        for (bool index : {false, true}) {
+            auto start = Clock::now();
+            for (int frame = 0; frame < numFrames; frame++) {
+                if (index) {
+                    SV_BuildEntityIndex();
+                }
+                for (int c = 0; c < numClients; c++) {
+                    SV_BuildClientSnapshot(&clients[c]);
+                }
+                SV_ClearEntityIndex();
+            }
+            std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+            int sent = 0;
+            for (int c = 0; c < numClients; c++) {
+                sent += clients[c].frames[0].num_entities;
+            }
+            Log::Notice("%d entities, %d clients, %d clusters, %s: %.1f us/frame, %d entities/snapshot",
+                        numEntities, numClients, CM_NumClusters(), index ? "cluster index" : "full scan",
+                        elapsed.count() / numFrames, sent / numClients);
+        }
+    }
+}
+
+} // namespace
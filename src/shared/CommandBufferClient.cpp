@@ -68,18 +68,36 @@ namespace IPC {
         Flush();
     }
 
-    void CommandBufferClient::Write(Util::Writer& writer) {
+    void CommandBufferClient::BeginWrite(Util::Writer& writer) {
         if (!VM::rootChannel.canSendSyncMsg) {
             Sys::Drop("Trying to write to the %s command buffer when handling an async message or in toplevel", name);
         }
-        auto& writerData = writer.GetData();
-        uint32_t dataSize = writerData.size();
-        uint32_t totalSize = dataSize + sizeof(uint32_t);
+        if (!initialized) {
+            return;
+        }
+
+        // Serialize the message right after the room for its size, if it
+        // doesn't fit the writer will move it to its own memory.
+        buffer.LoadReaderData();
+        buffer.BeginWrite(writer, sizeof(uint32_t));
+    }
 
+    void CommandBufferClient::Write(Util::Writer& writer) {
         if (writer.GetHandles().size() != 0) {
             Sys::Drop("Command buffer %s: handles sent to the command buffer", name);
         }
 
+        if (writer.InRing()) {
+            uint32_t dataSize = writer.GetRingLength();
+            buffer.Write((char*)&dataSize, sizeof(uint32_t));
+            buffer.AdvanceWritePointer(dataSize + sizeof(uint32_t));
+            return;
+        }
+
+        auto& writerData = writer.GetData();
+        uint32_t dataSize = writerData.size();
+        uint32_t totalSize = dataSize + sizeof(uint32_t);
+
         buffer.LoadReaderData();
         if (!buffer.CanWrite(totalSize)) {
             logs.Debug("Message of size %i(+4) for %s doesn't fit the remaining %i, flushing.", dataSize, name, buffer.GetMaxWriteLength());
@@ -52,6 +52,7 @@ namespace IPC {
                 static_assert(sizeof...(Args) == std::tuple_size<typename Message::Inputs>::value, "Incorrect number of arguments for CommandBufferClient::SendMsg");
 
                 Util::Writer writer;
+                BeginWrite(writer);
                 writer.Write<uint32_t>(Message::id);
                 writer.WriteArgs(Util::TypeListFromTuple<typename Message::Inputs>(), std::forward<Args>(args)...);
 
@@ -68,6 +69,7 @@ namespace IPC {
             IPC::SharedMemory shm;
             bool initialized;
 
+            void BeginWrite(Util::Writer& writer);
             void Write(Util::Writer& writer);
 
             bool CanWrite(size_t length);
@@ -443,9 +443,21 @@ namespace VM {
         return offset;
     }
 
+    // Forwards the profiler zones of the VM to the engine
+    static IPC::SharedMemory profilerShm;
+    static void InitializeProfiler() {
+        profilerShm = IPC::SharedMemory::Create(sizeof(Profiler::SharedBuffer));
+        auto* buffer = static_cast<Profiler::SharedBuffer*>(profilerShm.GetBase());
+        buffer->enabled = 0;
+        buffer->count = 0;
+        Profiler::UseSharedBuffer(buffer);
+        SendMsg<ProfilerLocateMsg>(profilerShm);
+    }
+
     void InitializeProxies(int milliseconds) {
         baseTime = Sys::SteadyClock::now() - std::chrono::milliseconds(milliseconds);
         Cvar::InitializeProxy();
+        InitializeProfiler();
 
 #ifdef BUILD_VM_NATIVE_EXE
         // Set up the crash handler now that we have cvars to know if we want to use it.
@@ -79,6 +79,7 @@ static void CommonInit(Sys::OSHandle rootSocket)
 		if (id == IPC::ID_EXIT) {
 			return;
 		}
+		PROFILE_ZONE("HandleMsg");
 		VM::VMHandleSyscall(id, std::move(reader));
 	}
 }
@@ -52,6 +52,7 @@ namespace VM {
 		if (!Sys::OnMainThread()) {
 			Sys::Error("SendMsg from non-main VM thread");
 		}
+		PROFILE_ZONE("SendMsg");
 		IPC::SendMsg<Msg>(rootChannel, VMHandleSyscall, std::forward<Args>(args)...);
 	}
 
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <engine/client/cg_msgdef.h>
+#include <engine/client/cg_snapshot_ring.h>
 #include <shared/VMMain.h>
 #include <shared/CommandBufferClient.h>
 #include "cg_api.h"
@@ -66,9 +67,24 @@ void trap_GetCurrentSnapshotNumber( int *snapshotNumber, int *serverTime )
 	VM::SendMsg<GetCurrentSnapshotNumberMsg>(*snapshotNumber, *serverTime);
 }
 
+// Enough for most snapshots, bigger ones are requested from the engine
+static const int SNAPSHOT_RING_ENTITIES = 1024;
+
 bool trap_GetSnapshot( int snapshotNumber, ipcSnapshot_t *snapshot )
 {
+	static IPC::SharedMemory snapshotRing;
 	bool res;
+
+	if ( !snapshotRing )
+	{
+		snapshotRing = IPC::SharedMemory::Create( SnapshotRing::Size( SNAPSHOT_RING_ENTITIES ) );
+		VM::SendMsg<SnapshotRingLocateMsg>( snapshotRing, SNAPSHOT_RING_ENTITIES );
+	}
+	else if ( SnapshotRing::Read( snapshotRing.GetBase(), snapshotRing.GetSize(), SNAPSHOT_RING_ENTITIES, snapshotNumber, res, *snapshot ) )
+	{
+		return res;
+	}
+
 	VM::SendMsg<GetSnapshotMsg>(snapshotNumber, res, *snapshot);
 	return res;
 }
@@ -290,6 +306,13 @@ qhandle_t trap_R_RegisterShader( const char *name, int flags )
 	return handle;
 }
 
+std::vector<int> trap_RegisterAssets( const std::vector<assetRegistration_t> &assets )
+{
+	std::vector<int> handles;
+	VM::SendMsg<RegisterAssetsMsg>(assets, handles);
+	return handles;
+}
+
 void trap_R_ClearScene()
 {
 	cmdBuffer.SendMsg<Render::ClearSceneMsg>();
@@ -447,6 +470,34 @@ int trap_R_BuildSkeleton( refSkeleton_t *skel, qhandle_t anim, int startFrame, i
 	return result;
 }
 
+std::vector<int> trap_R_BuildSkeletons( const std::vector<SkeletonBuild> &builds, const std::vector<refSkeleton_t *> &skeletons )
+{
+	std::vector<SkeletonBuildResult> results;
+	std::vector<SkeletonBone> bones;
+	VM::SendMsg<Render::BuildSkeletonsMsg>(builds, results, bones);
+
+	if ( results.size() != builds.size() )
+	{
+		Sys::Drop( "trap_R_BuildSkeletons: wrong number of results" );
+	}
+
+	std::vector<int> res( results.size() );
+	size_t firstBone = 0;
+	for ( size_t i = 0; i < results.size(); i++ )
+	{
+		res[ i ] = results[ i ].result;
+		if ( builds[ i ].returnBones && i < skeletons.size() && skeletons[ i ] )
+		{
+			firstBone = Render::ExtractSkeleton( results[ i ], bones, firstBone, *skeletons[ i ] );
+		}
+		else
+		{
+			firstBone += results[ i ].numBones;
+		}
+	}
+	return res;
+}
+
 // Shamelessly stolen from tr_animation.cpp
 int trap_R_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float frac )
 {
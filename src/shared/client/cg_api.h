@@ -64,6 +64,7 @@ void            trap_R_LoadWorldMap( const char *mapname );
 qhandle_t       trap_R_RegisterModel( const char *name );
 qhandle_t       trap_R_RegisterSkin( const char *name );
 qhandle_t       trap_R_RegisterShader( const char *name, int flags );
+std::vector<int> trap_RegisterAssets( const std::vector<assetRegistration_t> &assets );
 void            trap_R_ClearScene();
 void trap_R_AddRefEntityToScene( const refEntity_t *re );
 void trap_R_SyncRefEntities( const std::vector<EntityUpdate>& ents );
@@ -110,6 +111,9 @@ std::vector<bool> trap_R_BatchInPVS(
 qhandle_t       trap_R_RegisterAnimation( const char *name );
 int             trap_R_BuildSkeleton( refSkeleton_t *skel, qhandle_t anim, int startFrame, int endFrame, float frac, bool clearOrigin );
 int             trap_R_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float frac );
+// Builds all the skeletons in one message. The bones are written to
+// skeletons[ i ] only for the builds with returnBones set.
+std::vector<int> trap_R_BuildSkeletons( const std::vector<SkeletonBuild> &builds, const std::vector<refSkeleton_t *> &skeletons );
 int             trap_R_BoneIndex( qhandle_t hModel, const char *boneName );
 int             trap_R_AnimNumFrames( qhandle_t hAnim );
 int             trap_R_AnimFrameRate( qhandle_t hAnim );
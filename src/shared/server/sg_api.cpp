@@ -33,6 +33,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 IPC::SharedMemory shmRegion;
 
+// State of the GAME_CLIENT_THINK_BATCH being run, see G_ClientThinkBatch
+static bool inThinkBatch = false;
+static usercmd_t thinkBatchUsercmds[MAX_CLIENTS];
+static bool thinkBatchHasUsercmd[MAX_CLIENTS];
+static bool thinkBatchDropped[MAX_CLIENTS];
+
 // Definition of the VM->Engine calls
 
 // The actual shared memory region is handled in this file, and is pretty much invisible to the rest of the code
@@ -48,6 +54,10 @@ void trap_LocateGameData(int numGEntities, int sizeofGEntity_t, int sizeofGClien
 
 void trap_DropClient(int clientNum, const char *reason)
 {
+    if (inThinkBatch && clientNum >= 0 && clientNum < MAX_CLIENTS) {
+        thinkBatchDropped[clientNum] = true;
+    }
+
     VM::SendMsg<DropClientMsg>(clientNum, reason);
 }
 
@@ -100,6 +110,12 @@ void trap_GetServerinfo(char *buffer, int bufferSize)
 
 void trap_GetUsercmd(int clientNum, usercmd_t *cmd)
 {
+    // the engine only knows the last usercmd of the batch
+    if (inThinkBatch && clientNum >= 0 && clientNum < MAX_CLIENTS && thinkBatchHasUsercmd[clientNum]) {
+        *cmd = thinkBatchUsercmds[clientNum];
+        return;
+    }
+
     VM::SendMsg<GetUsercmdMsg>(clientNum, *cmd);
 }
 
@@ -165,6 +181,36 @@ int trap_BotGetServerCommand(int clientNum, char *message, int size)
     return res;
 }
 
+void trap_EnableClientThinkBatch()
+{
+    VM::SendMsg<EnableClientThinkBatchMsg>();
+}
+
+void G_ClientThinkBatch(const std::vector<std::pair<int, usercmd_t>>& thinks, void (*clientThink)(int clientNum))
+{
+    std::fill(std::begin(thinkBatchHasUsercmd), std::end(thinkBatchHasUsercmd), false);
+    std::fill(std::begin(thinkBatchDropped), std::end(thinkBatchDropped), false);
+    inThinkBatch = true;
+
+    for (const auto& think : thinks) {
+        int clientNum = think.first;
+        if (clientNum < 0 || clientNum >= MAX_CLIENTS) {
+            Sys::Drop("G_ClientThinkBatch: bad clientNum %d", clientNum);
+        }
+
+        // unbatched, the engine stops sending the usercmds of a client once it is dropped
+        if (thinkBatchDropped[clientNum]) {
+            continue;
+        }
+
+        thinkBatchUsercmds[clientNum] = think.second;
+        thinkBatchHasUsercmd[clientNum] = true;
+        clientThink(clientNum);
+    }
+
+    inThinkBatch = false;
+}
+
 void trap_DispatchRawData( const std::string& data ) {
     VM::SendMsg<DispatchRawDataMsg>( data );
 }
@@ -55,5 +55,11 @@ void             trap_GenFingerprint( const char *pubkey, int size, char *buffer
 void             trap_GetPlayerPubkey( int clientNum, char *pubkey, int size );
 void             trap_GetTimeString( char *buffer, int size, const char *format, const qtime_t *tm );
 std::vector<int> trap_GetPings();
+void             trap_EnableClientThinkBatch();
+
+// To be called when handling GAME_CLIENT_THINK_BATCH, after trap_EnableClientThinkBatch:
+// runs clientThink for each usercmd in order, trap_GetUsercmd returning that usercmd.
+void             G_ClientThinkBatch( const std::vector<std::pair<int, usercmd_t>>& thinks,
+                                     void ( *clientThink )( int clientNum ) );
 
 #endif